@@ -0,0 +1,129 @@
+/**
+ * @file spsc_queue.h
+ * @brief 单生产者单消费者无锁队列
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 定长环形缓冲区实现的 SPSC 队列。入队/出队只使用两个分处不同缓存行的
+ * 原子下标，没有锁；消费者队列为空时可在 futex 上阻塞等待，生产者仅在
+ * 消费者确实处于等待状态时才发起唤醒系统调用。
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * @brief 单生产者单消费者无锁队列
+ * @tparam T 元素类型，应为可平凡拷贝的小对象（如缓冲区索引或帧描述符）
+ *
+ * 容量向上取整为 2 的幂。try_push 只能由一个线程调用，try_pop / wait_pop
+ * 只能由另一个线程调用。
+ */
+template <typename T> class SpscQueue {
+public:
+  /**
+   * @brief 构造函数
+   * @param capacity 最少可容纳的元素个数
+   */
+  explicit SpscQueue(size_t capacity)
+      : head_(0), tail_(0), consumer_waiting_(0) {
+    size_t size = 1;
+    while (size < capacity)
+      size <<= 1;
+    slots_.resize(size);
+    mask_ = (uint32_t)(size - 1);
+  }
+
+  SpscQueue(const SpscQueue &) = delete;
+  SpscQueue &operator=(const SpscQueue &) = delete;
+
+  /**
+   * @brief 入队（仅生产者线程调用）
+   * @param value 元素
+   * @return false 队列已满
+   */
+  bool try_push(const T &value) {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) > mask_)
+      return false;
+    slots_[tail & mask_] = value;
+    // seq_cst 与消费者对 consumer_waiting_ 的写入构成 Dekker 配对，防止丢失唤醒
+    tail_.store(tail + 1, std::memory_order_seq_cst);
+    if (consumer_waiting_.load(std::memory_order_seq_cst))
+      syscall(SYS_futex, reinterpret_cast<uint32_t *>(&tail_),
+              FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+    return true;
+  }
+
+  /**
+   * @brief 非阻塞出队（仅消费者线程调用）
+   * @param out 输出元素
+   * @return false 队列为空
+   */
+  bool try_pop(T &out) {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire))
+      return false;
+    out = slots_[head & mask_];
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief 阻塞出队（仅消费者线程调用）
+   * @param out 输出元素
+   * @param timeout_ms 超时时间（毫秒）
+   * @return false 超时仍为空
+   */
+  bool wait_pop(T &out, int timeout_ms) {
+    if (try_pop(out))
+      return true;
+
+    struct timespec ts;
+    ts.tv_sec = timeout_ms / 1000;
+    ts.tv_nsec = (long)(timeout_ms % 1000) * 1000000L;
+
+    consumer_waiting_.store(1, std::memory_order_seq_cst);
+    uint32_t tail = tail_.load(std::memory_order_seq_cst);
+    if (tail == head_.load(std::memory_order_relaxed)) {
+      // tail_ 在此期间变化时 futex 立即返回 EAGAIN
+      syscall(SYS_futex, reinterpret_cast<uint32_t *>(&tail_),
+              FUTEX_WAIT_PRIVATE, tail, &ts, nullptr, 0);
+    }
+    consumer_waiting_.store(0, std::memory_order_relaxed);
+    return try_pop(out);
+  }
+
+  /**
+   * @brief 当前元素个数（近似值，仅用于统计）
+   */
+  size_t size() const {
+    return tail_.load(std::memory_order_acquire) -
+           head_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief 队列容量
+   */
+  size_t capacity() const { return slots_.size(); }
+
+private:
+  alignas(64) std::atomic<uint32_t> head_; ///< 消费者下标
+  alignas(64) std::atomic<uint32_t> tail_; ///< 生产者下标（futex 等待字）
+  alignas(64) std::atomic<uint32_t> consumer_waiting_; ///< 消费者是否在 futex 上等待
+  uint32_t mask_;                          ///< 下标掩码
+  std::vector<T> slots_;                   ///< 环形缓冲区
+};
+
+#endif // SPSC_QUEUE_H
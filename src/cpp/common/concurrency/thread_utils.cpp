@@ -0,0 +1,29 @@
+/**
+ * @file thread_utils.cpp
+ * @brief 线程 CPU 绑定与实时调度工具函数实现
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ */
+
+#include "thread_utils.h"
+#include <pthread.h>
+#include <sched.h>
+
+int pin_thread_to_cpu(std::thread &thread, int cpu) {
+  if (cpu < 0)
+    return 0;
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(cpu, &cpuset);
+  return pthread_setaffinity_np(thread.native_handle(), sizeof(cpuset),
+                                &cpuset);
+}
+
+int set_thread_fifo_priority(std::thread &thread, int priority) {
+  if (priority <= 0)
+    return 0;
+  sched_param param{};
+  param.sched_priority = priority;
+  return pthread_setschedparam(thread.native_handle(), SCHED_FIFO, &param);
+}
@@ -0,0 +1,34 @@
+/**
+ * @file thread_utils.h
+ * @brief 线程 CPU 绑定与实时调度工具函数
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 对 pthread_setaffinity_np / pthread_setschedparam 的薄封装，
+ * 供捕获、发布、解码等流水线线程统一使用。
+ */
+
+#ifndef THREAD_UTILS_H
+#define THREAD_UTILS_H
+
+#include <thread>
+
+/**
+ * @brief 将线程绑定到指定 CPU
+ * @param thread 目标线程
+ * @param cpu CPU 编号，小于 0 时不做任何操作
+ * @return int 成功返回 0，失败返回 errno 值
+ */
+int pin_thread_to_cpu(std::thread &thread, int cpu);
+
+/**
+ * @brief 将线程切换为 SCHED_FIFO 实时调度
+ * @param thread 目标线程
+ * @param priority 实时优先级（1~99），小于等于 0 时保持默认调度策略
+ * @return int 成功返回 0，失败返回 errno 值（通常为 EPERM，需要
+ *         CAP_SYS_NICE 或 RLIMIT_RTPRIO 权限）
+ */
+int set_thread_fifo_priority(std::thread &thread, int priority);
+
+#endif // THREAD_UTILS_H
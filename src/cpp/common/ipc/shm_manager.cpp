@@ -14,19 +14,187 @@
 #include <chrono>
 #include <cstring>
 #include <fcntl.h>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <linux/futex.h>
 #include <memory>
+#include <optional>
+#include <signal.h>
+#include <sys/eventfd.h>
 #include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <sys/vfs.h>
 #include <thread>
 #include <unistd.h>
-#include <unordered_map>
 
-// 全局存储用于管理Guard对象的生命周期
-static std::mutex guard_map_mutex;
-static std::unordered_map<void *, std::unique_ptr<WriteBufferGuard>>
-    write_guards;
-static std::unordered_map<const void *, std::unique_ptr<ReadBufferGuard>>
-    read_guards;
+// ========== C接口租约表 ==========
+// create_shm_manager 创建的管理器自带固定大小的守卫租约表。C接口获取缓冲区时
+// 在本管理器的占用位图上做一次 CAS 占住一个表项并原地构造守卫，释放时清除位；
+// 无堆分配、无全局锁，不同管理器之间互不竞争。
+namespace {
+
+constexpr uint32_t kCApiLeaseIndexBits = 6; ///< 句柄低位：表项下标
+constexpr uint32_t kCApiLeaseTagMask =
+    UINT32_MAX >> kCApiLeaseIndexBits; ///< 句柄高位：表项代数
+static_assert(SHM_C_MAX_LEASES == (1u << kCApiLeaseIndexBits),
+              "lease index bits must cover the lease table");
+
+/**
+ * @brief C接口持有的单个守卫
+ */
+struct CApiLease {
+  enum Kind : uint32_t { Empty = 0, Write = 1, Read = 2 };
+
+  std::atomic<uint32_t> tag{0};       ///< 代数，每次释放加一，识别过期句柄
+  std::atomic<uint32_t> kind{Empty};  ///< 守卫类型，非 Empty 表示已发布
+  std::atomic<const void *> buffer{nullptr}; ///< 缓冲区地址，供按指针查找
+  std::optional<WriteBufferGuard> write;     ///< 写守卫
+  std::optional<ReadBufferGuard> read;       ///< 读守卫
+};
+
+/**
+ * @brief C接口使用的管理器：ShmManager 加每管理器租约表
+ *
+ * 表项析构先于基类，因此销毁管理器时未释放的守卫会正常归还槽位。
+ */
+class CApiManager : public ShmManager {
+public:
+  explicit CApiManager(const char *shm_name) : ShmManager(shm_name) {}
+
+  /**
+   * @brief 占用一个空闲表项
+   * @return int 表项下标，表满时返回 -1
+   */
+  int claim() {
+    uint64_t mask = busy_mask_.load(std::memory_order_relaxed);
+    while (~mask) {
+      int index = __builtin_ctzll(~mask);
+      if (busy_mask_.compare_exchange_weak(mask, mask | (1ull << index),
+                                           std::memory_order_acquire,
+                                           std::memory_order_relaxed))
+        return index;
+    }
+    return -1;
+  }
+
+  /**
+   * @brief 发布已构造好守卫的表项
+   * @return uint32_t 租约句柄
+   */
+  uint32_t publish(int index, CApiLease::Kind kind, const void *buffer) {
+    CApiLease &lease = leases_[index];
+    lease.buffer.store(buffer, std::memory_order_relaxed);
+    lease.kind.store(kind, std::memory_order_release);
+    return (lease.tag.load(std::memory_order_relaxed)
+            << kCApiLeaseIndexBits) |
+           (uint32_t)index;
+  }
+
+  /**
+   * @brief 按句柄独占一个已发布的表项
+   *
+   * 代数 CAS 保证同一句柄只有一个调用者能成功，过期或重复释放的句柄返回失败。
+   * @return CApiLease* 成功时返回表项，调用者处理后必须调用 put_back
+   */
+  CApiLease *take(uint32_t handle, CApiLease::Kind kind) {
+    uint32_t index = handle & (SHM_C_MAX_LEASES - 1);
+    CApiLease &lease = leases_[index];
+    if (lease.kind.load(std::memory_order_acquire) != kind)
+      return nullptr;
+    uint32_t expected = handle >> kCApiLeaseIndexBits;
+    if (!lease.tag.compare_exchange_strong(
+            expected, (expected + 1) & kCApiLeaseTagMask,
+            std::memory_order_acq_rel, std::memory_order_relaxed))
+      return nullptr;
+    return &lease;
+  }
+
+  /**
+   * @brief 按缓冲区地址独占一个已发布的表项（兼容指针形式的C接口）
+   */
+  CApiLease *take_buffer(const void *buffer, CApiLease::Kind kind) {
+    uint64_t mask = busy_mask_.load(std::memory_order_acquire);
+    while (mask) {
+      int index = __builtin_ctzll(mask);
+      mask &= mask - 1;
+      CApiLease &lease = leases_[index];
+      if (lease.kind.load(std::memory_order_acquire) != kind ||
+          lease.buffer.load(std::memory_order_relaxed) != buffer)
+        continue;
+      uint32_t handle =
+          (lease.tag.load(std::memory_order_relaxed) << kCApiLeaseIndexBits) |
+          (uint32_t)index;
+      if (CApiLease *taken = take(handle, kind))
+        return taken;
+    }
+    return nullptr;
+  }
+
+  /**
+   * @brief 析构守卫并归还表项
+   */
+  void put_back(int index) {
+    CApiLease &lease = leases_[index];
+    lease.kind.store(CApiLease::Empty, std::memory_order_relaxed);
+    lease.buffer.store(nullptr, std::memory_order_relaxed);
+    lease.write.reset();
+    lease.read.reset();
+    busy_mask_.fetch_and(~(1ull << index), std::memory_order_release);
+  }
+
+  void put_back(CApiLease *lease) { put_back((int)(lease - leases_)); }
+
+  CApiLease &lease(int index) { return leases_[index]; }
+
+private:
+  std::atomic<uint64_t> busy_mask_{0};     ///< 表项占用位图
+  CApiLease leases_[SHM_C_MAX_LEASES];     ///< 租约表
+};
+
+CApiManager *c_api_manager(void *manager_ptr) {
+  return static_cast<CApiManager *>(static_cast<ShmManager *>(manager_ptr));
+}
+
+/**
+ * @brief 把读守卫放入租约表
+ * @return int 操作结果，0表示成功
+ */
+int publish_read_guard(CApiManager *manager, ReadBufferGuard &&guard,
+                       const void **buffer_ptr, size_t *data_size,
+                       uint64_t *frame_version, uint32_t *lease_handle) {
+  if (!guard.is_valid())
+    return static_cast<int>(guard.status());
+  int index = manager->claim();
+  if (index < 0)
+    return static_cast<int>(ShmStatus::BufferInUse);
+  CApiLease &lease = manager->lease(index);
+  lease.read.emplace(std::move(guard));
+  *buffer_ptr = lease.read->get();
+  *data_size = lease.read->size();
+  *frame_version = lease.read->frame_version();
+  *lease_handle = manager->publish(index, CApiLease::Read, *buffer_ptr);
+  return static_cast<int>(ShmStatus::Success);
+}
+
+} // namespace
+
+// ========== futex 辅助函数 ==========
+// 共享内存跨进程使用，因此不能使用 FUTEX_PRIVATE_FLAG
+static long futex_wait(std::atomic<uint32_t> *addr, uint32_t expected,
+                       const struct timespec *timeout) {
+  return syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAIT,
+                 expected, timeout, nullptr, 0);
+}
+
+static long futex_wake_all(std::atomic<uint32_t> *addr) {
+  return syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAKE,
+                 INT_MAX, nullptr, nullptr, 0);
+}
 
 // ========== 状态码转换函数 ==========
 const char *shm_status_to_string(ShmStatus status) {
@@ -57,6 +225,12 @@ const char *shm_status_to_string(ShmStatus status) {
     return "No Data Available";
   case ShmStatus::AcquireFailed:
     return "Acquire Failed";
+  case ShmStatus::Timeout:
+    return "Timeout";
+  case ShmStatus::LayoutMismatch:
+    return "Layout Mismatch";
+  case ShmStatus::ProducerRestarted:
+    return "Producer Restarted";
   default:
     return "Unknown Status";
   }
@@ -67,17 +241,43 @@ WriteBufferGuard::WriteBufferGuard(ShmManager *manager, size_t expected_size)
     : manager_(manager), buffer_(nullptr), capacity_(0), buffer_idx_(0),
       committed_(false) {
   if (manager_) {
-    buffer_ =
-        manager_->internal_acquire_write_buffer(expected_size, &buffer_idx_);
-    if (buffer_)
-      capacity_ = manager_->get_buffer_size();
+    buffer_ = manager_->internal_acquire_write_buffer(
+        expected_size, &buffer_idx_, &capacity_);
+    if (!buffer_)
+      manager_->account_write_failure();
+  }
+}
+
+WriteBufferGuard::~WriteBufferGuard() { release(); }
+
+WriteBufferGuard::WriteBufferGuard(WriteBufferGuard &&other) noexcept
+    : manager_(other.manager_), buffer_(other.buffer_),
+      capacity_(other.capacity_), buffer_idx_(other.buffer_idx_),
+      committed_(other.committed_) {
+  other.buffer_ = nullptr;
+  other.capacity_ = 0;
+}
+
+WriteBufferGuard &
+WriteBufferGuard::operator=(WriteBufferGuard &&other) noexcept {
+  if (this != &other) {
+    release();
+    manager_ = other.manager_;
+    buffer_ = other.buffer_;
+    capacity_ = other.capacity_;
+    buffer_idx_ = other.buffer_idx_;
+    committed_ = other.committed_;
+    other.buffer_ = nullptr;
+    other.capacity_ = 0;
   }
+  return *this;
 }
 
-WriteBufferGuard::~WriteBufferGuard() {
+void WriteBufferGuard::release() {
   if (buffer_ && !committed_ && manager_) {
     manager_->internal_release_write_buffer(buffer_idx_);
   }
+  buffer_ = nullptr;
 }
 
 ShmStatus WriteBufferGuard::commit(size_t actual_size, uint64_t frame_version,
@@ -94,25 +294,88 @@ ShmStatus WriteBufferGuard::commit(size_t actual_size, uint64_t frame_version,
 // ========== ReadBufferGuard Implementation ==========
 ReadBufferGuard::ReadBufferGuard(ShmManager *manager)
     : manager_(manager), buffer_(nullptr), size_(0), frame_version_(0),
-      timestamp_us_(0), buffer_idx_(0), status_(ShmStatus::Success) {
+      timestamp_us_(0), buffer_idx_(0), status_(ShmStatus::Success),
+      acquire_us_(0), lease_handle_(0) {
+  if (manager_) {
+    buffer_ = manager_->internal_acquire_read_buffer(
+        &size_, &frame_version_, &timestamp_us_, &buffer_idx_, &status_,
+        ShmBufferControl::NO_CONSUMER, &lease_handle_);
+    if (buffer_)
+      acquire_us_ = monotonic_now_us();
+    else if (status_ != ShmStatus::NotInitialized &&
+             status_ != ShmStatus::InvalidArguments)
+      manager_->account_read_miss();
+  }
+}
+
+ReadBufferGuard::ReadBufferGuard(ShmManager *manager, uint32_t consumer_id)
+    : manager_(manager), buffer_(nullptr), size_(0), frame_version_(0),
+      timestamp_us_(0), buffer_idx_(0), status_(ShmStatus::Success),
+      acquire_us_(0), lease_handle_(0) {
   if (manager_) {
     buffer_ = manager_->internal_acquire_read_buffer(
-        &size_, &frame_version_, &timestamp_us_, &buffer_idx_, &status_);
+        &size_, &frame_version_, &timestamp_us_, &buffer_idx_, &status_,
+        consumer_id, &lease_handle_);
+    if (buffer_)
+      acquire_us_ = monotonic_now_us();
+    else if (status_ != ShmStatus::NotInitialized &&
+             status_ != ShmStatus::InvalidArguments)
+      manager_->account_read_miss();
+  }
+}
+
+ReadBufferGuard::~ReadBufferGuard() { release(); }
+
+ReadBufferGuard::ReadBufferGuard(ReadBufferGuard &&other) noexcept
+    : manager_(other.manager_), buffer_(other.buffer_), size_(other.size_),
+      frame_version_(other.frame_version_),
+      timestamp_us_(other.timestamp_us_), buffer_idx_(other.buffer_idx_),
+      status_(other.status_), acquire_us_(other.acquire_us_),
+      lease_handle_(other.lease_handle_) {
+  other.buffer_ = nullptr;
+}
+
+ReadBufferGuard &ReadBufferGuard::operator=(ReadBufferGuard &&other) noexcept {
+  if (this != &other) {
+    release();
+    manager_ = other.manager_;
+    buffer_ = other.buffer_;
+    size_ = other.size_;
+    frame_version_ = other.frame_version_;
+    timestamp_us_ = other.timestamp_us_;
+    buffer_idx_ = other.buffer_idx_;
+    status_ = other.status_;
+    acquire_us_ = other.acquire_us_;
+    lease_handle_ = other.lease_handle_;
+    other.buffer_ = nullptr;
   }
+  return *this;
 }
 
-ReadBufferGuard::~ReadBufferGuard() {
+void ReadBufferGuard::release() {
   if (buffer_ && manager_) {
-    manager_->internal_release_read_buffer(buffer_idx_);
+    manager_->internal_release_read_buffer(
+        buffer_idx_, monotonic_now_us() - acquire_us_, lease_handle_);
   }
+  buffer_ = nullptr;
 }
 
 // ========== ShmManager Implementation ==========
-ShmManager::ShmManager(const std::string &shm_name)
-    : shm_name_(shm_name), shm_fd_(-1), shm_ptr_(nullptr),
-      state_(ShmState::Uninitialized), is_creator_(false) {}
-
-ShmManager::~ShmManager() { unmap_and_close(); }
+ShmManager::ShmManager(const std::string &shm_name,
+                       const ShmMapOptions &map_options)
+    : shm_name_(shm_name), map_options_(map_options), on_hugetlbfs_(false),
+      shm_fd_(-1), shm_ptr_(nullptr), state_(ShmState::Uninitialized),
+      is_creator_(false), generation_(0),
+      lease_handle_(ShmBufferControl::NO_LEASE),
+      last_reader_reap_us_(0), notify_socket_(-1), notify_requests_seen_(0),
+      notify_fd_(-1),
+      notify_lease_handle_(ShmBufferControl::NO_LEASE), notify_generation_(0) {}
+
+ShmManager::~ShmManager() {
+  unmap_and_close();
+  if (notify_fd_ != -1)
+    close(notify_fd_);
+}
 
 void ShmManager::log_error(const std::string &message,
                            ShmStatus status_code) const {
@@ -122,6 +385,16 @@ void ShmManager::log_error(const std::string &message,
             << " (" << strerror(errno) << ")" << std::endl;
 }
 
+void ShmManager::log_legacy_segment() const {
+  std::cerr << "Error [ShmManager '" << shm_name_
+            << "']: Segment was created by a producer predating the layout "
+               "header (no magic, 24-byte image header); it cannot be read by "
+               "this version. Upgrade and restart the producer. (Status: "
+            << shm_status_to_string(ShmStatus::LayoutMismatch) << " ["
+            << static_cast<int>(ShmStatus::LayoutMismatch) << "])"
+            << std::endl;
+}
+
 void ShmManager::close_internal_handles() {
   if (shm_fd_ != -1) {
     if (close(shm_fd_) == -1) {
@@ -132,17 +405,11 @@ void ShmManager::close_internal_handles() {
   }
 }
 
-// 计算所需的共享内存大小的静态辅助函数
-static size_t calculate_required_shm_size(uint32_t buffer_count,
-                                          size_t buffer_size) {
-  return ShmBufferControl::get_data_buffers_offset(buffer_count) +
-         buffer_count * buffer_size;
-}
-
-ShmStatus ShmManager::validate_buffer_layout(size_t shm_total_size,
-                                             size_t buffer_size,
-                                             uint32_t buffer_count) const {
-  size_t required_size = calculate_required_shm_size(buffer_count, buffer_size);
+ShmStatus ShmManager::validate_buffer_layout(
+    size_t shm_total_size, size_t buffer_size, uint32_t buffer_count,
+    ShmSlotAllocator allocator) const {
+  size_t required_size = ShmBufferControl::get_required_size(
+      buffer_count, buffer_size, allocator);
   if (shm_total_size < required_size) {
     log_error("Shared memory size too small. Required: " +
                   std::to_string(required_size) +
@@ -153,39 +420,308 @@ ShmStatus ShmManager::validate_buffer_layout(size_t shm_total_size,
   return ShmStatus::Success;
 }
 
+ShmStatus ShmManager::check_mapped_layout(size_t shm_total_size,
+                                          size_t buffer_size,
+                                          uint32_t buffer_count) const {
+  auto *control = static_cast<const ShmBufferControl *>(shm_ptr_);
+  if (shm_total_size < sizeof(ShmBufferControl) ||
+      control->magic.load(std::memory_order_acquire) !=
+          ShmBufferControl::MAGIC) {
+    if (ShmBufferControl::is_legacy_header(control, shm_total_size))
+      log_legacy_segment();
+    else
+      log_error("Shared memory header magic mismatch (not initialized or "
+                "incompatible producer)",
+                ShmStatus::LayoutMismatch);
+    return ShmStatus::LayoutMismatch;
+  }
+  if (!ShmBufferControl::is_supported_layout(control->layout_version)) {
+    log_error("Unsupported layout version " +
+                  std::to_string(control->layout_version),
+              ShmStatus::LayoutMismatch);
+    return ShmStatus::LayoutMismatch;
+  }
+  uint32_t mapped_count = control->buffer_count.load(std::memory_order_acquire);
+  if (mapped_count != buffer_count || control->buffer_size != buffer_size) {
+    log_error("Shared memory geometry mismatch. Segment: " +
+                  std::to_string(mapped_count) + " x " +
+                  std::to_string(control->buffer_size) +
+                  ", Expected: " + std::to_string(buffer_count) + " x " +
+                  std::to_string(buffer_size),
+              ShmStatus::LayoutMismatch);
+    return ShmStatus::LayoutMismatch;
+  }
+  return validate_buffer_layout(
+      shm_total_size, buffer_size, buffer_count,
+      static_cast<ShmSlotAllocator>(control->slot_allocator));
+}
+
+std::string ShmManager::get_hugetlbfs_path() const {
+  // shm_open 名称以 '/' 开头，在挂载点下作为普通文件名使用
+  std::string file_name = shm_name_;
+  while (!file_name.empty() && file_name.front() == '/')
+    file_name.erase(0, 1);
+  return map_options_.hugetlbfs_dir + "/" + file_name;
+}
+
+void *ShmManager::try_map_hugetlbfs(size_t shm_total_size, bool create,
+                                    bool *newly_created, size_t *mapped_size) {
+  std::string path = get_hugetlbfs_path();
+  *newly_created = false;
+
+  int fd = -1;
+  if (create) {
+    // 已有文件在调用前已被删除，此处仍存在说明另一个生产者正在创建
+    fd = open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+    if (fd != -1)
+      *newly_created = true;
+  } else {
+    fd = open(path.c_str(), O_RDWR, 0666);
+  }
+  if (fd == -1) {
+    if (create)
+      std::cerr << "Warning [ShmManager '" << shm_name_
+                << "']: Cannot open hugetlbfs file '" << path
+                << "', falling back to /dev/shm. Errno: " << errno << " ("
+                << strerror(errno) << ")" << std::endl;
+    return nullptr;
+  }
+
+  // hugetlbfs 要求长度按大页对齐，大页大小即文件系统块大小
+  struct statfs fs_info;
+  size_t huge_page_size = 2 * 1024 * 1024;
+  if (fstatfs(fd, &fs_info) == 0 && fs_info.f_bsize > 0)
+    huge_page_size = static_cast<size_t>(fs_info.f_bsize);
+  size_t length = ShmBufferControl::align_up(shm_total_size, huge_page_size);
+
+  auto fail = [&](const char *what) -> void * {
+    std::cerr << "Warning [ShmManager '" << shm_name_ << "']: " << what
+              << " on hugetlbfs, falling back to /dev/shm. Errno: " << errno
+              << " (" << strerror(errno) << ")" << std::endl;
+    close(fd);
+    if (*newly_created)
+      unlink(path.c_str());
+    *newly_created = false;
+    return nullptr;
+  };
+
+  if (*newly_created) {
+    if (ftruncate(fd, length) == -1)
+      return fail("ftruncate failed");
+  } else {
+    // 创建者尚未完成 ftruncate 时访问会触发 SIGBUS
+    struct stat file_info;
+    if (fstat(fd, &file_info) == -1 ||
+        static_cast<size_t>(file_info.st_size) < length) {
+      close(fd);
+      return nullptr;
+    }
+  }
+
+  int flags = MAP_SHARED | (map_options_.populate ? MAP_POPULATE : 0);
+  void *addr = mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, fd, 0);
+  if (addr == MAP_FAILED)
+    return fail("mmap failed (no free huge pages?)");
+
+  shm_fd_ = fd;
+  on_hugetlbfs_ = true;
+  *mapped_size = length;
+  std::cout << "ShmManager '" << shm_name_ << "': Mapped " << length
+            << " bytes on hugetlbfs (" << huge_page_size / 1024
+            << " KB pages)." << std::endl;
+  return addr;
+}
+
+void ShmManager::apply_map_hints(void *addr, size_t length) const {
+  // 提示均为尽力而为，失败时仅告警，不影响映射本身
+  if (map_options_.transparent_huge_pages && !on_hugetlbfs_ &&
+      madvise(addr, length, MADV_HUGEPAGE) == -1)
+    std::cerr << "Warning [ShmManager '" << shm_name_
+              << "']: madvise(MADV_HUGEPAGE) failed. Errno: " << errno << " ("
+              << strerror(errno) << ")" << std::endl;
+  if (map_options_.will_need && madvise(addr, length, MADV_WILLNEED) == -1)
+    std::cerr << "Warning [ShmManager '" << shm_name_
+              << "']: madvise(MADV_WILLNEED) failed. Errno: " << errno << " ("
+              << strerror(errno) << ")" << std::endl;
+  if (map_options_.lock && mlock(addr, length) == -1)
+    std::cerr << "Warning [ShmManager '" << shm_name_
+              << "']: mlock failed (check RLIMIT_MEMLOCK). Errno: " << errno
+              << " (" << strerror(errno) << ")" << std::endl;
+}
+
+/// 重新附加时两次尝试之间的间隔
+static constexpr int kReconnectPollMs = 2;
+
+/**
+ * @brief 生成新的生产者代数：取 CLOCK_REALTIME 微秒，跨进程重启单调递增
+ */
+static uint64_t next_generation(uint64_t previous) {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  uint64_t now = (uint64_t)ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+  return std::max(now, previous + 1);
+}
+
+int ShmManager::open_segment_fd(bool writable) const {
+  // 与映射时相同的查找顺序：先 hugetlbfs 文件，再 /dev/shm
+  int flags = writable ? O_RDWR : O_RDONLY;
+  if (map_options_.use_hugetlbfs) {
+    int fd = open(get_hugetlbfs_path().c_str(), flags);
+    if (fd != -1)
+      return fd;
+  }
+  return shm_open(shm_name_.c_str(), flags, 0666);
+}
+
+/**
+ * @brief 映射段头部所在的首页（hugetlbfs 上为首个大页）
+ * @return 映射地址，段尚未 ftruncate 或映射失败时返回 nullptr
+ */
+static ShmBufferControl *map_segment_header(int fd, bool writable,
+                                            size_t *length,
+                                            size_t *file_size) {
+  // 创建者尚未完成 ftruncate 时访问头部会触发 SIGBUS
+  struct stat file_info;
+  if (fstat(fd, &file_info) == -1 ||
+      static_cast<size_t>(file_info.st_size) < sizeof(ShmBufferControl))
+    return nullptr;
+  struct statfs fs_info;
+  size_t page_size = ShmBufferControl::PAGE_SIZE;
+  if (fstatfs(fd, &fs_info) == 0 && fs_info.f_bsize > 0)
+    page_size = static_cast<size_t>(fs_info.f_bsize);
+  *length = ShmBufferControl::align_up(sizeof(ShmBufferControl), page_size);
+  *file_size = static_cast<size_t>(file_info.st_size);
+  void *addr = mmap(nullptr, *length,
+                    writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED,
+                    fd, 0);
+  return addr == MAP_FAILED ? nullptr : static_cast<ShmBufferControl *>(addr);
+}
+
+ShmStatus ShmManager::read_segment_geometry(size_t *shm_total_size,
+                                            size_t *buffer_size,
+                                            uint32_t *buffer_count) const {
+  int fd = open_segment_fd(false);
+  if (fd == -1)
+    return ShmStatus::ShmOpenFailed;
+
+  ShmStatus status = ShmStatus::ShmOpenFailed;
+  size_t length = 0, file_size = 0;
+  if (ShmBufferControl *control =
+          map_segment_header(fd, false, &length, &file_size)) {
+    // 魔数未写入表示创建者仍在初始化；已被取代的旧段等待新段出现
+    if (control->magic.load(std::memory_order_acquire) ==
+            ShmBufferControl::MAGIC &&
+        !control->superseded.load(std::memory_order_acquire)) {
+      *buffer_count = control->buffer_count.load(std::memory_order_acquire);
+      *buffer_size = control->buffer_size;
+      // 旧版本创建的段头部不含总大小，按文件大小映射
+      *shm_total_size =
+          control->total_size ? static_cast<size_t>(control->total_size)
+                              : file_size;
+      status = ShmStatus::Success;
+    } else if (control->magic.load(std::memory_order_acquire) !=
+                   ShmBufferControl::MAGIC &&
+               ShmBufferControl::is_legacy_header(control, file_size)) {
+      // 旧格式段永远不会写入魔数，不能当作初始化中的段继续等待
+      status = ShmStatus::LayoutMismatch;
+    }
+    munmap(control, length);
+  }
+  close(fd);
+  return status;
+}
+
+void ShmManager::mark_superseded(ShmBufferControl *control) {
+  control->superseded.store(1, std::memory_order_seq_cst);
+  // 递增提交序号，使阻塞在 futex 上的读者立即醒来检查标志
+  control->commit_seq.fetch_add(1, std::memory_order_seq_cst);
+  futex_wake_all(&control->commit_seq);
+}
+
+bool ShmManager::is_superseded(const ShmBufferControl *control) const {
+  return control->superseded.load(std::memory_order_acquire) ||
+         control->generation.load(std::memory_order_acquire) !=
+             generation_.load(std::memory_order_relaxed);
+}
+
+uint64_t ShmManager::supersede_existing_segment() {
+  int fd = open_segment_fd(true);
+  if (fd == -1)
+    return 0;
+
+  uint64_t generation = 0;
+  size_t length = 0, file_size = 0;
+  if (ShmBufferControl *control =
+          map_segment_header(fd, true, &length, &file_size)) {
+    if (control->magic.load(std::memory_order_acquire) ==
+        ShmBufferControl::MAGIC) {
+      generation = control->generation.load(std::memory_order_acquire);
+      mark_superseded(control);
+    }
+    munmap(control, length);
+  }
+  close(fd);
+  return generation;
+}
+
+uint64_t ShmManager::remove_existing_segment() {
+  uint64_t generation = supersede_existing_segment();
+  bool removed = false;
+  if (map_options_.use_hugetlbfs)
+    removed = unlink(get_hugetlbfs_path().c_str()) == 0;
+  removed = shm_unlink(shm_name_.c_str()) == 0 || removed;
+  if (removed)
+    std::cout << "ShmManager '" << shm_name_
+              << "': Replaced shared memory left by a previous producer."
+              << std::endl;
+  return generation;
+}
+
 ShmStatus ShmManager::create_and_init(size_t shm_total_size, size_t buffer_size,
-                                      uint32_t buffer_count) {
+                                      uint32_t buffer_count,
+                                      const ShmCreateOptions &options) {
   std::lock_guard<std::mutex> lock(state_mutex_);
-  if (state_ != ShmState::Uninitialized) {
+  ShmState state = state_.load(std::memory_order_acquire);
+  if (state != ShmState::Uninitialized && state != ShmState::Closed) {
     log_error("Shared memory already initialized",
               ShmStatus::AlreadyInitialized);
     return ShmStatus::AlreadyInitialized;
   }
+  is_creator_ = false;
 
-  ShmStatus validation_result =
-      validate_buffer_layout(shm_total_size, buffer_size, buffer_count);
+  ShmStatus validation_result = validate_buffer_layout(
+      shm_total_size, buffer_size, buffer_count, options.allocator);
   if (validation_result != ShmStatus::Success) {
     return validation_result;
   }
 
-  shm_fd_ = shm_open(shm_name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+  // 已有段属于上一个（可能已崩溃的）生产者：槽位写标志、就绪位、游标与
+  // 租约计数都不可信，几何参数也可能与新配置不同。标记取代并删除后创建
+  // 新段，仍附加在旧段上的读者经 superseded 标志重新附加
+  uint64_t previous_generation = remove_existing_segment();
+
   bool shm_newly_created = false;
-  if (shm_fd_ == -1) {
-    if (errno == EEXIST) {
-      shm_fd_ = shm_open(shm_name_.c_str(), O_RDWR, 0666);
-      if (shm_fd_ == -1) {
-        log_error("Failed to open existing shared memory",
-                  ShmStatus::ShmOpenFailed);
-        return ShmStatus::ShmOpenFailed;
-      }
-      std::cout << "ShmManager '" << shm_name_
-                << "': Opened existing shared memory." << std::endl;
-    } else {
-      log_error("Failed to create shared memory", ShmStatus::ShmOpenFailed);
+  size_t mapped_size = shm_total_size;
+  int map_flags = MAP_SHARED | (map_options_.populate ? MAP_POPULATE : 0);
+  shm_ptr_ = nullptr;
+  on_hugetlbfs_ = false;
+  if (map_options_.use_hugetlbfs) {
+    shm_ptr_ = try_map_hugetlbfs(shm_total_size, true, &shm_newly_created,
+                                 &mapped_size);
+    if (shm_ptr_)
+      is_creator_ = true;
+  }
+
+  if (!shm_ptr_) {
+    shm_fd_ = shm_open(shm_name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+    if (shm_fd_ == -1) {
+      // EEXIST：删除旧段之后另一个生产者抢先创建了同名段
+      log_error(errno == EEXIST
+                    ? "Shared memory was created concurrently by another producer"
+                    : "Failed to create shared memory",
+                ShmStatus::ShmOpenFailed);
       return ShmStatus::ShmOpenFailed;
     }
-  } else {
-    shm_newly_created = true;
     is_creator_ = true;
     if (ftruncate(shm_fd_, shm_total_size) == -1) {
       log_error("Failed to set shared memory size",
@@ -198,33 +734,42 @@ ShmStatus ShmManager::create_and_init(size_t shm_total_size, size_t buffer_size,
     std::cout << "ShmManager '" << shm_name_
               << "': Created new shared memory with size " << shm_total_size
               << " bytes, " << buffer_count << " buffers." << std::endl;
-  }
 
-  shm_ptr_ = mmap(nullptr, shm_total_size, PROT_READ | PROT_WRITE, MAP_SHARED,
-                  shm_fd_, 0);
-  if (shm_ptr_ == MAP_FAILED) {
-    log_error("Failed to map shared memory", ShmStatus::ShmMapFailed);
-    close(shm_fd_);
-    shm_fd_ = -1;
-    if (shm_newly_created) {
+    shm_ptr_ = mmap(nullptr, shm_total_size, PROT_READ | PROT_WRITE,
+                    map_flags, shm_fd_, 0);
+    if (shm_ptr_ == MAP_FAILED) {
+      log_error("Failed to map shared memory", ShmStatus::ShmMapFailed);
+      close(shm_fd_);
+      shm_fd_ = -1;
       shm_unlink(shm_name_.c_str());
+      shm_ptr_ = nullptr;
+      return ShmStatus::ShmMapFailed;
     }
-    shm_ptr_ = nullptr;
-    return ShmStatus::ShmMapFailed;
   }
+  apply_map_hints(shm_ptr_, mapped_size);
 
-  current_shm_size_.store(shm_total_size, std::memory_order_release);
+  current_shm_size_.store(mapped_size, std::memory_order_release);
   buffer_size_.store(buffer_size, std::memory_order_release);
 
-  if (shm_newly_created) {
-    auto *control = static_cast<ShmBufferControl *>(shm_ptr_);
-    control->initialize(buffer_count, buffer_size, shm_ptr_);
-    std::cout << "ShmManager '" << shm_name_
-              << "': Initialized buffer control structure with " << buffer_count
-              << " buffers." << std::endl;
-  }
-
-  state_ = ShmState::Created;
+  auto *control = static_cast<ShmBufferControl *>(shm_ptr_);
+  control->initialize(buffer_count, buffer_size, shm_total_size, shm_ptr_,
+                      options, next_generation(previous_generation));
+  std::cout << "ShmManager '" << shm_name_
+            << "': Initialized buffer control structure with " << buffer_count
+            << " buffers (layout v" << control->layout_version << ", "
+            << (options.ring_mode == ShmRingMode::Queue ? "queue" : "latest")
+            << " mode"
+            << (options.allocator == ShmSlotAllocator::ByteRing
+                    ? ", byte ring of " + std::to_string(control->arena_size) +
+                          " bytes"
+                    : std::string())
+            << ")." << std::endl;
+  generation_.store(control->generation.load(std::memory_order_acquire),
+                    std::memory_order_relaxed);
+  // 通知套接字按代数命名，须在代数确定之后打开；失败不影响轮询/futex 读者
+  open_notify_socket(control);
+
+  state_.store(ShmState::Created, std::memory_order_release);
   std::cout << "ShmManager '" << shm_name_
             << "' created and mapped successfully." << std::endl;
   return ShmStatus::Success;
@@ -233,48 +778,141 @@ ShmStatus ShmManager::create_and_init(size_t shm_total_size, size_t buffer_size,
 ShmStatus ShmManager::open_and_map(size_t shm_total_size, size_t buffer_size,
                                    uint32_t buffer_count) {
   std::lock_guard<std::mutex> lock(state_mutex_);
-  if (state_ != ShmState::Uninitialized) {
+  ShmState state = state_.load(std::memory_order_acquire);
+  if (state != ShmState::Uninitialized && state != ShmState::Closed) {
     log_error("Shared memory already initialized",
               ShmStatus::AlreadyInitialized);
     return ShmStatus::AlreadyInitialized;
   }
 
-  ShmStatus validation_result =
-      validate_buffer_layout(shm_total_size, buffer_size, buffer_count);
-  if (validation_result != ShmStatus::Success) {
-    return validation_result;
+  size_t mapped_size = shm_total_size;
+  int map_flags = MAP_SHARED | (map_options_.populate ? MAP_POPULATE : 0);
+  shm_ptr_ = nullptr;
+  on_hugetlbfs_ = false;
+  if (map_options_.use_hugetlbfs) {
+    bool unused_created = false;
+    shm_ptr_ = try_map_hugetlbfs(shm_total_size, false, &unused_created,
+                                 &mapped_size);
   }
 
-  shm_fd_ = shm_open(shm_name_.c_str(), O_RDWR, 0666);
-  if (shm_fd_ == -1) {
-    log_error("Failed to open shared memory", ShmStatus::ShmOpenFailed);
-    return ShmStatus::ShmOpenFailed;
+  if (!shm_ptr_) {
+    shm_fd_ = shm_open(shm_name_.c_str(), O_RDWR, 0666);
+    if (shm_fd_ == -1) {
+      log_error("Failed to open shared memory", ShmStatus::ShmOpenFailed);
+      return ShmStatus::ShmOpenFailed;
+    }
+
+    shm_ptr_ = mmap(nullptr, shm_total_size, PROT_READ | PROT_WRITE,
+                    map_flags, shm_fd_, 0);
+    if (shm_ptr_ == MAP_FAILED) {
+      log_error("Failed to map shared memory", ShmStatus::ShmMapFailed);
+      close(shm_fd_);
+      shm_fd_ = -1;
+      shm_ptr_ = nullptr;
+      return ShmStatus::ShmMapFailed;
+    }
   }
 
-  shm_ptr_ = mmap(nullptr, shm_total_size, PROT_READ | PROT_WRITE, MAP_SHARED,
-                  shm_fd_, 0);
-  if (shm_ptr_ == MAP_FAILED) {
-    log_error("Failed to map shared memory", ShmStatus::ShmMapFailed);
-    close(shm_fd_);
-    shm_fd_ = -1;
+  // 布局由创建者决定，映射后根据头部中的魔数与版本号校验
+  ShmStatus layout_status =
+      check_mapped_layout(shm_total_size, buffer_size, buffer_count);
+  if (layout_status != ShmStatus::Success) {
+    munmap(shm_ptr_, mapped_size);
     shm_ptr_ = nullptr;
-    return ShmStatus::ShmMapFailed;
+    close_internal_handles();
+    return layout_status;
   }
+  apply_map_hints(shm_ptr_, mapped_size);
 
-  current_shm_size_.store(shm_total_size, std::memory_order_release);
+  current_shm_size_.store(mapped_size, std::memory_order_release);
   buffer_size_.store(buffer_size, std::memory_order_release);
   is_creator_ = false;
-  state_ = ShmState::Mapped;
+  generation_.store(static_cast<ShmBufferControl *>(shm_ptr_)->generation.load(
+                        std::memory_order_acquire),
+                    std::memory_order_relaxed);
+  state_.store(ShmState::Mapped, std::memory_order_release);
   std::cout << "ShmManager '" << shm_name_
             << "' opened and mapped successfully." << std::endl;
   return ShmStatus::Success;
 }
 
+ShmStatus ShmManager::open_and_map() {
+  size_t shm_total_size = 0, buffer_size = 0;
+  uint32_t buffer_count = 0;
+  ShmStatus status =
+      read_segment_geometry(&shm_total_size, &buffer_size, &buffer_count);
+  if (status == ShmStatus::LayoutMismatch)
+    log_legacy_segment();
+  if (status != ShmStatus::Success)
+    return status;
+  return open_and_map(shm_total_size, buffer_size, buffer_count);
+}
+
+ShmStatus ShmManager::reconnect(int timeout_ms) {
+  unmap_and_close();
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(timeout_ms > 0 ? timeout_ms : 0);
+  while (true) {
+    size_t shm_total_size = 0, buffer_size = 0;
+    uint32_t buffer_count = 0;
+    ShmStatus status =
+        read_segment_geometry(&shm_total_size, &buffer_size, &buffer_count);
+    if (status == ShmStatus::LayoutMismatch) {
+      // 旧格式生产者仍在运行，继续等待不会改变结果
+      log_legacy_segment();
+      return status;
+    }
+    if (status == ShmStatus::Success)
+      status = open_and_map(shm_total_size, buffer_size, buffer_count);
+    if (status == ShmStatus::Success) {
+      // 已使用 eventfd 的读者向新生产者重新登记，失败时由下次 get_notify_fd 重试
+      std::lock_guard<std::mutex> lock(notify_mutex_);
+      if (notify_fd_ != -1)
+        register_notify_fd(get_buffer_control());
+      return ShmStatus::Success;
+    }
+    if (timeout_ms >= 0 && std::chrono::steady_clock::now() >= deadline)
+      return ShmStatus::Timeout;
+    std::this_thread::sleep_for(std::chrono::milliseconds(kReconnectPollMs));
+  }
+}
+
+bool ShmManager::producer_restarted() const {
+  auto *control = get_buffer_control();
+  if (!control)
+    return false;
+  if (is_superseded(control))
+    return true;
+  // 段名被直接删除（未经 unlink_shm 标记）时已映射文件的链接数归零
+  struct stat file_info;
+  return shm_fd_ != -1 && fstat(shm_fd_, &file_info) == 0 &&
+         file_info.st_nlink == 0;
+}
+
+uint64_t ShmManager::get_generation() const {
+  return is_mapped() ? generation_.load(std::memory_order_relaxed) : 0;
+}
+
 ShmStatus ShmManager::unmap_and_close() {
   std::lock_guard<std::mutex> lock(state_mutex_);
-  if (state_ == ShmState::Uninitialized || state_ == ShmState::Closed) {
+  ShmState state = state_.load(std::memory_order_acquire);
+  if (state == ShmState::Uninitialized || state == ShmState::Closed) {
     return ShmStatus::Success;
   }
+  // 归还读者租约，其余读者与写者不必等待回收
+  release_reader_lease();
+  {
+    // 写者唤醒并关闭已登记的读者 eventfd；读者重新附加后须重新登记
+    std::lock_guard<std::mutex> notify_lock(notify_mutex_);
+    close_notify_targets(true);
+    if (notify_socket_ != -1) {
+      close(notify_socket_);
+      notify_socket_ = -1;
+    }
+    notify_generation_ = 0;
+  }
+  // 先发布关闭状态，使无锁快速路径不再访问即将解除映射的内存
+  state_.store(ShmState::Closed, std::memory_order_release);
   ShmStatus status = ShmStatus::Success;
   if (shm_ptr_ != nullptr) {
     size_t shm_size = current_shm_size_.load(std::memory_order_acquire);
@@ -290,11 +928,30 @@ ShmStatus ShmManager::unmap_and_close() {
     buffer_size_.store(0, std::memory_order_release);
   }
   close_internal_handles();
-  state_ = ShmState::Closed;
   return status;
 }
 
 ShmStatus ShmManager::unlink_shm() {
+  // 删除前标记旧段已被取代，仍附加在旧段上的读者立即感知并重新附加
+  supersede_existing_segment();
+  if (is_creator_) {
+    // 使用 eventfd 的读者不在 futex 上等待，需要单独唤醒
+    std::lock_guard<std::mutex> lock(notify_mutex_);
+    close_notify_targets(true);
+  }
+  if (map_options_.use_hugetlbfs) {
+    // 段可能位于 hugetlbfs（或已回退到 /dev/shm），两处都尝试删除
+    std::string path = get_hugetlbfs_path();
+    bool removed = unlink(path.c_str()) == 0;
+    removed = shm_unlink(shm_name_.c_str()) == 0 || removed;
+    if (!removed) {
+      log_error("Failed to unlink shared memory", ShmStatus::ShmUnlinkFailed);
+      return ShmStatus::ShmUnlinkFailed;
+    }
+    std::cout << "ShmManager '" << shm_name_
+              << "': Unlinked (destroyed) successfully." << std::endl;
+    return ShmStatus::Success;
+  }
   if (shm_unlink(shm_name_.c_str()) == -1) {
     log_error("Failed to unlink shared memory", ShmStatus::ShmUnlinkFailed);
     return ShmStatus::ShmUnlinkFailed;
@@ -313,133 +970,938 @@ ReadBufferGuard ShmManager::acquire_read_buffer() {
   return ReadBufferGuard(this);
 }
 
-// ========== 兼容性接口实现（内部使用零拷贝实现）==========
-ShmStatus ShmManager::write_and_switch(const void *data, size_t size,
-                                       uint64_t frame_version) {
-  if (!data || size == 0)
-    return ShmStatus::InvalidArguments;
-
-  WriteBufferGuard guard = acquire_write_buffer(size);
-  if (!guard.is_valid()) {
-    // 在单写者模型中，可以简单返回错误，而不是忙等
-    return ShmStatus::AcquireFailed;
-  }
+// ========== 进程存活检查 ==========
+//
+// 游标与租约记录 pid、PID 命名空间与进程启动时间。只有 kill(pid, 0) 时，
+// 同一 pid 被新进程复用会让失效记录永不回收；记录者位于其他 PID 命名空间
+// （例如容器内）时，pid 在写者的命名空间中可能不存在或指向别的进程，
+// 误判为已退出会回收仍在读取的租约。
 
-  std::memcpy(guard.get(), data, size);
+/**
+ * @brief 读取进程启动时间（/proc/<pid>/stat 第22项，开机以来的时钟节拍）
+ * @return uint64_t 启动时间，进程不存在或无法读取时为0
+ */
+static uint64_t read_process_start_time(const char *stat_path) {
+  int fd = open(stat_path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1)
+    return 0;
+  char buf[512];
+  ssize_t n = read(fd, buf, sizeof(buf) - 1);
+  close(fd);
+  if (n <= 0)
+    return 0;
+  buf[n] = '\0';
+  // 第2项进程名可能含空格与括号，从最后一个 ')' 之后开始数
+  const char *p = strrchr(buf, ')');
+  if (!p)
+    return 0;
+  for (int field = 2; field < 22 && p; ++field)
+    p = strchr(p + 1, ' ');
+  return p ? strtoull(p + 1, nullptr, 10) : 0;
+}
 
-  uint64_t current_timestamp =
-      std::chrono::duration_cast<std::chrono::microseconds>(
-          std::chrono::system_clock::now().time_since_epoch())
-          .count();
+/**
+ * @brief 本进程的 PID 命名空间 inode 与启动时间（进程内只读取一次）
+ */
+struct ProcessIdentity {
+  uint64_t pid_ns;
+  uint64_t start_time;
+};
+
+static const ProcessIdentity &self_identity() {
+  static const ProcessIdentity identity = [] {
+    struct stat ns_info;
+    ProcessIdentity id;
+    id.pid_ns = stat("/proc/self/ns/pid", &ns_info) == 0 ? ns_info.st_ino : 0;
+    id.start_time = read_process_start_time("/proc/self/stat");
+    return id;
+  }();
+  return identity;
+}
 
-  return guard.commit(size, frame_version, current_timestamp);
+/**
+ * @brief 判断记录的进程是否已经退出
+ *
+ * 未记录命名空间或启动时间（旧版本写入的记录）时退化为只检查 pid；
+ * 记录来自其他 PID 命名空间时无法判断，按仍存活处理。
+ */
+static bool process_exited(pid_t pid, uint64_t pid_ns, uint64_t start_time) {
+  if (pid <= 0)
+    return false;
+  const ProcessIdentity &self = self_identity();
+  if (pid_ns != 0 && self.pid_ns != 0 && pid_ns != self.pid_ns)
+    return false;
+  if (kill(pid, 0) == -1 && errno == ESRCH)
+    return true;
+  if (start_time == 0)
+    return false;
+  char stat_path[32];
+  snprintf(stat_path, sizeof(stat_path), "/proc/%d/stat", (int)pid);
+  const uint64_t current = read_process_start_time(stat_path);
+  return current != 0 && current != start_time;
 }
 
-ShmStatus ShmManager::try_read_latest(void *data, size_t max_size,
-                                      size_t *actual_size) {
-  if (!data || max_size == 0) {
+// ========== 队列模式接口实现 ==========
+//
+// 消费者游标 active 字段取值：空闲 / 注册中 / 已激活。注册时先以
+// CAS(空闲 -> 注册中) 占用记录，初始化游标后再发布为已激活，
+// 写者计算最慢游标时只统计已激活记录，不会读到上一任使用者的旧游标。
+static constexpr uint32_t kCursorFree = 0;
+static constexpr uint32_t kCursorActive = 1;
+static constexpr uint32_t kCursorRegistering = 2;
+/// 阻塞策略下生产者单次等待空闲槽位的最长时间，超时后回收失效消费者并返回
+static constexpr int kProducerBlockTimeoutMs = 100;
+
+ShmStatus ShmManager::register_consumer(uint32_t *consumer_id) {
+  if (!consumer_id)
+    return ShmStatus::InvalidArguments;
+  auto *control = get_buffer_control();
+  if (!control)
+    return ShmStatus::NotInitialized;
+  if (!control->is_queue_mode()) {
+    log_error("register_consumer requires queue ring mode",
+              ShmStatus::InvalidArguments);
     return ShmStatus::InvalidArguments;
   }
-  ReadBufferGuard guard = acquire_read_buffer();
-  if (!guard.is_valid()) {
-    if (actual_size)
-      *actual_size = 0;
-    return guard.status();
-  }
-  size_t copy_size = std::min(max_size, guard.size());
-  std::memcpy(data, guard.get(), copy_size);
-  if (actual_size)
-    *actual_size = copy_size;
-  return ShmStatus::Success;
-}
 
-ShmStatus ShmManager::wait_and_read(void *data, size_t max_size,
-                                    size_t *actual_size) {
-  while (true) {
-    ReadBufferGuard guard = acquire_read_buffer();
-    if (guard.is_valid()) {
-      size_t copy_size = std::min(max_size, guard.size());
-      std::memcpy(data, guard.get(), copy_size);
-      if (actual_size)
-        *actual_size = copy_size;
+  // 第一轮直接查找空闲记录，失败后回收已退出进程的注册再试一次
+  for (int pass = 0; pass < 2; ++pass) {
+    for (uint32_t i = 0; i < ShmBufferControl::MAX_CONSUMERS; ++i) {
+      ShmConsumerCursor *cursor = control->get_consumer(i, shm_ptr_);
+      uint32_t expected = kCursorFree;
+      if (!cursor->active.compare_exchange_strong(
+              expected, kCursorRegistering, std::memory_order_acquire,
+              std::memory_order_relaxed))
+        continue;
+
+      cursor->pid.store(getpid(), std::memory_order_relaxed);
+      cursor->pid_ns.store(self_identity().pid_ns, std::memory_order_relaxed);
+      cursor->start_time.store(self_identity().start_time,
+                               std::memory_order_relaxed);
+      cursor->frames_consumed.store(0, std::memory_order_relaxed);
+      cursor->frames_dropped.store(0, std::memory_order_relaxed);
+      // 新消费者从当前最新帧开始，不回放注册前的历史帧
+      cursor->next_version.store(get_latest_frame_version(),
+                                 std::memory_order_relaxed);
+      cursor->active.store(kCursorActive, std::memory_order_release);
+      *consumer_id = i;
       return ShmStatus::Success;
     }
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if (pass == 0)
+      reap_dead_consumers();
   }
-  return ShmStatus::NoDataAvailable; // 理论上不会执行到这里
-}
 
-// ========== 信息获取接口实现 ==========
-void *ShmManager::get_shm_ptr() const {
-  std::lock_guard<std::mutex> lock(state_mutex_);
-  return (state_ == ShmState::Created || state_ == ShmState::Mapped) ? shm_ptr_
-                                                                     : nullptr;
+  log_error("Consumer cursor table is full", ShmStatus::BufferInUse);
+  return ShmStatus::BufferInUse;
 }
 
-size_t ShmManager::get_shm_size() const {
-  return current_shm_size_.load(std::memory_order_acquire);
-}
+ShmStatus ShmManager::unregister_consumer(uint32_t consumer_id) {
+  ShmConsumerCursor *cursor = get_active_consumer(consumer_id);
+  if (!cursor)
+    return ShmStatus::InvalidArguments;
 
-size_t ShmManager::get_buffer_size() const {
-  return buffer_size_.load(std::memory_order_acquire);
+  cursor->active.store(kCursorFree, std::memory_order_release);
+  // 该消费者不再限制写者，唤醒可能正在等待的生产者
+  auto *control = get_buffer_control();
+  control->consume_seq.fetch_add(1, std::memory_order_seq_cst);
+  if (control->producer_waiting.load(std::memory_order_seq_cst))
+    futex_wake_all(&control->consume_seq);
+  return ShmStatus::Success;
 }
 
-ShmState ShmManager::get_state() const {
-  std::lock_guard<std::mutex> lock(state_mutex_);
-  return state_;
+ReadBufferGuard ShmManager::acquire_next_buffer(uint32_t consumer_id) {
+  return ReadBufferGuard(this, consumer_id);
 }
 
-bool ShmManager::is_initialized() const {
-  std::lock_guard<std::mutex> lock(state_mutex_);
-  return state_ == ShmState::Created || state_ == ShmState::Mapped;
+ShmStatus ShmManager::get_consumer_stats(uint32_t consumer_id,
+                                         ShmConsumerStats *stats) const {
+  if (!stats)
+    return ShmStatus::InvalidArguments;
+  ShmConsumerCursor *cursor = get_active_consumer(consumer_id);
+  if (!cursor)
+    return ShmStatus::InvalidArguments;
+
+  uint64_t next_version = cursor->next_version.load(std::memory_order_acquire);
+  uint64_t latest_version = get_latest_frame_version();
+  stats->next_version = next_version;
+  stats->frames_consumed =
+      cursor->frames_consumed.load(std::memory_order_relaxed);
+  stats->frames_dropped = cursor->frames_dropped.load(std::memory_order_relaxed);
+  stats->lag =
+      latest_version >= next_version ? latest_version - next_version + 1 : 0;
+  return ShmStatus::Success;
 }
 
-ShmBufferControl *ShmManager::get_buffer_control() const {
-  std::lock_guard<std::mutex> lock(state_mutex_);
-  return (state_ == ShmState::Created || state_ == ShmState::Mapped)
-             ? static_cast<ShmBufferControl *>(shm_ptr_)
-             : nullptr;
+ShmStatus ShmManager::get_segment_stats(ShmSegmentStats *stats) const {
+  if (!stats)
+    return ShmStatus::InvalidArguments;
+  auto *control = get_buffer_control();
+  if (!control)
+    return ShmStatus::NotInitialized;
+  control->read_stats(shm_ptr_, stats);
+  return ShmStatus::Success;
 }
 
-void *ShmManager::get_data_buffer(uint32_t buffer_idx) const {
-  std::lock_guard<std::mutex> lock(state_mutex_);
-  return get_data_buffer_nolock(buffer_idx);
+ShmRingMode ShmManager::get_ring_mode() const {
+  auto *control = get_buffer_control();
+  if (!control)
+    return ShmRingMode::Latest;
+  return static_cast<ShmRingMode>(control->ring_mode);
 }
 
-void *ShmManager::get_data_buffer_nolock(uint32_t buffer_idx) const {
-  // 这个函数假设 state_mutex_ 已经被外部调用者锁住
-  if (state_ != ShmState::Created && state_ != ShmState::Mapped)
+ShmConsumerCursor *ShmManager::get_active_consumer(uint32_t consumer_id) const {
+  auto *control = get_buffer_control();
+  if (!control || !control->is_queue_mode() ||
+      consumer_id >= ShmBufferControl::MAX_CONSUMERS)
+    return nullptr;
+  ShmConsumerCursor *cursor = control->get_consumer(consumer_id, shm_ptr_);
+  if (!cursor ||
+      cursor->active.load(std::memory_order_acquire) != kCursorActive)
     return nullptr;
+  return cursor;
+}
 
+uint64_t ShmManager::get_min_consumer_cursor() const {
   auto *control = static_cast<ShmBufferControl *>(shm_ptr_);
-  if (!control)
-    return nullptr;
+  uint64_t min_cursor = UINT64_MAX;
+  for (uint32_t i = 0; i < ShmBufferControl::MAX_CONSUMERS; ++i) {
+    ShmConsumerCursor *cursor = control->get_consumer(i, shm_ptr_);
+    if (cursor->active.load(std::memory_order_acquire) == kCursorActive)
+      min_cursor = std::min(
+          min_cursor, cursor->next_version.load(std::memory_order_acquire));
+  }
+  return min_cursor;
+}
 
-  uint32_t buffer_count = control->buffer_count.load(std::memory_order_acquire);
-  if (buffer_idx >= buffer_count)
-    return nullptr;
+void ShmManager::reap_dead_consumers() {
+  auto *control = get_buffer_control();
+  if (!control || !control->is_queue_mode())
+    return;
+
+  bool reaped = false;
+  for (uint32_t i = 0; i < ShmBufferControl::MAX_CONSUMERS; ++i) {
+    ShmConsumerCursor *cursor = control->get_consumer(i, shm_ptr_);
+    if (cursor->active.load(std::memory_order_acquire) != kCursorActive)
+      continue;
+    pid_t pid = cursor->pid.load(std::memory_order_relaxed);
+    if (process_exited(pid, cursor->pid_ns.load(std::memory_order_relaxed),
+                       cursor->start_time.load(std::memory_order_relaxed))) {
+      uint32_t expected = kCursorActive;
+      if (cursor->active.compare_exchange_strong(expected, kCursorFree,
+                                                 std::memory_order_acq_rel)) {
+        std::cout << "ShmManager '" << shm_name_ << "': Reaped consumer " << i
+                  << " (pid " << pid << " exited)." << std::endl;
+        reaped = true;
+      }
+    }
+  }
+  if (reaped) {
+    control->consume_seq.fetch_add(1, std::memory_order_seq_cst);
+    if (control->producer_waiting.load(std::memory_order_seq_cst))
+      futex_wake_all(&control->consume_seq);
+  }
+}
+
+// ========== 读者租约 ==========
+//
+// 租约 state 字段取值：空闲 / 分配中 / 已激活 / 回收中。分配与回收都先以
+// CAS 独占记录，再修改 pid、持有计数与 reader_lease_mask；epoch 每次分配
+// 与回收递增，持有者用 (epoch, 索引) 句柄识别自己的租约。
+static constexpr uint32_t kLeaseFree = 0;
+static constexpr uint32_t kLeaseRegistering = 1;
+static constexpr uint32_t kLeaseActive = 2;
+static constexpr uint32_t kLeaseReclaiming = 3;
+/// 写者发现槽位被读者占用时，检查失效租约的最小间隔（微秒）
+static constexpr uint64_t kReaderReapIntervalUs = 200000;
+
+static uint32_t lease_index(uint64_t handle) { return (uint32_t)handle; }
+static uint32_t lease_epoch(uint64_t handle) { return (uint32_t)(handle >> 32); }
+
+ShmReaderLease *ShmManager::get_reader_lease(uint64_t *handle_out) {
+  auto *control = get_buffer_control();
+  uint64_t handle = lease_handle_.load(std::memory_order_acquire);
+  uint32_t idx = lease_index(handle);
+  if (idx != ShmBufferControl::NO_LEASE) {
+    ShmReaderLease *lease = control->get_reader_lease(idx, shm_ptr_);
+    // 租约仍属于本实例（未被当作失效租约回收）时直接使用
+    if (lease->epoch.load(std::memory_order_acquire) == lease_epoch(handle) &&
+        lease->state.load(std::memory_order_relaxed) == kLeaseActive) {
+      *handle_out = handle;
+      return lease;
+    }
+  }
+  return acquire_reader_lease(handle_out);
+}
+
+ShmReaderLease *ShmManager::acquire_reader_lease(uint64_t *handle_out) {
+  std::lock_guard<std::mutex> lock(lease_mutex_);
+  auto *control = get_buffer_control();
+  if (!control)
+    return nullptr;
+
+  // 其他线程可能已经完成分配
+  uint64_t handle = lease_handle_.load(std::memory_order_acquire);
+  uint32_t idx = lease_index(handle);
+  if (idx != ShmBufferControl::NO_LEASE) {
+    ShmReaderLease *lease = control->get_reader_lease(idx, shm_ptr_);
+    if (lease->epoch.load(std::memory_order_acquire) == lease_epoch(handle) &&
+        lease->state.load(std::memory_order_relaxed) == kLeaseActive) {
+      *handle_out = handle;
+      return lease;
+    }
+  }
+
+  uint32_t buffer_count = control->buffer_count.load(std::memory_order_acquire);
+  // 第一轮直接查找空闲记录，失败后回收已退出进程的租约再试一次
+  for (int pass = 0; pass < 2; ++pass) {
+    for (uint32_t i = 0; i < ShmBufferControl::MAX_READER_LEASES; ++i) {
+      ShmReaderLease *lease = control->get_reader_lease(i, shm_ptr_);
+      uint32_t expected = kLeaseFree;
+      if (!lease->state.compare_exchange_strong(expected, kLeaseRegistering,
+                                                std::memory_order_acquire,
+                                                std::memory_order_relaxed))
+        continue;
+
+      lease->pid.store(getpid(), std::memory_order_relaxed);
+      lease->pid_ns.store(self_identity().pid_ns, std::memory_order_relaxed);
+      lease->start_time.store(self_identity().start_time,
+                              std::memory_order_relaxed);
+      for (uint32_t j = 0; j < buffer_count; ++j)
+        lease->held()[j].store(0, std::memory_order_relaxed);
+      uint32_t epoch = lease->epoch.fetch_add(1, std::memory_order_relaxed) + 1;
+      lease->state.store(kLeaseActive, std::memory_order_release);
+      // 位图须先于任何持有登记对写者可见
+      control->reader_lease_mask.fetch_or(1u << i, std::memory_order_seq_cst);
+      handle = ((uint64_t)epoch << 32) | i;
+      lease_handle_.store(handle, std::memory_order_release);
+      *handle_out = handle;
+      return lease;
+    }
+    if (pass == 0)
+      reap_dead_readers();
+  }
+
+  log_error("Reader lease table is full", ShmStatus::BufferInUse);
+  return nullptr;
+}
+
+void ShmManager::release_reader_lease() {
+  std::lock_guard<std::mutex> lock(lease_mutex_);
+  uint64_t handle = lease_handle_.exchange(ShmBufferControl::NO_LEASE,
+                                           std::memory_order_acq_rel);
+  uint32_t idx = lease_index(handle);
+  auto *control = get_buffer_control();
+  if (!control || idx == ShmBufferControl::NO_LEASE)
+    return;
+
+  ShmReaderLease *lease = control->get_reader_lease(idx, shm_ptr_);
+  uint32_t expected = kLeaseActive;
+  if (lease->epoch.load(std::memory_order_acquire) != lease_epoch(handle) ||
+      !lease->state.compare_exchange_strong(expected, kLeaseReclaiming,
+                                            std::memory_order_acq_rel))
+    return; // 已被回收
+  uint32_t buffer_count = control->buffer_count.load(std::memory_order_acquire);
+  for (uint32_t j = 0; j < buffer_count; ++j)
+    lease->held()[j].store(0, std::memory_order_relaxed);
+  lease->epoch.fetch_add(1, std::memory_order_relaxed);
+  control->notify_mask.fetch_and(~(1u << idx), std::memory_order_relaxed);
+  control->reader_lease_mask.fetch_and(~(1u << idx), std::memory_order_seq_cst);
+  lease->state.store(kLeaseFree, std::memory_order_release);
+}
+
+bool ShmManager::reap_dead_readers() {
+  auto *control = get_buffer_control();
+  if (!control)
+    return false;
+
+  uint32_t buffer_count = control->buffer_count.load(std::memory_order_acquire);
+  bool reaped = false;
+  uint32_t mask = control->reader_lease_mask.load(std::memory_order_acquire);
+  while (mask) {
+    uint32_t i = __builtin_ctz(mask);
+    mask &= mask - 1;
+    ShmReaderLease *lease = control->get_reader_lease(i, shm_ptr_);
+    if (lease->state.load(std::memory_order_acquire) != kLeaseActive)
+      continue;
+    pid_t pid = lease->pid.load(std::memory_order_relaxed);
+    if (!process_exited(pid, lease->pid_ns.load(std::memory_order_relaxed),
+                        lease->start_time.load(std::memory_order_relaxed)))
+      continue;
+    uint32_t expected = kLeaseActive;
+    if (!lease->state.compare_exchange_strong(expected, kLeaseReclaiming,
+                                              std::memory_order_acq_rel))
+      continue;
+
+    // 持有者已退出，清零其全部持有计数即可恢复被占用的槽位
+    uint32_t holds = 0;
+    for (uint32_t j = 0; j < buffer_count; ++j)
+      holds += lease->held()[j].exchange(0, std::memory_order_relaxed);
+    lease->epoch.fetch_add(1, std::memory_order_relaxed);
+    control->notify_mask.fetch_and(~(1u << i), std::memory_order_relaxed);
+    control->reader_lease_mask.fetch_and(~(1u << i), std::memory_order_seq_cst);
+    lease->state.store(kLeaseFree, std::memory_order_release);
+    if (ShmStatsRegion *stats = control->get_stats(shm_ptr_))
+      stats->reader_leases_reclaimed.fetch_add(1, std::memory_order_relaxed);
+    std::cout << "ShmManager '" << shm_name_ << "': Reclaimed reader lease "
+              << i << " (pid " << pid << " exited, " << holds
+              << " slot holds released)." << std::endl;
+    reaped = true;
+  }
+  if (reaped && control->is_queue_mode()) {
+    control->consume_seq.fetch_add(1, std::memory_order_seq_cst);
+    if (control->producer_waiting.load(std::memory_order_seq_cst))
+      futex_wake_all(&control->consume_seq);
+  }
+  return reaped;
+}
+
+void ShmManager::maybe_reap_dead_readers() {
+  // 写者每次发现槽位被读者占用都可能调用，按时间间隔限流，
+  // 正常情况下只有一次时钟读取，不产生系统调用
+  uint64_t now = monotonic_now_us();
+  uint64_t last = last_reader_reap_us_.load(std::memory_order_relaxed);
+  if (now - last < kReaderReapIntervalUs ||
+      !last_reader_reap_us_.compare_exchange_strong(last, now,
+                                                    std::memory_order_relaxed))
+    return;
+  reap_dead_readers();
+}
+
+bool ShmManager::wait_for_consumer_release(uint32_t seq, int timeout_ms) {
+  auto *control = static_cast<ShmBufferControl *>(shm_ptr_);
+  struct timespec ts;
+  ts.tv_sec = timeout_ms / 1000;
+  ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+
+  control->producer_waiting.store(1, std::memory_order_seq_cst);
+  long ret = futex_wait(&control->consume_seq, seq, &ts);
+  int saved_errno = errno;
+  control->producer_waiting.store(0, std::memory_order_release);
+  return ret == 0 || saved_errno != ETIMEDOUT;
+}
+
+// ========== 兼容性接口实现（内部使用零拷贝实现）==========
+ShmStatus ShmManager::write_and_switch(const void *data, size_t size,
+                                       uint64_t frame_version) {
+  if (!data || size == 0)
+    return ShmStatus::InvalidArguments;
+
+  WriteBufferGuard guard = acquire_write_buffer(size);
+  if (!guard.is_valid()) {
+    // 在单写者模型中，可以简单返回错误，而不是忙等
+    return ShmStatus::AcquireFailed;
+  }
+
+  std::memcpy(guard.get(), data, size);
+
+  uint64_t current_timestamp = monotonic_now_us();
+
+  return guard.commit(size, frame_version, current_timestamp);
+}
+
+ShmStatus ShmManager::try_read_latest(void *data, size_t max_size,
+                                      size_t *actual_size) {
+  if (!data || max_size == 0) {
+    return ShmStatus::InvalidArguments;
+  }
+  ReadBufferGuard guard = acquire_read_buffer();
+  if (!guard.is_valid()) {
+    if (actual_size)
+      *actual_size = 0;
+    return guard.status();
+  }
+  size_t copy_size = std::min(max_size, guard.size());
+  std::memcpy(data, guard.get(), copy_size);
+  if (actual_size)
+    *actual_size = copy_size;
+  return ShmStatus::Success;
+}
+
+ShmStatus ShmManager::wait_and_read(void *data, size_t max_size,
+                                    size_t *actual_size) {
+  while (true) {
+    // 读取前记下最新版本：已有帧却读取失败（槽位恰被覆盖）时等待下一帧，
+    // 而不是立即重试
+    const uint64_t seen_version = get_latest_frame_version();
+    ReadBufferGuard guard = acquire_read_buffer();
+    if (guard.is_valid()) {
+      size_t copy_size = std::min(max_size, guard.size());
+      std::memcpy(data, guard.get(), copy_size);
+      if (actual_size)
+        *actual_size = copy_size;
+      return ShmStatus::Success;
+    }
+    if (guard.status() != ShmStatus::NoDataAvailable &&
+        guard.status() != ShmStatus::Success)
+      return guard.status();
+    // 阻塞在futex上直到有新帧；生产者重启或等待失败时交给调用者处理
+    ShmStatus wait_status = wait_for_new_frame(seen_version, -1);
+    if (wait_status != ShmStatus::Success && wait_status != ShmStatus::Timeout)
+      return wait_status;
+  }
+}
+
+ShmStatus ShmManager::wait_for_new_frame(uint64_t last_version,
+                                         int timeout_ms) {
+  auto *control = get_buffer_control();
+  if (!control)
+    return ShmStatus::NotInitialized;
+
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(timeout_ms > 0 ? timeout_ms : 0);
+
+  while (true) {
+    // 先读取序号再检查版本，避免在检查与等待之间错过唤醒
+    uint32_t seq = control->commit_seq.load(std::memory_order_acquire);
+    if (is_superseded(control))
+      return ShmStatus::ProducerRestarted;
+    if (get_latest_frame_version() > last_version)
+      return ShmStatus::Success;
+    if (timeout_ms == 0)
+      return ShmStatus::Timeout;
+
+    struct timespec ts;
+    struct timespec *ts_ptr = nullptr;
+    if (timeout_ms > 0) {
+      auto remaining = deadline - std::chrono::steady_clock::now();
+      if (remaining <= std::chrono::nanoseconds::zero())
+        return ShmStatus::Timeout;
+      auto ns =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(remaining)
+              .count();
+      ts.tv_sec = ns / 1000000000;
+      ts.tv_nsec = ns % 1000000000;
+      ts_ptr = &ts;
+    }
+
+    control->waiter_count.fetch_add(1, std::memory_order_seq_cst);
+    long ret = futex_wait(&control->commit_seq, seq, ts_ptr);
+    int saved_errno = errno;
+    control->waiter_count.fetch_sub(1, std::memory_order_release);
+
+    if (ret == -1 && saved_errno != EAGAIN && saved_errno != EINTR &&
+        saved_errno != ETIMEDOUT) {
+      errno = saved_errno;
+      log_error("futex wait failed", ShmStatus::AcquireFailed);
+      return ShmStatus::AcquireFailed;
+    }
+  }
+}
+
+// ========== 新帧通知（eventfd） ==========
+// 读者创建 eventfd，经生产者按段名与代数绑定的抽象 unix 数据报套接字（SCM_RIGHTS）
+// 交给生产者，再在 notify_mask 中置位。生产者提交时若位图非空，就在提交路径上
+// 非阻塞地收取新登记、取走位图并逐个写 eventfd，不需要额外线程。
+// 读者处理完通知后重新置位，因此两次处理之间的突发提交只产生一次唤醒。
+
+namespace {
+
+/// 读者随 eventfd 一起发送的登记消息
+struct ShmNotifyRegistration {
+  uint32_t lease_idx;   ///< 读者租约索引
+  uint32_t lease_epoch; ///< 登记时的租约代数
+};
+
+} // namespace
+
+/**
+ * @brief 生成通知套接字地址（抽象命名空间，进程退出后自动消失）
+ * @return socklen_t 地址长度
+ */
+static socklen_t notify_socket_address(const std::string &shm_name,
+                                       uint64_t generation,
+                                       struct sockaddr_un *addr) {
+  std::memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+  // 名称带代数，重启的生产者不会与尚未退出的旧生产者冲突
+  std::string name = "sensorcomm-shm-notify" + shm_name + "." +
+                     std::to_string(generation);
+  size_t length = std::min(name.size(), sizeof(addr->sun_path) - 1);
+  std::memcpy(addr->sun_path + 1, name.data(), length);
+  return static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + 1 +
+                                length);
+}
+
+static void signal_eventfd(int fd) {
+  uint64_t one = 1;
+  ssize_t written = write(fd, &one, sizeof(one));
+  (void)written; // 计数溢出（EAGAIN）时 eventfd 本就可读
+}
+
+void ShmManager::open_notify_socket(ShmBufferControl *control) {
+  std::lock_guard<std::mutex> lock(notify_mutex_);
+  close_notify_targets(false);
+  if (notify_socket_ != -1) {
+    close(notify_socket_);
+    notify_socket_ = -1;
+  }
+  // 读者登记从空表开始，读者会在代数变化后重新登记
+  control->notify_mask.store(0, std::memory_order_seq_cst);
+  notify_requests_seen_ =
+      control->notify_requests.load(std::memory_order_acquire);
+
+  int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  struct sockaddr_un addr;
+  socklen_t addr_len = notify_socket_address(
+      shm_name_, generation_.load(std::memory_order_relaxed), &addr);
+  if (fd == -1 || bind(fd, reinterpret_cast<struct sockaddr *>(&addr),
+                       addr_len) == -1) {
+    log_error("Failed to open frame notification socket, eventfd "
+              "notifications disabled",
+              ShmStatus::AcquireFailed);
+    if (fd != -1)
+      close(fd);
+    return;
+  }
+  notify_socket_ = fd;
+}
+
+void ShmManager::close_notify_targets(bool wake) {
+  // 调用者持有 notify_mutex_
+  for (NotifyTarget &target : notify_targets_) {
+    if (target.fd == -1)
+      continue;
+    if (wake)
+      signal_eventfd(target.fd);
+    close(target.fd);
+    target.fd = -1;
+  }
+}
+
+void ShmManager::receive_notify_registrations(ShmBufferControl *control) {
+  // 调用者持有 notify_mutex_
+  notify_requests_seen_ =
+      control->notify_requests.load(std::memory_order_acquire);
+  while (true) {
+    ShmNotifyRegistration registration;
+    struct iovec iov = {&registration, sizeof(registration)};
+    alignas(struct cmsghdr) char cmsg_buf[CMSG_SPACE(sizeof(int))];
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cmsg_buf;
+    msg.msg_controllen = sizeof(cmsg_buf);
+    ssize_t received =
+        recvmsg(notify_socket_, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+    if (received == -1)
+      break; // EAGAIN：已收完
+    int fd = -1;
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg && cmsg->cmsg_level == SOL_SOCKET &&
+        cmsg->cmsg_type == SCM_RIGHTS)
+      std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(fd));
+    if (fd == -1)
+      continue;
+    if (received != sizeof(registration) ||
+        registration.lease_idx >= ShmBufferControl::MAX_READER_LEASES) {
+      close(fd);
+      continue;
+    }
+    NotifyTarget &target = notify_targets_[registration.lease_idx];
+    if (target.fd != -1)
+      close(target.fd);
+    target.fd = fd;
+    target.epoch = registration.lease_epoch;
+  }
+}
+
+void ShmManager::notify_subscribers(ShmBufferControl *control) {
+  std::lock_guard<std::mutex> lock(notify_mutex_);
+  if (notify_socket_ == -1)
+    return;
+  if (control->notify_requests.load(std::memory_order_acquire) !=
+      notify_requests_seen_)
+    receive_notify_registrations(control);
+
+  uint32_t armed = control->notify_mask.exchange(0, std::memory_order_seq_cst);
+  uint32_t pending = 0;
+  while (armed) {
+    uint32_t idx = static_cast<uint32_t>(__builtin_ctz(armed));
+    armed &= armed - 1;
+    NotifyTarget &target = notify_targets_[idx];
+    ShmReaderLease *lease = control->get_reader_lease(idx, shm_ptr_);
+    uint32_t epoch = lease->epoch.load(std::memory_order_acquire);
+    if (target.fd != -1 && target.epoch != epoch) {
+      // 租约已释放或被回收，登记随之失效
+      close(target.fd);
+      target.fd = -1;
+    }
+    if (target.fd == -1) {
+      // 置位先于登记消息被看到时保留到下一次提交
+      if (lease->state.load(std::memory_order_relaxed) == kLeaseActive)
+        pending |= 1u << idx;
+      continue;
+    }
+    signal_eventfd(target.fd);
+  }
+  if (pending)
+    control->notify_mask.fetch_or(pending, std::memory_order_seq_cst);
+}
+
+ShmStatus ShmManager::register_notify_fd(ShmBufferControl *control) {
+  // 调用者持有 notify_mutex_
+  uint64_t handle;
+  if (!control || !get_reader_lease(&handle))
+    return control ? ShmStatus::BufferInUse : ShmStatus::NotInitialized;
+
+  ShmNotifyRegistration registration = {lease_index(handle),
+                                        lease_epoch(handle)};
+  uint64_t generation = generation_.load(std::memory_order_relaxed);
+  struct sockaddr_un addr;
+  socklen_t addr_len = notify_socket_address(shm_name_, generation, &addr);
+  struct iovec iov = {&registration, sizeof(registration)};
+  alignas(struct cmsghdr) char cmsg_buf[CMSG_SPACE(sizeof(int))];
+  std::memset(cmsg_buf, 0, sizeof(cmsg_buf));
+  struct msghdr msg;
+  std::memset(&msg, 0, sizeof(msg));
+  msg.msg_name = &addr;
+  msg.msg_namelen = addr_len;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = cmsg_buf;
+  msg.msg_controllen = sizeof(cmsg_buf);
+  struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  std::memcpy(CMSG_DATA(cmsg), &notify_fd_, sizeof(int));
+
+  int sock = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  ssize_t sent = sock == -1 ? -1 : sendmsg(sock, &msg, MSG_DONTWAIT);
+  if (sock != -1)
+    close(sock);
+  if (sent != static_cast<ssize_t>(sizeof(registration))) {
+    log_error("Producer did not accept eventfd registration",
+              ShmStatus::AcquireFailed);
+    return ShmStatus::AcquireFailed;
+  }
+  notify_lease_handle_ = handle;
+  notify_generation_ = generation;
+  // 先递增请求序号再置位：写者看到置位时一定会去收取登记消息
+  control->notify_requests.fetch_add(1, std::memory_order_release);
+  control->notify_mask.fetch_or(1u << registration.lease_idx,
+                                std::memory_order_seq_cst);
+  return ShmStatus::Success;
+}
+
+ShmStatus ShmManager::get_notify_fd(int *fd) {
+  if (!fd)
+    return ShmStatus::InvalidArguments;
+  auto *control = get_buffer_control();
+  if (!control)
+    return ShmStatus::NotInitialized;
+
+  std::lock_guard<std::mutex> lock(notify_mutex_);
+  if (notify_fd_ == -1) {
+    notify_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (notify_fd_ == -1) {
+      log_error("Failed to create eventfd", ShmStatus::AcquireFailed);
+      return ShmStatus::AcquireFailed;
+    }
+  }
+  if (notify_generation_ != generation_.load(std::memory_order_relaxed) ||
+      notify_lease_handle_ != lease_handle_.load(std::memory_order_acquire)) {
+    ShmStatus status = register_notify_fd(control);
+    if (status != ShmStatus::Success)
+      return status;
+  }
+  *fd = notify_fd_;
+  return ShmStatus::Success;
+}
+
+void ShmManager::consume_notification() {
+  auto *control = get_buffer_control();
+  std::lock_guard<std::mutex> lock(notify_mutex_);
+  if (!control || notify_fd_ == -1)
+    return;
+  uint64_t count;
+  ssize_t drained = read(notify_fd_, &count, sizeof(count));
+  (void)drained; // 未触发时 EAGAIN
+
+  uint64_t handle = lease_handle_.load(std::memory_order_acquire);
+  if (notify_generation_ != generation_.load(std::memory_order_relaxed) ||
+      notify_lease_handle_ != handle) {
+    register_notify_fd(control);
+    return;
+  }
+  control->notify_mask.fetch_or(1u << lease_index(handle),
+                                std::memory_order_seq_cst);
+}
+
+uint64_t ShmManager::get_latest_frame_version() const {
+  if (!is_mapped())
+    return 0;
+  auto *control = static_cast<ShmBufferControl *>(shm_ptr_);
+  if (!control)
+    return 0;
+
+  uint32_t buffer_count = control->buffer_count.load(std::memory_order_acquire);
+
+  uint64_t max_version = 0;
+  for (uint32_t i = 0; i < buffer_count; ++i) {
+    ShmSlotView slot = control->get_slot(i, shm_ptr_);
+    if (slot.ready->load(std::memory_order_acquire)) {
+      max_version = std::max(
+          max_version, slot.frame_version->load(std::memory_order_acquire));
+    }
+  }
+  return max_version;
+}
+
+// ========== 信息获取接口实现 ==========
+void *ShmManager::get_shm_ptr() const { return is_mapped() ? shm_ptr_ : nullptr; }
+
+size_t ShmManager::get_shm_size() const {
+  return current_shm_size_.load(std::memory_order_acquire);
+}
+
+size_t ShmManager::get_buffer_size() const {
+  return buffer_size_.load(std::memory_order_acquire);
+}
+
+uint32_t ShmManager::get_buffer_count() const {
+  auto *control = get_buffer_control();
+  return control ? control->buffer_count.load(std::memory_order_acquire) : 0;
+}
+
+ShmState ShmManager::get_state() const {
+  return state_.load(std::memory_order_acquire);
+}
+
+bool ShmManager::is_initialized() const { return is_mapped(); }
+
+bool ShmManager::is_mapped() const {
+  ShmState state = state_.load(std::memory_order_acquire);
+  return state == ShmState::Created || state == ShmState::Mapped;
+}
+
+ShmBufferControl *ShmManager::get_buffer_control() const {
+  return is_mapped() ? static_cast<ShmBufferControl *>(shm_ptr_) : nullptr;
+}
+
+void *ShmManager::get_data_buffer(uint32_t buffer_idx) const {
+  if (!is_mapped())
+    return nullptr;
+
+  auto *control = static_cast<ShmBufferControl *>(shm_ptr_);
+  if (!control)
+    return nullptr;
+
+  uint32_t buffer_count = control->buffer_count.load(std::memory_order_acquire);
+  if (buffer_idx >= buffer_count)
+    return nullptr;
 
   char *base = static_cast<char *>(shm_ptr_);
   size_t data_offset = ShmBufferControl::get_data_buffers_offset(buffer_count);
-  return base + data_offset +
-         buffer_idx * buffer_size_.load(std::memory_order_acquire);
+  if (control->is_byte_ring()) {
+    // 描述符中的偏移由写者在持有认领时写入，读者认领后读取即可见
+    return base + data_offset +
+           control->get_slot(buffer_idx, shm_ptr_)
+               .data_offset->load(std::memory_order_acquire);
+  }
+  size_t stride = ShmBufferControl::get_buffer_stride(
+      buffer_size_.load(std::memory_order_acquire));
+  return base + data_offset + buffer_idx * stride;
 }
 
 uint64_t ShmManager::get_frame_version(uint32_t buffer_idx) const {
-  std::lock_guard<std::mutex> lock(state_mutex_);
-  if (state_ != ShmState::Created && state_ != ShmState::Mapped)
-    return 0;
-  auto *control = static_cast<ShmBufferControl *>(shm_ptr_);
+  auto *control = get_buffer_control();
   if (!control)
     return 0;
   return control->get_frame_version(buffer_idx, shm_ptr_);
 }
 
 // ========== 内部零拷贝实现方法 ==========
+//
+// 无锁协议：buffer_reader_count[i] 作为槽位的写者认领字。
+// - 写者通过 CAS(0 -> WRITER_BIT) 独占空闲槽位，提交或放弃时清零；
+// - 读者把持有登记在自己的租约 held()[i] 中（seq_cst），再检查
+//   WRITER_BIT；写者 CAS 置位后（seq_cst）再检查所有已激活租约的 held()[i]。
+//   两侧都是"先写自己的字、再读对方的字"，至少有一方能看到另一方并退让，
+//   因此读者不可能读到正在写入的槽位。读者进程崩溃时遗留的只是它自己的
+//   租约，写者确认 pid 失效后整条清除即可。
+// 整个快速路径不涉及任何互斥锁。
+static constexpr int kMaxClaimRetries = 64; ///< 认领竞争时的最大重试次数
+
+uint32_t ShmManager::select_write_slot(uint64_t min_cursor, bool *consumed,
+                                       uint64_t *version, bool *reader_held,
+                                       const uint8_t *pins) const {
+  auto *control = static_cast<ShmBufferControl *>(shm_ptr_);
+  uint32_t buffer_count = control->buffer_count.load(std::memory_order_acquire);
+
+  uint32_t write_idx = -1;
+  uint64_t min_version = 0;
+  bool write_idx_consumed = false;
+  *reader_held = false;
+
+  for (uint32_t i = 0; i < buffer_count; ++i) {
+    ShmSlotView slot = control->get_slot(i, shm_ptr_);
+    if (slot.reader_count->load(std::memory_order_relaxed) != 0)
+      continue;
+    if (pins ? pins[i] != 0 : control->count_slot_readers(i, shm_ptr_) != 0) {
+      *reader_held = true;
+      continue;
+    }
+    uint64_t current_version =
+        slot.frame_version->load(std::memory_order_acquire);
+    bool slot_consumed = !slot.ready->load(std::memory_order_acquire) ||
+                         current_version < min_cursor;
+    // 优先选择已被所有消费者读过的槽位，其次才是最旧的未读槽位
+    if (write_idx == (uint32_t)-1 ||
+        (slot_consumed && !write_idx_consumed) ||
+        (slot_consumed == write_idx_consumed &&
+         current_version < min_version)) {
+      min_version = current_version;
+      write_idx = i;
+      write_idx_consumed = slot_consumed;
+    }
+  }
+
+  *consumed = write_idx_consumed;
+  *version = min_version;
+  return write_idx;
+}
+
+void ShmManager::account_overwrite(uint64_t frame_version) {
+  auto *control = static_cast<ShmBufferControl *>(shm_ptr_);
+  // 覆盖未读帧：为每个尚未读到该帧的消费者累计丢帧
+  for (uint32_t i = 0; i < ShmBufferControl::MAX_CONSUMERS; ++i) {
+    ShmConsumerCursor *cursor = control->get_consumer(i, shm_ptr_);
+    if (cursor->active.load(std::memory_order_acquire) == kCursorActive &&
+        cursor->next_version.load(std::memory_order_acquire) <= frame_version)
+      cursor->frames_dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+// 段内计数：写者认领到仍持有已提交帧、且该帧从未被读取过的槽位时，
+// 计为一次"未读即覆盖"。reads_since_commit 由读者认领成功后递增，
+// 写者提交时清零（此时写者独占槽位，不会与读者竞争）。
+static void account_unread_overwrite(ShmStatsRegion *stats,
+                                     const ShmSlotView &slot) {
+  if (stats && slot.ready->load(std::memory_order_relaxed) &&
+      slot.meta->reads_since_commit.load(std::memory_order_relaxed) == 0)
+    stats->frames_overwritten_unread.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ShmManager::account_write_failure() {
+  auto *control = get_buffer_control();
+  ShmStatsRegion *stats = control ? control->get_stats(shm_ptr_) : nullptr;
+  if (stats)
+    stats->write_acquire_failures.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ShmManager::account_read_miss() {
+  auto *control = get_buffer_control();
+  ShmStatsRegion *stats = control ? control->get_stats(shm_ptr_) : nullptr;
+  if (stats)
+    stats->read_misses.fetch_add(1, std::memory_order_relaxed);
+}
+
 void *ShmManager::internal_acquire_write_buffer(size_t expected_size,
-                                                uint32_t *buffer_idx) {
-  std::lock_guard<std::mutex> lock(state_mutex_);
-  if (state_ != ShmState::Created && state_ != ShmState::Mapped)
+                                                uint32_t *buffer_idx,
+                                                size_t *capacity) {
+  if (!is_mapped())
     return nullptr;
   if (expected_size > buffer_size_.load(std::memory_order_acquire))
     return nullptr;
@@ -448,90 +1910,585 @@ void *ShmManager::internal_acquire_write_buffer(size_t expected_size,
   if (!control)
     return nullptr;
 
+  if (control->is_byte_ring())
+    return acquire_arena_buffer(expected_size, buffer_idx, capacity);
+
+  bool queue_mode = control->is_queue_mode();
+  bool block_producer =
+      queue_mode && control->overflow_policy ==
+                        static_cast<uint32_t>(ShmOverflowPolicy::BlockProducer);
+  auto block_deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(kProducerBlockTimeoutMs);
+
+  int attempt = 0;
+  bool reaped = false;
+  while (attempt < kMaxClaimRetries) {
+    // 先读取消费序号再扫描，避免在扫描与等待之间错过读者的释放
+    uint32_t consume_seq =
+        queue_mode ? control->consume_seq.load(std::memory_order_acquire) : 0;
+    // 队列模式下版本号不小于最慢游标的帧尚有消费者未读，应尽量保留
+    uint64_t min_cursor = queue_mode ? get_min_consumer_cursor() : UINT64_MAX;
+
+    bool write_idx_consumed = false;
+    uint64_t min_version = 0;
+    bool reader_held = false;
+    uint32_t write_idx = select_write_slot(min_cursor, &write_idx_consumed,
+                                           &min_version, &reader_held);
+
+    if (write_idx == (uint32_t)-1) {
+      // 全部槽位被占用：回收已退出读者的租约后重试一次
+      if (reader_held && !reaped && reap_dead_readers()) {
+        reaped = true;
+        continue;
+      }
+      return nullptr;
+    }
+    if (reader_held)
+      maybe_reap_dead_readers();
+
+    if (!write_idx_consumed && block_producer) {
+      // 环形缓冲区已满：等待最慢的消费者释放槽位
+      auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           block_deadline - std::chrono::steady_clock::now())
+                           .count();
+      if (remaining <= 0 ||
+          !wait_for_consumer_release(consume_seq, static_cast<int>(remaining))) {
+        reap_dead_consumers();
+        return nullptr;
+      }
+      continue;
+    }
+
+    ShmSlotView slot = control->get_slot(write_idx, shm_ptr_);
+    uint32_t expected = 0;
+    if (!slot.reader_count->compare_exchange_strong(
+            expected, ShmBufferControl::WRITER_BIT, std::memory_order_seq_cst,
+            std::memory_order_relaxed)) {
+      ++attempt;
+      continue; // 扫描后被读者抢先认领，重新选择
+    }
+    if (control->count_slot_readers(write_idx, shm_ptr_) != 0) {
+      slot.reader_count->store(0, std::memory_order_release);
+      ++attempt;
+      continue; // 置位前已有读者登记租约，重新选择
+    }
+
+    if (!write_idx_consumed && queue_mode)
+      account_overwrite(min_version);
+    account_unread_overwrite(control->get_stats(shm_ptr_), slot);
+
+    slot.ready->store(false, std::memory_order_relaxed);
+    *buffer_idx = write_idx;
+    *capacity = buffer_size_.load(std::memory_order_acquire);
+    return get_data_buffer(write_idx);
+  }
+  return nullptr;
+}
+
+const uint8_t *ShmManager::snapshot_slot_pins(uint32_t buffer_count) {
+  auto *control = static_cast<ShmBufferControl *>(shm_ptr_);
+  // 每条已激活租约顺序读一遍持有计数数组，代价与检查一个槽位相同量级的
+  // 租约数乘以缓冲区数，而不是每个候选位置、每个描述符各查一遍
+  arena_pins_.assign(buffer_count, 0);
+  uint32_t mask = control->reader_lease_mask.load(std::memory_order_seq_cst);
+  while (mask) {
+    uint32_t l = __builtin_ctz(mask);
+    mask &= mask - 1;
+    std::atomic<uint8_t> *held = control->get_reader_lease(l, shm_ptr_)->held();
+    for (uint32_t i = 0; i < buffer_count; ++i)
+      arena_pins_[i] |= held[i].load(std::memory_order_seq_cst);
+  }
+  return arena_pins_.data();
+}
+
+// 字节环分配：槽位仅作为帧描述符，数据按实际大小从环头顺序分配。
+// 新区域与旧帧重叠时淘汰旧帧（写者认领其描述符后清除就绪标志）；
+// 被读者或其他未提交写入占用的区域不能淘汰，分配起点跳过该区域。
+void *ShmManager::acquire_arena_buffer(size_t expected_size,
+                                       uint32_t *buffer_idx,
+                                       size_t *capacity) {
+  auto *control = static_cast<ShmBufferControl *>(shm_ptr_);
   uint32_t buffer_count = control->buffer_count.load(std::memory_order_acquire);
-  auto *buffer_reader_count = control->get_buffer_reader_count_array(shm_ptr_);
-  auto *frame_version = control->get_frame_version_array(shm_ptr_);
-  auto *buffer_ready = control->get_buffer_ready_array(shm_ptr_);
+  uint64_t arena_size = control->arena_size;
+  uint64_t need = ShmBufferControl::align_up(
+      std::max<size_t>(expected_size, 1), ShmBufferControl::ARENA_ALIGN);
+  if (need > arena_size)
+    return nullptr;
 
-  uint32_t write_idx = -1;
-  uint64_t min_version = 0;
+  bool queue_mode = control->is_queue_mode();
+  bool block_producer =
+      queue_mode && control->overflow_policy ==
+                        static_cast<uint32_t>(ShmOverflowPolicy::BlockProducer);
+  auto block_deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(kProducerBlockTimeoutMs);
+
+  int attempt = 0;
+  bool reaped = false;
+  while (attempt < kMaxClaimRetries) {
+    uint32_t consume_seq =
+        queue_mode ? control->consume_seq.load(std::memory_order_acquire) : 0;
+    uint64_t min_cursor = queue_mode ? get_min_consumer_cursor() : UINT64_MAX;
+
+    // 读者持有按租约一次性汇总到各描述符，描述符选择与候选位置查找
+    // 都只读这份快照，不再逐个描述符遍历租约（认领后仍逐个复核）
+    const uint8_t *pins = snapshot_slot_pins(buffer_count);
+    bool desc_consumed = false;
+    uint64_t desc_version = 0;
+    bool reader_held = false;
+    uint32_t desc_idx = select_write_slot(min_cursor, &desc_consumed,
+                                          &desc_version, &reader_held, pins);
+    if (desc_idx == (uint32_t)-1) {
+      if (reader_held && !reaped && reap_dead_readers()) {
+        reaped = true;
+        continue;
+      }
+      return nullptr;
+    }
+    if (reader_held)
+      maybe_reap_dead_readers();
+
+    arena_busy_.clear();
+    arena_unread_.clear();
+    for (uint32_t i = 0; i < buffer_count; ++i) {
+      if (i == desc_idx)
+        continue;
+      ShmSlotView slot = control->get_slot(i, shm_ptr_);
+      uint32_t claim = slot.reader_count->load(std::memory_order_acquire);
+      bool ready = slot.ready->load(std::memory_order_acquire);
+      if (!ready && !(claim & ShmBufferControl::WRITER_BIT))
+        continue; // 描述符空闲，其数据区已失效
+      ArenaSpan span;
+      span.begin = slot.data_offset->load(std::memory_order_acquire);
+      span.end = span.begin + slot.data_capacity->load(std::memory_order_acquire);
+      span.unread = slot.frame_version->load(std::memory_order_acquire) >=
+                    min_cursor;
+      if (claim != 0 || pins[i] != 0)
+        arena_busy_.push_back(span);
+      else if (span.unread)
+        arena_unread_.push_back(span);
+    }
+    // 被占用的通常只有读者正持有的几帧；有效数据区互不重叠，按起始偏移
+    // 排序后结束偏移同样有序，候选位置沿数组单向推进
+    std::sort(arena_busy_.begin(), arena_busy_.end(),
+              [](const ArenaSpan &a, const ArenaSpan &b) {
+                return a.begin < b.begin;
+              });
+
+    // 从环头开始寻找不与被占用区域重叠的位置，最多回绕一次
+    uint64_t offset = control->arena_head;
+    bool wrapped = false;
+    bool found = false;
+    size_t k = 0;
+    while (true) {
+      if (offset + need > arena_size) {
+        if (wrapped)
+          break;
+        offset = 0;
+        wrapped = true;
+        k = 0;
+      }
+      while (k < arena_busy_.size() && arena_busy_[k].end <= offset)
+        ++k;
+      if (k == arena_busy_.size() || arena_busy_[k].begin >= offset + need) {
+        found = true;
+        break;
+      }
+      offset = arena_busy_[k].end;
+    }
+    bool unread_overlap = false;
+    for (const ArenaSpan &span : arena_unread_)
+      if (span.end > offset && span.begin < offset + need)
+        unread_overlap = true;
+    if (!found) {
+      // 数据区被读者全部占用：回收已退出读者的租约后重试一次
+      if (!reaped && reap_dead_readers()) {
+        reaped = true;
+        continue;
+      }
+      return nullptr;
+    }
 
-  for (uint32_t i = 0; i < buffer_count; ++i) {
-    if (buffer_reader_count[i].load(std::memory_order_acquire) == 0) {
-      uint64_t current_version =
-          frame_version[i].load(std::memory_order_acquire);
-      if (write_idx == (uint32_t)-1 || current_version < min_version) {
-        min_version = current_version;
-        write_idx = i;
+    if ((unread_overlap || !desc_consumed) && block_producer) {
+      auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           block_deadline - std::chrono::steady_clock::now())
+                           .count();
+      if (remaining <= 0 ||
+          !wait_for_consumer_release(consume_seq, static_cast<int>(remaining))) {
+        reap_dead_consumers();
+        return nullptr;
       }
+      continue;
+    }
+
+    ShmSlotView desc = control->get_slot(desc_idx, shm_ptr_);
+    uint32_t expected = 0;
+    if (!desc.reader_count->compare_exchange_strong(
+            expected, ShmBufferControl::WRITER_BIT, std::memory_order_seq_cst,
+            std::memory_order_relaxed)) {
+      ++attempt;
+      continue;
+    }
+    if (control->count_slot_readers(desc_idx, shm_ptr_) != 0) {
+      desc.reader_count->store(0, std::memory_order_release);
+      ++attempt;
+      continue;
+    }
+    if (!desc_consumed && queue_mode &&
+        desc.ready->load(std::memory_order_relaxed))
+      account_overwrite(desc_version);
+    ShmStatsRegion *stats = control->get_stats(shm_ptr_);
+    account_unread_overwrite(stats, desc);
+    desc.ready->store(false, std::memory_order_relaxed);
+
+    // 淘汰与新区域重叠的旧帧
+    bool evicted_all = true;
+    for (uint32_t i = 0; i < buffer_count; ++i) {
+      if (i == desc_idx)
+        continue;
+      ShmSlotView slot = control->get_slot(i, shm_ptr_);
+      if (!slot.ready->load(std::memory_order_acquire))
+        continue;
+      uint64_t begin = slot.data_offset->load(std::memory_order_acquire);
+      uint64_t end =
+          begin + slot.data_capacity->load(std::memory_order_acquire);
+      if (end <= offset || begin >= offset + need)
+        continue;
+      uint32_t free_claim = 0;
+      if (!slot.reader_count->compare_exchange_strong(
+              free_claim, ShmBufferControl::WRITER_BIT,
+              std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        evicted_all = false; // 扫描后被读者认领
+        break;
+      }
+      if (control->count_slot_readers(i, shm_ptr_) != 0) {
+        slot.reader_count->store(0, std::memory_order_release);
+        evicted_all = false;
+        break;
+      }
+      uint64_t version = slot.frame_version->load(std::memory_order_relaxed);
+      if (queue_mode && version >= min_cursor)
+        account_overwrite(version);
+      account_unread_overwrite(stats, slot);
+      slot.ready->store(false, std::memory_order_relaxed);
+      slot.data_capacity->store(0, std::memory_order_relaxed);
+      slot.reader_count->store(0, std::memory_order_release);
+    }
+    if (!evicted_all) {
+      desc.reader_count->store(0, std::memory_order_release);
+      ++attempt;
+      continue;
     }
+
+    desc.data_offset->store(offset, std::memory_order_relaxed);
+    desc.data_capacity->store(need, std::memory_order_relaxed);
+    control->arena_head = offset + need;
+    *buffer_idx = desc_idx;
+    *capacity = need;
+    return get_data_buffer(desc_idx);
   }
+  return nullptr;
+}
 
-  if (write_idx == (uint32_t)-1)
-    return nullptr;
+bool ShmManager::claim_read_slot(ShmSlotView &slot, ShmReaderLease *lease,
+                                 uint32_t buffer_idx) {
+  // 先登记持有再检查写者认领位，与写者"先置位再检查租约"配对
+  // 持有计数只有 8 位：共享本实例的多个线程可能同时接近上限，
+  // 检查与递增必须是同一次 CAS，否则计数回绕为 0，写者会误认槽位空闲
+  std::atomic<uint8_t> &held = lease->held()[buffer_idx];
+  uint8_t count = held.load(std::memory_order_relaxed);
+  do {
+    if (count == UINT8_MAX)
+      return false; // 本实例对该槽位的持有数已达上限
+  } while (!held.compare_exchange_weak(count, count + 1,
+                                       std::memory_order_seq_cst,
+                                       std::memory_order_relaxed));
+  if (slot.reader_count->load(std::memory_order_seq_cst) &
+      ShmBufferControl::WRITER_BIT) {
+    held.fetch_sub(1, std::memory_order_release);
+    return false;
+  }
+  return true;
+}
 
-  buffer_ready[write_idx].store(false, std::memory_order_release);
-  *buffer_idx = write_idx;
-  return get_data_buffer_nolock(write_idx);
+void ShmManager::drop_read_claim(ShmReaderLease *lease, uint32_t buffer_idx) {
+  lease->held()[buffer_idx].fetch_sub(1, std::memory_order_release);
+}
+
+void ShmManager::account_read(ShmBufferControl *control, ShmSlotView &slot,
+                              uint64_t lag) {
+  ShmStatsRegion *stats = control->get_stats(shm_ptr_);
+  if (!stats)
+    return;
+  slot.meta->reads_since_commit.fetch_add(1, std::memory_order_relaxed);
+  stats->reads.fetch_add(1, std::memory_order_relaxed);
+  stats->lag_total.fetch_add(lag, std::memory_order_relaxed);
+  ShmStatsRegion::update_max(stats->lag_max, lag);
+  stats->lag_hist[ShmStatsRegion::log2_bucket(lag, ShmStatsRegion::LAG_BUCKETS)]
+      .fetch_add(1, std::memory_order_relaxed);
 }
 
 const void *ShmManager::internal_acquire_read_buffer(size_t *data_size,
                                                      uint64_t *frame_version,
                                                      uint64_t *timestamp_us,
                                                      uint32_t *buffer_idx,
-                                                     ShmStatus *status) {
-  std::lock_guard<std::mutex> lock(state_mutex_);
+                                                     ShmStatus *status,
+                                                     uint32_t consumer_id,
+                                                     uint64_t *lease_handle) {
   *status = ShmStatus::Success;
-  auto *control = static_cast<ShmBufferControl *>(shm_ptr_);
-  if (!control || (state_ != ShmState::Created && state_ != ShmState::Mapped)) {
+  auto *control = get_buffer_control();
+  if (!control) {
     *status = ShmStatus::NotInitialized;
     return nullptr;
   }
 
+  // 读者通过本实例的租约登记持有
+  ShmReaderLease *lease = get_reader_lease(lease_handle);
+  if (!lease) {
+    *status = ShmStatus::BufferInUse;
+    return nullptr;
+  }
+
+  ShmConsumerCursor *cursor = nullptr;
+  if (consumer_id != ShmBufferControl::NO_CONSUMER) {
+    cursor = get_active_consumer(consumer_id);
+    if (!cursor) {
+      *status = ShmStatus::InvalidArguments;
+      return nullptr;
+    }
+  }
+  bool skip_to_latest =
+      control->overflow_policy ==
+      static_cast<uint32_t>(ShmOverflowPolicy::SkipToLatest);
+
   uint32_t buffer_count = control->buffer_count.load(std::memory_order_acquire);
-  auto *buffer_ready = control->get_buffer_ready_array(shm_ptr_);
-  auto *frame_version_array = control->get_frame_version_array(shm_ptr_);
-  auto *buffer_reader_count = control->get_buffer_reader_count_array(shm_ptr_);
-  auto *buffer_data_size = control->get_buffer_data_size_array(shm_ptr_);
-  auto *timestamp_us_array = control->get_timestamp_us_array(shm_ptr_);
 
-  uint32_t latest_idx = -1;
-  uint64_t max_version = 0;
+  for (int attempt = 0; attempt < kMaxClaimRetries; ++attempt) {
+    // 未注册读者取最新帧；已注册消费者取不小于游标的最旧帧
+    uint64_t next_version =
+        cursor ? cursor->next_version.load(std::memory_order_acquire) : 0;
+    uint32_t latest_idx = -1;
+    uint32_t oldest_idx = -1;
+    uint64_t max_version = 0;
+    uint64_t min_version = 0;
+    uint64_t pending = 0;
+
+    // 扫描期间写者可能先后提交 v 与 v+1，扫描可能只看到后者。
+    // 已注册消费者发现游标之后出现空缺时再扫描一次：看到 v+1 即保证
+    // v 的提交已可见，第二次扫描仍找不到的帧才是真正被覆盖的。
+    for (int scan = 0; scan < 2; ++scan) {
+      latest_idx = oldest_idx = -1;
+      max_version = min_version = pending = 0;
+      for (uint32_t i = 0; i < buffer_count; ++i) {
+        ShmSlotView slot = control->get_slot(i, shm_ptr_);
+        if (slot.ready->load(std::memory_order_acquire)) {
+          uint64_t current_version =
+              slot.frame_version->load(std::memory_order_acquire);
+          if (current_version < next_version)
+            continue;
+          ++pending;
+          if (latest_idx == (uint32_t)-1 || current_version > max_version) {
+            max_version = current_version;
+            latest_idx = i;
+          }
+          if (oldest_idx == (uint32_t)-1 || current_version < min_version) {
+            min_version = current_version;
+            oldest_idx = i;
+          }
+        }
+      }
+      if (!cursor || latest_idx == (uint32_t)-1 || min_version <= next_version)
+        break;
+    }
 
-  for (uint32_t i = 0; i < buffer_count; ++i) {
-    if (buffer_ready[i].load(std::memory_order_acquire)) {
-      uint64_t current_version =
-          frame_version_array[i].load(std::memory_order_acquire);
-      if (latest_idx == (uint32_t)-1 || current_version > max_version) {
-        max_version = current_version;
-        latest_idx = i;
+    if (latest_idx == (uint32_t)-1) {
+      *status = ShmStatus::NoDataAvailable;
+      return nullptr;
+    }
+
+    uint32_t read_idx = latest_idx;
+    uint64_t read_version = max_version;
+    uint64_t skipped = 0;
+    if (cursor) {
+      read_idx = oldest_idx;
+      read_version = min_version;
+      // 游标处的帧已被覆盖：SkipToLatest 策略下直接追到最新帧
+      if (skip_to_latest && min_version > next_version) {
+        read_idx = latest_idx;
+        read_version = max_version;
+        skipped = pending - 1;
       }
     }
-  }
 
-  if (latest_idx == (uint32_t)-1) {
-    *status = ShmStatus::NoDataAvailable;
-    return nullptr;
+    // 认领：写者持有槽位时放弃，重新扫描
+    ShmSlotView slot = control->get_slot(read_idx, shm_ptr_);
+    if (!claim_read_slot(slot, lease, read_idx))
+      continue;
+
+    // 认领后复查：槽位可能在扫描与认领之间被重写
+    if (!slot.ready->load(std::memory_order_acquire) ||
+        (cursor &&
+         slot.frame_version->load(std::memory_order_acquire) != read_version)) {
+      drop_read_claim(lease, read_idx);
+      continue;
+    }
+
+    // 读取时落后最新帧的帧数：最新帧模式下反映扫描期间的新提交，
+    // 队列模式下反映消费者积压
+    account_read(control, slot,
+                 max_version > read_version ? max_version - read_version : 0);
+
+    *buffer_idx = read_idx;
+    *data_size = slot.data_size->load(std::memory_order_acquire);
+    *timestamp_us = slot.timestamp_us->load(std::memory_order_acquire);
+    *frame_version = slot.frame_version->load(std::memory_order_acquire);
+
+    if (cursor) {
+      cursor->next_version.store(read_version + 1, std::memory_order_release);
+      cursor->frames_consumed.fetch_add(1, std::memory_order_relaxed);
+      if (skipped)
+        cursor->frames_dropped.fetch_add(skipped, std::memory_order_relaxed);
+    }
+
+    return get_data_buffer(read_idx);
   }
 
-  buffer_reader_count[latest_idx].fetch_add(1, std::memory_order_acquire);
-  *buffer_idx = latest_idx;
-  *data_size = buffer_data_size[latest_idx].load(std::memory_order_acquire);
-  *timestamp_us =
-      timestamp_us_array[latest_idx].load(std::memory_order_acquire);
-  *frame_version = max_version;
+  *status = ShmStatus::AcquireFailed;
+  return nullptr;
+}
+
+ShmStatus ShmManager::acquire_read_batch(uint32_t k,
+                                         std::vector<ReadBufferGuard> *frames) {
+  if (!frames || k == 0)
+    return ShmStatus::InvalidArguments;
+  frames->clear();
+  auto *control = get_buffer_control();
+  if (!control)
+    return ShmStatus::NotInitialized;
+
+  uint64_t lease_handle = 0;
+  ShmReaderLease *lease = get_reader_lease(&lease_handle);
+  if (!lease)
+    return ShmStatus::BufferInUse;
+
+  uint32_t buffer_count = control->buffer_count.load(std::memory_order_acquire);
+  // 至少为写者保留一个槽位，否则读者固定全部槽位时写者无法提交
+  k = std::min(k, buffer_count > 1 ? buffer_count - 1 : 1u);
+
+  struct Candidate {
+    uint64_t version;
+    uint32_t idx;
+  };
+  std::vector<Candidate> ready;
+  ready.reserve(buffer_count);
+
+  for (int attempt = 0; attempt < kMaxClaimRetries; ++attempt) {
+    uint32_t seq = control->commit_seq.load(std::memory_order_acquire);
+    ready.clear();
+    for (uint32_t i = 0; i < buffer_count; ++i) {
+      ShmSlotView slot = control->get_slot(i, shm_ptr_);
+      if (slot.ready->load(std::memory_order_acquire))
+        ready.push_back(
+            {slot.frame_version->load(std::memory_order_acquire), i});
+    }
+    if (ready.empty()) {
+      account_read_miss();
+      return ShmStatus::NoDataAvailable;
+    }
+
+    // 版本降序，前 n 个即最近的 n 帧
+    std::sort(ready.begin(), ready.end(),
+              [](const Candidate &a, const Candidate &b) {
+                return a.version > b.version;
+              });
+    size_t n = std::min<size_t>(k, ready.size());
+    size_t pinned = 0;
+    bool consistent = true;
+    for (; pinned < n; ++pinned) {
+      ShmSlotView slot = control->get_slot(ready[pinned].idx, shm_ptr_);
+      if (!claim_read_slot(slot, lease, ready[pinned].idx)) {
+        consistent = false;
+        break;
+      }
+      if (!slot.ready->load(std::memory_order_acquire) ||
+          slot.frame_version->load(std::memory_order_acquire) !=
+              ready[pinned].version) {
+        drop_read_claim(lease, ready[pinned].idx);
+        consistent = false;
+        break;
+      }
+    }
+
+    // 扫描到固定完成期间没有新提交即为完整快照（单写者按序递增提交序号）。
+    // 写者持续快于扫描时，最后一次尝试接受下方复查通过的结果
+    if (consistent && attempt + 1 < kMaxClaimRetries &&
+        control->commit_seq.load(std::memory_order_acquire) != seq)
+      consistent = false;
+
+    // 复查：扫描期间写者可能先后提交 v 与 v+1 而扫描只看到后者，
+    // 固定区间内出现未固定的帧即说明快照不完整
+    uint64_t newest = ready[0].version, oldest = ready[n - 1].version;
+    for (uint32_t i = 0; consistent && i < buffer_count; ++i) {
+      ShmSlotView slot = control->get_slot(i, shm_ptr_);
+      if (!slot.ready->load(std::memory_order_acquire))
+        continue;
+      uint64_t version = slot.frame_version->load(std::memory_order_acquire);
+      if (version <= oldest || version >= newest)
+        continue;
+      bool is_pinned = false;
+      for (size_t j = 0; j < n && !is_pinned; ++j)
+        is_pinned = ready[j].idx == i;
+      consistent = is_pinned;
+    }
+
+    if (!consistent) {
+      for (size_t j = 0; j < pinned; ++j) {
+        ShmSlotView slot = control->get_slot(ready[j].idx, shm_ptr_);
+        drop_read_claim(lease, ready[j].idx);
+      }
+      continue;
+    }
+
+    uint64_t now_us = monotonic_now_us();
+    frames->reserve(n);
+    for (size_t j = n; j-- > 0;) {
+      uint32_t idx = ready[j].idx;
+      ShmSlotView slot = control->get_slot(idx, shm_ptr_);
+      account_read(control, slot, newest - ready[j].version);
+      ReadBufferGuard guard(nullptr);
+      guard.manager_ = this;
+      guard.buffer_ = get_data_buffer(idx);
+      guard.size_ = slot.data_size->load(std::memory_order_acquire);
+      guard.frame_version_ = ready[j].version;
+      guard.timestamp_us_ = slot.timestamp_us->load(std::memory_order_acquire);
+      guard.buffer_idx_ = idx;
+      guard.acquire_us_ = now_us;
+      guard.lease_handle_ = lease_handle;
+      frames->push_back(std::move(guard));
+    }
+    return ShmStatus::Success;
+  }
 
-  return get_data_buffer_nolock(latest_idx);
+  account_read_miss();
+  return ShmStatus::AcquireFailed;
 }
 
 void ShmManager::internal_release_write_buffer(uint32_t buffer_idx) {
-  std::lock_guard<std::mutex> lock(state_mutex_);
-  if (state_ != ShmState::Created && state_ != ShmState::Mapped)
+  auto *control = get_buffer_control();
+  if (!control)
     return;
-  auto *control = static_cast<ShmBufferControl *>(shm_ptr_);
   uint32_t buffer_count = control->buffer_count.load(std::memory_order_acquire);
-  if (control && buffer_idx < buffer_count) {
-    // 在单写者模型中，此函数体可以为空
+  if (buffer_idx < buffer_count) {
+    ShmSlotView slot = control->get_slot(buffer_idx, shm_ptr_);
+    if (control->is_byte_ring()) {
+      // 放弃的是最近一次分配时归还数据区，否则留待环头绕回时覆盖
+      uint64_t begin = slot.data_offset->load(std::memory_order_relaxed);
+      if (control->arena_head ==
+          begin + slot.data_capacity->load(std::memory_order_relaxed))
+        control->arena_head = begin;
+      slot.data_capacity->store(0, std::memory_order_relaxed);
+    }
+    // 未提交：buffer_ready 保持 false，仅释放写者认领
+    slot.reader_count->store(0, std::memory_order_release);
   }
 }
 
@@ -539,45 +2496,84 @@ ShmStatus ShmManager::internal_commit_write_buffer(uint32_t buffer_idx,
                                                    size_t actual_size,
                                                    uint64_t frame_version,
                                                    uint64_t timestamp_us) {
-  std::lock_guard<std::mutex> lock(state_mutex_);
-  if (state_ != ShmState::Created && state_ != ShmState::Mapped)
-    return ShmStatus::NotInitialized;
-
-  auto *control = static_cast<ShmBufferControl *>(shm_ptr_);
+  auto *control = get_buffer_control();
   if (!control)
-    return ShmStatus::InvalidArguments;
+    return ShmStatus::NotInitialized;
 
   uint32_t buffer_count = control->buffer_count.load(std::memory_order_acquire);
   if (buffer_idx >= buffer_count)
     return ShmStatus::InvalidArguments;
 
-  auto *buffer_data_size = control->get_buffer_data_size_array(shm_ptr_);
-  auto *timestamp_us_array = control->get_timestamp_us_array(shm_ptr_);
-  auto *frame_version_array = control->get_frame_version_array(shm_ptr_);
-  auto *buffer_ready = control->get_buffer_ready_array(shm_ptr_);
-
-  buffer_data_size[buffer_idx].store(actual_size, std::memory_order_release);
-  timestamp_us_array[buffer_idx].store(timestamp_us, std::memory_order_release);
-  frame_version_array[buffer_idx].store(frame_version,
-                                        std::memory_order_release);
-  buffer_ready[buffer_idx].store(true, std::memory_order_release);
+  ShmSlotView slot = control->get_slot(buffer_idx, shm_ptr_);
+  if (control->is_byte_ring()) {
+    // 按实际提交大小收缩预留区域，只有最近一次分配可以回退环头
+    uint64_t begin = slot.data_offset->load(std::memory_order_relaxed);
+    uint64_t reserved = slot.data_capacity->load(std::memory_order_relaxed);
+    uint64_t used = ShmBufferControl::align_up(
+        std::max<size_t>(actual_size, 1), ShmBufferControl::ARENA_ALIGN);
+    if (used < reserved) {
+      if (control->arena_head == begin + reserved)
+        control->arena_head = begin + used;
+      slot.data_capacity->store(used, std::memory_order_relaxed);
+    }
+  }
+  slot.data_size->store(actual_size, std::memory_order_release);
+  slot.timestamp_us->store(timestamp_us, std::memory_order_release);
+  slot.frame_version->store(frame_version, std::memory_order_release);
+  ShmStatsRegion *stats = control->get_stats(shm_ptr_);
+  if (stats) {
+    slot.meta->reads_since_commit.store(0, std::memory_order_relaxed);
+    stats->frames_committed.fetch_add(1, std::memory_order_relaxed);
+    stats->bytes_committed.fetch_add(actual_size, std::memory_order_relaxed);
+  }
+  slot.ready->store(true, std::memory_order_release);
+  // 释放写者认领，此后读者才能认领该槽位
+  slot.reader_count->store(0, std::memory_order_release);
+
+  // 递增提交序号，仅在有等待者时才进入内核唤醒
+  control->commit_seq.fetch_add(1, std::memory_order_seq_cst);
+  if (control->waiter_count.load(std::memory_order_seq_cst) > 0)
+    futex_wake_all(&control->commit_seq);
+  // 仅在有读者等待 eventfd 通知时才加锁写 eventfd
+  if (control->notify_mask.load(std::memory_order_seq_cst) != 0)
+    notify_subscribers(control);
 
   return ShmStatus::Success;
 }
 
-void ShmManager::internal_release_read_buffer(uint32_t buffer_idx) {
-  std::lock_guard<std::mutex> lock(state_mutex_);
-  if (state_ != ShmState::Created && state_ != ShmState::Mapped)
-    return;
-  auto *control = static_cast<ShmBufferControl *>(shm_ptr_);
+void ShmManager::internal_release_read_buffer(uint32_t buffer_idx,
+                                               uint64_t hold_us,
+                                               uint64_t lease_handle) {
+  auto *control = get_buffer_control();
   if (!control)
     return;
 
   uint32_t buffer_count = control->buffer_count.load(std::memory_order_acquire);
   if (buffer_idx < buffer_count) {
-    auto *buffer_reader_count =
-        control->get_buffer_reader_count_array(shm_ptr_);
-    buffer_reader_count[buffer_idx].fetch_sub(1, std::memory_order_release);
+    ShmSlotView slot = control->get_slot(buffer_idx, shm_ptr_);
+    if (ShmStatsRegion *stats = control->get_stats(shm_ptr_)) {
+      // 持有时间在释放认领前记入，槽位与全局各一份
+      slot.meta->reads.fetch_add(1, std::memory_order_relaxed);
+      slot.meta->hold_total_us.fetch_add(hold_us, std::memory_order_relaxed);
+      ShmStatsRegion::update_max(slot.meta->hold_max_us, hold_us);
+      stats->hold_total_us.fetch_add(hold_us, std::memory_order_relaxed);
+      ShmStatsRegion::update_max(stats->hold_max_us, hold_us);
+      stats->hold_hist[ShmStatsRegion::log2_bucket(
+                           hold_us, ShmStatsRegion::HOLD_BUCKETS)]
+          .fetch_add(1, std::memory_order_relaxed);
+    }
+    // 租约在持有期间被回收（句柄代数不符）时持有计数已清零，不再释放
+    ShmReaderLease *lease =
+        control->get_reader_lease(lease_index(lease_handle), shm_ptr_);
+    if (lease->epoch.load(std::memory_order_acquire) ==
+        lease_epoch(lease_handle))
+      lease->held()[buffer_idx].fetch_sub(1, std::memory_order_release);
+    // 队列模式下读者释放可能腾出槽位，通知阻塞中的生产者
+    if (control->is_queue_mode()) {
+      control->consume_seq.fetch_add(1, std::memory_order_seq_cst);
+      if (control->producer_waiting.load(std::memory_order_seq_cst))
+        futex_wake_all(&control->consume_seq);
+    }
   }
 }
 
@@ -590,7 +2586,7 @@ void *create_shm_manager(const char *shm_name) {
     return nullptr;
   }
   try {
-    return new ShmManager(shm_name);
+    return static_cast<ShmManager *>(new CApiManager(shm_name));
   } catch (const std::bad_alloc &e) {
     std::cerr << "Error: Failed to allocate ShmManager: " << e.what()
               << std::endl;
@@ -600,7 +2596,7 @@ void *create_shm_manager(const char *shm_name) {
 
 void destroy_shm_manager(void *manager_ptr) {
   if (manager_ptr) {
-    delete static_cast<ShmManager *>(manager_ptr);
+    delete c_api_manager(manager_ptr);
   }
 }
 
@@ -622,6 +2618,26 @@ int shm_manager_open_and_map(void *manager_ptr, size_t shm_total_size,
           ->open_and_map(shm_total_size, buffer_size, buffer_count));
 }
 
+int shm_manager_attach(void *manager_ptr) {
+  if (!manager_ptr)
+    return static_cast<int>(ShmStatus::InvalidArguments);
+  return static_cast<int>(static_cast<ShmManager *>(manager_ptr)->open_and_map());
+}
+
+int shm_manager_reconnect(void *manager_ptr, int timeout_ms) {
+  if (!manager_ptr)
+    return static_cast<int>(ShmStatus::InvalidArguments);
+  return static_cast<int>(
+      static_cast<ShmManager *>(manager_ptr)->reconnect(timeout_ms));
+}
+
+int shm_manager_producer_restarted(const void *manager_ptr) {
+  if (!manager_ptr)
+    return 0;
+  return static_cast<const ShmManager *>(manager_ptr)->producer_restarted() ? 1
+                                                                            : 0;
+}
+
 int shm_manager_unmap_and_close(void *manager_ptr) {
   if (!manager_ptr)
     return static_cast<int>(ShmStatus::InvalidArguments);
@@ -635,21 +2651,96 @@ int shm_manager_unlink_shm(void *manager_ptr) {
   return static_cast<int>(static_cast<ShmManager *>(manager_ptr)->unlink_shm());
 }
 
-// 零拷贝C接口
+// 零拷贝C接口（租约句柄）
+int shm_manager_acquire_write_lease(void *manager_ptr, size_t expected_size,
+                                    void **buffer_ptr, uint32_t *lease_handle) {
+  if (!manager_ptr || !buffer_ptr || !lease_handle)
+    return static_cast<int>(ShmStatus::InvalidArguments);
+  CApiManager *manager = c_api_manager(manager_ptr);
+  int index = manager->claim();
+  if (index < 0)
+    return static_cast<int>(ShmStatus::BufferInUse);
+  CApiLease &lease = manager->lease(index);
+  lease.write.emplace(manager->acquire_write_buffer(expected_size));
+  if (!lease.write->is_valid()) {
+    manager->put_back(index);
+    return static_cast<int>(ShmStatus::AcquireFailed);
+  }
+  *buffer_ptr = lease.write->get();
+  *lease_handle = manager->publish(index, CApiLease::Write, *buffer_ptr);
+  return static_cast<int>(ShmStatus::Success);
+}
+
+int shm_manager_commit_write_lease(void *manager_ptr, uint32_t lease_handle,
+                                   size_t actual_size, uint64_t frame_version) {
+  if (!manager_ptr)
+    return static_cast<int>(ShmStatus::InvalidArguments);
+  CApiManager *manager = c_api_manager(manager_ptr);
+  CApiLease *lease = manager->take(lease_handle, CApiLease::Write);
+  if (!lease)
+    return static_cast<int>(ShmStatus::InvalidArguments);
+  ShmStatus status =
+      lease->write->commit(actual_size, frame_version, monotonic_now_us());
+  manager->put_back(lease);
+  return static_cast<int>(status);
+}
+
+int shm_manager_release_write_lease(void *manager_ptr, uint32_t lease_handle) {
+  if (!manager_ptr)
+    return static_cast<int>(ShmStatus::InvalidArguments);
+  CApiManager *manager = c_api_manager(manager_ptr);
+  CApiLease *lease = manager->take(lease_handle, CApiLease::Write);
+  if (!lease)
+    return static_cast<int>(ShmStatus::InvalidArguments);
+  manager->put_back(lease); // Guard析构，放弃本次写入
+  return static_cast<int>(ShmStatus::Success);
+}
+
+int shm_manager_acquire_read_lease(void *manager_ptr, const void **buffer_ptr,
+                                   size_t *data_size, uint64_t *frame_version,
+                                   uint32_t *lease_handle) {
+  if (!manager_ptr || !buffer_ptr || !data_size || !frame_version ||
+      !lease_handle)
+    return static_cast<int>(ShmStatus::InvalidArguments);
+  CApiManager *manager = c_api_manager(manager_ptr);
+  return publish_read_guard(manager, manager->acquire_read_buffer(),
+                            buffer_ptr, data_size, frame_version,
+                            lease_handle);
+}
+
+int shm_manager_acquire_next_lease(void *manager_ptr, uint32_t consumer_id,
+                                   const void **buffer_ptr, size_t *data_size,
+                                   uint64_t *frame_version,
+                                   uint32_t *lease_handle) {
+  if (!manager_ptr || !buffer_ptr || !data_size || !frame_version ||
+      !lease_handle)
+    return static_cast<int>(ShmStatus::InvalidArguments);
+  CApiManager *manager = c_api_manager(manager_ptr);
+  return publish_read_guard(manager, manager->acquire_next_buffer(consumer_id),
+                            buffer_ptr, data_size, frame_version,
+                            lease_handle);
+}
+
+int shm_manager_release_read_lease(void *manager_ptr, uint32_t lease_handle) {
+  if (!manager_ptr)
+    return static_cast<int>(ShmStatus::InvalidArguments);
+  CApiManager *manager = c_api_manager(manager_ptr);
+  CApiLease *lease = manager->take(lease_handle, CApiLease::Read);
+  if (!lease)
+    return static_cast<int>(ShmStatus::InvalidArguments);
+  manager->put_back(lease); // Guard析构，释放缓冲区
+  return static_cast<int>(ShmStatus::Success);
+}
+
+// 零拷贝C接口（按缓冲区指针，兼容旧调用方，同样使用租约表）
 void *shm_manager_acquire_write_buffer(void *manager_ptr,
                                        size_t expected_size) {
-  if (!manager_ptr)
+  void *buffer_ptr = nullptr;
+  uint32_t lease_handle;
+  if (shm_manager_acquire_write_lease(manager_ptr, expected_size, &buffer_ptr,
+                                      &lease_handle) != 0)
     return nullptr;
-  ShmManager *manager = static_cast<ShmManager *>(manager_ptr);
-  auto guard = std::make_unique<WriteBufferGuard>(
-      manager->acquire_write_buffer(expected_size));
-  if (guard->is_valid()) {
-    void *buffer_ptr = guard->get();
-    std::lock_guard<std::mutex> lock(guard_map_mutex);
-    write_guards[buffer_ptr] = std::move(guard);
-    return buffer_ptr;
-  }
-  return nullptr;
+  return buffer_ptr;
 }
 
 int shm_manager_commit_write_buffer(void *manager_ptr, void *buffer_ptr,
@@ -657,82 +2748,120 @@ int shm_manager_commit_write_buffer(void *manager_ptr, void *buffer_ptr,
                                     uint64_t frame_version) {
   if (!manager_ptr || !buffer_ptr)
     return static_cast<int>(ShmStatus::InvalidArguments);
-  std::lock_guard<std::mutex> lock(guard_map_mutex);
-  auto it = write_guards.find(buffer_ptr);
-  if (it == write_guards.end())
+  CApiManager *manager = c_api_manager(manager_ptr);
+  CApiLease *lease = manager->take_buffer(buffer_ptr, CApiLease::Write);
+  if (!lease)
     return static_cast<int>(ShmStatus::InvalidArguments);
-
-  // 生成当前时间戳
-  uint64_t current_timestamp =
-      std::chrono::duration_cast<std::chrono::microseconds>(
-          std::chrono::system_clock::now().time_since_epoch())
-          .count();
-
   ShmStatus status =
-      it->second->commit(actual_size, frame_version, current_timestamp);
-  write_guards.erase(it); // Guard自动析构，完成提交
+      lease->write->commit(actual_size, frame_version, monotonic_now_us());
+  manager->put_back(lease); // Guard析构，完成提交
   return static_cast<int>(status);
 }
 
 void shm_manager_release_write_buffer(void *manager_ptr, void *buffer_ptr) {
   if (!manager_ptr || !buffer_ptr)
     return;
-  std::lock_guard<std::mutex> lock(guard_map_mutex);
-  auto it = write_guards.find(buffer_ptr);
-  if (it != write_guards.end()) {
-    write_guards.erase(it); // Guard自动析构，释放缓冲区
-  }
+  CApiManager *manager = c_api_manager(manager_ptr);
+  if (CApiLease *lease = manager->take_buffer(buffer_ptr, CApiLease::Write))
+    manager->put_back(lease); // Guard析构，释放缓冲区
 }
 
 const void *shm_manager_acquire_read_buffer(void *manager_ptr,
                                             size_t *data_size,
                                             uint64_t *frame_version) {
-  if (!manager_ptr || !data_size || !frame_version)
+  const void *buffer_ptr = nullptr;
+  uint32_t lease_handle;
+  if (shm_manager_acquire_read_lease(manager_ptr, &buffer_ptr, data_size,
+                                     frame_version, &lease_handle) != 0)
     return nullptr;
-  ShmManager *manager = static_cast<ShmManager *>(manager_ptr);
-  auto guard =
-      std::make_unique<ReadBufferGuard>(manager->acquire_read_buffer());
-  if (guard->is_valid()) {
-    const void *buffer_ptr = guard->get();
-    *data_size = guard->size();
-    *frame_version = guard->frame_version();
-    std::lock_guard<std::mutex> lock(guard_map_mutex);
-    read_guards[buffer_ptr] = std::move(guard);
-    return buffer_ptr;
-  }
-  return nullptr;
+  return buffer_ptr;
 }
 
 const void *shm_manager_wait_for_data(void *manager_ptr, size_t *data_size,
                                       uint64_t *frame_version) {
   if (!manager_ptr || !data_size || !frame_version)
     return nullptr;
-  ShmManager *manager = static_cast<ShmManager *>(manager_ptr);
+  CApiManager *manager = c_api_manager(manager_ptr);
   while (true) {
-    auto guard =
-        std::make_unique<ReadBufferGuard>(manager->acquire_read_buffer());
-    if (guard->is_valid()) {
-      const void *buffer_ptr = guard->get();
-      *data_size = guard->size();
-      *frame_version = guard->frame_version();
-      std::lock_guard<std::mutex> lock(guard_map_mutex);
-      read_guards[buffer_ptr] = std::move(guard);
+    const void *buffer_ptr = nullptr;
+    uint32_t lease_handle;
+    const uint64_t seen_version = manager->get_latest_frame_version();
+    ShmStatus status = static_cast<ShmStatus>(
+        publish_read_guard(manager, manager->acquire_read_buffer(), &buffer_ptr,
+                           data_size, frame_version, &lease_handle));
+    if (status == ShmStatus::Success)
       return buffer_ptr;
-    }
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if (status != ShmStatus::NoDataAvailable)
+      return nullptr;
+    // 生产者重启或等待失败时返回 NULL，调用者重新附加后再读取
+    ShmStatus wait_status = manager->wait_for_new_frame(seen_version, -1);
+    if (wait_status != ShmStatus::Success && wait_status != ShmStatus::Timeout)
+      return nullptr;
   }
-  return nullptr;
 }
 
 void shm_manager_release_read_buffer(void *manager_ptr,
                                      const void *buffer_ptr) {
   if (!manager_ptr || !buffer_ptr)
     return;
-  std::lock_guard<std::mutex> lock(guard_map_mutex);
-  auto it = read_guards.find(buffer_ptr);
-  if (it != read_guards.end()) {
-    read_guards.erase(it); // Guard自动析构，释放缓冲区
-  }
+  CApiManager *manager = c_api_manager(manager_ptr);
+  if (CApiLease *lease = manager->take_buffer(buffer_ptr, CApiLease::Read))
+    manager->put_back(lease); // Guard析构，释放缓冲区
+}
+
+int shm_manager_wait_for_new_frame(void *manager_ptr, uint64_t last_version,
+                                   int timeout_ms) {
+  if (!manager_ptr)
+    return static_cast<int>(ShmStatus::InvalidArguments);
+  return static_cast<int>(static_cast<ShmManager *>(manager_ptr)
+                              ->wait_for_new_frame(last_version, timeout_ms));
+}
+
+int shm_manager_get_notify_fd(void *manager_ptr, int *fd) {
+  if (!manager_ptr)
+    return static_cast<int>(ShmStatus::InvalidArguments);
+  return static_cast<int>(
+      static_cast<ShmManager *>(manager_ptr)->get_notify_fd(fd));
+}
+
+void shm_manager_consume_notification(void *manager_ptr) {
+  if (manager_ptr)
+    static_cast<ShmManager *>(manager_ptr)->consume_notification();
+}
+
+uint64_t shm_manager_get_latest_frame_version(const void *manager_ptr) {
+  if (!manager_ptr)
+    return 0;
+  return static_cast<const ShmManager *>(manager_ptr)
+      ->get_latest_frame_version();
+}
+
+// 队列模式C接口
+int shm_manager_register_consumer(void *manager_ptr, uint32_t *consumer_id) {
+  if (!manager_ptr)
+    return static_cast<int>(ShmStatus::InvalidArguments);
+  return static_cast<int>(
+      static_cast<ShmManager *>(manager_ptr)->register_consumer(consumer_id));
+}
+
+int shm_manager_unregister_consumer(void *manager_ptr, uint32_t consumer_id) {
+  if (!manager_ptr)
+    return static_cast<int>(ShmStatus::InvalidArguments);
+  return static_cast<int>(
+      static_cast<ShmManager *>(manager_ptr)->unregister_consumer(consumer_id));
+}
+
+const void *shm_manager_acquire_next_buffer(void *manager_ptr,
+                                            uint32_t consumer_id,
+                                            size_t *data_size,
+                                            uint64_t *frame_version) {
+  const void *buffer_ptr = nullptr;
+  uint32_t lease_handle;
+  if (shm_manager_acquire_next_lease(manager_ptr, consumer_id, &buffer_ptr,
+                                     data_size, frame_version,
+                                     &lease_handle) != 0)
+    return nullptr;
+  return buffer_ptr;
 }
 
 // 兼容接口
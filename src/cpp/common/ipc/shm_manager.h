@@ -18,6 +18,7 @@
 #include <atomic>
 #include <mutex>
 #include <string>
+#include <vector>
 
 /**
  * @brief 将共享内存状态码转换为可读字符串
@@ -41,8 +42,10 @@ public:
   /**
    * @brief 构造函数
    * @param shm_name 共享内存名称，用于标识共享内存段
+   * @param map_options 映射选项（大页、预取、锁定等），默认普通映射
    */
-  ShmManager(const std::string &shm_name);
+  ShmManager(const std::string &shm_name,
+             const ShmMapOptions &map_options = ShmMapOptions());
 
   /**
    * @brief 析构函数，自动清理资源
@@ -54,10 +57,16 @@ public:
    * @param shm_total_size 共享内存总大小（字节）
    * @param buffer_size 单个缓冲区大小（字节）
    * @param buffer_count 缓冲区数量
+   * @param options 创建选项：读取模式、写满策略与数据区分配方式
    * @return ShmStatus 操作结果状态码
+   *
+   * 同名段已存在（上一个生产者崩溃或未删除）时，先将其标记为已取代并删除，
+   * 再按本次参数创建新段：旧段的槽位状态不会被沿用，几何参数也可以改变。
+   * 仍附加在旧段上的读者收到 ProducerRestarted 后调用 reconnect() 即可。
    */
   ShmStatus create_and_init(size_t shm_total_size, size_t buffer_size,
-                            uint32_t buffer_count);
+                            uint32_t buffer_count,
+                            const ShmCreateOptions &options = ShmCreateOptions());
 
   /**
    * @brief 打开并映射已存在的共享内存
@@ -65,10 +74,51 @@ public:
    * @param buffer_size 预期的单个缓冲区大小
    * @param buffer_count 预期的缓冲区数量
    * @return ShmStatus 操作结果状态码
+   *
+   * 布局版本由创建者决定，映射后根据头部魔数与版本号自动识别，
+   * 不匹配时返回 LayoutMismatch；引入魔数之前的旧版本生产者创建的段
+   * 同样返回 LayoutMismatch 并输出升级提示。
    */
   ShmStatus open_and_map(size_t shm_total_size, size_t buffer_size,
                          uint32_t buffer_count);
 
+  /**
+   * @brief 仅凭名称打开并映射已存在的共享内存
+   * @return ShmStatus 操作结果状态码，段尚不存在或创建者尚未完成初始化时
+   *         返回 ShmOpenFailed（不输出错误日志，便于高频轮询）；段由旧版本
+   *         生产者创建（无魔数头部）时返回 LayoutMismatch
+   *
+   * 段总大小、缓冲区大小与数量从段头部读取，消费者无需与生产者同步配置。
+   * 已被新段取代（superseded）的旧段视为不存在。
+   */
+  ShmStatus open_and_map();
+
+  /**
+   * @brief 解除当前映射并按名称重新附加（生产者重启后调用）
+   * @param timeout_ms 等待新段出现的超时时间（毫秒），负数表示无限等待
+   * @return ShmStatus Success 表示已附加到新段，Timeout 表示超时，
+   *         同名段由旧版本生产者创建时立即返回 LayoutMismatch
+   *
+   * 每隔数毫秒尝试一次，新生产者完成初始化后即可附加。
+   * 调用前须释放全部读写守卫，队列模式消费者需重新注册。
+   */
+  ShmStatus reconnect(int timeout_ms);
+
+  /**
+   * @brief 检查附加的段是否已被重启的生产者取代
+   * @return bool true 表示应调用 reconnect() 重新附加
+   *
+   * 依据段内 superseded 标志、生产者代数以及段名是否已被删除判断，
+   * 生产者崩溃且尚未重启时返回 false。
+   */
+  bool producer_restarted() const;
+
+  /**
+   * @brief 获取附加时段头部记录的生产者代数
+   * @return uint64_t 生产者代数，未映射时返回0
+   */
+  uint64_t get_generation() const;
+
   /**
    * @brief 取消映射并关闭共享内存
    * @return ShmStatus 操作结果状态码
@@ -94,6 +144,77 @@ public:
    */
   ReadBufferGuard acquire_read_buffer();
 
+  /**
+   * @brief 一次性固定最近提交的至多 k 帧（共享历史帧窗口）
+   * @param k 期望帧数，超过 buffer_count - 1 时按 buffer_count - 1 截断，
+   *          始终为写者保留一个槽位
+   * @param frames 输出参数，按 frame_version 升序排列的读守卫，原有内容被清空
+   * @return ShmStatus Success 表示至少获取到一帧，无已提交帧时返回 NoDataAvailable
+   *
+   * 扫描与固定期间若有新提交（提交序号变化）则整体重试，得到的是某一时刻
+   * 环内最新的 n 帧，版本连续。写者持续快于扫描时最多重试有限次，
+   * 之后接受固定区间内没有遗漏帧的结果（区间内已被覆盖的帧无法返回）。
+   * 守卫存活期间这些槽位不会被覆盖，时域滤波等算法可直接把环形缓冲区
+   * 当作历史窗口使用而无需拷贝。不推进队列模式消费者游标。
+   */
+  ShmStatus acquire_read_batch(uint32_t k, std::vector<ReadBufferGuard> *frames);
+
+  // 队列模式接口
+  /**
+   * @brief 注册为队列模式消费者
+   * @param consumer_id 输出参数，接收分配的消费者ID
+   * @return ShmStatus 操作结果状态码，游标表已满时返回 BufferInUse
+   *
+   * 新消费者从当前最新帧开始读取。注册后写者不会覆盖该消费者尚未读取的帧
+   * （BlockProducer），或在覆盖时累计其丢帧计数（DropOldest/SkipToLatest）。
+   * 已退出进程遗留的注册会在游标表满时被自动回收。
+   *
+   * @note 存活判断依据 pid 与进程启动时间，pid 被复用时也能识别；
+   *       但只对与写者同一 PID 命名空间的进程有效，其他命名空间
+   *       （如未共享 --pid 的容器）中崩溃的消费者不会被回收。
+   */
+  ShmStatus register_consumer(uint32_t *consumer_id);
+
+  /**
+   * @brief 注销队列模式消费者
+   * @param consumer_id register_consumer() 返回的消费者ID
+   * @return ShmStatus 操作结果状态码
+   */
+  ShmStatus unregister_consumer(uint32_t consumer_id);
+
+  /**
+   * @brief 按版本顺序获取指定消费者的下一帧
+   * @param consumer_id register_consumer() 返回的消费者ID
+   * @return ReadBufferGuard RAII风格的读缓冲区守卫，无新帧时无效
+   */
+  ReadBufferGuard acquire_next_buffer(uint32_t consumer_id);
+
+  /**
+   * @brief 获取指定消费者的统计信息
+   * @param consumer_id 消费者ID
+   * @param stats 输出参数，接收统计信息
+   * @return ShmStatus 操作结果状态码
+   */
+  ShmStatus get_consumer_stats(uint32_t consumer_id,
+                               ShmConsumerStats *stats) const;
+
+  /**
+   * @brief 获取段内性能计数快照
+   * @param stats 输出参数，接收计数快照
+   * @return ShmStatus 操作结果状态码
+   *
+   * 计数由写者和所有读者在共享内存中累加，这里读取的是所有附加进程的总和。
+   * 外部诊断工具（shm_stats）可以只读映射段后直接调用
+   * ShmBufferControl::read_stats() 得到同样的结果。
+   */
+  ShmStatus get_segment_stats(ShmSegmentStats *stats) const;
+
+  /**
+   * @brief 获取共享内存的读取模式
+   * @return ShmRingMode 创建者设置的读取模式，未映射时返回 Latest
+   */
+  ShmRingMode get_ring_mode() const;
+
   // 兼容性接口
   /**
    * @brief 写入数据并切换到下一个缓冲区（兼容接口）
@@ -119,10 +240,49 @@ public:
    * @param data 接收数据的缓冲区
    * @param max_size 缓冲区最大容量
    * @param actual_size 实际读取的数据大小
-   * @return ShmStatus 操作结果状态码
+   * @return ShmStatus 操作结果状态码；生产者重启时返回 ProducerRestarted
+   *         （应调用 reconnect()），futex 等待失败时返回 AcquireFailed
    */
   ShmStatus wait_and_read(void *data, size_t max_size, size_t *actual_size);
 
+  /**
+   * @brief 阻塞等待比 last_version 更新的帧被提交
+   * @param last_version 调用者已处理的最新帧版本号
+   * @param timeout_ms 超时时间（毫秒），负数表示无限等待，0表示仅检查
+   * @return ShmStatus Success表示已有新帧，Timeout表示超时
+   *
+   * 基于共享内存中的futex字实现，写者每次提交时递增并唤醒等待者，
+   * 等待期间不占用CPU。返回Success后调用 acquire_read_buffer() 读取。
+   * 段被重启的生产者取代时立即返回 ProducerRestarted，应调用 reconnect()。
+   */
+  ShmStatus wait_for_new_frame(uint64_t last_version, int timeout_ms);
+
+  /**
+   * @brief 获取新帧通知的 eventfd，可加入 epoll/select 与其他 I/O 一起等待
+   * @param fd 输出参数，接收 eventfd（由本实例持有，析构时关闭，调用者不要关闭）
+   * @return ShmStatus 操作结果；生产者未开启通知套接字时返回 AcquireFailed
+   *
+   * 首次调用时创建 eventfd 并经 unix 套接字（SCM_RIGHTS）交给生产者，
+   * 生产者在之后的提交中使其可读。可读后先调用 consume_notification()，
+   * 再读取最新帧；两次 consume_notification() 之间的多次提交只产生一次唤醒。
+   * 生产者删除段或正常退出时也会使其可读（崩溃时不会，等待应带超时），
+   * reconnect() 后自动向新生产者重新登记。
+   */
+  ShmStatus get_notify_fd(int *fd);
+
+  /**
+   * @brief 清空 eventfd 计数并重新登记下一次通知
+   *
+   * 在 eventfd 可读后、读取帧之前调用。读者租约被回收或生产者代数变化时重新登记。
+   */
+  void consume_notification();
+
+  /**
+   * @brief 获取当前已提交的最新帧版本号
+   * @return uint64_t 最新帧版本号，无数据时返回0
+   */
+  uint64_t get_latest_frame_version() const;
+
   /**
    * @brief 获取共享内存指针
    * @return void* 共享内存的起始地址
@@ -141,6 +301,12 @@ public:
    */
   size_t get_buffer_size() const;
 
+  /**
+   * @brief 获取缓冲区数量
+   * @return uint32_t 共享内存中的缓冲区数量，未映射时返回0
+   */
+  uint32_t get_buffer_count() const;
+
   /**
    * @brief 获取当前状态
    * @return ShmState 当前共享内存状态
@@ -166,7 +332,9 @@ private:
 
   // 内部接口，由友元类访问
   void *internal_acquire_write_buffer(size_t expected_size,
-                                      uint32_t *buffer_idx);
+                                      uint32_t *buffer_idx, size_t *capacity);
+  void *acquire_arena_buffer(size_t expected_size, uint32_t *buffer_idx,
+                             size_t *capacity);
   void internal_release_write_buffer(uint32_t buffer_idx);
   ShmStatus internal_commit_write_buffer(uint32_t buffer_idx,
                                          size_t actual_size,
@@ -176,27 +344,105 @@ private:
                                            uint64_t *frame_version,
                                            uint64_t *timestamp_us,
                                            uint32_t *buffer_idx,
-                                           ShmStatus *status);
-  void internal_release_read_buffer(uint32_t buffer_idx);
+                                           ShmStatus *status,
+                                           uint32_t consumer_id,
+                                           uint64_t *lease_handle);
+  void internal_release_read_buffer(uint32_t buffer_idx, uint64_t hold_us,
+                                    uint64_t lease_handle);
+  void account_write_failure();
+  void account_read_miss();
+  bool claim_read_slot(ShmSlotView &slot, ShmReaderLease *lease,
+                       uint32_t buffer_idx);
+  void drop_read_claim(ShmReaderLease *lease, uint32_t buffer_idx);
+  void account_read(ShmBufferControl *control, ShmSlotView &slot, uint64_t lag);
 
   // 辅助方法
   void log_error(const std::string &message, ShmStatus status_code) const;
+  void log_legacy_segment() const;
   void close_internal_handles();
+  std::string get_hugetlbfs_path() const;
+  void *try_map_hugetlbfs(size_t shm_total_size, bool create,
+                          bool *newly_created, size_t *mapped_size);
+  void apply_map_hints(void *addr, size_t length) const;
   ShmStatus validate_buffer_layout(size_t shm_total_size, size_t buffer_size,
-                                   uint32_t buffer_count) const;
+                                   uint32_t buffer_count,
+                                   ShmSlotAllocator allocator) const;
+  ShmStatus check_mapped_layout(size_t shm_total_size, size_t buffer_size,
+                                uint32_t buffer_count) const;
+  int open_segment_fd(bool writable) const;
+  ShmStatus read_segment_geometry(size_t *shm_total_size, size_t *buffer_size,
+                                  uint32_t *buffer_count) const;
+  uint64_t supersede_existing_segment();
+  uint64_t remove_existing_segment();
+  static void mark_superseded(ShmBufferControl *control);
+  bool is_superseded(const ShmBufferControl *control) const;
+  bool is_mapped() const;
+  ShmConsumerCursor *get_active_consumer(uint32_t consumer_id) const;
+  uint64_t get_min_consumer_cursor() const;
+  uint32_t select_write_slot(uint64_t min_cursor, bool *consumed,
+                             uint64_t *version, bool *reader_held,
+                             const uint8_t *pins = nullptr) const;
+  const uint8_t *snapshot_slot_pins(uint32_t buffer_count);
+  void account_overwrite(uint64_t frame_version);
+  void reap_dead_consumers();
+  ShmReaderLease *get_reader_lease(uint64_t *lease_handle);
+  ShmReaderLease *acquire_reader_lease(uint64_t *lease_handle);
+  void release_reader_lease();
+  bool reap_dead_readers();
+  void maybe_reap_dead_readers();
+  bool wait_for_consumer_release(uint32_t seq, int timeout_ms);
+  void open_notify_socket(ShmBufferControl *control);
+  void close_notify_targets(bool wake);
+  void notify_subscribers(ShmBufferControl *control);
+  void receive_notify_registrations(ShmBufferControl *control);
+  ShmStatus register_notify_fd(ShmBufferControl *control);
   ShmBufferControl *get_buffer_control() const;
   void *get_data_buffer(uint32_t buffer_idx) const;
-  void *get_data_buffer_nolock(uint32_t buffer_idx) const;
 
 private:
   std::string shm_name_;                 ///< 共享内存名称
+  ShmMapOptions map_options_;            ///< 映射选项
+  bool on_hugetlbfs_;                    ///< 当前映射是否位于 hugetlbfs
   int shm_fd_;                           ///< 共享内存文件描述符
   void *shm_ptr_;                        ///< 共享内存映射指针
   std::atomic<size_t> current_shm_size_; ///< 当前共享内存大小
   std::atomic<size_t> buffer_size_;      ///< 缓冲区大小
-  ShmState state_;                       ///< 当前状态
+  std::atomic<ShmState> state_;          ///< 当前状态（快速路径无锁读取）
   bool is_creator_;                      ///< 是否为创建者标志
-  mutable std::mutex state_mutex_;       ///< 状态保护互斥锁
+  std::atomic<uint64_t> generation_;     ///< 附加时的生产者代数
+  mutable std::mutex state_mutex_;       ///< 生命周期转换（创建/映射/关闭）互斥锁
+  /// 本实例的读者租约句柄：高32位为租约代数，低32位为租约索引
+  std::atomic<uint64_t> lease_handle_;
+  std::mutex lease_mutex_;                    ///< 租约分配/释放互斥锁
+  std::atomic<uint64_t> last_reader_reap_us_; ///< 上次检查失效读者租约的时间
+
+  /**
+   * @brief 写者侧登记的读者 eventfd（按读者租约索引）
+   */
+  struct NotifyTarget {
+    int fd = -1;        ///< 读者交来的 eventfd 副本
+    uint32_t epoch = 0; ///< 登记时的租约代数，租约被回收后失效
+  };
+  std::mutex notify_mutex_;   ///< 通知状态互斥锁（写者登记表 / 读者 eventfd）
+  int notify_socket_;         ///< 写者：接收 eventfd 登记的 unix 数据报套接字
+  uint32_t notify_requests_seen_; ///< 写者：已处理的登记请求序号
+  NotifyTarget notify_targets_[ShmBufferControl::MAX_READER_LEASES]; ///< 写者：登记表
+  int notify_fd_;             ///< 读者：本实例的通知 eventfd
+  uint64_t notify_lease_handle_; ///< 读者：登记时的租约句柄
+  uint64_t notify_generation_;   ///< 读者：登记时的生产者代数
+
+  /**
+   * @brief 字节环分配时一个描述符数据区的快照
+   */
+  struct ArenaSpan {
+    uint64_t begin; ///< 数据区起始偏移
+    uint64_t end;   ///< 数据区结束偏移
+    bool unread;    ///< 仍有消费者未读
+  };
+  // 字节环分配的临时数组（仅写者使用，复用避免每帧分配）
+  std::vector<uint8_t> arena_pins_;     ///< 各描述符是否被读者租约持有
+  std::vector<ArenaSpan> arena_busy_;   ///< 不能淘汰的数据区，按起始偏移排序
+  std::vector<ArenaSpan> arena_unread_; ///< 可淘汰但仍有消费者未读的数据区
 };
 
 // ========== C接口声明 ==========
@@ -205,9 +451,17 @@ private:
  *
  * 以下函数提供了C语言兼容的共享内存管理接口，
  * 方便与Python、Go等语言进行FFI调用。
+ *
+ * 零拷贝缓冲区由每个管理器自带的固定大小租约表持有（至多 SHM_C_MAX_LEASES 个），
+ * 获取/释放只在本管理器的占用位图上做一次 CAS，无堆分配、无全局锁。
+ * 推荐使用返回租约句柄的 *_lease 接口；按指针释放的旧接口仍可用，
+ * 但需要在表内按地址查找。
  */
 extern "C" {
 
+/// 每个管理器通过C接口同时持有的缓冲区上限
+#define SHM_C_MAX_LEASES 64
+
 /**
  * @brief 创建共享内存管理器实例
  * @param shm_name 共享内存名称
@@ -243,6 +497,30 @@ int shm_manager_create_and_init(void *manager_ptr, size_t shm_total_size,
 int shm_manager_open_and_map(void *manager_ptr, size_t shm_total_size,
                              size_t buffer_size, uint32_t buffer_count);
 
+/**
+ * @brief 仅凭名称打开并映射已存在的共享内存，几何参数从段头部读取
+ * @param manager_ptr 管理器实例指针
+ * @return int 操作结果，0表示成功，其他值表示失败
+ */
+int shm_manager_attach(void *manager_ptr);
+
+/**
+ * @brief 解除映射并按名称重新附加（生产者重启后调用）
+ * @param manager_ptr 管理器实例指针
+ * @param timeout_ms 超时时间（毫秒），负数表示无限等待
+ * @return int 操作结果，0表示成功，其他值表示失败或超时
+ *
+ * 调用前须释放全部已获取的读写缓冲区。
+ */
+int shm_manager_reconnect(void *manager_ptr, int timeout_ms);
+
+/**
+ * @brief 检查附加的段是否已被重启的生产者取代
+ * @param manager_ptr 管理器实例指针
+ * @return int 1表示应重新附加，0表示否
+ */
+int shm_manager_producer_restarted(const void *manager_ptr);
+
 /**
  * @brief 取消映射并关闭共享内存
  * @param manager_ptr 管理器实例指针
@@ -257,7 +535,74 @@ int shm_manager_unmap_and_close(void *manager_ptr);
  */
 int shm_manager_unlink_shm(void *manager_ptr);
 
-// 零拷贝C接口
+// 零拷贝C接口（租约句柄）
+/**
+ * @brief 获取写缓冲区并登记为租约
+ * @param manager_ptr 管理器实例指针
+ * @param expected_size 预期写入的数据大小
+ * @param buffer_ptr 输出参数，接收可写缓冲区指针
+ * @param lease_handle 输出参数，接收租约句柄
+ * @return int 操作结果，0表示成功；租约表已满时返回 BufferInUse
+ */
+int shm_manager_acquire_write_lease(void *manager_ptr, size_t expected_size,
+                                    void **buffer_ptr, uint32_t *lease_handle);
+
+/**
+ * @brief 提交写租约并归还
+ * @param manager_ptr 管理器实例指针
+ * @param lease_handle 租约句柄
+ * @param actual_size 实际写入的数据大小
+ * @param frame_version 帧版本号
+ * @return int 操作结果，0表示成功；句柄无效或已释放时返回 InvalidArguments
+ */
+int shm_manager_commit_write_lease(void *manager_ptr, uint32_t lease_handle,
+                                   size_t actual_size, uint64_t frame_version);
+
+/**
+ * @brief 放弃写租约（不提交）
+ * @param manager_ptr 管理器实例指针
+ * @param lease_handle 租约句柄
+ * @return int 操作结果，0表示成功
+ */
+int shm_manager_release_write_lease(void *manager_ptr, uint32_t lease_handle);
+
+/**
+ * @brief 获取最新帧并登记为读租约
+ * @param manager_ptr 管理器实例指针
+ * @param buffer_ptr 输出参数，接收数据指针
+ * @param data_size 输出参数，接收数据大小
+ * @param frame_version 输出参数，接收帧版本号
+ * @param lease_handle 输出参数，接收租约句柄
+ * @return int 操作结果，0表示成功，无数据时返回 NoDataAvailable
+ */
+int shm_manager_acquire_read_lease(void *manager_ptr, const void **buffer_ptr,
+                                   size_t *data_size, uint64_t *frame_version,
+                                   uint32_t *lease_handle);
+
+/**
+ * @brief 按版本顺序获取指定消费者的下一帧并登记为读租约
+ * @param manager_ptr 管理器实例指针
+ * @param consumer_id 消费者ID
+ * @param buffer_ptr 输出参数，接收数据指针
+ * @param data_size 输出参数，接收数据大小
+ * @param frame_version 输出参数，接收帧版本号
+ * @param lease_handle 输出参数，接收租约句柄
+ * @return int 操作结果，0表示成功
+ */
+int shm_manager_acquire_next_lease(void *manager_ptr, uint32_t consumer_id,
+                                   const void **buffer_ptr, size_t *data_size,
+                                   uint64_t *frame_version,
+                                   uint32_t *lease_handle);
+
+/**
+ * @brief 释放读租约
+ * @param manager_ptr 管理器实例指针
+ * @param lease_handle 租约句柄
+ * @return int 操作结果，0表示成功；句柄无效或已释放时返回 InvalidArguments
+ */
+int shm_manager_release_read_lease(void *manager_ptr, uint32_t lease_handle);
+
+// 零拷贝C接口（按缓冲区指针）
 /**
  * @brief 获取写缓冲区指针
  * @param manager_ptr 管理器实例指针
@@ -300,7 +645,8 @@ const void *shm_manager_acquire_read_buffer(void *manager_ptr,
  * @param manager_ptr 管理器实例指针
  * @param data_size 输出参数，接收数据大小
  * @param frame_version 输出参数，接收帧版本号
- * @return const void* 数据指针，失败时返回NULL
+ * @return const void* 数据指针，失败时返回NULL；生产者重启后同样返回NULL，
+ *         应先调用 shm_manager_reconnect()
  */
 const void *shm_manager_wait_for_data(void *manager_ptr, size_t *data_size,
                                       uint64_t *frame_version);
@@ -312,6 +658,68 @@ const void *shm_manager_wait_for_data(void *manager_ptr, size_t *data_size,
  */
 void shm_manager_release_read_buffer(void *manager_ptr, const void *buffer_ptr);
 
+/**
+ * @brief 阻塞等待比 last_version 更新的帧被提交
+ * @param manager_ptr 管理器实例指针
+ * @param last_version 调用者已处理的最新帧版本号
+ * @param timeout_ms 超时时间（毫秒），负数表示无限等待
+ * @return int 操作结果，0表示有新帧，其他值表示失败或超时
+ */
+int shm_manager_wait_for_new_frame(void *manager_ptr, uint64_t last_version,
+                                   int timeout_ms);
+
+/**
+ * @brief 获取新帧通知的 eventfd，可加入调用者自己的 epoll/poll 循环
+ * @param manager_ptr 管理器实例指针
+ * @param fd 输出参数，接收 eventfd（归管理器所有，不要关闭）
+ * @return int 操作结果，0表示成功
+ */
+int shm_manager_get_notify_fd(void *manager_ptr, int *fd);
+
+/**
+ * @brief eventfd 可读后清空计数并重新登记下一次通知
+ * @param manager_ptr 管理器实例指针
+ */
+void shm_manager_consume_notification(void *manager_ptr);
+
+/**
+ * @brief 获取当前已提交的最新帧版本号
+ * @param manager_ptr 管理器实例指针
+ * @return uint64_t 最新帧版本号，无数据时返回0
+ */
+uint64_t shm_manager_get_latest_frame_version(const void *manager_ptr);
+
+// 队列模式C接口
+/**
+ * @brief 注册为队列模式消费者
+ * @param manager_ptr 管理器实例指针
+ * @param consumer_id 输出参数，接收分配的消费者ID
+ * @return int 操作结果，0表示成功，其他值表示失败
+ */
+int shm_manager_register_consumer(void *manager_ptr, uint32_t *consumer_id);
+
+/**
+ * @brief 注销队列模式消费者
+ * @param manager_ptr 管理器实例指针
+ * @param consumer_id 消费者ID
+ * @return int 操作结果，0表示成功，其他值表示失败
+ */
+int shm_manager_unregister_consumer(void *manager_ptr, uint32_t consumer_id);
+
+/**
+ * @brief 按版本顺序获取指定消费者的下一帧
+ * @param manager_ptr 管理器实例指针
+ * @param consumer_id 消费者ID
+ * @param data_size 输出参数，接收数据大小
+ * @param frame_version 输出参数，接收帧版本号
+ * @return const void* 读缓冲区数据指针，无新帧时返回NULL，
+ *         使用完毕后调用 shm_manager_release_read_buffer() 释放
+ */
+const void *shm_manager_acquire_next_buffer(void *manager_ptr,
+                                            uint32_t consumer_id,
+                                            size_t *data_size,
+                                            uint64_t *frame_version);
+
 // 兼容接口
 /**
  * @brief 写入数据并切换到下一个缓冲区（兼容接口）
@@ -17,6 +17,11 @@
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <string>
+#include <vector>
 
 /**
  * @brief 共享内存操作状态码枚举
@@ -36,7 +41,10 @@ enum class ShmStatus {
   BufferTooSmall,     ///< 缓冲区太小
   BufferInUse,        ///< 缓冲区正在使用
   NoDataAvailable,    ///< 没有可用数据
-  AcquireFailed       ///< 获取缓冲区失败
+  AcquireFailed,      ///< 获取缓冲区失败
+  Timeout,            ///< 等待超时
+  LayoutMismatch,     ///< 共享内存布局版本或魔数不匹配
+  ProducerRestarted   ///< 生产者已重建共享内存段，需重新附加
 };
 
 /**
@@ -51,219 +59,704 @@ enum class ShmState {
   Closed         ///< 已关闭状态
 };
 
+/**
+ * @brief 获取单调时钟当前时间（微秒）
+ * @return uint64_t CLOCK_MONOTONIC 时间（微秒）
+ *
+ * 共享内存中的帧时间戳统一使用该时钟：与 V4L2 驱动时间戳同源，不受系统
+ * 时间调整影响，同一主机上的不同进程之间可以直接相减计算延迟。
+ */
+inline uint64_t monotonic_now_us() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief 环形缓冲区读取模式
+ */
+enum class ShmRingMode : uint32_t {
+  Latest = 0, ///< 最新帧优先：读者总是获取最新帧，慢读者自动跳帧
+  Queue = 1   ///< 队列模式：每个已注册消费者按版本顺序逐帧读取
+};
+
+/**
+ * @brief 队列模式下环形缓冲区写满时的处理策略
+ */
+enum class ShmOverflowPolicy : uint32_t {
+  DropOldest = 0,    ///< 覆盖最旧帧，慢消费者从仍保留的最旧帧继续
+  BlockProducer = 1, ///< 阻塞生产者，直到最慢的消费者腾出槽位
+  SkipToLatest = 2   ///< 覆盖最旧帧，被覆盖的消费者直接跳到最新帧
+};
+
+/**
+ * @brief 数据区分配方式
+ */
+enum class ShmSlotAllocator : uint32_t {
+  FixedSlots = 0, ///< 每个槽位固定 buffer_size 字节
+  ByteRing = 1    ///< 变长字节环：槽位仅作为帧描述符，按提交大小从数据区顺序分配
+};
+
+/**
+ * @brief 共享内存创建选项
+ *
+ * 仅由创建者使用，写入控制块头部后对所有附加方生效。
+ */
+struct ShmCreateOptions {
+  ShmRingMode ring_mode = ShmRingMode::Latest; ///< 读取模式
+  ShmOverflowPolicy overflow_policy =
+      ShmOverflowPolicy::DropOldest; ///< 队列模式写满策略
+  ShmSlotAllocator allocator = ShmSlotAllocator::FixedSlots; ///< 数据区分配方式
+};
+
+/**
+ * @brief 共享内存映射选项
+ *
+ * 各进程独立配置，只影响本进程如何映射同一段共享内存，
+ * 生产者与消费者应使用相同的 hugetlbfs 设置才能找到同一个段。
+ */
+struct ShmMapOptions {
+  bool use_hugetlbfs = false; ///< 在 hugetlbfs 挂载点上创建/打开段，失败时回退到 /dev/shm
+  std::string hugetlbfs_dir = "/dev/hugepages"; ///< hugetlbfs 挂载点
+  bool transparent_huge_pages = false; ///< 对 /dev/shm 映射调用 madvise(MADV_HUGEPAGE)
+  bool populate = false;  ///< 使用 MAP_POPULATE 在映射时预先建立页表
+  bool lock = false;      ///< 使用 mlock 锁定映射，避免换出
+  bool will_need = false; ///< 调用 madvise(MADV_WILLNEED) 提示内核预读
+};
+
+/**
+ * @brief 单个消费者的统计信息（队列模式）
+ */
+struct ShmConsumerStats {
+  uint64_t next_version;    ///< 下一个待读取的帧版本号
+  uint64_t frames_consumed; ///< 已读取帧数
+  uint64_t frames_dropped;  ///< 未读取即被覆盖或跳过的帧数
+  uint64_t lag;             ///< 落后于最新提交帧的帧数
+};
+
+/**
+ * @brief 单个缓冲区的元数据记录
+ *
+ * 每条记录按缓存行对齐，且分为两条缓存行：
+ * - 第一条仅由写者修改（版本号、时间戳、数据大小、就绪标志）；
+ * - 第二条存放写者认领字与读者统计，读者计数不会使
+ *   其他槽位或写者元数据所在的缓存行失效。
+ *
+ * 读者不递增 reader_count，而是记录在各自的 ShmReaderLease 中，
+ * reader_count 只剩写者认领位（WRITER_BIT）。
+ */
+struct alignas(64) ShmSlotMeta {
+  std::atomic<uint64_t> frame_version{0}; ///< 帧版本号
+  std::atomic<uint64_t> timestamp_us{0};  ///< 时间戳（微秒，CLOCK_MONOTONIC）
+  std::atomic<size_t> data_size{0};       ///< 已提交数据大小
+  std::atomic<bool> ready{false};         ///< 就绪标志
+  std::atomic<uint64_t> data_offset{0};   ///< 字节环模式：数据在数据区内的偏移
+  std::atomic<uint64_t> data_capacity{0}; ///< 字节环模式：占用的数据区长度
+
+  alignas(64) std::atomic<uint32_t> reader_count{0}; ///< 写者认领字（不含读者计数）
+  std::atomic<uint32_t> reads_since_commit{0}; ///< 本次提交以来的读取次数，写者覆盖时据此判断是否未读
+  std::atomic<uint64_t> reads{0};         ///< 累计读取次数
+  std::atomic<uint64_t> hold_total_us{0}; ///< 读者累计持有时间（微秒）
+  std::atomic<uint64_t> hold_max_us{0};   ///< 读者单次最长持有时间（微秒）
+};
+
+static_assert(sizeof(ShmSlotMeta) == 128,
+              "ShmSlotMeta must occupy exactly two cache lines");
+
+/**
+ * @brief 队列模式下已注册消费者的读游标记录
+ *
+ * 每条记录独占一条缓存行，消费者推进游标时不会干扰其他消费者。
+ * frames_dropped 由写者在覆盖该消费者尚未读取的帧时递增。
+ */
+struct alignas(64) ShmConsumerCursor {
+  std::atomic<uint32_t> active{0};         ///< 是否已被占用
+  std::atomic<int32_t> pid{0};             ///< 注册进程PID，用于回收失效消费者
+  std::atomic<uint64_t> next_version{0};   ///< 下一个待读取的帧版本号
+  std::atomic<uint64_t> pid_ns{0};         ///< 注册进程的 PID 命名空间（inode），0 表示未记录
+  std::atomic<uint64_t> start_time{0};     ///< 注册进程启动时间（/proc stat 第22项），识别 PID 复用
+  std::atomic<uint64_t> frames_consumed{0}; ///< 已读取帧数
+  std::atomic<uint64_t> frames_dropped{0};  ///< 被覆盖或跳过的帧数
+};
+
+static_assert(sizeof(ShmConsumerCursor) == 64,
+              "ShmConsumerCursor must occupy exactly one cache line");
+
+/**
+ * @brief 读者租约记录
+ *
+ * 每个读取该段的 ShmManager 实例在首次读取时占用一条租约，
+ * 之后持有的槽位都记录在自己的租约中（held()[i] 为持有槽位 i 的守卫数），
+ * 不再递增槽位上的匿名计数。持有计数数组紧跟在记录头之后，
+ * 长度等于缓冲区数量，按缓存行向上取整。读者进程崩溃后，写者发现其 pid 已不存在
+ * 即可整条回收租约，被其持有的槽位立即恢复可写，环形缓冲区深度不受影响。
+ * pid 连同其 PID 命名空间与进程启动时间一起记录：pid 被新进程复用时启动时间
+ * 不符，同样视为已退出；持有者位于写者看不到的其他 PID 命名空间时无法判断
+ * 存活，租约不会被回收。
+ *
+ * epoch 在每次分配与回收时递增，持有者据此发现租约已被回收，
+ * 不会在回收后再次释放或继续使用旧租约。
+ */
+struct alignas(64) ShmReaderLease {
+  std::atomic<uint32_t> state{0}; ///< 空闲 / 分配中 / 已激活 / 回收中
+  std::atomic<int32_t> pid{0};    ///< 持有者进程PID
+  std::atomic<uint32_t> epoch{0}; ///< 租约代数，分配与回收时递增
+  std::atomic<uint64_t> pid_ns{0};     ///< 持有者 PID 命名空间（inode），0 表示未记录
+  std::atomic<uint64_t> start_time{0}; ///< 持有者启动时间（/proc stat 第22项），识别 PID 复用
+
+  /**
+   * @brief 获取紧跟记录头的各槽位持有计数数组
+   */
+  std::atomic<uint8_t> *held() {
+    return reinterpret_cast<std::atomic<uint8_t> *>(this + 1);
+  }
+};
+
+static_assert(sizeof(ShmReaderLease) == 64,
+              "ShmReaderLease header must occupy exactly one cache line");
+
+/**
+ * @brief 段内性能计数区
+ *
+ * 位于消费者游标表之后，由写者与所有读者直接以原子操作累加，
+ * 任何进程都可以只读附加后采样，无需重启生产者或消费者即可诊断丢帧。
+ * 写者计数与读者计数分处不同缓存行，读者更新计数不会干扰写者。
+ */
+struct alignas(64) ShmStatsRegion {
+  static constexpr uint32_t HOLD_BUCKETS = 20; ///< 持有时间直方图桶数（log2 微秒）
+  static constexpr uint32_t LAG_BUCKETS = 8;   ///< 消费者落后帧数直方图桶数（log2 帧）
+
+  // 写者计数
+  std::atomic<uint64_t> frames_committed{0};          ///< 已提交帧数
+  std::atomic<uint64_t> bytes_committed{0};           ///< 已提交字节数
+  std::atomic<uint64_t> frames_overwritten_unread{0}; ///< 未被任何读者读取即被覆盖的帧数
+  std::atomic<uint64_t> write_acquire_failures{0};    ///< 写缓冲区获取失败次数（无空闲槽位）
+  std::atomic<uint64_t> reader_leases_reclaimed{0};   ///< 回收的已退出读者租约数
+  uint64_t created_us{0}; ///< 段创建时间（微秒，CLOCK_MONOTONIC）
+
+  // 读者计数
+  alignas(64) std::atomic<uint64_t> reads{0};   ///< 成功读取次数
+  std::atomic<uint64_t> read_misses{0};         ///< 无可读帧或认领失败次数
+  std::atomic<uint64_t> hold_total_us{0};       ///< 读者累计持有时间（微秒）
+  std::atomic<uint64_t> hold_max_us{0};         ///< 读者单次最长持有时间（微秒）
+  std::atomic<uint64_t> lag_total{0};           ///< 读取时落后最新帧的累计帧数
+  std::atomic<uint64_t> lag_max{0};             ///< 读取时落后最新帧的最大帧数
+
+  /// 持有时间直方图：桶0为0微秒，桶 b 统计 [2^(b-1), 2^b) 微秒，最后一桶为溢出
+  alignas(64) std::atomic<uint64_t> hold_hist[HOLD_BUCKETS];
+  /// 落后帧数直方图：桶0为0帧，桶 b 统计 [2^(b-1), 2^b) 帧，最后一桶为溢出
+  alignas(64) std::atomic<uint64_t> lag_hist[LAG_BUCKETS];
+
+  /**
+   * @brief 计算数值所在的 log2 直方图桶
+   * @param value 数值
+   * @param buckets 桶数
+   * @return uint32_t 桶索引，超出范围时为最后一桶
+   */
+  static uint32_t log2_bucket(uint64_t value, uint32_t buckets) {
+    uint32_t b = value == 0 ? 0 : 64 - __builtin_clzll(value);
+    return b < buckets ? b : buckets - 1;
+  }
+
+  /**
+   * @brief 以 CAS 方式更新最大值
+   */
+  static void update_max(std::atomic<uint64_t> &target, uint64_t value) {
+    uint64_t current = target.load(std::memory_order_relaxed);
+    while (value > current &&
+           !target.compare_exchange_weak(current, value,
+                                         std::memory_order_relaxed))
+      ;
+  }
+};
+
+/**
+ * @brief 单个槽位的读者统计快照
+ */
+struct ShmSlotStats {
+  uint64_t reads;         ///< 累计读取次数
+  uint64_t hold_total_us; ///< 累计持有时间（微秒）
+  uint64_t hold_max_us;   ///< 单次最长持有时间（微秒）
+  uint32_t readers;       ///< 当前持有该槽位的读者数量
+};
+
+/**
+ * @brief 段内性能计数快照
+ *
+ * 由 ShmBufferControl::read_stats() 从共享内存逐字段读取，
+ * 各计数器之间不保证同一时刻一致，用于速率与分布统计已足够。
+ */
+struct ShmSegmentStats {
+  uint64_t sample_us;                 ///< 采样时间（微秒，CLOCK_MONOTONIC）
+  uint64_t created_us;                ///< 段创建时间
+  uint64_t frames_committed;          ///< 已提交帧数
+  uint64_t bytes_committed;           ///< 已提交字节数
+  uint64_t frames_overwritten_unread; ///< 未读即被覆盖的帧数
+  uint64_t write_acquire_failures;    ///< 写缓冲区获取失败次数
+  uint64_t reader_leases_reclaimed;   ///< 回收的已退出读者租约数
+  uint32_t reader_leases_active;      ///< 当前已激活的读者租约数
+  uint64_t reads;                     ///< 成功读取次数
+  uint64_t read_misses;               ///< 读取未命中次数
+  uint64_t hold_total_us;             ///< 读者累计持有时间
+  uint64_t hold_max_us;               ///< 读者单次最长持有时间
+  uint64_t lag_total;                 ///< 读取时累计落后帧数
+  uint64_t lag_max;                   ///< 读取时最大落后帧数
+  uint64_t hold_hist[ShmStatsRegion::HOLD_BUCKETS]; ///< 持有时间直方图
+  uint64_t lag_hist[ShmStatsRegion::LAG_BUCKETS];   ///< 落后帧数直方图
+  std::vector<ShmSlotStats> slots;    ///< 各槽位读者统计
+};
+
+/**
+ * @brief 单个缓冲区元数据的访问视图
+ *
+ * 各字段指针直接指向共享内存中该槽位 ShmSlotMeta 记录的原子变量。
+ */
+struct ShmSlotView {
+  std::atomic<uint64_t> *frame_version; ///< 帧版本号
+  std::atomic<uint64_t> *timestamp_us;  ///< 时间戳（微秒，CLOCK_MONOTONIC）
+  std::atomic<size_t> *data_size;       ///< 已提交数据大小
+  std::atomic<bool> *ready;             ///< 就绪标志
+  std::atomic<uint32_t> *reader_count;  ///< 读者计数/写者认领字
+  std::atomic<uint64_t> *data_offset;   ///< 数据区偏移（字节环模式）
+  std::atomic<uint64_t> *data_capacity; ///< 占用长度（字节环模式）
+  ShmSlotMeta *meta;                    ///< 完整元数据记录，含读者统计
+};
+
 /**
  * @brief 共享内存缓冲区控制结构
  *
- * 管理多个缓冲区的元数据，支持动态缓冲区数量配置。
- * 在共享内存中的布局：
- * [ShmBufferControl头部] [frame_version数组] [timestamp_us数组]
- * [buffer_data_size数组] [buffer_ready数组] [buffer_reader_count数组]
- * [数据缓冲区...]
+ * 位于共享内存起始处，管理多个缓冲区的元数据，支持动态缓冲区数量配置。
+ * 头部携带魔数、布局版本号、段几何参数（总大小/缓冲区大小/数量）与生产者代数，
+ * 消费者只凭名称即可附加，并据代数与 superseded 标志发现生产者重启。
+ * 布局版本号目前只有 2（缓存行对齐布局）：
+ *
+ * [ShmBufferControl头部] [ShmSlotMeta x N]
+ * [ShmConsumerCursor x MAX_CONSUMERS] [ShmReaderLease x MAX_READER_LEASES]
+ * [ShmStatsRegion] [页对齐填充]
+ * [数据缓冲区0] [数据缓冲区1] ...（每个缓冲区起始地址按页对齐）
+ *
+ * 字节环分配（ShmSlotAllocator::ByteRing）：
+ * 页对齐填充之后到段末尾为一整块数据区，槽位元数据退化为帧描述符，
+ * 记录每帧在数据区中的偏移与长度。写者从环头按提交大小顺序分配，
+ * 到达末尾时回绕到数据区起点，并淘汰与新区域重叠的旧帧。
+ *
+ * 这是一次不兼容的布局变更：引入魔数之前的旧格式段（16 字节头部、
+ * 紧凑的槽位元数据数组、24 字节图像头部）既不能被本版本读取，旧版本
+ * 读者也无法识别新段（魔数占据了旧格式的 buffer_count 位置），生产者
+ * 与消费者必须同时升级。附加时识别出旧格式段并返回 LayoutMismatch，
+ * 而不是当作初始化中的段无限等待。
  *
  * 使用原子操作确保多进程访问的线程安全性。
  */
-struct ShmBufferControl {
+struct alignas(64) ShmBufferControl {
+  /// buffer_reader_count 中表示写者独占槽位的标志位，其余位为读者数量
+  static constexpr uint32_t WRITER_BIT = 0x80000000u;
+  static constexpr uint32_t MAGIC = 0x43484D53u;  ///< 魔数 "SMHC"
+  static constexpr uint32_t LAYOUT_VERSION = 2; ///< 布局版本号（缓存行对齐布局）
+  static constexpr size_t CACHE_LINE_SIZE = 64; ///< 缓存行大小
+  static constexpr size_t PAGE_SIZE = 4096;     ///< 数据缓冲区对齐粒度
+  static constexpr uint32_t MAX_CONSUMERS = 16; ///< 队列模式最大消费者数量
+  static constexpr uint32_t NO_CONSUMER = 0xFFFFFFFFu; ///< 未注册读者（最新帧模式）
+  static constexpr size_t ARENA_ALIGN = CACHE_LINE_SIZE; ///< 字节环分配粒度
+  static constexpr uint32_t MAX_READER_LEASES = 32; ///< 读者租约数量（reader_lease_mask 位数）
+  static constexpr uint32_t NO_LEASE = 0xFFFFFFFFu; ///< 未占用租约
+  static constexpr size_t LEGACY_HEADER_SIZE = 16; ///< 旧格式（无魔数）头部大小
+  static constexpr size_t LEGACY_SLOT_ARRAY_BYTES = 29; ///< 旧格式每槽元数据数组字节数
+  static constexpr uint32_t LEGACY_MAX_BUFFERS = 4096; ///< 识别旧格式时接受的最大缓冲区数
+
+  std::atomic<uint32_t> magic;        ///< 魔数，初始化完成后最后写入
+  uint32_t layout_version;            ///< 布局版本号
   std::atomic<uint32_t> buffer_count; ///< 缓冲区数量
   size_t buffer_size;                 ///< 单个缓冲区大小
+  uint32_t ring_mode;                 ///< 读取模式（ShmRingMode）
+  uint32_t overflow_policy;           ///< 队列模式写满策略（ShmOverflowPolicy）
+  uint32_t slot_allocator;            ///< 数据区分配方式（ShmSlotAllocator）
+  uint64_t arena_size;                ///< 字节环模式下数据区总长度
+  /// 已激活读者租约位图，仅在租约分配/回收时修改，
+  /// 写者只需遍历置位的租约即可判断槽位是否被读者持有
+  std::atomic<uint32_t> reader_lease_mask;
+  uint64_t total_size; ///< 创建时的段总大小，附加方据此按名称映射整段
+
+  /// 提交序号（futex字），每次提交递增并唤醒等待者。
+  /// 单独占用一条缓存行，避免写者提交时使只读头部字段失效。
+  alignas(64) std::atomic<uint32_t> commit_seq;
+  std::atomic<uint32_t> waiter_count; ///< 正在futex上等待的消费者数量
+  uint64_t arena_head; ///< 字节环下一次分配的起始偏移（仅写者访问）
+  /// 生产者代数：每次由生产者创建或接管段时更新，读者据此发现生产者重启
+  std::atomic<uint64_t> generation;
+  /// 段已被同名新段取代（或创建者已删除），置位后递增 commit_seq 唤醒等待者
+  std::atomic<uint32_t> superseded;
+  /// 已登记 eventfd 且等待下一次通知的读者租约位图。
+  /// 写者提交时整体取走并逐个写 eventfd，读者处理完通知后重新置位，突发提交只唤醒一次
+  std::atomic<uint32_t> notify_mask;
+  /// 读者通过 unix 套接字发送 eventfd 后递增，写者据此在提交路径上非阻塞接收登记
+  std::atomic<uint32_t> notify_requests;
+
+  /// 消费序号（futex字），队列模式下读者释放槽位时递增，
+  /// 供阻塞策略下的生产者等待。由读者写入，因此独占一条缓存行。
+  alignas(64) std::atomic<uint32_t> consume_seq;
+  std::atomic<uint32_t> producer_waiting; ///< 生产者是否正在等待空闲槽位
+
+  /**
+   * @brief 检查布局版本号是否受支持
+   * @param version 布局版本号
+   * @return bool true表示支持
+   */
+  static bool is_supported_layout(uint32_t version) {
+    return version == LAYOUT_VERSION;
+  }
+
+  /**
+   * @brief 判断段是否由引入魔数之前的旧版本生产者创建
+   * @param base 段首地址（至少可读 LEGACY_HEADER_SIZE 字节）
+   * @param file_size 段文件大小
+   * @return bool true 表示段头部符合旧格式（不含魔数）
+   *
+   * 旧格式头部只有 buffer_count（4 字节，补齐到 8）与 buffer_size，之后是
+   * 每槽 29 字节的五个紧凑数组与按 buffer_size 紧密排列的数据缓冲区。
+   * 魔数位于同一位置，旧段的缓冲区数量不可能等于魔数；再按几何参数校验
+   * 文件大小，排除尚未初始化（全零）或其他来源的段。
+   */
+  static bool is_legacy_header(const void *base, size_t file_size) {
+    if (file_size < LEGACY_HEADER_SIZE)
+      return false;
+    uint32_t count;
+    uint64_t size;
+    std::memcpy(&count, base, sizeof(count));
+    std::memcpy(&size, static_cast<const char *>(base) + 8, sizeof(size));
+    if (count == 0 || count == MAGIC || count > LEGACY_MAX_BUFFERS || size == 0 ||
+        size > file_size)
+      return false;
+    return LEGACY_HEADER_SIZE + count * LEGACY_SLOT_ARRAY_BYTES +
+               count * size <=
+           file_size;
+  }
+
+  /**
+   * @brief 向上对齐到指定粒度
+   * @param value 原始值
+   * @param alignment 对齐粒度（2的幂）
+   * @return size_t 对齐后的值
+   */
+  static constexpr size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+  }
 
   /**
-   * @brief 获取帧版本数组在共享内存中的偏移量
+   * @brief 获取槽位元数据记录数组的偏移量
    * @return size_t 偏移量（字节）
    */
-  static size_t get_frame_version_offset() { return sizeof(ShmBufferControl); }
+  static size_t get_slot_meta_offset() { return sizeof(ShmBufferControl); }
 
   /**
-   * @brief 获取时间戳数组在共享内存中的偏移量
+   * @brief 获取消费者游标表的偏移量
    * @param buffer_count 缓冲区数量
    * @return size_t 偏移量（字节）
    */
-  static size_t get_timestamp_us_offset(uint32_t buffer_count) {
-    return get_frame_version_offset() +
-           buffer_count * sizeof(std::atomic<uint64_t>);
+  static size_t get_consumer_table_offset(uint32_t buffer_count) {
+    return get_slot_meta_offset() + buffer_count * sizeof(ShmSlotMeta);
   }
 
   /**
-   * @brief 获取缓冲区数据大小数组的偏移量
+   * @brief 获取单条读者租约（记录头 + 持有计数数组）的跨度
    * @param buffer_count 缓冲区数量
-   * @return size_t 偏移量（字节）
+   * @return size_t 跨度（字节），按缓存行对齐
    */
-  static size_t get_buffer_data_size_offset(uint32_t buffer_count) {
-    return get_timestamp_us_offset(buffer_count) +
-           buffer_count * sizeof(std::atomic<uint64_t>);
+  static size_t get_reader_lease_stride(uint32_t buffer_count) {
+    return sizeof(ShmReaderLease) + align_up(buffer_count, CACHE_LINE_SIZE);
   }
 
   /**
-   * @brief 获取缓冲区就绪标志数组的偏移量
+   * @brief 获取读者租约表的偏移量
    * @param buffer_count 缓冲区数量
    * @return size_t 偏移量（字节）
    */
-  static size_t get_buffer_ready_offset(uint32_t buffer_count) {
-    return get_buffer_data_size_offset(buffer_count) +
-           buffer_count * sizeof(std::atomic<size_t>);
+  static size_t get_reader_lease_offset(uint32_t buffer_count) {
+    return get_consumer_table_offset(buffer_count) +
+           MAX_CONSUMERS * sizeof(ShmConsumerCursor);
   }
 
   /**
-   * @brief 获取读者计数数组的偏移量
+   * @brief 获取段内性能计数区的偏移量
    * @param buffer_count 缓冲区数量
    * @return size_t 偏移量（字节）
    */
-  static size_t get_buffer_reader_count_offset(uint32_t buffer_count) {
-    return get_buffer_ready_offset(buffer_count) +
-           buffer_count * sizeof(std::atomic<bool>);
+  static size_t get_stats_offset(uint32_t buffer_count) {
+    return get_reader_lease_offset(buffer_count) +
+           MAX_READER_LEASES * get_reader_lease_stride(buffer_count);
   }
 
   /**
    * @brief 获取数据缓冲区区域的起始偏移量
    * @param buffer_count 缓冲区数量
-   * @return size_t 偏移量（字节）
+   * @return size_t 偏移量（字节），按页对齐
    */
   static size_t get_data_buffers_offset(uint32_t buffer_count) {
-    return get_buffer_reader_count_offset(buffer_count) +
-           buffer_count * sizeof(std::atomic<uint32_t>);
+    return align_up(get_stats_offset(buffer_count) + sizeof(ShmStatsRegion),
+                    PAGE_SIZE);
+  }
+
+  /**
+   * @brief 获取相邻数据缓冲区之间的跨度
+   * @param buffer_size 单个缓冲区大小
+   * @return size_t 跨度（字节），按页向上取整
+   */
+  static size_t get_buffer_stride(size_t buffer_size) {
+    return align_up(buffer_size, PAGE_SIZE);
+  }
+
+  /**
+   * @brief 计算所需的共享内存总大小
+   * @param buffer_count 缓冲区数量
+   * @param buffer_size 单个缓冲区大小
+   * @param allocator 数据区分配方式
+   * @return size_t 所需大小（字节）
+   *
+   * 字节环模式下 buffer_size 为单帧上限，数据区至少需容纳一帧，
+   * 段内剩余空间全部用作字节环。
+   */
+  static size_t
+  get_required_size(uint32_t buffer_count, size_t buffer_size,
+                    ShmSlotAllocator allocator = ShmSlotAllocator::FixedSlots) {
+    if (allocator == ShmSlotAllocator::ByteRing)
+      return get_data_buffers_offset(buffer_count) +
+             align_up(buffer_size, ARENA_ALIGN);
+    return get_data_buffers_offset(buffer_count) +
+           buffer_count * get_buffer_stride(buffer_size);
   }
 
   /**
    * @brief 初始化缓冲区控制结构
    * @param num_buffers 缓冲区数量
    * @param single_buffer_size 单个缓冲区大小
+   * @param segment_size 共享内存总大小，写入头部并用于确定字节环数据区长度
    * @param base_ptr 共享内存基地址
+   * @param options 创建选项（读取模式、写满策略与分配方式）
+   * @param producer_generation 生产者代数
    */
   void initialize(uint32_t num_buffers, size_t single_buffer_size,
-                  void *base_ptr) {
+                  size_t segment_size, void *base_ptr,
+                  const ShmCreateOptions &options = ShmCreateOptions(),
+                  uint64_t producer_generation = 1) {
+    layout_version = LAYOUT_VERSION;
     buffer_count.store(num_buffers, std::memory_order_release);
     buffer_size = single_buffer_size;
+    total_size = segment_size;
+    ring_mode = static_cast<uint32_t>(options.ring_mode);
+    overflow_policy = static_cast<uint32_t>(options.overflow_policy);
+    slot_allocator = static_cast<uint32_t>(options.allocator);
+    arena_size = options.allocator == ShmSlotAllocator::ByteRing
+                     ? segment_size - get_data_buffers_offset(num_buffers)
+                     : 0;
+    arena_head = 0;
+    new (&generation) std::atomic<uint64_t>(producer_generation);
+    new (&superseded) std::atomic<uint32_t>(0);
+    new (&notify_mask) std::atomic<uint32_t>(0);
+    new (&notify_requests) std::atomic<uint32_t>(0);
+    new (&commit_seq) std::atomic<uint32_t>(0);
+    new (&waiter_count) std::atomic<uint32_t>(0);
+    new (&consume_seq) std::atomic<uint32_t>(0);
+    new (&producer_waiting) std::atomic<uint32_t>(0);
+    new (&reader_lease_mask) std::atomic<uint32_t>(0);
 
     char *base = static_cast<char *>(base_ptr);
 
-    // 获取各数组的指针
-    auto *frame_version = reinterpret_cast<std::atomic<uint64_t> *>(
-        base + get_frame_version_offset());
-    auto *timestamp_us = reinterpret_cast<std::atomic<uint64_t> *>(
-        base + get_timestamp_us_offset(num_buffers));
-    auto *buffer_data_size = reinterpret_cast<std::atomic<size_t> *>(
-        base + get_buffer_data_size_offset(num_buffers));
-    auto *buffer_ready = reinterpret_cast<std::atomic<bool> *>(
-        base + get_buffer_ready_offset(num_buffers));
-    auto *buffer_reader_count = reinterpret_cast<std::atomic<uint32_t> *>(
-        base + get_buffer_reader_count_offset(num_buffers));
-
-    for (uint32_t i = 0; i < num_buffers; ++i) {
-      new (&frame_version[i]) std::atomic<uint64_t>(0);
-      new (&timestamp_us[i]) std::atomic<uint64_t>(0);
-      new (&buffer_data_size[i]) std::atomic<size_t>(0);
-      new (&buffer_ready[i]) std::atomic<bool>(false);
-      new (&buffer_reader_count[i]) std::atomic<uint32_t>(0);
+    auto *slots =
+        reinterpret_cast<ShmSlotMeta *>(base + get_slot_meta_offset());
+    for (uint32_t i = 0; i < num_buffers; ++i)
+      new (&slots[i]) ShmSlotMeta();
+    auto *consumers = reinterpret_cast<ShmConsumerCursor *>(
+        base + get_consumer_table_offset(num_buffers));
+    for (uint32_t i = 0; i < MAX_CONSUMERS; ++i)
+      new (&consumers[i]) ShmConsumerCursor();
+    auto *stats = new (base + get_stats_offset(num_buffers)) ShmStatsRegion();
+    for (uint32_t i = 0; i < ShmStatsRegion::HOLD_BUCKETS; ++i)
+      new (&stats->hold_hist[i]) std::atomic<uint64_t>(0);
+    for (uint32_t i = 0; i < ShmStatsRegion::LAG_BUCKETS; ++i)
+      new (&stats->lag_hist[i]) std::atomic<uint64_t>(0);
+    stats->created_us = monotonic_now_us();
+    size_t lease_stride = get_reader_lease_stride(num_buffers);
+    for (uint32_t i = 0; i < MAX_READER_LEASES; ++i) {
+      auto *lease = new (base + get_reader_lease_offset(num_buffers) +
+                         i * lease_stride) ShmReaderLease();
+      for (uint32_t j = 0; j < num_buffers; ++j)
+        new (&lease->held()[j]) std::atomic<uint8_t>(0);
     }
+
+    // 魔数最后写入，附加方看到魔数即表示头部初始化完成
+    magic.store(MAGIC, std::memory_order_release);
   }
 
   /**
-   * @brief 获取指定缓冲区的数据大小
-   * @param buffer_idx 缓冲区索引
+   * @brief 获取指定缓冲区的元数据视图
+   * @param buffer_idx 缓冲区索引（调用者保证有效）
    * @param base_ptr 共享内存基地址
-   * @return size_t 数据大小，无效索引时返回0
+   * @return ShmSlotView 元数据视图
    */
-  size_t get_buffer_data_size(uint32_t buffer_idx, void *base_ptr) const {
-    uint32_t num_buffers = buffer_count.load(std::memory_order_acquire);
-    if (buffer_idx >= num_buffers)
-      return 0;
-
+  ShmSlotView get_slot(uint32_t buffer_idx, void *base_ptr) const {
     char *base = static_cast<char *>(base_ptr);
-    auto *buffer_data_size = reinterpret_cast<std::atomic<size_t> *>(
-        base + get_buffer_data_size_offset(num_buffers));
-    return buffer_data_size[buffer_idx].load(std::memory_order_acquire);
+    auto *slot = reinterpret_cast<ShmSlotMeta *>(base + get_slot_meta_offset()) +
+                 buffer_idx;
+    return {&slot->frame_version, &slot->timestamp_us, &slot->data_size,
+            &slot->ready, &slot->reader_count, &slot->data_offset,
+            &slot->data_capacity, slot};
   }
 
   /**
-   * @brief 获取指定缓冲区的帧版本号
-   * @param buffer_idx 缓冲区索引
-   * @param base_ptr 共享内存基地址
-   * @return uint64_t 帧版本号，无效索引时返回0
+   * @brief 检查是否处于队列模式
+   * @return bool true表示队列模式
    */
-  uint64_t get_frame_version(uint32_t buffer_idx, void *base_ptr) const {
-    uint32_t num_buffers = buffer_count.load(std::memory_order_acquire);
-    if (buffer_idx >= num_buffers)
-      return 0;
+  bool is_queue_mode() const {
+    return ring_mode == static_cast<uint32_t>(ShmRingMode::Queue);
+  }
+
+  /**
+   * @brief 检查数据区是否使用字节环分配
+   * @return bool true表示字节环模式
+   */
+  bool is_byte_ring() const {
+    return slot_allocator == static_cast<uint32_t>(ShmSlotAllocator::ByteRing);
+  }
 
+  /**
+   * @brief 获取指定消费者的游标记录
+   * @param consumer_id 消费者ID（调用者保证小于 MAX_CONSUMERS）
+   * @param base_ptr 共享内存基地址
+   * @return ShmConsumerCursor* 游标记录指针
+   */
+  ShmConsumerCursor *get_consumer(uint32_t consumer_id, void *base_ptr) const {
     char *base = static_cast<char *>(base_ptr);
-    auto *frame_version = reinterpret_cast<std::atomic<uint64_t> *>(
-        base + get_frame_version_offset());
-    return frame_version[buffer_idx].load(std::memory_order_acquire);
+    return reinterpret_cast<ShmConsumerCursor *>(
+               base + get_consumer_table_offset(buffer_count.load(
+                          std::memory_order_acquire))) +
+           consumer_id;
   }
 
   /**
-   * @brief 获取指定缓冲区的时间戳
-   * @param buffer_idx 缓冲区索引
+   * @brief 获取指定读者租约
+   * @param lease_idx 租约索引（调用者保证小于 MAX_READER_LEASES）
    * @param base_ptr 共享内存基地址
-   * @return uint64_t 时间戳（微秒），无效索引时返回0
+   * @return ShmReaderLease* 租约指针
    */
-  uint64_t get_timestamp_us(uint32_t buffer_idx, void *base_ptr) const {
+  ShmReaderLease *get_reader_lease(uint32_t lease_idx, void *base_ptr) const {
     uint32_t num_buffers = buffer_count.load(std::memory_order_acquire);
-    if (buffer_idx >= num_buffers)
-      return 0;
-
-    char *base = static_cast<char *>(base_ptr);
-    auto *timestamp_us = reinterpret_cast<std::atomic<uint64_t> *>(
-        base + get_timestamp_us_offset(num_buffers));
-    return timestamp_us[buffer_idx].load(std::memory_order_acquire);
+    return reinterpret_cast<ShmReaderLease *>(
+        static_cast<char *>(base_ptr) + get_reader_lease_offset(num_buffers) +
+        lease_idx * get_reader_lease_stride(num_buffers));
   }
 
   /**
-   * @brief 获取帧版本数组指针
+   * @brief 统计当前持有指定槽位的读者数
+   * @param buffer_idx 缓冲区索引（调用者保证有效）
    * @param base_ptr 共享内存基地址
-   * @return std::atomic<uint64_t>* 帧版本数组指针
+   * @return uint32_t 读者数
+   *
+   * 遍历已激活租约的持有计数。
+   * 使用 seq_cst 读取，与读者"先登记持有、再检查写者认领位"配对。
    */
-  std::atomic<uint64_t> *get_frame_version_array(void *base_ptr) const {
-    char *base = static_cast<char *>(base_ptr);
-    return reinterpret_cast<std::atomic<uint64_t> *>(
-        base + get_frame_version_offset());
+  uint32_t count_slot_readers(uint32_t buffer_idx, void *base_ptr) const {
+    uint32_t readers = 0;
+    uint32_t mask = reader_lease_mask.load(std::memory_order_seq_cst);
+    while (mask) {
+      uint32_t i = __builtin_ctz(mask);
+      mask &= mask - 1;
+      readers += get_reader_lease(i, base_ptr)
+                     ->held()[buffer_idx]
+                     .load(std::memory_order_seq_cst);
+    }
+    return readers;
   }
 
   /**
-   * @brief 获取时间戳数组指针
+   * @brief 获取段内性能计数区
    * @param base_ptr 共享内存基地址
-   * @return std::atomic<uint64_t>* 时间戳数组指针
+   * @return ShmStatsRegion* 计数区指针
    */
-  std::atomic<uint64_t> *get_timestamp_us_array(void *base_ptr) const {
+  ShmStatsRegion *get_stats(void *base_ptr) const {
+    return reinterpret_cast<ShmStatsRegion *>(
+        static_cast<char *>(base_ptr) +
+        get_stats_offset(buffer_count.load(std::memory_order_acquire)));
+  }
+
+  /**
+   * @brief 读取段内性能计数快照
+   * @param base_ptr 共享内存基地址（只读映射即可）
+   * @param out 输出快照
+   */
+  void read_stats(const void *base_ptr, ShmSegmentStats *out) const {
+    void *base = const_cast<void *>(base_ptr);
+    const ShmStatsRegion *stats = get_stats(base);
+    auto load = [](const std::atomic<uint64_t> &v) {
+      return v.load(std::memory_order_relaxed);
+    };
+    out->sample_us = monotonic_now_us();
+    out->created_us = stats->created_us;
+    out->frames_committed = load(stats->frames_committed);
+    out->bytes_committed = load(stats->bytes_committed);
+    out->frames_overwritten_unread = load(stats->frames_overwritten_unread);
+    out->write_acquire_failures = load(stats->write_acquire_failures);
+    out->reader_leases_reclaimed = load(stats->reader_leases_reclaimed);
+    out->reader_leases_active = __builtin_popcount(
+        reader_lease_mask.load(std::memory_order_acquire));
+    out->reads = load(stats->reads);
+    out->read_misses = load(stats->read_misses);
+    out->hold_total_us = load(stats->hold_total_us);
+    out->hold_max_us = load(stats->hold_max_us);
+    out->lag_total = load(stats->lag_total);
+    out->lag_max = load(stats->lag_max);
+    for (uint32_t i = 0; i < ShmStatsRegion::HOLD_BUCKETS; ++i)
+      out->hold_hist[i] = load(stats->hold_hist[i]);
+    for (uint32_t i = 0; i < ShmStatsRegion::LAG_BUCKETS; ++i)
+      out->lag_hist[i] = load(stats->lag_hist[i]);
+
     uint32_t num_buffers = buffer_count.load(std::memory_order_acquire);
-    char *base = static_cast<char *>(base_ptr);
-    return reinterpret_cast<std::atomic<uint64_t> *>(
-        base + get_timestamp_us_offset(num_buffers));
+    out->slots.resize(num_buffers);
+    for (uint32_t i = 0; i < num_buffers; ++i) {
+      const ShmSlotMeta *meta = get_slot(i, base).meta;
+      out->slots[i].reads = load(meta->reads);
+      out->slots[i].hold_total_us = load(meta->hold_total_us);
+      out->slots[i].hold_max_us = load(meta->hold_max_us);
+      out->slots[i].readers = count_slot_readers(i, base);
+    }
   }
 
   /**
-   * @brief 获取缓冲区数据大小数组指针
+   * @brief 获取指定缓冲区的数据大小
+   * @param buffer_idx 缓冲区索引
    * @param base_ptr 共享内存基地址
-   * @return std::atomic<size_t>* 数据大小数组指针
+   * @return size_t 数据大小，无效索引时返回0
    */
-  std::atomic<size_t> *get_buffer_data_size_array(void *base_ptr) const {
-    uint32_t num_buffers = buffer_count.load(std::memory_order_acquire);
-    char *base = static_cast<char *>(base_ptr);
-    return reinterpret_cast<std::atomic<size_t> *>(
-        base + get_buffer_data_size_offset(num_buffers));
+  size_t get_buffer_data_size(uint32_t buffer_idx, void *base_ptr) const {
+    if (buffer_idx >= buffer_count.load(std::memory_order_acquire))
+      return 0;
+    return get_slot(buffer_idx, base_ptr)
+        .data_size->load(std::memory_order_acquire);
   }
 
   /**
-   * @brief 获取缓冲区就绪标志数组指针
+   * @brief 获取指定缓冲区的帧版本号
+   * @param buffer_idx 缓冲区索引
    * @param base_ptr 共享内存基地址
-   * @return std::atomic<bool>* 就绪标志数组指针
+   * @return uint64_t 帧版本号，无效索引时返回0
    */
-  std::atomic<bool> *get_buffer_ready_array(void *base_ptr) const {
-    uint32_t num_buffers = buffer_count.load(std::memory_order_acquire);
-    char *base = static_cast<char *>(base_ptr);
-    return reinterpret_cast<std::atomic<bool> *>(
-        base + get_buffer_ready_offset(num_buffers));
+  uint64_t get_frame_version(uint32_t buffer_idx, void *base_ptr) const {
+    if (buffer_idx >= buffer_count.load(std::memory_order_acquire))
+      return 0;
+    return get_slot(buffer_idx, base_ptr)
+        .frame_version->load(std::memory_order_acquire);
   }
 
   /**
-   * @brief 获取读者计数数组指针
+   * @brief 获取指定缓冲区的时间戳
+   * @param buffer_idx 缓冲区索引
    * @param base_ptr 共享内存基地址
-   * @return std::atomic<uint32_t>* 读者计数数组指针
+   * @return uint64_t 时间戳（微秒），无效索引时返回0
    */
-  std::atomic<uint32_t> *get_buffer_reader_count_array(void *base_ptr) const {
-    uint32_t num_buffers = buffer_count.load(std::memory_order_acquire);
-    char *base = static_cast<char *>(base_ptr);
-    return reinterpret_cast<std::atomic<uint32_t> *>(
-        base + get_buffer_reader_count_offset(num_buffers));
+  uint64_t get_timestamp_us(uint32_t buffer_idx, void *base_ptr) const {
+    if (buffer_idx >= buffer_count.load(std::memory_order_acquire))
+      return 0;
+    return get_slot(buffer_idx, base_ptr)
+        .timestamp_us->load(std::memory_order_acquire);
   }
 };
 
@@ -290,6 +783,23 @@ public:
    */
   ~WriteBufferGuard();
 
+  /**
+   * @brief 移动构造函数，转移缓冲区所有权
+   * @param other 被移动的守卫对象，移动后变为无效
+   */
+  WriteBufferGuard(WriteBufferGuard &&other) noexcept;
+
+  /**
+   * @brief 移动赋值运算符，释放当前缓冲区后接管 other 的缓冲区
+   * @param other 被移动的守卫对象，移动后变为无效
+   * @return WriteBufferGuard& 自身引用
+   */
+  WriteBufferGuard &operator=(WriteBufferGuard &&other) noexcept;
+
+  // 禁用拷贝，避免同一槽位被重复释放
+  WriteBufferGuard(const WriteBufferGuard &) = delete;
+  WriteBufferGuard &operator=(const WriteBufferGuard &) = delete;
+
   /**
    * @brief 提交写入的数据
    * @param actual_size 实际写入的数据大小
@@ -325,6 +835,8 @@ public:
   bool is_valid() const { return buffer_ != nullptr; }
 
 private:
+  void release();
+
   ShmManager *manager_; ///< 管理器指针
   void *buffer_;        ///< 缓冲区指针
   size_t capacity_;     ///< 缓冲区容量
@@ -346,11 +858,35 @@ public:
    */
   ReadBufferGuard(ShmManager *manager);
 
+  /**
+   * @brief 构造函数，为已注册消费者按顺序获取下一帧（队列模式）
+   * @param manager 共享内存管理器指针
+   * @param consumer_id register_consumer() 返回的消费者ID
+   */
+  ReadBufferGuard(ShmManager *manager, uint32_t consumer_id);
+
   /**
    * @brief 析构函数，自动释放缓冲区资源
    */
   ~ReadBufferGuard();
 
+  /**
+   * @brief 移动构造函数，转移缓冲区所有权
+   * @param other 被移动的守卫对象，移动后变为无效
+   */
+  ReadBufferGuard(ReadBufferGuard &&other) noexcept;
+
+  /**
+   * @brief 移动赋值运算符，释放当前缓冲区后接管 other 的缓冲区
+   * @param other 被移动的守卫对象，移动后变为无效
+   * @return ReadBufferGuard& 自身引用
+   */
+  ReadBufferGuard &operator=(ReadBufferGuard &&other) noexcept;
+
+  // 禁用拷贝，避免同一槽位被重复释放
+  ReadBufferGuard(const ReadBufferGuard &) = delete;
+  ReadBufferGuard &operator=(const ReadBufferGuard &) = delete;
+
   /**
    * @brief 获取数据指针
    * @return const void* 只读数据指针
@@ -388,6 +924,10 @@ public:
   ShmStatus status() const { return status_; }
 
 private:
+  friend class ShmManager; // acquire_read_batch() 直接填充已固定的槽位
+
+  void release();
+
   ShmManager *manager_;    ///< 管理器指针
   const void *buffer_;     ///< 数据指针
   size_t size_;            ///< 数据大小
@@ -395,6 +935,8 @@ private:
   uint64_t timestamp_us_;  ///< 时间戳
   uint32_t buffer_idx_;    ///< 缓冲区索引
   ShmStatus status_;       ///< 操作状态
+  uint64_t acquire_us_;    ///< 获取时刻，释放时据此累计持有时间
+  uint64_t lease_handle_;  ///< 获取时使用的读者租约句柄
 };
 
 #endif // SHM_MANAGER_SHM_TYPES_H
\ No newline at end of file
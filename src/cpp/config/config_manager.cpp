@@ -13,6 +13,7 @@
 #include <iostream>
 #include <linux/videodev2.h> // 需要 V4L2 格式常量
 #include <map>
+#include <set>
 
 ConfigManager &ConfigManager::get_instance() {
   static ConfigManager instance;
@@ -29,10 +30,17 @@ ConfigManager &ConfigManager::get_instance() {
  * 目前支持的格式包括：
  * - "YUYV" -> V4L2_PIX_FMT_YUYV
  * - "MJPG" -> V4L2_PIX_FMT_MJPEG
+ * - "H264" -> V4L2_PIX_FMT_H264（支持 H264 输出的 UVC 摄像头）
+ * - "NV12" -> V4L2_PIX_FMT_NV12（ISP 摄像头，多平面设备也接受 NV12M）
+ * - "NV16" -> V4L2_PIX_FMT_NV16（ISP 摄像头，多平面设备也接受 NV16M）
  */
 static uint32_t string_to_v4l2_format(const std::string &format_str) {
   static const std::map<std::string, uint32_t> format_map = {
-      {"YUYV", V4L2_PIX_FMT_YUYV}, {"MJPG", V4L2_PIX_FMT_MJPEG}};
+      {"YUYV", V4L2_PIX_FMT_YUYV},
+      {"MJPG", V4L2_PIX_FMT_MJPEG},
+      {"H264", V4L2_PIX_FMT_H264},
+      {"NV12", V4L2_PIX_FMT_NV12},
+      {"NV16", V4L2_PIX_FMT_NV16}};
   auto it = format_map.find(format_str);
   if (it != format_map.end()) {
     return it->second;
@@ -41,6 +49,189 @@ static uint32_t string_to_v4l2_format(const std::string &format_str) {
                            format_str + "'");
 }
 
+/**
+ * @brief 将IO方式字符串转换为 V4L2 内存类型常量
+ * @param io_method IO方式字符串，"mmap" 或 "userptr"
+ * @return uint32_t 对应的 V4L2_MEMORY_* 常量值
+ * @throws std::runtime_error 当IO方式不被支持时抛出异常
+ *
+ * - "mmap"    -> V4L2_MEMORY_MMAP（驱动缓冲区，发布时拷贝到共享内存）
+ * - "userptr" -> V4L2_MEMORY_USERPTR（驱动直接写入共享内存槽位，零拷贝）
+ */
+static uint32_t string_to_v4l2_memory(const std::string &io_method) {
+  static const std::map<std::string, uint32_t> memory_map = {
+      {"mmap", V4L2_MEMORY_MMAP}, {"userptr", V4L2_MEMORY_USERPTR}};
+  auto it = memory_map.find(io_method);
+  if (it != memory_map.end()) {
+    return it->second;
+  }
+  throw std::runtime_error("Config Error: Unknown io_method '" + io_method +
+                           "'");
+}
+
+/**
+ * @brief 将读取模式字符串转换为 ShmRingMode
+ * @param mode_str 模式字符串，"latest" 或 "queue"
+ * @return ShmRingMode 对应的读取模式
+ * @throws std::runtime_error 当模式不被支持时抛出异常
+ */
+static ShmRingMode string_to_ring_mode(const std::string &mode_str) {
+  static const std::map<std::string, ShmRingMode> mode_map = {
+      {"latest", ShmRingMode::Latest}, {"queue", ShmRingMode::Queue}};
+  auto it = mode_map.find(mode_str);
+  if (it != mode_map.end()) {
+    return it->second;
+  }
+  throw std::runtime_error("Config Error: Unknown shm mode '" + mode_str +
+                           "'");
+}
+
+/**
+ * @brief 将写满策略字符串转换为 ShmOverflowPolicy
+ * @param policy_str 策略字符串，"drop_oldest"、"block_producer" 或
+ * "skip_to_latest"
+ * @return ShmOverflowPolicy 对应的写满策略
+ * @throws std::runtime_error 当策略不被支持时抛出异常
+ */
+static ShmOverflowPolicy string_to_overflow_policy(const std::string &policy_str) {
+  static const std::map<std::string, ShmOverflowPolicy> policy_map = {
+      {"drop_oldest", ShmOverflowPolicy::DropOldest},
+      {"block_producer", ShmOverflowPolicy::BlockProducer},
+      {"skip_to_latest", ShmOverflowPolicy::SkipToLatest}};
+  auto it = policy_map.find(policy_str);
+  if (it != policy_map.end()) {
+    return it->second;
+  }
+  throw std::runtime_error("Config Error: Unknown overflow_policy '" +
+                           policy_str + "'");
+}
+
+/**
+ * @brief 将分配方式字符串转换为 ShmSlotAllocator
+ * @param allocator_str 分配方式字符串，"fixed" 或 "byte_ring"
+ * @return ShmSlotAllocator 对应的分配方式
+ * @throws std::runtime_error 当分配方式不被支持时抛出异常
+ */
+static ShmSlotAllocator string_to_allocator(const std::string &allocator_str) {
+  static const std::map<std::string, ShmSlotAllocator> allocator_map = {
+      {"fixed", ShmSlotAllocator::FixedSlots},
+      {"byte_ring", ShmSlotAllocator::ByteRing}};
+  auto it = allocator_map.find(allocator_str);
+  if (it != allocator_map.end()) {
+    return it->second;
+  }
+  throw std::runtime_error("Config Error: Unknown allocator '" +
+                           allocator_str + "'");
+}
+
+/**
+ * @brief 将解码输出颜色字符串转换为 DecodeColor
+ * @param color_str 颜色字符串，"bgr" 或 "gray"
+ * @return DecodeColor 对应的输出颜色格式
+ * @throws std::runtime_error 当颜色格式不被支持时抛出异常
+ */
+static DecodeColor string_to_decode_color(const std::string &color_str) {
+  static const std::map<std::string, DecodeColor> color_map = {
+      {"bgr", DecodeColor::Bgr}, {"gray", DecodeColor::Gray}};
+  auto it = color_map.find(color_str);
+  if (it != color_map.end()) {
+    return it->second;
+  }
+  throw std::runtime_error("Config Error: Unknown decoder color '" +
+                           color_str + "'");
+}
+
+/**
+ * @brief 解析解码输出选项
+ * @param output 包含 color/width/height/roi 的 JSON 对象，字段均可选
+ * @return DecoderOptions 解析得到的输出选项
+ * @throws std::runtime_error 当颜色格式或 ROI 格式非法时抛出异常
+ */
+static DecoderOptions parse_decoder_options(const nlohmann::json &output) {
+  DecoderOptions options;
+  options.color =
+      string_to_decode_color(output.value("color", std::string("bgr")));
+  options.output_size =
+      cv::Size(output.value("width", 0), output.value("height", 0));
+  options.scale = output.value("scale", 1u);
+  if (options.scale != 1 && options.scale != 2 && options.scale != 4 &&
+      options.scale != 8)
+    throw std::runtime_error("Config Error: output scale must be 1, 2, 4 or 8");
+  const auto roi = output.value("roi", std::vector<int>());
+  if (roi.size() == 4)
+    options.roi = cv::Rect(roi[0], roi[1], roi[2], roi[3]);
+  else if (!roi.empty())
+    throw std::runtime_error(
+        "Config Error: output roi must be [x, y, width, height]");
+  return options;
+}
+
+/**
+ * @brief 解析单个 V4L2 捕获设备配置
+ * @param cfg 设备配置 JSON 对象
+ * @param default_threads 设备未指定 threads 时使用的线程配置
+ * @return V4l2Config 解析后的设备配置
+ * @throws std::runtime_error 当字段缺失或取值非法时抛出异常
+ */
+static V4l2Config parse_v4l2_config(const nlohmann::json &cfg,
+                                    const nlohmann::json &default_threads) {
+  V4l2Config config;
+  // 可选：录制回放。回放源的尺寸与格式取自录制文件，设备字段均可省略
+  if (cfg.contains("replay")) {
+    const auto &replay = cfg.at("replay");
+    config.replay.path = replay.at("path");
+    config.replay.speed = replay.value("speed", 1.0);
+    config.replay.loop = replay.value("loop", false);
+    if (config.replay.speed < 0)
+      throw std::runtime_error("Config Error: replay speed must be >= 0");
+  }
+  const bool replay = !config.replay.path.empty();
+  config.device_path = replay ? cfg.value("device_path",
+                                          "replay:" + config.replay.path)
+                              : cfg.at("device_path").get<std::string>();
+  config.width = replay ? cfg.value("width", 0) : cfg.at("width").get<int>();
+  config.height = replay ? cfg.value("height", 0) : cfg.at("height").get<int>();
+  config.pixel_format_v4l2 = string_to_v4l2_format(
+      replay ? cfg.value("format", std::string("MJPG"))
+             : cfg.at("format").get<std::string>());
+  config.buffer_count =
+      replay ? cfg.value("buffer_count", 4) : cfg.at("buffer_count").get<int>();
+  config.memory_v4l2 =
+      string_to_v4l2_memory(cfg.value("io_method", std::string("mmap")));
+  config.shm_name = cfg.value("shm_name", std::string());
+
+  // 可选：捕获/发布线程绑定与实时调度
+  const auto threads = cfg.value("threads", default_threads);
+  config.threads.capture_cpu = threads.value("capture_cpu", -1);
+  config.threads.publish_cpu = threads.value("publish_cpu", -1);
+  config.threads.capture_priority = threads.value("capture_priority", 0);
+  config.threads.publish_priority = threads.value("publish_priority", 0);
+  if (config.threads.capture_priority > 99 ||
+      config.threads.publish_priority > 99)
+    throw std::runtime_error(
+        "Config Error: SCHED_FIFO priority must be in range 1-99");
+
+  // 可选：生产者内硬件编码，发布编码后的码流而不是原始帧
+  if (cfg.contains("encode")) {
+    const auto &encode = cfg.at("encode");
+    config.encode.codec = encode.value("codec", std::string("H264"));
+    config.encode.device_path = encode.value("device", std::string());
+    config.encode.bitrate = encode.value("bitrate", config.encode.bitrate);
+    config.encode.gop = encode.value("gop", config.encode.gop);
+    config.encode.fps = encode.value("fps", config.encode.fps);
+    config.encode.buffer_count =
+        encode.value("buffer_count", config.encode.buffer_count);
+    if (config.encode.codec != "H264")
+      throw std::runtime_error("Config Error: Unsupported encode codec '" +
+                               config.encode.codec + "'");
+    if (config.encode.gop == 0 || config.encode.fps == 0 ||
+        config.encode.buffer_count < 2)
+      throw std::runtime_error(
+          "Config Error: encode gop/fps must be > 0 and buffer_count >= 2");
+  }
+  return config;
+}
+
 void ConfigManager::load_video_config(const std::string &path) {
   std::ifstream file(path);
   if (!file.is_open())
@@ -50,15 +241,40 @@ void ConfigManager::load_video_config(const std::string &path) {
   nlohmann::json data;
   file >> data;
 
-  const auto &cfg = data.at("v4l2_capture");
-  v4l2_config_.device_path = cfg.at("device_path");
-  v4l2_config_.width = cfg.at("width");
-  v4l2_config_.height = cfg.at("height");
-  v4l2_config_.pixel_format_v4l2 = string_to_v4l2_format(cfg.at("format"));
-  v4l2_config_.buffer_count = cfg.at("buffer_count");
+  // 多摄像头使用 "v4l2_captures" 数组，单摄像头沿用 "v4l2_capture" 对象
+  const auto default_threads = data.value("threads", nlohmann::json::object());
+  std::vector<V4l2Config> configs;
+  if (data.contains("v4l2_captures")) {
+    for (const auto &cfg : data.at("v4l2_captures"))
+      configs.push_back(parse_v4l2_config(cfg, default_threads));
+  } else {
+    configs.push_back(
+        parse_v4l2_config(data.at("v4l2_capture"), default_threads));
+  }
+
+  if (configs.empty())
+    throw std::runtime_error("Config Error: v4l2_captures is empty");
+  std::set<std::string> devices, shm_names;
+  for (const auto &config : configs) {
+    if (!devices.insert(config.device_path).second)
+      throw std::runtime_error("Config Error: Duplicate capture device '" +
+                               config.device_path + "'");
+    // 多个设备时必须为每个设备指定独立的输出共享内存
+    if (configs.size() > 1 && config.shm_name.empty())
+      throw std::runtime_error("Config Error: Capture device '" +
+                               config.device_path +
+                               "' needs a shm_name when multiple devices "
+                               "are configured");
+    if (!config.shm_name.empty() && !shm_names.insert(config.shm_name).second)
+      throw std::runtime_error("Config Error: Duplicate shm_name '" +
+                               config.shm_name + "'");
+  }
 
+  v4l2_configs_ = std::move(configs);
   video_loaded_ = true;
-  std::cout << "Video config loaded from " << path << std::endl;
+  std::cout << "Video config loaded from " << path << " ("
+            << v4l2_configs_.size() << " capture device"
+            << (v4l2_configs_.size() > 1 ? "s" : "") << ")" << std::endl;
 }
 
 void ConfigManager::load_shm_config(const std::string &path) {
@@ -76,19 +292,105 @@ void ConfigManager::load_shm_config(const std::string &path) {
   shm_config_.buffer_size_bytes =
       (size_t)cfg.at("buffer_size_mb") * 1024 * 1024;
   shm_config_.buffer_count = cfg.at("buffer_count");
+  shm_config_.ring_mode =
+      string_to_ring_mode(cfg.value("mode", std::string("latest")));
+  shm_config_.overflow_policy = string_to_overflow_policy(
+      cfg.value("overflow_policy", std::string("drop_oldest")));
+  shm_config_.allocator =
+      string_to_allocator(cfg.value("allocator", std::string("fixed")));
+
+  // 可选的映射选项，生产者与消费者读取同一份配置以保证 hugetlbfs 路径一致
+  const auto mapping = cfg.value("mapping", nlohmann::json::object());
+  ShmMapOptions &map_options = shm_config_.map_options;
+  map_options.use_hugetlbfs = mapping.value("hugetlbfs", false);
+  map_options.hugetlbfs_dir =
+      mapping.value("hugetlbfs_dir", map_options.hugetlbfs_dir);
+  map_options.transparent_huge_pages =
+      mapping.value("transparent_huge_pages", false);
+  map_options.populate = mapping.value("populate", false);
+  map_options.lock = mapping.value("lock", false);
+  map_options.will_need = mapping.value("will_need", false);
+
+  // 可选的派生流：尺寸由输出格式推导，消费者用同样的数值 open_and_map
+  shm_config_.derived_streams.clear();
+  for (const auto &stream_cfg :
+       cfg.value("derived_streams", nlohmann::json::array())) {
+    DerivedStreamConfig stream;
+    stream.name = stream_cfg.at("name");
+    stream.options = parse_decoder_options(stream_cfg);
+    if (stream.options.output_size.area() <= 0)
+      throw std::runtime_error("Config Error: derived stream '" +
+                               stream.name + "' needs width and height");
+    stream.buffer_count = stream_cfg.value("buffer_count", 3u);
+    size_t channels = stream.options.color == DecodeColor::Gray ? 1 : 3;
+    stream.buffer_size_bytes = ShmBufferControl::align_up(
+        ImageShmManager::payload_offset() +
+            (size_t)stream.options.output_size.area() * channels,
+        ShmBufferControl::PAGE_SIZE);
+    stream.total_size_bytes = ShmBufferControl::get_required_size(
+        stream.buffer_count, stream.buffer_size_bytes);
+    shm_config_.derived_streams.push_back(stream);
+  }
+
+  // 可选的解码缓存：服务与消费者读取同一份配置
+  const auto cache_cfg = cfg.value("decode_cache", nlohmann::json::object());
+  DecodeCacheConfig &decode_cache = shm_config_.decode_cache;
+  decode_cache.name = cache_cfg.value("name", std::string());
+  decode_cache.buffer_count = cache_cfg.value("buffer_count", 4u);
+  decode_cache.request_timeout_ms = cache_cfg.value("request_timeout_ms", 40);
+  if (decode_cache.buffer_count < 2)
+    throw std::runtime_error("Config Error: decode_cache buffer_count must be "
+                             "at least 2");
 
   shm_loaded_ = true;
   std::cout << "SHM config loaded from " << path << std::endl;
 }
 
+void ConfigManager::load_decode_config(const std::string &path) {
+  std::ifstream file(path);
+  if (!file.is_open())
+    throw std::runtime_error(
+        "Config Error: Could not open decode config at '" + path + "'");
+
+  nlohmann::json data;
+  file >> data;
+
+  const auto &cfg = data.at("decoder");
+  decode_config_.thread_count = cfg.value("thread_count", 0u);
+  decode_config_.cpu_affinity =
+      cfg.value("cpu_affinity", std::vector<int>());
+  decode_config_.queue_depth = cfg.value("queue_depth", 8u);
+  if (decode_config_.queue_depth == 0)
+    throw std::runtime_error("Config Error: decoder.queue_depth must be > 0");
+
+  // 可选的输出选项：消费者只需要缩小图或 ROI 时，解码阶段直接生成目标尺寸
+  decode_config_.options =
+      parse_decoder_options(cfg.value("output", nlohmann::json::object()));
+
+  decode_loaded_ = true;
+  std::cout << "Decode config loaded from " << path << std::endl;
+}
+
 const V4l2Config &ConfigManager::get_v4l2_config() const {
   if (!video_loaded_)
     throw std::runtime_error("Video config not loaded.");
-  return v4l2_config_;
+  return v4l2_configs_.front();
+}
+
+const std::vector<V4l2Config> &ConfigManager::get_v4l2_configs() const {
+  if (!video_loaded_)
+    throw std::runtime_error("Video config not loaded.");
+  return v4l2_configs_;
 }
 
 const ShmConfig &ConfigManager::get_shm_config() const {
   if (!shm_loaded_)
     throw std::runtime_error("SHM config not loaded.");
   return shm_config_;
+}
+
+const DecodeConfig &ConfigManager::get_decode_config() const {
+  if (!decode_loaded_)
+    throw std::runtime_error("Decode config not loaded.");
+  return decode_config_;
 }
\ No newline at end of file
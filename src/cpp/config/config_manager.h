@@ -12,10 +12,54 @@
 #ifndef CONFIG_MANAGER_H
 #define CONFIG_MANAGER_H
 
+#include "common/ipc/shm_types.h"
 #include "common/json/nlohmann_json/include/nlohmann/json.hpp"
+#include "video/formats/decoder_interface.h"
 #include <cstdint>
 #include <stdexcept>
 #include <string>
+#include <vector>
+
+/**
+ * @brief 生产者捕获/发布线程配置
+ *
+ * CPU 编号小于 0 表示不绑定；优先级大于 0 时使用 SCHED_FIFO 实时调度，
+ * 需要 CAP_SYS_NICE 或足够的 RLIMIT_RTPRIO，失败时保持默认调度并打印警告。
+ */
+struct CaptureThreadConfig {
+  int capture_cpu = -1;     ///< 捕获线程绑定的 CPU
+  int publish_cpu = -1;     ///< 发布线程绑定的 CPU
+  int capture_priority = 0; ///< 捕获线程 SCHED_FIFO 优先级，0 表示默认调度
+  int publish_priority = 0; ///< 发布线程 SCHED_FIFO 优先级，0 表示默认调度
+};
+
+/**
+ * @brief 录制回放配置
+ *
+ * path 非空时 Factory::create_capture() 创建 ReplayCapture，把 recorder_process
+ * 录制的原始帧按原始节奏（或倍速、尽快）重新发布到共享内存，无需摄像头。
+ */
+struct ReplayConfig {
+  std::string path;   ///< 录制路径：段文件、目录或 "<目录>/<前缀>"，为空表示不回放
+  double speed = 1.0; ///< 回放速度倍率，0 表示不限速（尽快回放）
+  bool loop = false;  ///< 播放完毕后是否从头循环
+};
+
+/**
+ * @brief 生产者编码配置
+ *
+ * codec 非空时 Factory::create_capture() 用 H264EncodeCapture 包装捕获器：
+ * 原始帧（YUYV）送入 V4L2 M2M 硬件编码器，发布到共享内存的是编码后的码流，
+ * 网络桥接与录制的带宽随之降到原始帧的几十分之一。
+ */
+struct EncodeConfig {
+  std::string codec;         ///< 编码格式，目前仅支持 "H264"；为空表示不编码
+  std::string device_path;   ///< M2M 编码器设备，为空时自动查找
+  uint32_t bitrate = 4000000; ///< 目标码率（bit/s）
+  uint32_t gop = 30;          ///< 关键帧间隔（帧），消费者中途加入最多等待一个间隔
+  uint32_t fps = 30;          ///< 码率控制使用的帧率
+  uint32_t buffer_count = 4;  ///< 编码器每个队列的缓冲区数量
+};
 
 /**
  * @brief 视频捕获配置结构体 (V4L2)
@@ -28,6 +72,39 @@ struct V4l2Config {
   int height;              ///< 视频帧高度（像素）
   uint32_t pixel_format_v4l2; ///< 像素格式，存储转换后的 V4L2_PIX_FMT_* 常量
   int buffer_count;           ///< 缓冲区数量
+  uint32_t memory_v4l2; ///< 缓冲区IO方式，V4L2_MEMORY_MMAP 或 V4L2_MEMORY_USERPTR
+  CaptureThreadConfig threads; ///< 捕获/发布线程绑定与调度配置
+  std::string shm_name; ///< 输出共享内存名称，空表示使用 shmConfig.json 中的名称
+  ReplayConfig replay;  ///< 录制回放配置，replay.path 非空时替代摄像头
+  EncodeConfig encode;  ///< 生产者编码配置，encode.codec 非空时发布编码后的码流
+};
+
+/**
+ * @brief 派生流配置结构体
+ *
+ * 生产者在后台从主共享内存派生的低成本图像流（如半分辨率BGR预览、
+ * 灰度亮度平面），每帧只计算一次并写入独立命名的共享内存。
+ * 缓冲区尺寸由输出尺寸推导，生产者与消费者读取同一份配置即可保持一致。
+ */
+struct DerivedStreamConfig {
+  std::string name;         ///< 派生流共享内存名称
+  DecoderOptions options;   ///< 输出颜色格式、ROI与输出尺寸（尺寸必填）
+  uint32_t buffer_count;    ///< 派生流缓冲区数量
+  size_t buffer_size_bytes; ///< 单个缓冲区大小（由输出尺寸推导）
+  size_t total_size_bytes;  ///< 派生流共享内存总大小（由缓冲区推导）
+};
+
+/**
+ * @brief 解码缓存配置结构体
+ *
+ * 解码缓存服务（decode_cache_process）按需把主流的压缩帧解码一次，
+ * 以主流帧版本号为键发布到独立命名的 BGR 共享内存，同一节点上的多个
+ * 消费者共享解码结果。名称为空表示不使用解码缓存。
+ */
+struct DecodeCacheConfig {
+  std::string name;       ///< 缓存共享内存名称，为空表示未启用
+  uint32_t buffer_count;  ///< 缓存环缓冲区数量（至少2）
+  int request_timeout_ms; ///< 消费者等待服务解码的上限（毫秒），超时后本地解码
 };
 
 /**
@@ -40,6 +117,24 @@ struct ShmConfig {
   size_t total_size_bytes;  ///< 总共享内存大小（字节）
   size_t buffer_size_bytes; ///< 单个缓冲区大小（字节）
   uint32_t buffer_count;    ///< 缓冲区数量
+  ShmRingMode ring_mode;    ///< 读取模式（最新帧优先 / 队列）
+  ShmOverflowPolicy overflow_policy; ///< 队列模式写满策略
+  ShmSlotAllocator allocator; ///< 数据区分配方式（固定槽位 / 变长字节环）
+  ShmMapOptions map_options;  ///< 映射选项（大页、预取、锁定等）
+  std::vector<DerivedStreamConfig> derived_streams; ///< 生产者额外发布的派生流
+  DecodeCacheConfig decode_cache; ///< 消费者共享的解码缓存
+};
+
+/**
+ * @brief 消费者解码流水线配置结构体
+ *
+ * 定义并行解码工作线程数量、CPU 亲和性、在途帧上限以及解码输出选项
+ */
+struct DecodeConfig {
+  uint32_t thread_count;         ///< 解码工作线程数量（0 表示按 CPU 核数）
+  std::vector<int> cpu_affinity; ///< 工作线程绑定的 CPU 列表，按线程序号循环使用；为空则不绑定
+  uint32_t queue_depth;          ///< 在途帧上限（待解码 + 解码中 + 待按序交付）
+  DecoderOptions options;        ///< 解码输出选项（颜色格式、ROI、输出尺寸）
 };
 
 /**
@@ -60,6 +155,10 @@ public:
    * @brief 加载视频配置文件
    * @param path 配置文件路径
    * @throws std::runtime_error 当文件无法打开或格式错误时抛出异常
+   *
+   * 单摄像头使用 "v4l2_capture" 对象；多摄像头使用 "v4l2_captures" 数组，
+   * 每个设备须指定互不相同的 "shm_name"。顶层 "threads" 为各设备缺省的
+   * 线程配置。
    */
   void load_video_config(const std::string &path);
 
@@ -71,12 +170,26 @@ public:
   void load_shm_config(const std::string &path);
 
   /**
-   * @brief 获取V4L2视频配置
+   * @brief 加载解码流水线配置文件
+   * @param path 配置文件路径
+   * @throws std::runtime_error 当文件无法打开或格式错误时抛出异常
+   */
+  void load_decode_config(const std::string &path);
+
+  /**
+   * @brief 获取V4L2视频配置（多设备时为第一个设备）
    * @return const V4l2Config& V4L2配置的常量引用
    * @throws std::runtime_error 当视频配置未加载时抛出异常
    */
   const V4l2Config &get_v4l2_config() const;
 
+  /**
+   * @brief 获取全部V4L2捕获设备配置
+   * @return const std::vector<V4l2Config>& 设备配置列表（至少一个）
+   * @throws std::runtime_error 当视频配置未加载时抛出异常
+   */
+  const std::vector<V4l2Config> &get_v4l2_configs() const;
+
   /**
    * @brief 获取共享内存配置
    * @return const ShmConfig& 共享内存配置的常量引用
@@ -84,6 +197,13 @@ public:
    */
   const ShmConfig &get_shm_config() const;
 
+  /**
+   * @brief 获取解码流水线配置
+   * @return const DecodeConfig& 解码配置的常量引用
+   * @throws std::runtime_error 当解码配置未加载时抛出异常
+   */
+  const DecodeConfig &get_decode_config() const;
+
   // 删除拷贝构造和赋值操作符，确保单例模式
   ConfigManager(const ConfigManager &) = delete;
   ConfigManager &operator=(const ConfigManager &) = delete;
@@ -92,12 +212,15 @@ private:
   /**
    * @brief 私有构造函数，初始化配置加载状态
    */
-  ConfigManager() : video_loaded_(false), shm_loaded_(false) {}
+  ConfigManager()
+      : video_loaded_(false), shm_loaded_(false), decode_loaded_(false) {}
 
   bool video_loaded_;      ///< 视频配置是否已加载的标志
   bool shm_loaded_;        ///< 共享内存配置是否已加载的标志
-  V4l2Config v4l2_config_; ///< V4L2视频配置实例
+  bool decode_loaded_;     ///< 解码配置是否已加载的标志
+  std::vector<V4l2Config> v4l2_configs_; ///< V4L2捕获设备配置列表
   ShmConfig shm_config_;   ///< 共享内存配置实例
+  DecodeConfig decode_config_; ///< 解码流水线配置实例
 };
 
 #endif // CONFIG_MANAGER_H
\ No newline at end of file
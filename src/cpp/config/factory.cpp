@@ -10,14 +10,32 @@
  */
 
 #include "factory.h"
+#include "video/formats/h264_decoder.h"
+#include "video/formats/h264_encode_capture.h"
 #include "video/formats/mjpg_decoder.h"
+#include "video/formats/nv12_decoder.h"
+#include "video/formats/replay_capture.h"
 #include "video/formats/v4l2_capture.h"
+#include "video/formats/yuyv_fast_decoder.h"
 #include "video/formats/yuyv_decoder.h"
+#include <linux/videodev2.h>
 #include <stdexcept>
 
 std::unique_ptr<ICapture> Factory::create_capture(const V4l2Config &config) {
-  // 目前只支持 V4L2 捕获，未来可扩展其他类型
-  return std::make_unique<V4l2Capture>(config);
+  // 配置了 replay 时回放录制，否则打开 V4L2 设备
+  std::unique_ptr<ICapture> source;
+  if (!config.replay.path.empty())
+    source = std::make_unique<ReplayCapture>(config);
+  else
+    source = std::make_unique<V4l2Capture>(config);
+  if (config.encode.codec.empty())
+    return source;
+
+  // 配置了 encode 时在生产者内硬件编码，原始帧只经过编码器自己的缓冲区
+  if (config.memory_v4l2 == V4L2_MEMORY_USERPTR)
+    throw std::runtime_error(
+        "Factory Error: encode cannot be combined with io_method userptr");
+  return std::make_unique<H264EncodeCapture>(std::move(source), config);
 }
 
 std::unique_ptr<IDecoder> Factory::create_decoder(ImageFormat format) {
@@ -29,10 +47,47 @@ std::unique_ptr<IDecoder> Factory::create_decoder(ImageFormat format) {
   case ImageFormat::BGR:
     // BGR 格式不需要解码
     throw std::runtime_error("Factory Error: BGR format doesn't need decoder");
+  case ImageFormat::GRAY:
+    // 灰度格式不需要解码
+    throw std::runtime_error("Factory Error: GRAY format doesn't need decoder");
   case ImageFormat::H264:
-    // H264 解码器暂未实现
-    throw std::runtime_error("Factory Error: H264 decoder not implemented");
+    return std::make_unique<H264Decoder>();
+  case ImageFormat::NV12:
+  case ImageFormat::NV16:
+    return std::make_unique<Nv12Decoder>();
   default:
     throw std::runtime_error("Factory Error: Unsupported format for decoder");
   }
+}
+
+std::unique_ptr<IDecoder>
+Factory::create_decoder(ImageFormat format, const DecoderOptions &options) {
+  if (options.is_default())
+    return create_decoder(format);
+
+  switch (format) {
+  case ImageFormat::YUYV:
+    return std::make_unique<YuyvFastDecoder>(options);
+  case ImageFormat::MJPG:
+    return std::make_unique<MjpgDecoder>(options);
+  case ImageFormat::H264:
+    return std::make_unique<H264Decoder>(options);
+  case ImageFormat::NV12:
+  case ImageFormat::NV16:
+    return std::make_unique<Nv12Decoder>(options);
+  default:
+    return create_decoder(format);
+  }
+}
+
+std::unique_ptr<DecodePipeline>
+Factory::create_decoder(ImageFormat format, const DecodeConfig &config) {
+  const DecoderOptions options = config.options;
+  // H264 解码器有状态，帧必须按序进入同一个实例，只能使用一个工作线程
+  const uint32_t thread_count =
+      format == ImageFormat::H264 ? 1 : config.thread_count;
+  return std::make_unique<DecodePipeline>(
+      [format, options] { return create_decoder(format, options); },
+      thread_count,
+      config.cpu_affinity, config.queue_depth);
 }
\ No newline at end of file
@@ -13,6 +13,7 @@
 #define FACTORY_H
 
 #include "video/formats/capture_interface.h"
+#include "video/formats/decode_pipeline.h"
 #include "video/formats/decoder_interface.h"
 #include "video/image_shm_manager.h"
 #include <memory>
@@ -32,7 +33,9 @@ public:
    * @throws std::runtime_error 当无法创建捕获器时抛出异常
    *
    * 根据V4L2配置中的像素格式和设备参数，创建相应的视频捕获器实例。
-   * 目前支持V4L2标准捕获设备。
+   * 目前支持V4L2标准捕获设备；配置中设置了 replay.path 时创建回放
+   * recorder_process 录制的 ReplayCapture。配置中设置了 encode 时再用
+   * H264EncodeCapture 包装，经 V4L2 M2M 硬件编码器发布 H264 码流。
    */
   static std::unique_ptr<ICapture> create_capture(const V4l2Config &config);
 
@@ -43,9 +46,38 @@ public:
    * @throws std::runtime_error 当格式不支持时抛出异常
    *
    * 根据指定的图像格式创建相应的解码器实例。
-   * 支持的格式包括YUYV、MJPEG等常见视频格式。
+   * 支持的格式包括YUYV、MJPEG、H264（V4L2 M2M 硬件解码）以及 NV12/NV16。
    */
   static std::unique_ptr<IDecoder> create_decoder(ImageFormat format);
+
+  /**
+   * @brief 按输出选项创建图像解码器对象
+   * @param format 图像格式枚举值
+   * @param options 输出选项（颜色格式、ROI、输出尺寸）
+   * @return std::unique_ptr<IDecoder> 指向解码器接口的智能指针
+   * @throws std::runtime_error 当格式不支持或该格式不支持所给选项时抛出异常
+   *
+   * 默认选项等价于 create_decoder(format)。YUYV 在指定 ROI、输出尺寸或灰度
+   * 输出时返回 YuyvFastDecoder，单遍完成裁剪、缩放与颜色转换；NV12/NV16
+   * 先在源平面上裁剪再转换；MJPEG 按输出尺寸（或 options.scale）在 DCT 域
+   * 缩小解码，灰度输出只解码亮度分量。
+   */
+  static std::unique_ptr<IDecoder> create_decoder(ImageFormat format,
+                                                  const DecoderOptions &options);
+
+  /**
+   * @brief 创建并行解码流水线
+   * @param format 图像格式枚举值
+   * @param config 解码配置，包含线程数、CPU 亲和性、在途帧上限与输出选项
+   * @return std::unique_ptr<DecodePipeline> 已启动的解码流水线
+   * @throws std::runtime_error 当格式不支持时抛出异常
+   *
+   * 为每个工作线程创建一个独立的 format 解码器实例，结果按提交顺序交付。
+   * 适用于 MJPEG 等单线程解码跟不上帧率的格式。H264 解码器有状态，
+   * 忽略 thread_count，始终只使用一个工作线程。
+   */
+  static std::unique_ptr<DecodePipeline>
+  create_decoder(ImageFormat format, const DecodeConfig &config);
 };
 
 #endif // FACTORY_H
\ No newline at end of file
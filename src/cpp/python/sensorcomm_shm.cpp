@@ -0,0 +1,861 @@
+/**
+ * @file sensorcomm_shm.cpp
+ * @brief 共享内存图像流的 Python 零拷贝扩展
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 基于 ImageShmManager 的 CPython 原生扩展，读取路径与 C++ 消费者相同：
+ * - Reader.wait() 在 futex 上阻塞等待新帧（期间释放 GIL）
+ * - Reader.acquire() 返回的 Frame 持有槽位读守卫，通过缓冲区协议导出
+ *   只读内存，np.asarray(frame) / memoryview(frame) 直接指向共享内存槽位
+ * - Frame 支持 with 语句，退出时释放槽位；ImageHeader 各字段作为只读属性
+ *
+ * 用法：
+ * @code
+ *   import numpy as np, sensorcomm_shm
+ *   reader = sensorcomm_shm.Reader("cam1_shm")
+ *   last = 0
+ *   while True:
+ *       if not reader.wait(last, 1000):
+ *           continue
+ *       with reader.acquire() as frame:
+ *           image = np.asarray(frame)   # (h, w, c) uint8，零拷贝
+ *           process(image)
+ *           del image                   # 释放导出后槽位才能归还
+ *           last = frame.version
+ * @endcode
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "video/image_shm_manager.h"
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include <thread>
+
+namespace {
+
+/// 无限等待时每次阻塞的时长，期间检查 Python 信号（Ctrl-C）
+constexpr int kSignalCheckMs = 100;
+
+PyObject *g_shm_error = nullptr;         ///< sensorcomm_shm.ShmError
+PyObject *g_producer_restarted = nullptr; ///< sensorcomm_shm.ProducerRestarted
+
+/**
+ * @brief 按状态码抛出 Python 异常
+ * @return PyObject* 始终返回 nullptr，便于 return raise_status(...)
+ */
+PyObject *raise_status(ShmStatus status) {
+  PyObject *type = status == ShmStatus::ProducerRestarted
+                       ? g_producer_restarted
+                       : g_shm_error;
+  PyObject *args = Py_BuildValue("(is)", static_cast<int>(status),
+                                 shm_status_to_string(status));
+  if (args) {
+    PyErr_SetObject(type, args);
+    Py_DECREF(args);
+  }
+  return nullptr;
+}
+
+const char *format_name(ImageFormat format) {
+  switch (format) {
+  case ImageFormat::YUYV:
+    return "YUYV";
+  case ImageFormat::H264:
+    return "H264";
+  case ImageFormat::BGR:
+    return "BGR";
+  case ImageFormat::MJPG:
+    return "MJPG";
+  case ImageFormat::GRAY:
+    return "GRAY";
+  case ImageFormat::NV12:
+    return "NV12";
+  case ImageFormat::NV16:
+    return "NV16";
+  }
+  return "UNKNOWN";
+}
+
+// ========== Reader ==========
+
+/**
+ * @brief Python Reader 对象：附加到一个图像共享内存段
+ */
+struct ReaderObject {
+  PyObject_HEAD
+  ImageShmManager *shm;   ///< 图像共享内存管理器
+  Py_ssize_t live_frames; ///< 尚未释放的 Frame 数，大于0时禁止解除映射
+  Py_ssize_t active_waits; ///< 其他线程中释放 GIL 阻塞的 wait() 数
+  bool unmapping;         ///< close()/reconnect() 进行中，映射随时可能失效
+  uint32_t consumer_id;   ///< 队列模式消费者ID
+  bool has_consumer;      ///< 是否已注册队列消费者
+};
+
+// ========== Frame ==========
+
+/**
+ * @brief Python Frame 对象：持有一个槽位读守卫
+ *
+ * 守卫直接构造在对象内（无额外堆分配）。缓冲区导出期间不能释放，
+ * 避免 Python 侧继续访问已归还给写者的槽位。
+ */
+struct FrameObject {
+  PyObject_HEAD
+  ReaderObject *reader; ///< 所属 Reader（持有引用，保证映射存活）
+  alignas(ReadImageGuard) unsigned char storage[sizeof(ReadImageGuard)];
+  bool held;            ///< storage 中的守卫是否存活
+  Py_ssize_t exports;   ///< 当前缓冲区导出数
+  int ndim;             ///< 导出维度：1（压缩数据）、2（灰度、NV12/NV16）或 3
+  Py_ssize_t shape[3];  ///< 导出形状
+  Py_ssize_t strides[3]; ///< 导出步长（NV12/NV16 的行步长含驱动填充）
+};
+
+ReadImageGuard &frame_image(FrameObject *self) {
+  return *std::launder(reinterpret_cast<ReadImageGuard *>(self->storage));
+}
+
+PyTypeObject *g_frame_type = nullptr;  ///< sensorcomm_shm.Frame
+PyTypeObject *g_reader_type = nullptr; ///< sensorcomm_shm.Reader
+
+/**
+ * @brief 释放槽位守卫
+ * @return bool 是否释放成功，仍有缓冲区导出时设置 BufferError 并返回 false
+ */
+bool frame_release_guard(FrameObject *self) {
+  if (!self->held)
+    return true;
+  if (self->exports > 0) {
+    PyErr_SetString(PyExc_BufferError,
+                    "cannot release frame: buffer is still exported "
+                    "(delete memoryview/ndarray first or copy it)");
+    return false;
+  }
+  frame_image(self).~ReadImageGuard();
+  self->held = false;
+  self->reader->live_frames--;
+  return true;
+}
+
+/**
+ * @brief 由读守卫创建 Frame，无数据时返回 None
+ */
+PyObject *frame_from_guard(ReaderObject *reader, ReadImageGuard &&image) {
+  if (!image.is_valid()) {
+    if (image.status() == ShmStatus::NoDataAvailable)
+      Py_RETURN_NONE;
+    return raise_status(image.status());
+  }
+  FrameObject *self = PyObject_New(FrameObject, g_frame_type);
+  if (!self)
+    return nullptr;
+  new (self->storage) ReadImageGuard(std::move(image));
+  self->held = true;
+  self->exports = 0;
+  Py_INCREF(reader);
+  self->reader = reader;
+  reader->live_frames++;
+
+  // 原始像素按 (h, w[, c]) 导出，压缩或尺寸不符的数据按一维字节导出
+  const ImageHeader &header = frame_image(self).header();
+  Py_ssize_t pixels = (Py_ssize_t)header.width * header.height;
+  Py_ssize_t size = header.data_size;
+  Py_ssize_t channels = pixels > 0 && size % pixels == 0 ? size / pixels : 0;
+  bool raw = header.format != ImageFormat::MJPG &&
+             header.format != ImageFormat::H264 &&
+             header.format != ImageFormat::NV12 &&
+             header.format != ImageFormat::NV16 && channels >= 1 &&
+             channels <= 4;
+  // NV12/NV16 两个平面行跨度相同且首尾相接时按 (h + uv_h, w) 导出，
+  // 与 cv2.cvtColor(..., COLOR_YUV2BGR_NV12) 的输入约定一致
+  const ImagePlaneLayout planes = image_plane_layout(header);
+  const Py_ssize_t stride = planes.strides[0];
+  const Py_ssize_t rows =
+      header.height + (header.format == ImageFormat::NV12 ? header.height / 2
+                                                          : header.height);
+  bool semi_planar = (header.format == ImageFormat::NV12 ||
+                      header.format == ImageFormat::NV16) &&
+                     header.width > 0 && header.height > 0 &&
+                     planes.offsets[0] == 0 &&
+                     planes.strides[1] == planes.strides[0] &&
+                     planes.offsets[1] == stride * header.height &&
+                     (rows - 1) * stride + header.width <= size;
+  if (semi_planar) {
+    self->ndim = 2;
+    self->shape[0] = rows;
+    self->shape[1] = header.width;
+    self->strides[0] = stride;
+    self->strides[1] = 1;
+  } else if (!raw) {
+    self->ndim = 1;
+    self->shape[0] = size;
+    self->strides[0] = 1;
+  } else {
+    self->ndim = channels == 1 ? 2 : 3;
+    self->shape[0] = header.height;
+    self->shape[1] = header.width;
+    self->shape[2] = channels;
+    self->strides[0] = (Py_ssize_t)header.width * channels;
+    self->strides[1] = channels;
+    self->strides[2] = 1;
+  }
+  return reinterpret_cast<PyObject *>(self);
+}
+
+void frame_dealloc(FrameObject *self) {
+  // 导出的缓冲区持有 Frame 的引用，走到这里时 exports 必为 0
+  if (self->held) {
+    frame_image(self).~ReadImageGuard();
+    self->reader->live_frames--;
+  }
+  Py_XDECREF(self->reader);
+  PyTypeObject *type = Py_TYPE(self);
+  PyObject_Free(self);
+  Py_DECREF(type); // 堆类型的实例持有类型引用
+}
+
+int frame_getbuffer(FrameObject *self, Py_buffer *view, int flags) {
+  if (!self->held) {
+    PyErr_SetString(PyExc_ValueError, "frame has been released");
+    view->obj = nullptr;
+    return -1;
+  }
+  if (flags & PyBUF_WRITABLE) {
+    PyErr_SetString(PyExc_BufferError, "shared memory frames are read-only");
+    view->obj = nullptr;
+    return -1;
+  }
+  // 带行填充的 NV12/NV16 不是 C 连续的，只能按步长导出
+  if ((flags & PyBUF_ND) && (flags & PyBUF_STRIDES) != PyBUF_STRIDES &&
+      self->ndim == 2 && self->strides[0] != self->shape[1]) {
+    PyErr_SetString(PyExc_BufferError,
+                    "frame rows are padded, request a strided buffer");
+    view->obj = nullptr;
+    return -1;
+  }
+  ReadImageGuard &image = frame_image(self);
+  view->buf = const_cast<uint8_t *>(image.data());
+  view->len = (Py_ssize_t)image.data_size();
+  view->readonly = 1;
+  view->itemsize = 1;
+  view->format = (flags & PyBUF_FORMAT) ? const_cast<char *>("B") : nullptr;
+  view->ndim = (flags & PyBUF_ND) ? self->ndim : 1;
+  view->shape = (flags & PyBUF_ND) ? self->shape : nullptr;
+  view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? self->strides
+                                                             : nullptr;
+  view->suboffsets = nullptr;
+  view->internal = nullptr;
+  Py_INCREF(self);
+  view->obj = reinterpret_cast<PyObject *>(self);
+  self->exports++;
+  return 0;
+}
+
+void frame_releasebuffer(FrameObject *self, Py_buffer *) { self->exports--; }
+
+PyObject *frame_release(FrameObject *self, PyObject *) {
+  if (!frame_release_guard(self))
+    return nullptr;
+  Py_RETURN_NONE;
+}
+
+PyObject *frame_enter(FrameObject *self, PyObject *) {
+  Py_INCREF(self);
+  return reinterpret_cast<PyObject *>(self);
+}
+
+PyObject *frame_exit(FrameObject *self, PyObject *) {
+  if (!frame_release_guard(self))
+    return nullptr;
+  Py_RETURN_FALSE;
+}
+
+/**
+ * @brief 检查 Frame 未被释放
+ */
+bool frame_check_held(FrameObject *self) {
+  if (self->held)
+    return true;
+  PyErr_SetString(PyExc_ValueError, "frame has been released");
+  return false;
+}
+
+/// ImageHeader 字段访问器
+enum FrameField {
+  FieldVersion,
+  FieldTimestamp,
+  FieldFormat,
+  FieldWidth,
+  FieldHeight,
+  FieldChannels,
+  FieldDataSize,
+  FieldFrameType,
+  FieldCaptureTs,
+  FieldDequeueTs,
+  FieldCommitTs,
+  FieldAcquireTs,
+  FieldPlaneOffsets,
+  FieldPlaneStrides
+};
+
+PyObject *frame_get_field(FrameObject *self, void *closure) {
+  if (!frame_check_held(self))
+    return nullptr;
+  const ReadImageGuard &image = frame_image(self);
+  const ImageHeader &header = image.header();
+  switch ((FrameField)(intptr_t)closure) {
+  case FieldVersion:
+    return PyLong_FromUnsignedLongLong(image.frame_version());
+  case FieldTimestamp:
+    return PyLong_FromUnsignedLongLong(image.timestamp_us());
+  case FieldFormat:
+    return PyLong_FromLong(static_cast<long>(header.format));
+  case FieldWidth:
+    return PyLong_FromUnsignedLong(header.width);
+  case FieldHeight:
+    return PyLong_FromUnsignedLong(header.height);
+  case FieldChannels:
+    return PyLong_FromUnsignedLong(header.channels);
+  case FieldDataSize:
+    return PyLong_FromUnsignedLong(header.data_size);
+  case FieldFrameType:
+    return PyLong_FromUnsignedLong(header.frame_type);
+  case FieldCaptureTs:
+    return PyLong_FromUnsignedLongLong(header.capture_timestamp_us);
+  case FieldDequeueTs:
+    return PyLong_FromUnsignedLongLong(header.dequeue_timestamp_us);
+  case FieldCommitTs:
+    return PyLong_FromUnsignedLongLong(header.commit_timestamp_us);
+  case FieldAcquireTs:
+    return PyLong_FromUnsignedLongLong(image.acquire_timestamp_us());
+  case FieldPlaneOffsets:
+  case FieldPlaneStrides: {
+    const ImagePlaneLayout planes = image_plane_layout(header);
+    const uint32_t *values = (FrameField)(intptr_t)closure == FieldPlaneOffsets
+                                 ? planes.offsets
+                                 : planes.strides;
+    return Py_BuildValue("(II)", values[0], values[1]);
+  }
+  }
+  Py_RETURN_NONE;
+}
+
+PyObject *frame_get_format_name(FrameObject *self, void *) {
+  if (!frame_check_held(self))
+    return nullptr;
+  return PyUnicode_FromString(format_name(frame_image(self).header().format));
+}
+
+PyObject *frame_get_released(FrameObject *self, void *) {
+  return PyBool_FromLong(!self->held);
+}
+
+#define FRAME_FIELD(name, field, doc)                                          \
+  {const_cast<char *>(name), reinterpret_cast<getter>(frame_get_field),       \
+   nullptr, const_cast<char *>(doc), reinterpret_cast<void *>(field)}
+
+PyGetSetDef frame_getset[] = {
+    FRAME_FIELD("version", FieldVersion, "帧版本号"),
+    FRAME_FIELD("timestamp_us", FieldTimestamp, "槽位时间戳（采集时间，微秒）"),
+    FRAME_FIELD("format", FieldFormat, "ImageFormat 数值"),
+    FRAME_FIELD("width", FieldWidth, "图像宽度"),
+    FRAME_FIELD("height", FieldHeight, "图像高度"),
+    FRAME_FIELD("channels", FieldChannels, "通道数"),
+    FRAME_FIELD("data_size", FieldDataSize, "图像数据大小（字节）"),
+    FRAME_FIELD("frame_type", FieldFrameType, "帧类型标志"),
+    FRAME_FIELD("capture_timestamp_us", FieldCaptureTs,
+                "采集时间（CLOCK_MONOTONIC 微秒）"),
+    FRAME_FIELD("dequeue_timestamp_us", FieldDequeueTs,
+                "生产者出队时间（CLOCK_MONOTONIC 微秒），未知时为0"),
+    FRAME_FIELD("commit_timestamp_us", FieldCommitTs,
+                "提交到共享内存的时间（CLOCK_MONOTONIC 微秒）"),
+    FRAME_FIELD("acquire_timestamp_us", FieldAcquireTs,
+                "本进程获取该帧的时间（CLOCK_MONOTONIC 微秒）"),
+    FRAME_FIELD("plane_offsets", FieldPlaneOffsets,
+                "(Y, UV) 平面偏移（字节），未使用的平面为0"),
+    FRAME_FIELD("plane_strides", FieldPlaneStrides,
+                "(Y, UV) 平面行跨度（字节），未使用的平面为0"),
+    {const_cast<char *>("format_name"),
+     reinterpret_cast<getter>(frame_get_format_name), nullptr,
+     const_cast<char *>("格式名称，如 'YUYV'"), nullptr},
+    {const_cast<char *>("released"),
+     reinterpret_cast<getter>(frame_get_released), nullptr,
+     const_cast<char *>("槽位是否已释放"), nullptr},
+    {nullptr, nullptr, nullptr, nullptr, nullptr}};
+
+#undef FRAME_FIELD
+
+PyMethodDef frame_methods[] = {
+    {"release", reinterpret_cast<PyCFunction>(frame_release), METH_NOARGS,
+     "释放槽位；仍有 memoryview/ndarray 导出时抛出 BufferError"},
+    {"__enter__", reinterpret_cast<PyCFunction>(frame_enter), METH_NOARGS,
+     nullptr},
+    {"__exit__", reinterpret_cast<PyCFunction>(frame_exit), METH_VARARGS,
+     nullptr},
+    {nullptr, nullptr, 0, nullptr}};
+
+// ========== Reader 实现 ==========
+
+/**
+ * @brief 检查 Reader 可以解除映射（没有存活的 Frame）
+ */
+bool reader_check_unmappable(ReaderObject *self) {
+  if (self->live_frames == 0)
+    return true;
+  PyErr_SetString(PyExc_BufferError,
+                  "frames acquired from this reader are still alive");
+  return false;
+}
+
+/**
+ * @brief 开始解除映射：拒绝新的访问，等待其他线程中的 wait() 退出
+ *
+ * wait() 释放 GIL 后直接在映射内的 futex 上阻塞，此时解除映射会让它
+ * 访问已失效的内存。计数只在持有 GIL 时修改；wait() 每个分片（至多
+ * kSignalCheckMs）醒来一次，看到 unmapping 后抛出异常返回，因此这里
+ * 最多等待一个分片。
+ * @return bool 是否可以解除映射，否则已设置 Python 异常
+ */
+bool reader_begin_unmap(ReaderObject *self) {
+  if (self->unmapping) {
+    PyErr_SetString(PyExc_RuntimeError,
+                    "reader is being closed or reconnected by another thread");
+    return false;
+  }
+  if (!reader_check_unmappable(self))
+    return false;
+  self->unmapping = true;
+  while (self->active_waits > 0) {
+    Py_BEGIN_ALLOW_THREADS
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    Py_END_ALLOW_THREADS
+  }
+  return true;
+}
+
+/**
+ * @brief 释放 GIL 附加共享内存，timeout_ms 为负数时一直等待（可被信号中断）
+ */
+ShmStatus reader_attach(ReaderObject *self, int timeout_ms) {
+  ShmStatus status;
+  if (timeout_ms == 0) {
+    // 不等待：首次附加保留具体失败原因，已映射时解除映射后尝试一次
+    bool mapped = self->shm->get_shm_ptr() != nullptr;
+    Py_BEGIN_ALLOW_THREADS
+    status = mapped ? self->shm->reconnect(0) : self->shm->open_and_map();
+    Py_END_ALLOW_THREADS
+    return status;
+  }
+  while (true) {
+    int slice = timeout_ms < 0 ? kSignalCheckMs
+                               : std::min(timeout_ms, kSignalCheckMs);
+    Py_BEGIN_ALLOW_THREADS
+    status = self->shm->reconnect(slice);
+    Py_END_ALLOW_THREADS
+    if (status != ShmStatus::Timeout)
+      return status;
+    if (timeout_ms > 0 && (timeout_ms -= slice) <= 0)
+      return status;
+    if (PyErr_CheckSignals() < 0)
+      return ShmStatus::Timeout;
+  }
+}
+
+int reader_init(ReaderObject *self, PyObject *args, PyObject *kwargs) {
+  static const char *keywords[] = {"name", "timeout_ms", nullptr};
+  const char *name = nullptr;
+  int timeout_ms = 0;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s|i",
+                                   const_cast<char **>(keywords), &name,
+                                   &timeout_ms))
+    return -1;
+  if (self->shm) {
+    PyErr_SetString(PyExc_RuntimeError, "Reader already initialized");
+    return -1;
+  }
+  try {
+    self->shm = new ImageShmManager(name);
+  } catch (const std::bad_alloc &) {
+    PyErr_NoMemory();
+    return -1;
+  }
+  ShmStatus status = reader_attach(self, timeout_ms);
+  if (PyErr_Occurred())
+    return -1;
+  if (status != ShmStatus::Success) {
+    raise_status(status);
+    return -1;
+  }
+  return 0;
+}
+
+PyObject *reader_new(PyTypeObject *type, PyObject *, PyObject *) {
+  ReaderObject *self = reinterpret_cast<ReaderObject *>(type->tp_alloc(type, 0));
+  if (self) {
+    self->shm = nullptr;
+    self->live_frames = 0;
+    self->active_waits = 0;
+    self->unmapping = false;
+    self->consumer_id = 0;
+    self->has_consumer = false;
+  }
+  return reinterpret_cast<PyObject *>(self);
+}
+
+void reader_dealloc(ReaderObject *self) {
+  // Frame 持有 Reader 引用，走到这里时已没有存活的 Frame
+  if (self->shm) {
+    if (self->has_consumer)
+      self->shm->unregister_consumer(self->consumer_id);
+    delete self->shm;
+  }
+  PyTypeObject *type = Py_TYPE(self);
+  type->tp_free(reinterpret_cast<PyObject *>(self));
+  Py_DECREF(type); // 堆类型的实例持有类型引用
+}
+
+bool reader_check_open(ReaderObject *self) {
+  if (self->unmapping) {
+    PyErr_SetString(PyExc_ValueError, "reader is being closed or reconnected");
+    return false;
+  }
+  if (self->shm && self->shm->get_shm_ptr())
+    return true;
+  PyErr_SetString(PyExc_ValueError, "reader is not attached");
+  return false;
+}
+
+/**
+ * @brief 可以安全读取映射的管理器，未初始化或正在解除映射时为 nullptr
+ */
+ImageShmManager *reader_manager(ReaderObject *self) {
+  return self->unmapping ? nullptr : self->shm;
+}
+
+PyObject *reader_wait(ReaderObject *self, PyObject *args, PyObject *kwargs) {
+  static const char *keywords[] = {"last_version", "timeout_ms", nullptr};
+  unsigned long long last_version = 0;
+  int timeout_ms = -1;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|Ki",
+                                   const_cast<char **>(keywords),
+                                   &last_version, &timeout_ms))
+    return nullptr;
+  if (!reader_check_open(self))
+    return nullptr;
+  while (true) {
+    int slice = timeout_ms < 0 ? kSignalCheckMs
+                               : std::min(timeout_ms, kSignalCheckMs);
+    ShmStatus status;
+    ++self->active_waits;
+    Py_BEGIN_ALLOW_THREADS
+    status = self->shm->wait_for_new_frame(last_version, slice);
+    Py_END_ALLOW_THREADS
+    --self->active_waits;
+    if (!reader_check_open(self))
+      return nullptr; // 等待期间被其他线程关闭或重新附加
+    if (status == ShmStatus::Success)
+      Py_RETURN_TRUE;
+    if (status != ShmStatus::Timeout)
+      return raise_status(status);
+    if (timeout_ms >= 0 && (timeout_ms -= slice) <= 0)
+      Py_RETURN_FALSE;
+    if (PyErr_CheckSignals() < 0)
+      return nullptr;
+  }
+}
+
+PyObject *reader_acquire(ReaderObject *self, PyObject *) {
+  if (!reader_check_open(self))
+    return nullptr;
+  return frame_from_guard(self, self->shm->acquire_image());
+}
+
+PyObject *reader_acquire_next(ReaderObject *self, PyObject *) {
+  if (!reader_check_open(self))
+    return nullptr;
+  if (!self->has_consumer) {
+    PyErr_SetString(PyExc_RuntimeError,
+                    "call register_consumer() before acquire_next()");
+    return nullptr;
+  }
+  return frame_from_guard(self,
+                          self->shm->acquire_next_image(self->consumer_id));
+}
+
+PyObject *reader_register_consumer(ReaderObject *self, PyObject *) {
+  if (!reader_check_open(self))
+    return nullptr;
+  if (!self->has_consumer) {
+    ShmStatus status = self->shm->register_consumer(&self->consumer_id);
+    if (status != ShmStatus::Success)
+      return raise_status(status);
+    self->has_consumer = true;
+  }
+  return PyLong_FromUnsignedLong(self->consumer_id);
+}
+
+PyObject *reader_unregister_consumer(ReaderObject *self, PyObject *) {
+  if (self->unmapping) {
+    PyErr_SetString(PyExc_ValueError, "reader is being closed or reconnected");
+    return nullptr;
+  }
+  if (self->has_consumer && self->shm && self->shm->get_shm_ptr())
+    self->shm->unregister_consumer(self->consumer_id);
+  self->has_consumer = false;
+  Py_RETURN_NONE;
+}
+
+PyObject *reader_reconnect(ReaderObject *self, PyObject *args,
+                           PyObject *kwargs) {
+  static const char *keywords[] = {"timeout_ms", nullptr};
+  int timeout_ms = -1;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|i",
+                                   const_cast<char **>(keywords), &timeout_ms))
+    return nullptr;
+  if (!self->shm) {
+    PyErr_SetString(PyExc_ValueError, "reader is not initialized");
+    return nullptr;
+  }
+  if (!reader_begin_unmap(self))
+    return nullptr;
+  // 新段的消费者游标表从空开始，队列模式需重新注册
+  bool had_consumer = self->has_consumer;
+  self->has_consumer = false;
+  ShmStatus status = reader_attach(self, timeout_ms);
+  self->unmapping = false;
+  if (PyErr_Occurred())
+    return nullptr;
+  if (status == ShmStatus::Timeout)
+    Py_RETURN_FALSE;
+  if (status != ShmStatus::Success)
+    return raise_status(status);
+  if (had_consumer) {
+    status = self->shm->register_consumer(&self->consumer_id);
+    if (status != ShmStatus::Success)
+      return raise_status(status);
+    self->has_consumer = true;
+  }
+  Py_RETURN_TRUE;
+}
+
+PyObject *reader_producer_restarted(ReaderObject *self, PyObject *) {
+  ImageShmManager *shm = reader_manager(self);
+  return PyBool_FromLong(shm && shm->producer_restarted());
+}
+
+PyObject *reader_fileno(ReaderObject *self, PyObject *) {
+  ImageShmManager *shm = reader_manager(self);
+  if (!shm) {
+    PyErr_SetString(PyExc_ValueError, "reader is not initialized");
+    return nullptr;
+  }
+  int fd = -1;
+  ShmStatus status = shm->get_notify_fd(&fd);
+  if (status != ShmStatus::Success)
+    return raise_status(status);
+  return PyLong_FromLong(fd);
+}
+
+PyObject *reader_consume_notification(ReaderObject *self, PyObject *) {
+  if (ImageShmManager *shm = reader_manager(self))
+    shm->consume_notification();
+  Py_RETURN_NONE;
+}
+
+PyObject *reader_close(ReaderObject *self, PyObject *) {
+  if (!self->shm)
+    Py_RETURN_NONE;
+  if (!reader_begin_unmap(self))
+    return nullptr;
+  if (self->has_consumer && self->shm->get_shm_ptr() != nullptr)
+    self->shm->unregister_consumer(self->consumer_id);
+  self->has_consumer = false;
+  self->shm->unmap_and_close();
+  self->unmapping = false;
+  Py_RETURN_NONE;
+}
+
+PyObject *reader_enter(ReaderObject *self, PyObject *) {
+  Py_INCREF(self);
+  return reinterpret_cast<PyObject *>(self);
+}
+
+PyObject *reader_exit(ReaderObject *self, PyObject *) {
+  PyObject *result = reader_close(self, nullptr);
+  if (!result)
+    return nullptr;
+  Py_DECREF(result);
+  Py_RETURN_FALSE;
+}
+
+PyObject *reader_get_latest_version(ReaderObject *self, void *) {
+  ImageShmManager *shm = reader_manager(self);
+  return PyLong_FromUnsignedLongLong(shm ? shm->get_latest_frame_version() : 0);
+}
+
+PyObject *reader_get_generation(ReaderObject *self, void *) {
+  ImageShmManager *shm = reader_manager(self);
+  return PyLong_FromUnsignedLongLong(shm ? shm->get_generation() : 0);
+}
+
+PyObject *reader_get_buffer_count(ReaderObject *self, void *) {
+  ImageShmManager *shm = reader_manager(self);
+  return PyLong_FromUnsignedLong(shm ? shm->get_buffer_count() : 0);
+}
+
+PyObject *reader_get_max_payload(ReaderObject *self, void *) {
+  ImageShmManager *shm = reader_manager(self);
+  return PyLong_FromSize_t(shm ? shm->get_max_payload_size() : 0);
+}
+
+PyMethodDef reader_methods[] = {
+    {"wait", reinterpret_cast<PyCFunction>(
+         reinterpret_cast<void (*)(void)>(reader_wait)),
+     METH_VARARGS | METH_KEYWORDS,
+     "wait(last_version=0, timeout_ms=-1) -> bool\n"
+     "在 futex 上等待比 last_version 更新的帧（释放 GIL），超时返回 False；"
+     "生产者重启时抛出 ProducerRestarted，"
+     "等待期间被其他线程 close()/reconnect() 时抛出 ValueError"},
+    {"acquire", reinterpret_cast<PyCFunction>(reader_acquire), METH_NOARGS,
+     "acquire() -> Frame | None\n获取最新帧（零拷贝），无数据时返回 None"},
+    {"acquire_next", reinterpret_cast<PyCFunction>(reader_acquire_next),
+     METH_NOARGS,
+     "acquire_next() -> Frame | None\n队列模式：按版本顺序获取下一帧"},
+    {"register_consumer",
+     reinterpret_cast<PyCFunction>(reader_register_consumer), METH_NOARGS,
+     "register_consumer() -> int\n注册为队列模式消费者"},
+    {"unregister_consumer",
+     reinterpret_cast<PyCFunction>(reader_unregister_consumer), METH_NOARGS,
+     "unregister_consumer()\n注销队列模式消费者"},
+    {"reconnect", reinterpret_cast<PyCFunction>(
+         reinterpret_cast<void (*)(void)>(reader_reconnect)),
+     METH_VARARGS | METH_KEYWORDS,
+     "reconnect(timeout_ms=-1) -> bool\n"
+     "解除映射并按名称重新附加（生产者重启后调用），超时返回 False；"
+     "先等待其他线程中的 wait() 退出"},
+    {"producer_restarted",
+     reinterpret_cast<PyCFunction>(reader_producer_restarted), METH_NOARGS,
+     "producer_restarted() -> bool\n附加的段是否已被重启的生产者取代"},
+    {"fileno", reinterpret_cast<PyCFunction>(reader_fileno), METH_NOARGS,
+     "fileno() -> int\n新帧通知 eventfd，可交给 select/selectors/asyncio 等待"},
+    {"consume_notification",
+     reinterpret_cast<PyCFunction>(reader_consume_notification), METH_NOARGS,
+     "consume_notification()\nfileno() 可读后调用，清空计数并等待下一次通知"},
+    {"close", reinterpret_cast<PyCFunction>(reader_close), METH_NOARGS,
+     "close()\n解除映射；仍有存活的 Frame 时抛出 BufferError，"
+     "先等待其他线程中的 wait() 退出"},
+    {"__enter__", reinterpret_cast<PyCFunction>(reader_enter), METH_NOARGS,
+     nullptr},
+    {"__exit__", reinterpret_cast<PyCFunction>(reader_exit), METH_VARARGS,
+     nullptr},
+    {nullptr, nullptr, 0, nullptr}};
+
+PyGetSetDef reader_getset[] = {
+    {const_cast<char *>("latest_version"),
+     reinterpret_cast<getter>(reader_get_latest_version), nullptr,
+     const_cast<char *>("最新已提交帧版本号"), nullptr},
+    {const_cast<char *>("generation"),
+     reinterpret_cast<getter>(reader_get_generation), nullptr,
+     const_cast<char *>("附加时的生产者代数"), nullptr},
+    {const_cast<char *>("buffer_count"),
+     reinterpret_cast<getter>(reader_get_buffer_count), nullptr,
+     const_cast<char *>("槽位数量"), nullptr},
+    {const_cast<char *>("max_payload_size"),
+     reinterpret_cast<getter>(reader_get_max_payload), nullptr,
+     const_cast<char *>("单帧图像数据最大字节数"), nullptr},
+    {nullptr, nullptr, nullptr, nullptr, nullptr}};
+
+PyType_Slot frame_slots[] = {
+    {Py_tp_doc, const_cast<char *>(
+                    "共享内存槽位中的一帧（只读，支持缓冲区协议与 with 语句）")},
+    {Py_tp_dealloc, reinterpret_cast<void *>(frame_dealloc)},
+    {Py_tp_methods, frame_methods},
+    {Py_tp_getset, frame_getset},
+    {Py_bf_getbuffer, reinterpret_cast<void *>(frame_getbuffer)},
+    {Py_bf_releasebuffer, reinterpret_cast<void *>(frame_releasebuffer)},
+    {0, nullptr}};
+
+PyType_Spec frame_spec = {"sensorcomm_shm.Frame", sizeof(FrameObject), 0,
+                          Py_TPFLAGS_DEFAULT, frame_slots};
+
+PyType_Slot reader_slots[] = {
+    {Py_tp_doc,
+     const_cast<char *>("Reader(name, timeout_ms=0)\n"
+                        "按名称附加图像共享内存段；timeout_ms 为负数时一直等待生产者启动")},
+    {Py_tp_new, reinterpret_cast<void *>(reader_new)},
+    {Py_tp_init, reinterpret_cast<void *>(reader_init)},
+    {Py_tp_dealloc, reinterpret_cast<void *>(reader_dealloc)},
+    {Py_tp_methods, reader_methods},
+    {Py_tp_getset, reader_getset},
+    {0, nullptr}};
+
+PyType_Spec reader_spec = {"sensorcomm_shm.Reader", sizeof(ReaderObject), 0,
+                           Py_TPFLAGS_DEFAULT, reader_slots};
+
+PyModuleDef shm_module = {PyModuleDef_HEAD_INIT,
+                          "sensorcomm_shm",
+                          "SensorComm 共享内存图像流的零拷贝读取接口",
+                          -1,
+                          nullptr,
+                          nullptr,
+                          nullptr,
+                          nullptr,
+                          nullptr};
+
+} // namespace
+
+PyMODINIT_FUNC PyInit_sensorcomm_shm(void) {
+  g_frame_type = reinterpret_cast<PyTypeObject *>(PyType_FromSpec(&frame_spec));
+  g_reader_type =
+      reinterpret_cast<PyTypeObject *>(PyType_FromSpec(&reader_spec));
+  if (!g_frame_type || !g_reader_type)
+    return nullptr;
+  // Frame 只能由 Reader.acquire() 创建
+  g_frame_type->tp_new = nullptr;
+
+  PyObject *module = PyModule_Create(&shm_module);
+  if (!module)
+    return nullptr;
+
+  g_shm_error = PyErr_NewExceptionWithDoc(
+      "sensorcomm_shm.ShmError", "共享内存操作失败，args 为 (status, message)",
+      PyExc_RuntimeError, nullptr);
+  g_producer_restarted = PyErr_NewExceptionWithDoc(
+      "sensorcomm_shm.ProducerRestarted",
+      "生产者已重建共享内存段，调用 Reader.reconnect() 重新附加",
+      g_shm_error, nullptr);
+  if (!g_shm_error || !g_producer_restarted) {
+    Py_DECREF(module);
+    return nullptr;
+  }
+
+  Py_INCREF(g_frame_type);
+  Py_INCREF(g_reader_type);
+  Py_INCREF(g_shm_error);
+  Py_INCREF(g_producer_restarted);
+  PyModule_AddObject(module, "Frame", reinterpret_cast<PyObject *>(g_frame_type));
+  PyModule_AddObject(module, "Reader",
+                     reinterpret_cast<PyObject *>(g_reader_type));
+  PyModule_AddObject(module, "ShmError", g_shm_error);
+  PyModule_AddObject(module, "ProducerRestarted", g_producer_restarted);
+
+  PyModule_AddIntConstant(module, "FORMAT_YUYV",
+                          static_cast<int>(ImageFormat::YUYV));
+  PyModule_AddIntConstant(module, "FORMAT_H264",
+                          static_cast<int>(ImageFormat::H264));
+  PyModule_AddIntConstant(module, "FORMAT_BGR",
+                          static_cast<int>(ImageFormat::BGR));
+  PyModule_AddIntConstant(module, "FORMAT_MJPG",
+                          static_cast<int>(ImageFormat::MJPG));
+  PyModule_AddIntConstant(module, "FORMAT_GRAY",
+                          static_cast<int>(ImageFormat::GRAY));
+  PyModule_AddIntConstant(module, "FORMAT_NV12",
+                          static_cast<int>(ImageFormat::NV12));
+  PyModule_AddIntConstant(module, "FORMAT_NV16",
+                          static_cast<int>(ImageFormat::NV16));
+  return module;
+}
@@ -0,0 +1,275 @@
+/**
+ * @file capture_pipeline.cpp
+ * @brief 生产者捕获/发布双线程流水线实现
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 捕获线程热路径上只有 poll(epoll)/DQBUF 与一次无锁入队，不触碰共享内存、
+ * 不做任何输出；VIDIOC_QBUF 由发布线程在写入完成后执行。
+ */
+
+#include "capture_pipeline.h"
+#include "common/concurrency/thread_utils.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+CapturePipeline::CapturePipeline(ICapture &capture, ImageShmManager &shm,
+                                 const CaptureThreadConfig &config)
+    : CapturePipeline(std::vector<CaptureChannel>{{&capture, &shm}}, config) {}
+
+CapturePipeline::CapturePipeline(const std::vector<CaptureChannel> &channels,
+                                 const CaptureThreadConfig &config)
+    : config_(config), use_epoll_(false), epoll_fd_(-1),
+      queue_(total_outstanding(channels)), running_(false),
+      capture_done_(true) {
+  if (channels.empty())
+    throw std::runtime_error("CapturePipeline Error: no capture channels");
+
+  bool all_pollable = true;
+  for (const auto &ch : channels) {
+    auto channel = std::make_unique<Channel>();
+    channel->capture = ch.capture;
+    channel->shm = ch.shm;
+    channel->max_outstanding = ch.capture->get_max_outstanding();
+    channels_.push_back(std::move(channel));
+    all_pollable = all_pollable && ch.capture->get_poll_fd() >= 0;
+  }
+
+  // 单个不支持事件驱动的捕获器仍可使用阻塞出队；多个通道必须共用 epoll
+  if (!all_pollable && channels_.size() > 1)
+    throw std::runtime_error("CapturePipeline Error: multiple channels "
+                             "require captures with a pollable fd");
+  use_epoll_ = all_pollable;
+}
+
+CapturePipeline::~CapturePipeline() {
+  stop();
+  if (epoll_fd_ != -1)
+    close(epoll_fd_);
+}
+
+uint32_t CapturePipeline::total_outstanding(
+    const std::vector<CaptureChannel> &channels) {
+  uint32_t total = 0;
+  for (const auto &ch : channels)
+    total += ch.capture->get_max_outstanding();
+  return total > 0 ? total : 1;
+}
+
+void CapturePipeline::start() {
+  if (running_.load())
+    return;
+
+  if (use_epoll_ && epoll_fd_ == -1) {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ == -1)
+      throw std::runtime_error("CapturePipeline Error: epoll_create1 failed: " +
+                               std::string(strerror(errno)));
+    for (uint32_t i = 0; i < channels_.size(); ++i) {
+      epoll_event event{};
+      event.events = EPOLLIN;
+      event.data.u32 = i;
+      if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD,
+                    channels_[i]->capture->get_poll_fd(), &event) == -1)
+        throw std::runtime_error(
+            "CapturePipeline Error: Failed to watch channel " +
+            std::to_string(i) + ": " + std::string(strerror(errno)));
+    }
+  }
+
+  running_.store(true);
+  capture_done_.store(false);
+  capture_thread_ = std::thread(use_epoll_ ? &CapturePipeline::epoll_loop
+                                           : &CapturePipeline::capture_loop,
+                                this);
+  publish_thread_ = std::thread(&CapturePipeline::publish_loop, this);
+  apply_thread_config(capture_thread_, "capture", config_.capture_cpu,
+                      config_.capture_priority);
+  apply_thread_config(publish_thread_, "publish", config_.publish_cpu,
+                      config_.publish_priority);
+}
+
+void CapturePipeline::stop() {
+  running_.store(false);
+  if (capture_thread_.joinable())
+    capture_thread_.join();
+  if (publish_thread_.joinable())
+    publish_thread_.join();
+}
+
+CapturePipelineStats CapturePipeline::get_stats() const {
+  CapturePipelineStats total;
+  for (size_t i = 0; i < channels_.size(); ++i) {
+    CapturePipelineStats stats = get_stats(i);
+    total.captured += stats.captured;
+    total.published += stats.published;
+    total.dropped += stats.dropped;
+    total.publish_failures += stats.publish_failures;
+    total.device_errors += stats.device_errors;
+  }
+  total.queue_depth = (uint32_t)queue_.size();
+  return total;
+}
+
+CapturePipelineStats CapturePipeline::get_stats(size_t index) const {
+  const Channel &channel = *channels_.at(index);
+  CapturePipelineStats stats;
+  stats.captured = channel.captured.load(std::memory_order_relaxed);
+  stats.published = channel.published.load(std::memory_order_relaxed);
+  stats.dropped = channel.dropped.load(std::memory_order_relaxed);
+  stats.publish_failures =
+      channel.publish_failures.load(std::memory_order_relaxed);
+  stats.device_errors = channel.device_errors.load(std::memory_order_relaxed);
+  stats.queue_depth = channel.outstanding.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void CapturePipeline::apply_thread_config(std::thread &thread,
+                                          const char *name, int cpu,
+                                          int priority) {
+  int ret = pin_thread_to_cpu(thread, cpu);
+  if (ret != 0)
+    std::cerr << "CapturePipeline: Failed to pin " << name << " thread to CPU "
+              << cpu << ": " << strerror(ret) << std::endl;
+  ret = set_thread_fifo_priority(thread, priority);
+  if (ret != 0)
+    std::cerr << "CapturePipeline: Failed to set SCHED_FIFO priority "
+              << priority << " for " << name << " thread: " << strerror(ret)
+              << std::endl;
+}
+
+void CapturePipeline::capture_loop() {
+  ICapture &capture = *channels_[0]->capture;
+  while (running_.load()) {
+    CapturedFrame frame{};
+    if (!capture.dequeue(frame, running_) || !frame.data)
+      continue;
+    dispatch(0, frame);
+  }
+  capture_done_.store(true);
+}
+
+void CapturePipeline::epoll_loop() {
+  epoll_event events[16];
+  while (running_.load()) {
+    // 超时返回以便及时响应 stop()
+    int n = epoll_wait(epoll_fd_, events, 16, 200);
+    if (n < 0 && errno != EINTR) {
+      std::cerr << "CapturePipeline: epoll_wait failed: " << strerror(errno)
+                << std::endl;
+      break;
+    }
+
+    for (int i = 0; i < n; ++i) {
+      uint32_t index = events[i].data.u32;
+      Channel &channel = *channels_[index];
+      CapturedFrame frame{};
+      bool ok = (events[i].events & EPOLLIN) &&
+                channel.capture->dequeue_ready(frame);
+      if (!ok) {
+        // 设备出错（如被拔出）：停止轮询该设备，其余设备不受影响
+        channel.device_errors.fetch_add(1, std::memory_order_relaxed);
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, channel.capture->get_poll_fd(),
+                  nullptr);
+        std::cerr << "CapturePipeline: Device error on channel " << index
+                  << ", no longer polling it" << std::endl;
+        continue;
+      }
+      if (frame.data)
+        dispatch(index, frame);
+    }
+  }
+  capture_done_.store(true);
+}
+
+void CapturePipeline::dispatch(uint32_t index, const CapturedFrame &frame) {
+  Channel &channel = *channels_[index];
+  channel.captured.fetch_add(1, std::memory_order_relaxed);
+
+  if (frame.buffer_index < 0) {
+    // 不支持缓冲区交接：数据只在下一次出队之前有效，就地发布
+    publish(channel, frame);
+    return;
+  }
+
+  // 先占用名额再入队，发布线程归还时不会出现计数下溢
+  if (channel.outstanding.fetch_add(1, std::memory_order_acq_rel) >=
+          channel.max_outstanding ||
+      !queue_.try_push(Handoff{index, frame})) {
+    channel.outstanding.fetch_sub(1, std::memory_order_acq_rel);
+    channel.dropped.fetch_add(1, std::memory_order_relaxed);
+    release(channel, frame);
+  }
+}
+
+void CapturePipeline::publish_loop() {
+  for (;;) {
+    Handoff item{};
+    if (!queue_.wait_pop(item, 100)) {
+      if (!capture_done_.load())
+        continue;
+      // 捕获线程已退出：排空队列，保证缓冲区全部归还后再退出
+      if (!queue_.try_pop(item))
+        break;
+    }
+    Channel &channel = *channels_[item.channel];
+    publish(channel, item.frame);
+    release(channel, item.frame);
+    channel.outstanding.fetch_sub(1, std::memory_order_acq_rel);
+  }
+}
+
+void CapturePipeline::publish(Channel &channel, const CapturedFrame &frame) {
+  ShmStatus status = ShmStatus::Success;
+  if (!frame.published) {
+    const uint32_t channels = (frame.format == ImageFormat::YUYV) ? 2 : 3;
+    const uint64_t version =
+        channel.next_frame_version.fetch_add(1, std::memory_order_relaxed);
+    status = frame.chroma_data
+                 ? write_split_planes(*channel.shm, frame, channels, version)
+                 : channel.shm->write_image(
+                       frame.data, frame.size, frame.width, frame.height,
+                       channels, version, frame.format, frame.cv_type,
+                       frame.timestamp_us, frame.dequeue_timestamp_us,
+                       frame.planes);
+  }
+  if (status == ShmStatus::Success)
+    channel.published.fetch_add(1, std::memory_order_relaxed);
+  else
+    channel.publish_failures.fetch_add(1, std::memory_order_relaxed);
+}
+
+ShmStatus CapturePipeline::write_split_planes(ImageShmManager &shm,
+                                              const CapturedFrame &frame,
+                                              uint32_t channels,
+                                              uint64_t version) {
+  const size_t chroma_offset = frame.planes.offsets[1];
+  if (!frame.data || chroma_offset < frame.size)
+    return ShmStatus::InvalidArguments;
+  const size_t total_size = chroma_offset + frame.chroma_size;
+  if (total_size > shm.get_max_payload_size())
+    return ShmStatus::BufferTooSmall;
+
+  WriteImageGuard image = shm.acquire_image_for_write(total_size);
+  if (!image.is_valid())
+    return ShmStatus::BufferInUse;
+  memcpy(image.data(), frame.data, frame.size);
+  memcpy(image.data() + chroma_offset, frame.chroma_data, frame.chroma_size);
+  return image.commit(total_size, frame.width, frame.height, channels, version,
+                      frame.format, frame.cv_type, frame.timestamp_us,
+                      frame.dequeue_timestamp_us, frame.planes);
+}
+
+void CapturePipeline::release(Channel &channel, const CapturedFrame &frame) {
+  try {
+    channel.capture->release(frame);
+  } catch (const std::exception &e) {
+    std::cerr << "CapturePipeline: Failed to re-queue buffer "
+              << frame.buffer_index << ": " << e.what() << std::endl;
+  }
+}
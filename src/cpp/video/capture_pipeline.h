@@ -0,0 +1,208 @@
+/**
+ * @file capture_pipeline.h
+ * @brief 生产者捕获/发布双线程流水线
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 该文件定义了把驱动出队（VIDIOC_DQBUF）与共享内存发布解耦的流水线。
+ * 捕获线程只负责出队并把缓冲区交给发布线程，两者之间通过无锁 SPSC
+ * 队列传递帧描述符；发布完成后才把缓冲区重新入队（VIDIOC_QBUF），
+ * 共享内存写入或日志输出的抖动不会再推迟下一次出队。
+ *
+ * 一条流水线可以驱动多个摄像头：捕获线程用一个 epoll 循环等待全部设备，
+ * 每个设备写入各自的共享内存通道，线程数不随摄像头数量增长。
+ */
+
+#ifndef CAPTURE_PIPELINE_H
+#define CAPTURE_PIPELINE_H
+
+#include "common/concurrency/spsc_queue.h"
+#include "config/config_manager.h"
+#include "video/formats/capture_interface.h"
+#include "video/image_shm_manager.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief 捕获流水线统计信息
+ */
+struct CapturePipelineStats {
+  uint64_t captured = 0;         ///< 从设备取出的帧数
+  uint64_t published = 0;        ///< 成功发布到共享内存的帧数
+  uint64_t dropped = 0;          ///< 发布线程积压时直接归还设备的帧数
+  uint64_t publish_failures = 0; ///< 共享内存写入失败次数
+  uint64_t device_errors = 0;    ///< 设备出错次数（出错的设备不再被轮询）
+  uint32_t queue_depth = 0;      ///< 当前等待发布的帧数（全部通道）
+};
+
+/**
+ * @brief 捕获通道：一个捕获器及其输出共享内存
+ */
+struct CaptureChannel {
+  ICapture *capture;    ///< 已创建的捕获器
+  ImageShmManager *shm; ///< 已初始化的输出共享内存
+};
+
+/**
+ * @brief 捕获/发布双线程流水线
+ *
+ * - 捕获线程：单个通道时循环调用 ICapture::dequeue()；捕获器都提供
+ *   ICapture::get_poll_fd() 时用一个 epoll 循环等待所有通道，就绪后
+ *   调用 ICapture::dequeue_ready()。帧描述符推入 SPSC 队列；某个通道
+ *   持有的缓冲区达到 ICapture::get_max_outstanding() 时，该通道的新帧
+ *   立即 release() 并计为丢弃，保证驱动队列中始终留有缓冲区；
+ * - 发布线程：从队列取出帧，写入对应通道的共享内存后调用
+ *   ICapture::release() 归还缓冲区。
+ *
+ * 捕获器不支持缓冲区交接（get_max_outstanding() 为 0，或帧的
+ * buffer_index 为 -1）时，帧在捕获线程内就地发布，行为与单线程循环一致。
+ *
+ * @note 调用 start() 前捕获器须已 start()；捕获器须在 stop() 之后才能停止
+ */
+class CapturePipeline {
+public:
+  /**
+   * @brief 构造单通道流水线
+   * @param capture 已创建的捕获器
+   * @param shm 已初始化的输出共享内存
+   * @param config 线程绑定与调度配置
+   */
+  CapturePipeline(ICapture &capture, ImageShmManager &shm,
+                  const CaptureThreadConfig &config);
+
+  /**
+   * @brief 构造多通道流水线
+   * @param channels 捕获通道列表（至少一个）
+   * @param config 线程绑定与调度配置
+   * @throws std::runtime_error 当多个通道中有捕获器不支持 get_poll_fd() 时抛出异常
+   */
+  CapturePipeline(const std::vector<CaptureChannel> &channels,
+                  const CaptureThreadConfig &config);
+
+  /**
+   * @brief 析构函数，停止两个线程
+   */
+  ~CapturePipeline();
+
+  CapturePipeline(const CapturePipeline &) = delete;
+  CapturePipeline &operator=(const CapturePipeline &) = delete;
+
+  /**
+   * @brief 启动捕获线程与发布线程，并应用绑定/调度配置
+   * @throws std::runtime_error 当 epoll 实例创建或设备注册失败时抛出异常
+   */
+  void start();
+
+  /**
+   * @brief 停止捕获线程，发布线程处理完队列中剩余帧后退出
+   *
+   * 返回时调用者已不再持有任何设备缓冲区。
+   */
+  void stop();
+
+  /**
+   * @brief 获取全部通道汇总的统计信息
+   */
+  CapturePipelineStats get_stats() const;
+
+  /**
+   * @brief 获取单个通道的统计信息
+   * @param channel 通道序号（与构造时的顺序一致）
+   */
+  CapturePipelineStats get_stats(size_t channel) const;
+
+  /**
+   * @brief 通道数量
+   */
+  size_t get_channel_count() const { return channels_.size(); }
+
+private:
+  /**
+   * @brief 单个通道的运行状态
+   */
+  struct Channel {
+    ICapture *capture;              ///< 捕获器
+    ImageShmManager *shm;           ///< 输出共享内存
+    uint32_t max_outstanding;       ///< 可同时持有的设备缓冲区数量
+    std::atomic<uint32_t> outstanding{0};       ///< 已出队、尚未归还的缓冲区数量
+    std::atomic<uint64_t> next_frame_version{1}; ///< 下一帧的帧版本号
+    std::atomic<uint64_t> captured{0};          ///< 出队帧数
+    std::atomic<uint64_t> published{0};         ///< 发布帧数
+    std::atomic<uint64_t> dropped{0};           ///< 丢弃帧数
+    std::atomic<uint64_t> publish_failures{0};  ///< 写入失败次数
+    std::atomic<uint64_t> device_errors{0};     ///< 设备出错次数
+  };
+
+  /**
+   * @brief 队列元素：通道序号与帧描述符
+   */
+  struct Handoff {
+    uint32_t channel;    ///< 通道序号
+    CapturedFrame frame; ///< 帧描述符
+  };
+
+  /**
+   * @brief 捕获线程主循环（单通道、阻塞出队）
+   */
+  void capture_loop();
+
+  /**
+   * @brief 捕获线程主循环（多通道、epoll 事件驱动）
+   */
+  void epoll_loop();
+
+  /**
+   * @brief 处理捕获线程取出的一帧：就地发布或交给发布线程
+   */
+  void dispatch(uint32_t index, const CapturedFrame &frame);
+
+  /**
+   * @brief 发布线程主循环
+   */
+  void publish_loop();
+
+  /**
+   * @brief 将一帧写入共享内存（已由捕获器提交的帧只计数）
+   */
+  void publish(Channel &channel, const CapturedFrame &frame);
+
+  /**
+   * @brief 把两个平面分处独立缓冲区的帧（NV12M/NV16M）拼接写入一个槽位
+   */
+  static ShmStatus write_split_planes(ImageShmManager &shm,
+                                      const CapturedFrame &frame,
+                                      uint32_t channels, uint64_t version);
+
+  /**
+   * @brief 归还缓冲区，失败时打印错误
+   */
+  void release(Channel &channel, const CapturedFrame &frame);
+
+  /**
+   * @brief 对线程应用 CPU 绑定与 SCHED_FIFO 配置，失败时打印警告
+   */
+  static void apply_thread_config(std::thread &thread, const char *name,
+                                  int cpu, int priority);
+
+  /**
+   * @brief 计算全部通道可同时持有的缓冲区总数（队列容量）
+   */
+  static uint32_t total_outstanding(const std::vector<CaptureChannel> &channels);
+
+  std::vector<std::unique_ptr<Channel>> channels_; ///< 捕获通道
+  CaptureThreadConfig config_;    ///< 线程配置
+  bool use_epoll_;                ///< 是否使用 epoll 循环
+  int epoll_fd_;                  ///< epoll 实例，未使用时为 -1
+  SpscQueue<Handoff> queue_;      ///< 捕获线程到发布线程的帧队列
+
+  std::thread capture_thread_;     ///< 捕获线程
+  std::thread publish_thread_;     ///< 发布线程
+  std::atomic<bool> running_;      ///< 捕获线程运行标志
+  std::atomic<bool> capture_done_; ///< 捕获线程已退出，发布线程排空后退出
+};
+
+#endif // CAPTURE_PIPELINE_H
@@ -0,0 +1,441 @@
+/**
+ * @file decode_cache.cpp
+ * @brief 多消费者共享的解码缓存实现
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 请求通过控制块中的 futex 字传递：消费者先以取最大值的方式写入
+ * requested_version，再递增 request_seq 并唤醒服务；服务按序读取二者，
+ * 看到新的序号时必然也看到对应的版本号。解码结果的就绪通知复用缓存
+ * 共享内存自身的新帧 futex。
+ */
+
+#include "decode_cache.h"
+#include "config/factory.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <linux/futex.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr long SERVICE_WAIT_NS = 100 * 1000000L; ///< 服务等待请求的超时，用于响应 stop()
+constexpr uint64_t SERVICE_TIMEOUT_US = 1000000; ///< 心跳超过该时间视为服务已退出
+constexpr uint64_t ATTACH_INTERVAL_US = 1000000; ///< 消费者重新尝试附加的最小间隔
+
+// 控制块跨进程使用，因此不能使用 FUTEX_PRIVATE_FLAG
+long futex_wait(std::atomic<uint32_t> *addr, uint32_t expected,
+                const struct timespec *timeout) {
+  return syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAIT,
+                 expected, timeout, nullptr, 0);
+}
+
+long futex_wake_all(std::atomic<uint32_t> *addr) {
+  return syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAKE,
+                 INT_MAX, nullptr, nullptr, 0);
+}
+
+std::string control_name(const std::string &cache_name) {
+  return cache_name + "_ctl";
+}
+
+/**
+ * @brief 创建或打开并映射控制块
+ * @return DecodeCacheControl* 映射地址，失败或尚未完成 ftruncate 时为 nullptr
+ */
+DecodeCacheControl *map_control(const std::string &name, bool create) {
+  int fd;
+  if (create) {
+    shm_unlink(name.c_str()); // 清理之前可能残留的控制块
+    fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+    if (fd != -1 && ftruncate(fd, sizeof(DecodeCacheControl)) == -1) {
+      close(fd);
+      shm_unlink(name.c_str());
+      return nullptr;
+    }
+  } else {
+    fd = shm_open(name.c_str(), O_RDWR, 0666);
+    struct stat info;
+    if (fd != -1 && (fstat(fd, &info) == -1 ||
+                     (size_t)info.st_size < sizeof(DecodeCacheControl))) {
+      close(fd);
+      return nullptr;
+    }
+  }
+  if (fd == -1)
+    return nullptr;
+  void *addr = mmap(nullptr, sizeof(DecodeCacheControl),
+                    PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  return addr == MAP_FAILED ? nullptr : static_cast<DecodeCacheControl *>(addr);
+}
+
+void unmap_control(DecodeCacheControl *control) {
+  munmap(control, sizeof(DecodeCacheControl));
+}
+
+DecodeCacheStats read_stats(const DecodeCacheControl *control) {
+  DecodeCacheStats stats;
+  if (!control)
+    return stats;
+  stats.hits = control->hits.load(std::memory_order_relaxed);
+  stats.misses = control->misses.load(std::memory_order_relaxed);
+  stats.fallbacks = control->fallbacks.load(std::memory_order_relaxed);
+  stats.decodes = control->decodes.load(std::memory_order_relaxed);
+  stats.expired = control->expired.load(std::memory_order_relaxed);
+  stats.errors = control->errors.load(std::memory_order_relaxed);
+  return stats;
+}
+
+ReadImageGuard no_image() { return ReadImageGuard(ReadBufferGuard(nullptr)); }
+
+/**
+ * @brief 在环中查找指定版本的帧
+ *
+ * 先看最新帧；已有更新的帧提交时再批量取回环内较旧的帧，
+ * 批量获取前释放最新帧，避免多占一个槽位。
+ */
+ReadImageGuard find_frame(ImageShmManager &shm, uint64_t frame_version,
+                          std::vector<ReadImageGuard> &batch) {
+  {
+    ReadImageGuard latest = shm.acquire_image();
+    if (!latest.is_valid() || latest.frame_version() < frame_version)
+      return no_image();
+    if (latest.frame_version() == frame_version)
+      return latest;
+  }
+  ReadImageGuard found = no_image();
+  const uint32_t k = std::max(shm.get_buffer_count(), 2u) - 1;
+  if (shm.acquire_image_batch(k, &batch) == ShmStatus::Success) {
+    for (ReadImageGuard &image : batch) {
+      if (image.frame_version() == frame_version) {
+        found = std::move(image);
+        break;
+      }
+    }
+  }
+  batch.clear();
+  return found;
+}
+
+} // namespace
+
+// ========== DecodeCacheService ==========
+DecodeCacheService::DecodeCacheService(ImageShmManager &source,
+                                       const DecodeCacheConfig &config,
+                                       const ShmMapOptions &map_options)
+    : source_(source), config_(config), map_options_(map_options),
+      control_(nullptr), last_served_(0), running_(false) {}
+
+DecodeCacheService::~DecodeCacheService() { stop(); }
+
+void DecodeCacheService::start() {
+  if (running_.load())
+    return;
+  if (config_.name.empty())
+    throw std::runtime_error("DecodeCacheService Error: Cache name is empty");
+
+  control_ = map_control(control_name(config_.name), true);
+  if (!control_)
+    throw std::runtime_error("DecodeCacheService Error: Failed to create "
+                             "control block '" +
+                             control_name(config_.name) + "'");
+  control_->source_generation.store(source_.get_generation(),
+                                    std::memory_order_relaxed);
+  control_->service_heartbeat_us.store(monotonic_now_us(),
+                                       std::memory_order_relaxed);
+  control_->magic.store(DecodeCacheControl::MAGIC, std::memory_order_release);
+
+  std::cout << "DecodeCacheService: Serving decoded frames at '"
+            << config_.name << "' (" << config_.buffer_count << " buffers)"
+            << std::endl;
+  running_.store(true);
+  worker_ = std::thread(&DecodeCacheService::run, this);
+}
+
+void DecodeCacheService::stop() {
+  running_.store(false);
+  if (worker_.joinable())
+    worker_.join();
+  drop_cache();
+  if (control_) {
+    // 清除 magic，仍附加的消费者随即解除映射并回退到本地解码
+    control_->magic.store(0, std::memory_order_release);
+    unmap_control(control_);
+    shm_unlink(control_name(config_.name).c_str());
+    control_ = nullptr;
+  }
+}
+
+DecodeCacheStats DecodeCacheService::get_stats() const {
+  return read_stats(control_);
+}
+
+void DecodeCacheService::run() {
+  uint32_t seen = control_->request_seq.load(std::memory_order_acquire);
+  while (running_.load()) {
+    control_->service_heartbeat_us.store(monotonic_now_us(),
+                                         std::memory_order_relaxed);
+    const struct timespec timeout = {0, SERVICE_WAIT_NS};
+    futex_wait(&control_->request_seq, seen, &timeout);
+
+    const uint32_t seq = control_->request_seq.load(std::memory_order_acquire);
+    if (seq == seen) {
+      check_source();
+      continue;
+    }
+    seen = seq;
+
+    // 并发的请求合并为最大版本；已发布或更旧的版本不再解码
+    const uint64_t version =
+        control_->requested_version.load(std::memory_order_acquire);
+    if (version <= last_served_)
+      continue;
+    try {
+      serve(version);
+    } catch (const std::exception &e) {
+      control_->errors.fetch_add(1, std::memory_order_relaxed);
+      std::cerr << "DecodeCacheService: Failed to decode frame " << version
+                << ": " << e.what() << std::endl;
+    }
+  }
+}
+
+bool DecodeCacheService::serve(uint64_t frame_version) {
+  ReadImageGuard image = find_frame(source_, frame_version, batch_);
+  if (!image.is_valid()) {
+    // 帧已被主流覆盖，或请求来自重启前的主流
+    control_->expired.fetch_add(1, std::memory_order_relaxed);
+    check_source();
+    return false;
+  }
+
+  const ImageHeader &header = image.header();
+  // H264 帧之间有参考关系，按需跳跃解码得不到正确画面
+  if (header.format == ImageFormat::H264 ||
+      header.format == ImageFormat::BGR)
+    throw std::runtime_error("format " + std::to_string((int)header.format) +
+                             " is not served by the decode cache");
+  auto it = decoders_.find(header.format);
+  if (it == decoders_.end())
+    it = decoders_
+             .emplace(header.format, Factory::create_decoder(header.format))
+             .first;
+
+  const size_t expected = (size_t)header.width * header.height * 3;
+  if (expected == 0 || !ensure_cache(expected)) {
+    control_->errors.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  WriteImageGuard slot = cache_->acquire_image_for_write(expected);
+  if (!slot.is_valid()) {
+    control_->errors.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  // 输出 Mat 直接包装缓存槽位，分辨率与头部一致时解码原地写入
+  cv::Mat out(header.height, header.width, CV_8UC3, slot.data());
+  it->second->decode_into(image.data(), header, out);
+  const size_t frame_bytes = out.total() * out.elemSize();
+  bool ok = !out.empty() && out.type() == CV_8UC3;
+  if (ok && out.data != slot.data()) {
+    // 实际分辨率与头部不符，解码器重新分配了输出，退化为拷贝
+    ok = out.isContinuous() && frame_bytes <= slot.capacity();
+    if (ok)
+      std::memcpy(slot.data(), out.data, frame_bytes);
+  }
+  ok = ok && slot.commit(frame_bytes, out.cols, out.rows, 3,
+                         image.frame_version(), ImageFormat::BGR, CV_8UC3,
+                         header.capture_timestamp_us,
+                         header.dequeue_timestamp_us) == ShmStatus::Success;
+  if (!ok) {
+    control_->errors.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  last_served_ = image.frame_version();
+  control_->decodes.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+bool DecodeCacheService::ensure_cache(size_t frame_bytes) {
+  if (cache_ && cache_->get_max_payload_size() >= frame_bytes)
+    return true;
+
+  drop_cache();
+  const size_t buffer_size = ShmBufferControl::align_up(
+      ImageShmManager::payload_offset() + frame_bytes,
+      ShmBufferControl::PAGE_SIZE);
+  const size_t total_size =
+      ShmBufferControl::get_required_size(config_.buffer_count, buffer_size);
+  auto cache = std::make_unique<ImageShmManager>(config_.name, map_options_);
+  cache->unlink_shm(); // 清理之前可能残留的共享内存
+  if (cache->create_and_init(total_size, buffer_size, config_.buffer_count) !=
+      ShmStatus::Success) {
+    std::cerr << "DecodeCacheService: Failed to create cache '"
+              << config_.name << "'" << std::endl;
+    return false;
+  }
+  std::cout << "DecodeCacheService: Created cache '" << config_.name << "' ("
+            << config_.buffer_count << " x " << buffer_size << " bytes)"
+            << std::endl;
+  cache_ = std::move(cache);
+  return true;
+}
+
+void DecodeCacheService::drop_cache() {
+  last_served_ = 0;
+  if (!cache_)
+    return;
+  // 标记为已取代后删除，附加在旧缓存上的消费者重新附加
+  cache_->unmap_and_close();
+  cache_->unlink_shm();
+  cache_.reset();
+}
+
+void DecodeCacheService::check_source() {
+  if (source_.is_initialized() && !source_.producer_restarted())
+    return;
+  // 新生产者的帧版本从头计数，旧缓存中的同版本号帧不能再命中
+  drop_cache();
+  if (source_.reconnect(100) != ShmStatus::Success)
+    return;
+  // 旧主流的请求版本号可能远大于新主流的帧版本，取最大值的请求会被它
+  // 一直压住；先清零再发布新代数，消费者看到新代数时请求字已复位
+  control_->requested_version.store(0, std::memory_order_relaxed);
+  control_->source_generation.store(source_.get_generation(),
+                                    std::memory_order_release);
+  std::cout << "DecodeCacheService: Re-attached to source (generation "
+            << source_.get_generation() << ")" << std::endl;
+}
+
+// ========== DecodeCacheClient ==========
+DecodeCacheClient::DecodeCacheClient(const std::string &cache_name,
+                                     const ImageShmManager &source,
+                                     const ShmMapOptions &map_options)
+    : name_(cache_name), source_(source), cache_(cache_name, map_options),
+      control_(nullptr), last_attach_us_(0) {}
+
+DecodeCacheClient::~DecodeCacheClient() { detach(); }
+
+bool DecodeCacheClient::attach() {
+  const uint64_t now = monotonic_now_us();
+  if (control_) {
+    // 服务正常退出时清除 magic；崩溃时心跳停止更新
+    if (control_->magic.load(std::memory_order_acquire) ==
+            DecodeCacheControl::MAGIC &&
+        now < control_->service_heartbeat_us.load(std::memory_order_relaxed) +
+                  SERVICE_TIMEOUT_US)
+      return true;
+    detach();
+  }
+  if (last_attach_us_ != 0 && now - last_attach_us_ < ATTACH_INTERVAL_US)
+    return false;
+  last_attach_us_ = now;
+
+  control_ = map_control(control_name(name_), false);
+  if (!control_)
+    return false;
+  if (control_->magic.load(std::memory_order_acquire) !=
+          DecodeCacheControl::MAGIC ||
+      now >= control_->service_heartbeat_us.load(std::memory_order_relaxed) +
+                 SERVICE_TIMEOUT_US) {
+    unmap_control(control_);
+    control_ = nullptr;
+    return false;
+  }
+  cache_.open_and_map(); // 缓存在首次请求时才创建，此时可能尚不存在
+  return true;
+}
+
+void DecodeCacheClient::detach() {
+  cache_.unmap_and_close();
+  if (control_) {
+    unmap_control(control_);
+    control_ = nullptr;
+  }
+}
+
+DecodeCacheStats DecodeCacheClient::get_stats() const {
+  return read_stats(control_);
+}
+
+ReadImageGuard DecodeCacheClient::find(uint64_t frame_version) {
+  if (cache_.is_initialized() && cache_.producer_restarted())
+    cache_.unmap_and_close(); // 服务重建了缓存
+  if (!cache_.is_initialized() && cache_.open_and_map() != ShmStatus::Success)
+    return no_image();
+  return find_frame(cache_, frame_version, batch_);
+}
+
+ReadImageGuard DecodeCacheClient::acquire(uint64_t frame_version,
+                                          int timeout_ms) {
+  if (!attach())
+    return no_image();
+  if (control_->source_generation.load(std::memory_order_acquire) !=
+      source_.get_generation()) {
+    // 服务与调用者附加的不是同一个主流段（其中一方尚未重新附加）
+    control_->fallbacks.fetch_add(1, std::memory_order_relaxed);
+    return no_image();
+  }
+
+  ReadImageGuard image = find(frame_version);
+  if (image.is_valid()) {
+    control_->hits.fetch_add(1, std::memory_order_relaxed);
+    return image;
+  }
+
+  // 请求字超过主流最新版本说明它来自重启前的主流（服务复位前有消费者
+  // 仍按旧段写入），此时直接覆盖而不是取最大值
+  const uint64_t source_latest = source_.get_latest_frame_version();
+  uint64_t requested =
+      control_->requested_version.load(std::memory_order_relaxed);
+  while ((requested < frame_version || requested > source_latest) &&
+         !control_->requested_version.compare_exchange_weak(
+             requested, frame_version, std::memory_order_release,
+             std::memory_order_relaxed)) {
+  }
+  control_->request_seq.fetch_add(1, std::memory_order_release);
+  futex_wake_all(&control_->request_seq);
+
+  const uint64_t deadline_us =
+      monotonic_now_us() + (uint64_t)std::max(timeout_ms, 0) * 1000;
+  while (true) {
+    uint64_t latest = 0;
+    if (cache_.is_initialized()) {
+      latest = cache_.get_latest_frame_version();
+      if (latest >= frame_version) {
+        image = find(frame_version);
+        if (image.is_valid()) {
+          control_->misses.fetch_add(1, std::memory_order_relaxed);
+          return image;
+        }
+        break; // 服务已发布更新的帧，该版本被跳过
+      }
+    }
+    const uint64_t now = monotonic_now_us();
+    if (now >= deadline_us)
+      break;
+    const int remaining_ms = (int)((deadline_us - now + 999) / 1000);
+    if (!cache_.is_initialized()) {
+      // 首次请求时缓存尚未创建，短暂休眠后重试附加
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      cache_.open_and_map();
+    } else {
+      ShmStatus status = cache_.wait_for_new_frame(latest, remaining_ms);
+      if (status == ShmStatus::ProducerRestarted ||
+          status == ShmStatus::NotInitialized)
+        cache_.unmap_and_close();
+    }
+  }
+  control_->fallbacks.fetch_add(1, std::memory_order_relaxed);
+  return no_image();
+}
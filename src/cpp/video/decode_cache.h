@@ -0,0 +1,231 @@
+/**
+ * @file decode_cache.h
+ * @brief 多消费者共享的解码缓存
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 同一节点上多个消费者读取同一路 MJPEG 时，每个消费者各自对同一帧
+ * 做一次完整的 JPEG 解码。解码缓存把解码集中到一个服务进程：消费者
+ * 先按主流帧版本号查找缓存，未命中时通过控制块向服务发出请求，服务
+ * 解码一次后把 BGR 结果发布到缓存共享内存，之后的消费者直接命中。
+ *
+ * 共享内存保持单写者模型：缓存环只由服务写入，消费者只写控制块中的
+ * 请求字与计数器。
+ */
+
+#ifndef DECODE_CACHE_H
+#define DECODE_CACHE_H
+
+#include "config/config_manager.h"
+#include "video/formats/decoder_interface.h"
+#include "video/image_shm_manager.h"
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief 解码缓存控制块（独立的小共享内存 "<缓存名>_ctl"）
+ *
+ * 由服务创建并初始化，magic 最后写入；消费者附加时校验 magic。
+ * 请求字与计数器分处不同缓存行，请求频繁时不与统计读取互相干扰。
+ */
+struct DecodeCacheControl {
+  static constexpr uint32_t MAGIC = 0x44434331; ///< "DCC1"
+
+  std::atomic<uint32_t> magic;              ///< 初始化完成标志
+  std::atomic<uint64_t> source_generation;  ///< 缓存内容对应的主流段代数
+  std::atomic<uint64_t> service_heartbeat_us; ///< 服务最近一次循环的时间（CLOCK_MONOTONIC 微秒）
+
+  alignas(64) std::atomic<uint32_t> request_seq; ///< 请求序号（futex 字），每次请求递增
+  std::atomic<uint64_t> requested_version;       ///< 被请求的最大主流帧版本号，主流重启时由服务清零
+
+  alignas(64) std::atomic<uint64_t> hits; ///< 直接命中缓存的次数
+  std::atomic<uint64_t> misses;           ///< 未命中、等待服务解码后取得的次数
+  std::atomic<uint64_t> fallbacks;        ///< 服务未能在超时内提供、由消费者本地解码的次数
+  std::atomic<uint64_t> decodes;          ///< 服务解码并发布的帧数
+  std::atomic<uint64_t> expired;          ///< 请求的帧已被主流覆盖而无法解码的次数
+  std::atomic<uint64_t> errors;           ///< 服务解码或写入失败次数
+};
+
+/**
+ * @brief 解码缓存统计快照（所有附加进程累计）
+ */
+struct DecodeCacheStats {
+  uint64_t hits = 0;      ///< 直接命中次数
+  uint64_t misses = 0;    ///< 等待服务解码后取得的次数
+  uint64_t fallbacks = 0; ///< 回退到本地解码的次数
+  uint64_t decodes = 0;   ///< 服务解码帧数
+  uint64_t expired = 0;   ///< 请求帧已被覆盖的次数
+  uint64_t errors = 0;    ///< 服务失败次数
+};
+
+/**
+ * @brief 解码缓存服务
+ *
+ * 后台线程在控制块的请求字上等待（futex），被唤醒后在主流环中找到
+ * 被请求的帧，用 Factory::create_decoder() 创建的解码器直接解码到缓存
+ * 槽位，以 ImageFormat::BGR 提交，帧版本号与采集/出队时间戳沿用主流帧。
+ * 只解码被请求的帧，没有消费者时不消耗 CPU；同一版本只解码一次，
+ * 比已发布版本更旧的请求直接忽略。
+ *
+ * 缓存共享内存在首次请求时按主流分辨率创建，分辨率变大或主流生产者
+ * 重启时删除重建，消费者据此重新附加，不会读到旧段的同版本号帧。
+ */
+class DecodeCacheService {
+public:
+  /**
+   * @brief 构造函数
+   * @param source 已附加的主流共享内存，服务线程独占使用（包括重新附加）
+   * @param config 缓存配置（名称不能为空）
+   * @param map_options 缓存共享内存映射选项
+   */
+  DecodeCacheService(ImageShmManager &source, const DecodeCacheConfig &config,
+                     const ShmMapOptions &map_options);
+
+  /**
+   * @brief 析构函数，停止服务并删除缓存与控制块共享内存
+   */
+  ~DecodeCacheService();
+
+  DecodeCacheService(const DecodeCacheService &) = delete;
+  DecodeCacheService &operator=(const DecodeCacheService &) = delete;
+
+  /**
+   * @brief 创建控制块并启动服务线程
+   * @throws std::runtime_error 当名称为空或控制块创建失败时抛出异常
+   */
+  void start();
+
+  /**
+   * @brief 停止服务线程，删除缓存与控制块共享内存
+   */
+  void stop();
+
+  /**
+   * @brief 获取统计信息（含全部消费者的命中计数）
+   */
+  DecodeCacheStats get_stats() const;
+
+private:
+  /**
+   * @brief 服务线程主循环
+   */
+  void run();
+
+  /**
+   * @brief 解码并发布指定版本的主流帧
+   * @return bool 是否发布成功
+   */
+  bool serve(uint64_t frame_version);
+
+  /**
+   * @brief 确保缓存共享内存可容纳 frame_bytes 字节的 BGR 帧
+   * @return bool 缓存是否可用
+   */
+  bool ensure_cache(size_t frame_bytes);
+
+  /**
+   * @brief 删除缓存共享内存（重建前或停止时）
+   */
+  void drop_cache();
+
+  /**
+   * @brief 检查主流生产者是否重启，是则重新附加并清空缓存
+   */
+  void check_source();
+
+  ImageShmManager &source_;   ///< 主流共享内存
+  DecodeCacheConfig config_;  ///< 缓存配置
+  ShmMapOptions map_options_; ///< 缓存映射选项
+  std::unique_ptr<ImageShmManager> cache_; ///< 缓存共享内存，首次请求时创建
+  DecodeCacheControl *control_; ///< 控制块映射
+  std::map<ImageFormat, std::unique_ptr<IDecoder>> decoders_; ///< 按格式创建的解码器
+  std::vector<ReadImageGuard> batch_; ///< 在主流环中查找旧帧的临时列表
+  uint64_t last_served_;      ///< 已发布的最新版本号
+  std::thread worker_;        ///< 服务线程
+  std::atomic<bool> running_; ///< 运行标志
+};
+
+/**
+ * @brief 消费者侧解码缓存客户端
+ *
+ * acquire() 的查找顺序：
+ * 1. 缓存中已有该版本 → 命中（hits）；
+ * 2. 否则发出请求并在缓存的 futex 上等待至多 timeout_ms → 取得（misses）；
+ * 3. 仍未取得（服务未运行、帧已被覆盖或超时）→ 返回无效守卫（fallbacks），
+ *    调用者应自行解码该帧。
+ *
+ * 服务尚未启动或缓存尚未创建时每秒最多尝试附加一次，期间全部回退。
+ *
+ * @note 非线程安全，每个线程应使用独立实例
+ */
+class DecodeCacheClient {
+public:
+  /**
+   * @brief 构造函数，不立即附加
+   * @param cache_name 缓存共享内存名称
+   * @param source 调用者读取的主流共享内存，用于校验缓存对应的主流段代数
+   * @param map_options 缓存共享内存映射选项
+   */
+  DecodeCacheClient(const std::string &cache_name,
+                    const ImageShmManager &source,
+                    const ShmMapOptions &map_options = ShmMapOptions());
+
+  /**
+   * @brief 析构函数，解除映射
+   */
+  ~DecodeCacheClient();
+
+  DecodeCacheClient(const DecodeCacheClient &) = delete;
+  DecodeCacheClient &operator=(const DecodeCacheClient &) = delete;
+
+  /**
+   * @brief 获取主流指定版本的解码结果
+   * @param frame_version 主流帧版本号
+   * @param timeout_ms 未命中时等待服务解码的上限（毫秒）
+   * @return ReadImageGuard BGR 图像读守卫（frame_version 与请求一致），
+   *         未能取得时无效，调用者应本地解码
+   */
+  ReadImageGuard acquire(uint64_t frame_version, int timeout_ms);
+
+  /**
+   * @brief 是否已附加到服务的控制块
+   */
+  bool is_attached() const { return control_ != nullptr; }
+
+  /**
+   * @brief 获取统计信息（服务与全部消费者累计），未附加时全为0
+   */
+  DecodeCacheStats get_stats() const;
+
+private:
+  /**
+   * @brief 按需附加控制块与缓存共享内存
+   * @return bool 控制块是否可用
+   */
+  bool attach();
+
+  /**
+   * @brief 解除控制块与缓存的映射
+   */
+  void detach();
+
+  /**
+   * @brief 在缓存环中查找指定版本
+   */
+  ReadImageGuard find(uint64_t frame_version);
+
+  std::string name_;               ///< 缓存共享内存名称
+  const ImageShmManager &source_;  ///< 主流共享内存
+  ImageShmManager cache_;          ///< 缓存共享内存
+  DecodeCacheControl *control_;    ///< 控制块映射，未附加时为 nullptr
+  uint64_t last_attach_us_;        ///< 上次尝试附加的时间
+  std::vector<ReadImageGuard> batch_; ///< 批量查找的临时列表
+};
+
+#endif // DECODE_CACHE_H
@@ -0,0 +1,212 @@
+/**
+ * @file derived_stream_publisher.cpp
+ * @brief 生产者侧派生流发布器实现
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 派生图像直接写入派生流共享内存槽位：输出 Mat 包装槽位内存，
+ * 解码器/缩放按 Mat::create 语义在尺寸一致时原地写入，无额外拷贝。
+ */
+
+#include "derived_stream_publisher.h"
+#include "config/factory.h"
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+DerivedStreamPublisher::DerivedStreamPublisher(
+    ImageShmManager &source, const std::vector<DerivedStreamConfig> &streams,
+    const ShmMapOptions &map_options)
+    : source_(source), map_options_(map_options), running_(false),
+      source_frames_(0), source_skipped_(0), frames_published_(0),
+      errors_(0) {
+  for (const auto &config : streams) {
+    Stream stream;
+    stream.config = config;
+    streams_.push_back(std::move(stream));
+  }
+}
+
+DerivedStreamPublisher::~DerivedStreamPublisher() { stop(); }
+
+void DerivedStreamPublisher::start() {
+  if (running_.load())
+    return;
+
+  for (auto &stream : streams_) {
+    const DerivedStreamConfig &config = stream.config;
+    stream.shm =
+        std::make_unique<ImageShmManager>(config.name, map_options_);
+    stream.shm->unlink_shm(); // 清理之前可能残留的共享内存
+    if (stream.shm->create_and_init(config.total_size_bytes,
+                                    config.buffer_size_bytes,
+                                    config.buffer_count) != ShmStatus::Success)
+      throw std::runtime_error("DerivedStreamPublisher Error: Failed to "
+                               "create derived stream '" +
+                               config.name + "'");
+    std::cout << "DerivedStreamPublisher: Publishing '" << config.name
+              << "' (" << config.options.output_size.width << "x"
+              << config.options.output_size.height << " "
+              << (config.options.color == DecodeColor::Gray ? "GRAY" : "BGR")
+              << ")" << std::endl;
+  }
+
+  running_.store(true);
+  worker_ = std::thread(&DerivedStreamPublisher::run, this);
+}
+
+void DerivedStreamPublisher::stop() {
+  running_.store(false);
+  if (worker_.joinable())
+    worker_.join();
+  for (auto &stream : streams_) {
+    if (!stream.shm)
+      continue;
+    stream.shm->unmap_and_close();
+    stream.shm->unlink_shm();
+    stream.shm.reset();
+  }
+}
+
+DerivedStreamStats DerivedStreamPublisher::get_stats() const {
+  DerivedStreamStats stats;
+  stats.source_frames = source_frames_.load(std::memory_order_relaxed);
+  stats.source_skipped = source_skipped_.load(std::memory_order_relaxed);
+  stats.frames_published = frames_published_.load(std::memory_order_relaxed);
+  stats.errors = errors_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void DerivedStreamPublisher::run() {
+  uint64_t last_version = 0;
+  while (running_.load()) {
+    // 超时返回以便及时响应 stop()
+    source_.wait_for_new_frame(last_version, 100);
+    ReadImageGuard image = source_.acquire_image();
+    if (!image.is_valid() || image.frame_version() <= last_version)
+      continue;
+
+    if (last_version != 0)
+      source_skipped_.fetch_add(image.frame_version() - last_version - 1,
+                                std::memory_order_relaxed);
+    last_version = image.frame_version();
+    source_frames_.fetch_add(1, std::memory_order_relaxed);
+
+    cv::Mat full; // 同一帧内所有派生流共享的全分辨率解码结果
+    for (auto &stream : streams_) {
+      bool ok = false;
+      try {
+        ok = publish(stream, image, full);
+      } catch (const std::exception &e) {
+        std::cerr << "DerivedStreamPublisher: Failed to derive '"
+                  << stream.config.name << "': " << e.what() << std::endl;
+      }
+      if (ok)
+        frames_published_.fetch_add(1, std::memory_order_relaxed);
+      else
+        errors_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+}
+
+IDecoder *DerivedStreamPublisher::get_direct_decoder(Stream &stream,
+                                                     ImageFormat format) {
+  auto it = stream.direct.find(format);
+  if (it == stream.direct.end()) {
+    std::unique_ptr<IDecoder> decoder;
+    // MJPEG 缩小解码仍需完整的熵解码，多个派生流时共享一次全分辨率解码更省
+    const bool shared_decode_cheaper =
+        format == ImageFormat::MJPG && streams_.size() > 1;
+    try {
+      if (!shared_decode_cheaper)
+        decoder = Factory::create_decoder(format, stream.config.options);
+    } catch (const std::exception &) {
+      // 该格式不支持单遍输出，走全分辨率解码路径
+    }
+    it = stream.direct.emplace(format, std::move(decoder)).first;
+  }
+  return it->second.get();
+}
+
+bool DerivedStreamPublisher::decode_full(const ReadImageGuard &image,
+                                         cv::Mat &full) {
+  if (!full.empty())
+    return true;
+
+  const ImageHeader &header = image.header();
+  if (header.format == ImageFormat::BGR || header.format == ImageFormat::GRAY) {
+    // 已是原始像素，直接包装共享内存数据（只读使用）
+    full = cv::Mat(header.height, header.width,
+                   header.format == ImageFormat::GRAY ? CV_8UC1 : CV_8UC3,
+                   (void *)image.data());
+    return true;
+  }
+
+  auto it = full_decoders_.find(header.format);
+  if (it == full_decoders_.end())
+    it = full_decoders_
+             .emplace(header.format, Factory::create_decoder(header.format))
+             .first;
+  full = full_pool_.decode(*it->second, image);
+  return !full.empty();
+}
+
+bool DerivedStreamPublisher::publish(Stream &stream,
+                                     const ReadImageGuard &image,
+                                     cv::Mat &full) {
+  const DecoderOptions &options = stream.config.options;
+  const bool gray = options.color == DecodeColor::Gray;
+  const int width = options.output_size.width;
+  const int height = options.output_size.height;
+  const int type = gray ? CV_8UC1 : CV_8UC3;
+  const size_t channels = gray ? 1 : 3;
+  const size_t frame_bytes = (size_t)width * height * channels;
+
+  WriteImageGuard slot = stream.shm->acquire_image_for_write(frame_bytes);
+  if (!slot.is_valid())
+    return false;
+
+  // 输出 Mat 直接包装共享内存槽位，尺寸一致时解码/缩放原地写入
+  cv::Mat out(height, width, type, slot.data());
+
+  IDecoder *direct = get_direct_decoder(stream, image.header().format);
+  if (direct) {
+    direct->decode_into(image.data(), image.header(), out);
+  } else {
+    if (!decode_full(image, full))
+      return false;
+    cv::Mat src = full;
+    if (!options.roi.empty()) {
+      cv::Rect roi = options.roi & cv::Rect(0, 0, full.cols, full.rows);
+      if (roi.empty())
+        return false;
+      src = full(roi);
+    }
+    if (gray && src.channels() == 3) {
+      cv::cvtColor(src, stream.scratch, cv::COLOR_BGR2GRAY);
+      src = stream.scratch;
+    }
+    if (src.cols == width && src.rows == height)
+      src.copyTo(out);
+    else
+      cv::resize(src, out, cv::Size(width, height), 0, 0, cv::INTER_AREA);
+  }
+
+  if (out.empty() || out.cols != width || out.rows != height ||
+      out.type() != type)
+    return false;
+  if (out.data != slot.data()) {
+    // 输出被重新分配（理论上不会发生），退化为拷贝
+    if (!out.isContinuous() || frame_bytes > slot.capacity())
+      return false;
+    std::memcpy(slot.data(), out.data, frame_bytes);
+  }
+
+  return slot.commit(frame_bytes, width, height, channels,
+                     image.frame_version(),
+                     gray ? ImageFormat::GRAY : ImageFormat::BGR,
+                     (uint8_t)type, image.header().capture_timestamp_us,
+                     image.header().dequeue_timestamp_us) ==
+         ShmStatus::Success;
+}
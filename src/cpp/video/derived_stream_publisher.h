@@ -0,0 +1,137 @@
+/**
+ * @file derived_stream_publisher.h
+ * @brief 生产者侧派生流发布器
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 该文件定义了在生产者进程内由主共享内存派生低成本图像流的发布器。
+ * 后台线程每帧只解码一次主流，生成半分辨率预览、灰度亮度平面等
+ * 派生图像并写入独立命名的共享内存，轻量消费者直接读取无需再解码。
+ */
+
+#ifndef DERIVED_STREAM_PUBLISHER_H
+#define DERIVED_STREAM_PUBLISHER_H
+
+#include "config/config_manager.h"
+#include "video/formats/decoder_interface.h"
+#include "video/formats/frame_pool.h"
+#include "video/image_shm_manager.h"
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief 派生流统计信息
+ */
+struct DerivedStreamStats {
+  uint64_t source_frames = 0;    ///< 后台阶段处理的主流帧数
+  uint64_t source_skipped = 0;   ///< 后台阶段来不及处理而跳过的主流帧数
+  uint64_t frames_published = 0; ///< 写入全部派生流的帧总数
+  uint64_t errors = 0;           ///< 解码或写入失败次数
+};
+
+/**
+ * @brief 派生流发布器
+ *
+ * 后台线程等待主流新帧（latest 语义，处理不过来时直接跳到最新帧，
+ * 不会拖慢主流生产者），对每帧：
+ * 1. 支持单遍输出的格式（如 YUYV；只有一个派生流时的 MJPEG，在 DCT 域
+ *    缩小解码）由 Factory::create_decoder(format, options) 得到的解码器
+ *    直接写入派生流的共享内存槽位；
+ * 2. 其余格式（以及多个派生流时的 MJPEG）先全分辨率解码一次，所有派生流
+ *    共享该结果，再各自裁剪/转灰度/缩放写入槽位。
+ *
+ * 派生流使用 ImageFormat::BGR / ImageFormat::GRAY 发布原始像素，
+ * 帧版本号与采集/出队时间戳沿用主流帧，便于消费者关联和统计端到端延迟。
+ */
+class DerivedStreamPublisher {
+public:
+  /**
+   * @brief 构造函数
+   * @param source 主流共享内存（已创建），发布器只读取
+   * @param streams 派生流配置列表
+   * @param map_options 派生流共享内存映射选项
+   */
+  DerivedStreamPublisher(ImageShmManager &source,
+                         const std::vector<DerivedStreamConfig> &streams,
+                         const ShmMapOptions &map_options);
+
+  /**
+   * @brief 析构函数，停止后台线程并删除派生流共享内存
+   */
+  ~DerivedStreamPublisher();
+
+  DerivedStreamPublisher(const DerivedStreamPublisher &) = delete;
+  DerivedStreamPublisher &operator=(const DerivedStreamPublisher &) = delete;
+
+  /**
+   * @brief 创建全部派生流共享内存并启动后台线程
+   * @throws std::runtime_error 当派生流共享内存创建失败时抛出异常
+   */
+  void start();
+
+  /**
+   * @brief 停止后台线程，解除映射并删除派生流共享内存
+   */
+  void stop();
+
+  /**
+   * @brief 获取统计信息
+   */
+  DerivedStreamStats get_stats() const;
+
+private:
+  /**
+   * @brief 单个派生流的运行状态
+   */
+  struct Stream {
+    DerivedStreamConfig config;              ///< 派生流配置
+    std::unique_ptr<ImageShmManager> shm;    ///< 派生流共享内存
+    std::map<ImageFormat, std::unique_ptr<IDecoder>> direct; ///< 单遍解码器，nullptr 表示该格式需走全分辨率路径
+    cv::Mat scratch;                         ///< 全分辨率路径的灰度中间结果
+  };
+
+  /**
+   * @brief 后台线程主循环
+   */
+  void run();
+
+  /**
+   * @brief 为一个派生流生成并发布当前帧
+   * @param stream 派生流
+   * @param image 主流当前帧
+   * @param full 全分辨率BGR（按需解码，所有派生流共享）
+   * @return bool 是否发布成功
+   */
+  bool publish(Stream &stream, const ReadImageGuard &image, cv::Mat &full);
+
+  /**
+   * @brief 获取格式对应的单遍解码器，不支持时返回 nullptr
+   */
+  IDecoder *get_direct_decoder(Stream &stream, ImageFormat format);
+
+  /**
+   * @brief 按需全分辨率解码主流当前帧
+   * @return bool 是否得到有效的全分辨率BGR
+   */
+  bool decode_full(const ReadImageGuard &image, cv::Mat &full);
+
+  ImageShmManager &source_;     ///< 主流共享内存
+  ShmMapOptions map_options_;   ///< 派生流映射选项
+  std::vector<Stream> streams_; ///< 派生流
+  std::map<ImageFormat, std::unique_ptr<IDecoder>> full_decoders_; ///< 全分辨率解码器
+  FramePool full_pool_;         ///< 全分辨率解码输出缓冲池
+  std::thread worker_;          ///< 后台线程
+  std::atomic<bool> running_;   ///< 运行标志
+
+  std::atomic<uint64_t> source_frames_;    ///< 处理的主流帧数
+  std::atomic<uint64_t> source_skipped_;   ///< 跳过的主流帧数
+  std::atomic<uint64_t> frames_published_; ///< 已发布帧数
+  std::atomic<uint64_t> errors_;           ///< 失败次数
+};
+
+#endif // DERIVED_STREAM_PUBLISHER_H
@@ -29,7 +29,16 @@ struct CapturedFrame {
   uint32_t width;      ///< 图像宽度（像素）
   uint32_t height;     ///< 图像高度（像素）
   ImageFormat format;  ///< 捕获到的原始图像格式
-  uint8_t cv_type;     ///< 对应的 OpenCV 数据类型常量
+  uint8_t cv_type;     ///< 对应的 OpenCV 数据类型常量；H264 为 H264FrameType 标志
+  bool published; ///< 是否已由捕获器直接提交到共享内存（零拷贝模式）
+  int buffer_index = -1; ///< dequeue() 交出的驱动缓冲区索引，-1 表示无需 release()
+  uint64_t timestamp_us = 0; ///< 采集时间（驱动时间戳，CLOCK_MONOTONIC 微秒），0 表示未知
+  uint64_t dequeue_timestamp_us = 0; ///< 出队时间（CLOCK_MONOTONIC 微秒），0 表示未知
+  ImagePlaneLayout planes{}; ///< 发布负载中的平面布局，全0表示紧凑排列
+  /// 第1平面位于独立缓冲区（NV12M/NV16M）时的地址，发布时拷贝到负载的
+  /// planes.offsets[1] 处；nullptr 表示各平面都在 data 内
+  const uint8_t *chroma_data = nullptr;
+  size_t chroma_size = 0; ///< chroma_data 的字节数
 };
 
 /**
@@ -81,6 +90,74 @@ public:
    */
   virtual bool capture(CapturedFrame &out_frame,
                        std::atomic<bool> &running) = 0;
+
+  /**
+   * @brief 取出一帧并把缓冲区所有权交给调用者
+   * @param out_frame 输出参数，接收捕获的帧数据；超时时 data 为 nullptr
+   * @param running 原子布尔标志，用于外部控制捕获循环
+   * @return bool true表示成功（含超时），false表示失败或应停止
+   *
+   * 与 capture() 不同，返回帧的 buffer_index 不为 -1 时，缓冲区在调用者
+   * 调用 release() 之前不会归还给设备，期间可以继续 dequeue() 后续帧，
+   * 从而让捕获与发布在不同线程并行进行。
+   *
+   * 默认实现直接调用 capture()，buffer_index 为 -1：帧数据只在下一次
+   * dequeue() 之前有效，调用者必须在此之前完成发布。
+   */
+  virtual bool dequeue(CapturedFrame &out_frame, std::atomic<bool> &running) {
+    bool ok = capture(out_frame, running);
+    out_frame.buffer_index = -1;
+    return ok;
+  }
+
+  /**
+   * @brief 获取可用于 poll/epoll 等待新帧的文件描述符
+   * @return int 文件描述符，-1 表示不支持事件驱动（只能使用阻塞的 dequeue()）
+   *
+   * 返回有效描述符的捕获器可以与其他捕获器共用一个 epoll 循环：
+   * 描述符可读后调用 dequeue_ready() 取帧。
+   */
+  virtual int get_poll_fd() const { return -1; }
+
+  /**
+   * @brief 在 get_poll_fd() 可读后取出一帧，不等待
+   * @param out_frame 输出参数，语义与 dequeue() 相同；没有就绪帧时 data 为 nullptr
+   * @return bool false表示设备出错
+   *
+   * 默认实现不支持事件驱动，返回false。
+   */
+  virtual bool dequeue_ready(CapturedFrame &out_frame) {
+    out_frame.data = nullptr;
+    return false;
+  }
+
+  /**
+   * @brief 将 dequeue() 交出的缓冲区归还给设备
+   * @param frame dequeue() 返回的帧（buffer_index 不为 -1）
+   *
+   * 可以在与 dequeue() 不同的线程调用。默认实现为空操作。
+   */
+  virtual void release(const CapturedFrame &frame) { (void)frame; }
+
+  /**
+   * @brief 调用者最多可同时持有的 dequeue() 缓冲区数量
+   * @return uint32_t 0 表示不支持缓冲区交接（dequeue() 始终返回 -1 索引）
+   */
+  virtual uint32_t get_max_outstanding() const { return 0; }
+
+  /**
+   * @brief 绑定输出共享内存，启用零拷贝发布
+   * @param shm 输出图像共享内存管理器，须在 start() 之前完成映射
+   * @return bool true表示捕获器将直接把帧写入共享内存槽位并提交，
+   *         此后 capture() 返回的帧 published 为 true，调用者无需再写入
+   * @throws std::runtime_error 当共享内存几何参数不满足零拷贝要求时抛出异常
+   *
+   * 默认实现不支持零拷贝，返回false，调用者继续使用 write_image() 发布。
+   */
+  virtual bool bind_output(ImageShmManager *shm) {
+    (void)shm;
+    return false;
+  }
 };
 
 #endif // CAPTURE_INTERFACE_H
\ No newline at end of file
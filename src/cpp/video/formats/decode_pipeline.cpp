@@ -0,0 +1,213 @@
+/**
+ * @file decode_pipeline.cpp
+ * @brief 并行解码流水线实现
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 单把互斥锁保护任务队列与重排队列；压缩数据拷贝和解码均在锁外进行，
+ * 锁内只做队列操作，因此锁竞争与线程数无关。
+ */
+
+#include "decode_pipeline.h"
+#include "common/concurrency/thread_utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+DecodePipeline::DecodePipeline(DecoderFactory make_decoder,
+                               uint32_t thread_count,
+                               const std::vector<int> &cpu_affinity,
+                               uint32_t max_in_flight)
+    : max_in_flight_(std::max<uint32_t>(max_in_flight, 1)) {
+  if (thread_count == 0)
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+  // 解码器在调用线程创建，创建失败时异常直接抛给调用者
+  for (uint32_t i = 0; i < thread_count; ++i) {
+    decoders_.push_back(make_decoder());
+    if (!decoders_.back())
+      throw std::runtime_error("DecodePipeline Error: decoder factory "
+                               "returned null");
+  }
+
+  stats_.max_in_flight = max_in_flight_;
+  for (uint32_t i = 0; i < thread_count; ++i) {
+    workers_.emplace_back(&DecodePipeline::worker_loop, this, i);
+    if (!cpu_affinity.empty())
+      pin_thread(workers_.back(), cpu_affinity[i % cpu_affinity.size()]);
+  }
+}
+
+DecodePipeline::~DecodePipeline() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  job_cv_.notify_all();
+  for (auto &worker : workers_) {
+    if (worker.joinable())
+      worker.join();
+  }
+}
+
+void DecodePipeline::pin_thread(std::thread &thread, int cpu) {
+  int ret = pin_thread_to_cpu(thread, cpu);
+  if (ret != 0) {
+    std::cerr << "DecodePipeline: Failed to pin worker to CPU " << cpu << ": "
+              << strerror(ret) << std::endl;
+  }
+}
+
+bool DecodePipeline::submit(const uint8_t *data, const ImageHeader &header,
+                            uint64_t frame_version, uint64_t timestamp_us,
+                            uint64_t acquire_timestamp_us) {
+  Job job;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_)
+      return false;
+    // 全部在途帧都已开始解码时没有可替换的旧帧，直接丢弃新帧
+    if (in_flight_ >= max_in_flight_ && pending_.empty()) {
+      stats_.dropped++;
+      return false;
+    }
+    if (!spare_payloads_.empty()) {
+      job.payload = std::move(spare_payloads_.back());
+      spare_payloads_.pop_back();
+    }
+  }
+
+  // 锁外拷贝；复用缓冲区容量足够时 assign 不分配内存
+  job.payload.assign(data, data + header.data_size);
+  job.header = header;
+  job.frame_version = frame_version;
+  job.timestamp_us = timestamp_us;
+  job.acquire_timestamp_us =
+      acquire_timestamp_us ? acquire_timestamp_us : monotonic_now_us();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_)
+      return false;
+    if (in_flight_ >= max_in_flight_) {
+      if (pending_.empty()) {
+        // 拷贝期间剩余帧已全部被工作线程取走
+        spare_payloads_.push_back(std::move(job.payload));
+        stats_.dropped++;
+        return false;
+      }
+      // 丢弃最旧的未开始解码的帧，留下空位保持交付顺序
+      Job &oldest = pending_.front();
+      ready_[oldest.seq] = DecodedFrame();
+      spare_payloads_.push_back(std::move(oldest.payload));
+      pending_.pop_front();
+      in_flight_--;
+      stats_.dropped++;
+    }
+    job.seq = next_seq_++;
+    pending_.push_back(std::move(job));
+    in_flight_++;
+    stats_.submitted++;
+  }
+  job_cv_.notify_one();
+  return true;
+}
+
+bool DecodePipeline::submit(const ReadImageGuard &image) {
+  if (!image.is_valid())
+    return false;
+  return submit(image.data(), image.header(), image.frame_version(),
+                image.timestamp_us(), image.acquire_timestamp_us());
+}
+
+void DecodePipeline::worker_loop(size_t index) {
+  IDecoder &decoder = *decoders_[index];
+  // 工作线程私有的缓冲池：重排队列与消费者同时持有的帧都不会被覆盖
+  FramePool pool(max_in_flight_ + 1);
+
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      job_cv_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+      if (stopping_)
+        return;
+      job = std::move(pending_.front());
+      pending_.pop_front();
+    }
+
+    DecodedFrame result;
+    result.header = job.header;
+    result.frame_version = job.frame_version;
+    result.timestamp_us = job.timestamp_us;
+    result.acquire_timestamp_us = job.acquire_timestamp_us;
+    try {
+      result.frame = pool.decode(decoder, job.payload.data(), job.header);
+    } catch (const std::exception &e) {
+      std::cerr << "DecodePipeline: Decoding error for frame "
+                << job.frame_version << ": " << e.what() << std::endl;
+      result.frame.release();
+    }
+    result.decoded_timestamp_us = monotonic_now_us();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (result.frame.empty()) {
+        stats_.decode_errors++;
+        in_flight_--;
+      } else {
+        stats_.decoded++;
+      }
+      ready_[job.seq] = std::move(result);
+      spare_payloads_.push_back(std::move(job.payload));
+    }
+    result_cv_.notify_one();
+  }
+}
+
+bool DecodePipeline::pop_ready_locked(DecodedFrame &out) {
+  while (!ready_.empty() && ready_.begin()->first == next_deliver_) {
+    auto it = ready_.begin();
+    DecodedFrame frame = std::move(it->second);
+    ready_.erase(it);
+    next_deliver_++;
+    if (frame.frame.empty())
+      continue; // 丢弃或解码失败留下的空位
+    in_flight_--;
+    stats_.delivered++;
+    out = std::move(frame);
+    return true;
+  }
+  return false;
+}
+
+bool DecodePipeline::poll(DecodedFrame &out) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pop_ready_locked(out);
+}
+
+bool DecodePipeline::wait_for_frame(DecodedFrame &out, int timeout_ms) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  bool got = false;
+  result_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [&] {
+    got = pop_ready_locked(out);
+    return got || in_flight_ == 0;
+  });
+  return got;
+}
+
+DecodePipelineStats DecodePipeline::get_stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  DecodePipelineStats stats = stats_;
+  stats.queue_depth = pending_.size();
+  stats.reorder_depth = 0;
+  for (const auto &entry : ready_) {
+    if (!entry.second.frame.empty())
+      stats.reorder_depth++;
+  }
+  stats.in_flight = in_flight_;
+  return stats;
+}
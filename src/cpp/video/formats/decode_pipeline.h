@@ -0,0 +1,183 @@
+/**
+ * @file decode_pipeline.h
+ * @brief 并行解码流水线
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 该文件定义了多线程解码流水线：消费者线程提交帧，N 个工作线程并行解码，
+ * 结果经有界重排队列按提交顺序（即帧版本顺序）交付。用于 MJPEG 等
+ * 单核解码速度跟不上采集帧率的场景。
+ */
+
+#ifndef DECODE_PIPELINE_H
+#define DECODE_PIPELINE_H
+
+#include "decoder_interface.h"
+#include "frame_pool.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief 流水线交付的解码结果
+ */
+struct DecodedFrame {
+  cv::Mat frame;          ///< 解码后的图像（与工作线程的帧缓冲池共享内存）
+  ImageHeader header;     ///< 原始图像头部信息
+  uint64_t frame_version; ///< 共享内存中的帧版本号
+  uint64_t timestamp_us;  ///< 帧时间戳（微秒）
+  uint64_t acquire_timestamp_us; ///< 消费者获取（提交到流水线）的时间（CLOCK_MONOTONIC 微秒）
+  uint64_t decoded_timestamp_us; ///< 解码完成时间（CLOCK_MONOTONIC 微秒）
+};
+
+/**
+ * @brief 流水线统计信息
+ */
+struct DecodePipelineStats {
+  uint64_t submitted = 0;     ///< 成功提交的帧数
+  uint64_t decoded = 0;       ///< 解码成功的帧数
+  uint64_t delivered = 0;     ///< 已按序交付的帧数
+  uint64_t dropped = 0;       ///< 在途帧达到上限而丢弃的帧数
+  uint64_t decode_errors = 0; ///< 解码失败（异常或空结果）的帧数
+  size_t queue_depth = 0;     ///< 当前等待解码的帧数
+  size_t reorder_depth = 0;   ///< 当前已解码、等待按序交付的帧数
+  size_t in_flight = 0;       ///< 当前在途帧总数
+  size_t max_in_flight = 0;   ///< 在途帧上限
+};
+
+/**
+ * @brief 并行解码流水线
+ *
+ * 每个工作线程持有独立的解码器实例和帧缓冲池，互不共享状态。
+ * 提交时会把压缩数据拷贝到流水线内部复用的缓冲区，因此调用者可立即
+ * 释放共享内存读守卫，不会长时间占住槽位阻塞生产者。
+ *
+ * 在途帧（待解码 + 解码中 + 待交付）数量不超过 max_in_flight：
+ * 达到上限时优先丢弃最旧的尚未开始解码的帧，若全部已在解码则丢弃新帧。
+ * 被丢弃或解码失败的帧在重排队列中留下空位，交付时自动跳过，不会阻塞后续帧。
+ *
+ * @note submit/poll/wait_for_frame 应由同一个消费者线程调用
+ */
+class DecodePipeline {
+public:
+  /// 解码器构造函数，构造流水线时为每个工作线程调用一次
+  using DecoderFactory = std::function<std::unique_ptr<IDecoder>()>;
+
+  /**
+   * @brief 构造函数，启动工作线程
+   * @param make_decoder 解码器构造函数
+   * @param thread_count 工作线程数量（0 表示按 CPU 核数）
+   * @param cpu_affinity 工作线程绑定的 CPU 列表，按线程序号循环使用；为空则不绑定
+   * @param max_in_flight 在途帧上限
+   * @throws std::runtime_error 当解码器创建失败时抛出异常
+   */
+  DecodePipeline(DecoderFactory make_decoder, uint32_t thread_count,
+                 const std::vector<int> &cpu_affinity, uint32_t max_in_flight);
+
+  /**
+   * @brief 析构函数，停止并等待全部工作线程
+   */
+  ~DecodePipeline();
+
+  DecodePipeline(const DecodePipeline &) = delete;
+  DecodePipeline &operator=(const DecodePipeline &) = delete;
+
+  /**
+   * @brief 提交一帧待解码数据
+   * @param data 原始图像数据指针（函数返回前完成拷贝）
+   * @param header 图像头部信息
+   * @param frame_version 帧版本号
+   * @param timestamp_us 帧时间戳（微秒）
+   * @param acquire_timestamp_us 消费者获取该帧的时间，0 表示以提交时间代替
+   * @return true 已进入流水线；false 流水线已满且全部帧正在解码，该帧被丢弃
+   */
+  bool submit(const uint8_t *data, const ImageHeader &header,
+              uint64_t frame_version, uint64_t timestamp_us,
+              uint64_t acquire_timestamp_us = 0);
+
+  /**
+   * @brief 从零拷贝读守卫提交一帧
+   * @param image 有效的图像读守卫
+   * @return true 已进入流水线
+   */
+  bool submit(const ReadImageGuard &image);
+
+  /**
+   * @brief 非阻塞获取下一帧按序交付的结果
+   * @param out 输出的解码结果
+   * @return true 获取成功；false 下一帧尚未解码完成
+   */
+  bool poll(DecodedFrame &out);
+
+  /**
+   * @brief 阻塞等待下一帧按序交付的结果
+   * @param out 输出的解码结果
+   * @param timeout_ms 超时时间（毫秒）
+   * @return true 获取成功；false 超时或流水线中没有在途帧
+   */
+  bool wait_for_frame(DecodedFrame &out, int timeout_ms);
+
+  /**
+   * @brief 获取统计信息
+   */
+  DecodePipelineStats get_stats() const;
+
+  /**
+   * @brief 获取工作线程数量
+   */
+  size_t get_thread_count() const { return workers_.size(); }
+
+private:
+  /**
+   * @brief 待解码任务
+   */
+  struct Job {
+    uint64_t seq;                 ///< 提交序号，决定交付顺序
+    ImageHeader header;           ///< 图像头部信息
+    uint64_t frame_version;       ///< 帧版本号
+    uint64_t timestamp_us;        ///< 帧时间戳
+    uint64_t acquire_timestamp_us; ///< 消费者获取时间
+    std::vector<uint8_t> payload; ///< 压缩数据拷贝
+  };
+
+  /**
+   * @brief 工作线程主循环
+   * @param index 线程序号
+   */
+  void worker_loop(size_t index);
+
+  /**
+   * @brief 在持锁状态下取出下一帧可交付结果，跳过丢弃/失败留下的空位
+   */
+  bool pop_ready_locked(DecodedFrame &out);
+
+  /**
+   * @brief 将工作线程绑定到指定 CPU
+   */
+  static void pin_thread(std::thread &thread, int cpu);
+
+  std::vector<std::unique_ptr<IDecoder>> decoders_; ///< 每个工作线程独占的解码器
+  size_t max_in_flight_;                 ///< 在途帧上限
+  std::vector<std::thread> workers_;     ///< 工作线程
+
+  mutable std::mutex mutex_;             ///< 保护以下全部状态
+  std::condition_variable job_cv_;       ///< 新任务到达
+  std::condition_variable result_cv_;    ///< 新结果到达
+  std::deque<Job> pending_;              ///< 待解码任务（按提交顺序）
+  std::map<uint64_t, DecodedFrame> ready_; ///< 重排队列，空 frame 表示空位
+  std::vector<std::vector<uint8_t>> spare_payloads_; ///< 复用的压缩数据缓冲区
+  uint64_t next_seq_ = 0;                ///< 下一个提交序号
+  uint64_t next_deliver_ = 0;            ///< 下一个待交付序号
+  size_t in_flight_ = 0;                 ///< 在途帧数（不含空位）
+  bool stopping_ = false;                ///< 停止标志
+  DecodePipelineStats stats_;            ///< 统计计数
+};
+
+#endif // DECODE_PIPELINE_H
@@ -15,6 +15,51 @@
 #include "video/image_shm_manager.h"
 #include <opencv2/opencv.hpp>
 
+/**
+ * @brief 解码输出颜色格式
+ */
+enum class DecodeColor {
+  Bgr, ///< 三通道BGR（CV_8UC3）
+  Gray ///< 仅亮度（CV_8UC1），跳过色度转换
+};
+
+/**
+ * @brief 解码输出选项
+ *
+ * 描述消费者实际需要的输出：颜色格式、源图像上的感兴趣区域以及输出尺寸。
+ * 支持的解码器会在一次遍历中完成裁剪、缩放与颜色转换，避免先全分辨率解码
+ * 再缩放造成的浪费。
+ */
+struct DecoderOptions {
+  DecodeColor color = DecodeColor::Bgr; ///< 输出颜色格式
+  cv::Rect roi;         ///< 源图像上的感兴趣区域，为空表示整幅图像
+  cv::Size output_size; ///< 输出尺寸，为 0 表示由 ROI 与 scale 决定
+  uint32_t scale = 1;   ///< 缩小倍数（1/2/4/8），输出尺寸未指定的维度取 ROI 的 1/scale（向上取整）
+
+  /**
+   * @brief 是否为默认选项（全分辨率BGR）
+   */
+  bool is_default() const {
+    return color == DecodeColor::Bgr && roi.empty() &&
+           output_size.area() == 0 && scale <= 1;
+  }
+
+  /**
+   * @brief 计算区域对应的输出尺寸
+   * @param region 源图像上（裁剪后）的区域尺寸
+   * @return cv::Size 各维度取 output_size，为 0 时取 region 按 scale 缩小后的尺寸
+   *
+   * 向上取整与 libjpeg 的 DCT 域缩小解码一致。
+   */
+  cv::Size scaled_size(const cv::Size &region) const {
+    const int s = scale > 1 ? (int)scale : 1;
+    return cv::Size(output_size.width > 0 ? output_size.width
+                                          : (region.width + s - 1) / s,
+                    output_size.height > 0 ? output_size.height
+                                           : (region.height + s - 1) / s);
+  }
+};
+
 /**
  * @brief 图像解码器接口类
  *
@@ -43,10 +88,29 @@ public:
    * 将从共享内存读取的原始图像数据解码为OpenCV可处理的BGR格式。
    * 该方法会根据header中的格式信息选择合适的解码算法。
    *
-   * @note 返回的Mat对象包含解码后的图像数据，调用者负责管理其生命周期
+   * @note 默认实现通过 decode_into 写入新分配的Mat，调用者负责管理其生命周期
    * @warning data指针必须有效且指向完整的图像数据
    */
-  virtual cv::Mat decode(const uint8_t *data, const ImageHeader &header) = 0;
+  virtual cv::Mat decode(const uint8_t *data, const ImageHeader &header) {
+    cv::Mat out;
+    decode_into(data, header, out);
+    return out;
+  }
+
+  /**
+   * @brief 解码图像数据到调用者提供的输出矩阵
+   * @param data 原始图像数据指针
+   * @param header 图像头部信息，包含尺寸、格式等元数据
+   * @param out 输出矩阵，尺寸与类型匹配时直接复用其缓冲区
+   * @throws cv::Exception 当解码失败时抛出异常
+   *
+   * 实现必须通过 cv::Mat::create 语义写入 out：尺寸与类型不变时不重新分配，
+   * 因此配合 FramePool 可在稳定状态下做到每帧零堆分配。
+   *
+   * @warning out 不能与 data 指向同一块内存
+   */
+  virtual void decode_into(const uint8_t *data, const ImageHeader &header,
+                           cv::Mat &out) = 0;
 };
 
 #endif // DECODER_INTERFACE_H
\ No newline at end of file
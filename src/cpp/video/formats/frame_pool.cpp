@@ -0,0 +1,109 @@
+/**
+ * @file frame_pool.cpp
+ * @brief 解码输出帧缓冲池实现
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 基于 cv::Mat 引用计数判断缓冲区是否空闲，并通过比较写入前后的
+ * 数据指针统计实际发生的堆分配次数。
+ */
+
+#include "frame_pool.h"
+
+FramePool::FramePool(size_t capacity) : capacity_(capacity ? capacity : 1) {
+  // 预留容量，保证 find_free_frame 返回的指针在扩容时不失效
+  frames_.reserve(capacity_);
+}
+
+bool FramePool::is_free(const cv::Mat &frame) {
+  // 空 Mat 没有 UMatData；否则引用计数为 1 表示只有池自身持有。
+  // 其他线程释放引用时原子递减计数，这里用原子读取与之配对
+  return frame.u == nullptr ||
+         __atomic_load_n(&frame.u->refcount, __ATOMIC_ACQUIRE) == 1;
+}
+
+cv::Mat *FramePool::find_free_frame(int rows, int cols, int type) {
+  cv::Mat *fallback = nullptr;
+  for (auto &frame : frames_) {
+    if (!is_free(frame))
+      continue;
+    if (rows == 0) {
+      // 尺寸未知（解码前）：优先选已分配过的缓冲区，分辨率不变时即可复用
+      if (!frame.empty())
+        return &frame;
+    } else if (frame.rows == rows && frame.cols == cols &&
+               frame.type() == type) {
+      return &frame;
+    }
+    if (!fallback)
+      fallback = &frame;
+  }
+  if (fallback)
+    return fallback;
+
+  if (frames_.size() < capacity_) {
+    frames_.emplace_back();
+    return &frames_.back();
+  }
+  return nullptr;
+}
+
+void FramePool::account(const uint8_t *before, const cv::Mat &after) {
+  if (after.data == nullptr)
+    return; // 解码失败，缓冲区已被释放
+  if (after.data == before)
+    stats_.reuses++;
+  else
+    stats_.allocations++;
+}
+
+cv::Mat FramePool::decode(IDecoder &decoder, const uint8_t *data,
+                          const ImageHeader &header) {
+  stats_.frames_decoded++;
+
+  cv::Mat *frame = find_free_frame(0, 0, 0);
+  if (!frame) {
+    // 调用者同时持有的帧数超过容量，退化为一次性分配
+    stats_.pool_misses++;
+    stats_.allocations++;
+    cv::Mat out;
+    decoder.decode_into(data, header, out);
+    return out;
+  }
+
+  const uint8_t *before = frame->data;
+  decoder.decode_into(data, header, *frame);
+  account(before, *frame);
+  return *frame;
+}
+
+cv::Mat FramePool::decode(IDecoder &decoder, const ReadImageGuard &image) {
+  if (!image.is_valid())
+    return cv::Mat();
+  return decode(decoder, image.data(), image.header());
+}
+
+cv::Mat FramePool::acquire(int rows, int cols, int type) {
+  cv::Mat *frame = find_free_frame(rows, cols, type);
+  if (!frame) {
+    stats_.pool_misses++;
+    stats_.allocations++;
+    return cv::Mat(rows, cols, type);
+  }
+
+  const uint8_t *before = frame->data;
+  frame->create(rows, cols, type);
+  account(before, *frame);
+  return *frame;
+}
+
+FramePoolStats FramePool::get_stats() const {
+  FramePoolStats stats = stats_;
+  stats.pooled_frames = frames_.size();
+  return stats;
+}
+
+void FramePool::reset_stats() { stats_ = FramePoolStats(); }
+
+void FramePool::clear() { frames_.clear(); }
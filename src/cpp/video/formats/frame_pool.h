@@ -0,0 +1,122 @@
+/**
+ * @file frame_pool.h
+ * @brief 解码输出帧缓冲池
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 该文件定义了每个消费者私有的解码输出缓冲池。解码器通过 decode_into
+ * 写入池中已分配好的 cv::Mat，分辨率稳定后每帧不再发生堆分配。
+ */
+
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include "decoder_interface.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief 帧缓冲池统计信息
+ */
+struct FramePoolStats {
+  uint64_t frames_decoded = 0; ///< 通过缓冲池解码的帧数
+  uint64_t allocations = 0;    ///< 输出缓冲区发生堆分配（含重新分配）的次数
+  uint64_t reuses = 0;         ///< 直接复用已有缓冲区的次数
+  uint64_t pool_misses = 0;    ///< 池满且无空闲缓冲区、只能临时分配的次数
+  size_t pooled_frames = 0;    ///< 当前池中持有的缓冲区数量
+};
+
+/**
+ * @brief 解码输出帧缓冲池
+ *
+ * 池中每个 cv::Mat 都由池自身持有一份引用。调用者拿到的 Mat 与池共享
+ * 同一块像素内存，调用者释放（析构或重新赋值）后引用计数回到 1，
+ * 该缓冲区即可被下一帧复用，无需显式归还。
+ *
+ * 稳定状态（分辨率与格式不变、调用者同时持有的帧数不超过容量）下，
+ * decode 不产生任何堆分配，可通过 get_stats().allocations 验证。
+ *
+ * @note 非线程安全，每个消费者线程应使用独立的缓冲池；
+ *       返回的帧可以在其他线程中释放
+ */
+class FramePool {
+public:
+  /**
+   * @brief 构造函数
+   * @param capacity 池中最多保留的缓冲区数量，即调用者可同时持有的帧数
+   */
+  explicit FramePool(size_t capacity = 4);
+
+  /**
+   * @brief 使用池中空闲缓冲区解码一帧
+   * @param decoder 解码器
+   * @param data 原始图像数据指针
+   * @param header 图像头部信息
+   * @return cv::Mat 解码结果，与池共享像素内存
+   * @throws cv::Exception 当解码失败时抛出异常
+   */
+  cv::Mat decode(IDecoder &decoder, const uint8_t *data,
+                 const ImageHeader &header);
+
+  /**
+   * @brief 直接从零拷贝读守卫解码一帧
+   * @param decoder 解码器
+   * @param image 有效的图像读守卫
+   * @return cv::Mat 解码结果；守卫无效时返回空 Mat
+   */
+  cv::Mat decode(IDecoder &decoder, const ReadImageGuard &image);
+
+  /**
+   * @brief 获取指定尺寸与类型的空闲缓冲区
+   * @param rows 行数
+   * @param cols 列数
+   * @param type OpenCV 矩阵类型（如 CV_8UC3）
+   * @return cv::Mat 可直接写入的缓冲区，与池共享像素内存
+   */
+  cv::Mat acquire(int rows, int cols, int type);
+
+  /**
+   * @brief 获取统计信息
+   */
+  FramePoolStats get_stats() const;
+
+  /**
+   * @brief 清零统计计数（缓冲区保留）
+   */
+  void reset_stats();
+
+  /**
+   * @brief 释放池中持有的全部缓冲区
+   *
+   * 调用者仍持有的帧不受影响，其内存在调用者释放后归还系统。
+   */
+  void clear();
+
+private:
+  /**
+   * @brief 查找空闲缓冲区，必要时新建池槽
+   * @param rows 期望行数，0 表示不限
+   * @param cols 期望列数
+   * @param type 期望类型
+   * @return cv::Mat* 空闲缓冲区；池满且无空闲时返回 nullptr
+   */
+  cv::Mat *find_free_frame(int rows, int cols, int type);
+
+  /**
+   * @brief 判断缓冲区是否仅被池持有
+   */
+  static bool is_free(const cv::Mat &frame);
+
+  /**
+   * @brief 根据写入前后的数据指针累计分配/复用次数
+   */
+  void account(const uint8_t *before, const cv::Mat &after);
+
+  std::vector<cv::Mat> frames_; ///< 池中缓冲区
+  size_t capacity_;             ///< 最大缓冲区数量
+  FramePoolStats stats_;        ///< 统计信息
+};
+
+#endif // FRAME_POOL_H
@@ -0,0 +1,124 @@
+/**
+ * @file h264_bitstream.cpp
+ * @brief H264 Annex B 码流的帧类型识别实现
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ */
+
+#include "h264_bitstream.h"
+#include "video/image_shm_manager.h"
+
+namespace {
+
+/**
+ * @brief NAL 单元负载的位读取器，跳过防竞争字节（00 00 03）
+ */
+class BitReader {
+public:
+  BitReader(const uint8_t *data, size_t size)
+      : data_(data), size_(size), pos_(0), bit_(8), byte_(0), zeros_(0) {}
+
+  /**
+   * @brief 读取一位，越界时返回 -1
+   */
+  int read_bit() {
+    if (bit_ == 8) {
+      if (!next_byte())
+        return -1;
+      bit_ = 0;
+    }
+    return (byte_ >> (7 - bit_++)) & 1;
+  }
+
+  /**
+   * @brief 读取无符号指数哥伦布码 ue(v)，越界或超长时返回 -1
+   */
+  int64_t read_ue() {
+    int leading_zeros = 0;
+    int bit;
+    while ((bit = read_bit()) == 0)
+      if (++leading_zeros > 31)
+        return -1;
+    if (bit < 0)
+      return -1;
+    uint64_t value = 0;
+    for (int i = 0; i < leading_zeros; ++i) {
+      if ((bit = read_bit()) < 0)
+        return -1;
+      value = (value << 1) | bit;
+    }
+    return (int64_t)((1ULL << leading_zeros) - 1 + value);
+  }
+
+private:
+  bool next_byte() {
+    if (pos_ >= size_)
+      return false;
+    byte_ = data_[pos_++];
+    if (zeros_ >= 2 && byte_ == 0x03) {
+      zeros_ = 0;
+      if (pos_ >= size_)
+        return false;
+      byte_ = data_[pos_++];
+    }
+    zeros_ = (byte_ == 0) ? zeros_ + 1 : 0;
+    return true;
+  }
+
+  const uint8_t *data_;
+  size_t size_;
+  size_t pos_;
+  int bit_;
+  uint8_t byte_;
+  int zeros_;
+};
+
+/**
+ * @brief 查找从 pos 开始的下一个起始码（00 00 01）
+ * @return size_t 起始码之后第一个字节（NAL 头）的位置，找不到时返回 size
+ */
+size_t find_nal(const uint8_t *data, size_t size, size_t pos) {
+  for (size_t i = pos; i + 2 < size; ++i) {
+    if (data[i + 2] > 1) {
+      i += 2; // 第三个字节既不是 0 也不是 1，后两个位置都不可能是起始码
+    } else if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+      return i + 3;
+    }
+  }
+  return size;
+}
+
+} // namespace
+
+uint8_t h264_frame_type(const uint8_t *data, size_t size) {
+  uint8_t flags = 0;
+  size_t nal = find_nal(data, size, 0);
+  while (nal < size) {
+    const uint8_t nal_type = data[nal] & 0x1f;
+    if (nal_type == 7 || nal_type == 8) {
+      flags |= H264FrameType::CODEC_CONFIG;
+    } else if (nal_type == 5) {
+      return flags | H264FrameType::KEYFRAME;
+    } else if (nal_type == 1) {
+      // slice_header: first_mb_in_slice ue(v), slice_type ue(v)
+      BitReader reader(data + nal + 1, size - nal - 1);
+      if (reader.read_ue() < 0)
+        return flags;
+      const int64_t slice_type = reader.read_ue();
+      if (slice_type < 0)
+        return flags;
+      switch (slice_type % 5) {
+      case 0: // P
+      case 3: // SP
+        return flags | H264FrameType::PFRAME;
+      case 1: // B
+        return flags | H264FrameType::BFRAME;
+      default: // I / SI（非 IDR）
+        return flags;
+      }
+    }
+    nal = find_nal(data, size, nal + 1);
+  }
+  return flags;
+}
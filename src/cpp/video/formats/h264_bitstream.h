@@ -0,0 +1,31 @@
+/**
+ * @file h264_bitstream.h
+ * @brief H264 Annex B 码流的帧类型识别
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 摄像头（UVC H264）与 V4L2 M2M 编码器输出的每个缓冲区都是一帧 Annex B
+ * 码流。这里只解析到第一个 slice header，得到写入 ImageHeader::frame_type
+ * 的 H264FrameType 标志，不做完整的码流解析。
+ */
+
+#ifndef H264_BITSTREAM_H
+#define H264_BITSTREAM_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief 识别一帧 H264 码流的帧类型
+ * @param data Annex B 码流（以 00 00 01 或 00 00 00 01 起始码分隔的 NAL 单元）
+ * @param size 码流字节数
+ * @return uint8_t H264FrameType 标志的按位组合
+ *
+ * 依次检查 NAL 单元，遇到 SPS/PPS 置 CODEC_CONFIG，遇到第一个 slice 时
+ * 根据 nal_unit_type（5 为 IDR）与 slice_type 置 KEYFRAME/PFRAME/BFRAME
+ * 并停止扫描。参数集通常位于帧首，扫描代价与帧大小无关。
+ */
+uint8_t h264_frame_type(const uint8_t *data, size_t size);
+
+#endif // H264_BITSTREAM_H
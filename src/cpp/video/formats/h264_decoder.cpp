@@ -0,0 +1,247 @@
+/**
+ * @file h264_decoder.cpp
+ * @brief H264 硬件解码器实现
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 按内核 stateful 解码器接口（Documentation/userspace-api/media/v4l/dev-decoder）
+ * 的流程工作：先启动码流队列，等待 V4L2_EVENT_SOURCE_CHANGE 得知分辨率后
+ * 再建立 NV12 输出队列。
+ */
+
+#include "h264_decoder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <linux/videodev2.h>
+#include <poll.h>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+constexpr uint32_t INPUT_BUFFERS = 4;   ///< 码流缓冲区数量
+constexpr int DECODE_TIMEOUT_MS = 200;  ///< 单次 decode_into() 等待输出的上限
+constexpr uint32_t MIN_INPUT_SIZE = 1u << 20; ///< 码流缓冲区大小下限
+
+} // namespace
+
+H264Decoder::H264Decoder(const DecoderOptions &options,
+                         const std::string &device_path)
+    : options_(options), device_path_(device_path), visible_width_(0),
+      visible_height_(0), capture_ready_(false), waiting_keyframe_(true) {}
+
+H264Decoder::~H264Decoder() = default;
+
+void H264Decoder::decode_into(const uint8_t *data, const ImageHeader &header,
+                              cv::Mat &out) {
+  if (header.format != ImageFormat::H264)
+    throw std::runtime_error("H264Decoder: unexpected image format " +
+                             std::to_string((int)header.format));
+
+  // 参考帧缺失时解码结果没有意义，丢弃到下一个关键帧
+  if (waiting_keyframe_) {
+    if (!(header.frame_type & H264FrameType::KEYFRAME)) {
+      out.release();
+      return;
+    }
+    waiting_keyframe_ = false;
+  }
+
+  try {
+    if (!device_)
+      open_device(header);
+    handle_events();
+
+    int index = acquire_input();
+    if (index < 0)
+      throw std::runtime_error("H264Decoder: decoder input queue stalled");
+    if (header.data_size >
+        device_->get_plane_length(M2mQueue::Output, index, 0)) {
+      free_inputs_.push_back(index);
+      throw std::runtime_error("H264Decoder: frame of " +
+                               std::to_string(header.data_size) +
+                               " bytes exceeds decoder input buffer");
+    }
+    memcpy(device_->get_plane(M2mQueue::Output, index, 0), data,
+           header.data_size);
+    const uint32_t bytesused[2] = {header.data_size, 0};
+    device_->queue_buffer(M2mQueue::Output, index, bytesused,
+                          header.capture_timestamp_us);
+
+    // 等待解码输出；CAPTURE 队列建立前 poll 可能立即返回 POLLERR，
+    // 此时改为短暂休眠后再检查事件
+    const auto deadline = std::chrono::steady_clock::now() +
+                          std::chrono::milliseconds(DECODE_TIMEOUT_MS);
+    while (true) {
+      handle_events();
+      if (capture_ready_ && drain_output(out))
+        return;
+      const auto remaining =
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              deadline - std::chrono::steady_clock::now())
+              .count();
+      if (remaining <= 0)
+        break;
+      pollfd pfd = {device_->get_fd(), POLLIN | POLLPRI, 0};
+      int ret = poll(&pfd, 1, (int)remaining);
+      if (ret > 0 && !capture_ready_ && !(pfd.revents & POLLPRI))
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    out.release(); // 解码器尚未输出（启动阶段或有解码延迟）
+  } catch (...) {
+    // 设备状态未知：关闭解码器，下一个关键帧到达时重新打开
+    device_.reset();
+    capture_ready_ = false;
+    waiting_keyframe_ = true;
+    throw;
+  }
+}
+
+void H264Decoder::open_device(const ImageHeader &header) {
+  std::string path = device_path_;
+  if (path.empty())
+    path = V4l2M2mDevice::find_device(V4L2_PIX_FMT_H264, false);
+  if (path.empty())
+    throw std::runtime_error("H264Decoder: no V4L2 M2M H264 decoder found");
+
+  auto device = std::make_unique<V4l2M2mDevice>(path);
+  const uint32_t sizeimage =
+      std::max(header.width * header.height * 3 / 2, MIN_INPUT_SIZE);
+  device->set_format(M2mQueue::Output, V4L2_PIX_FMT_H264, header.width,
+                     header.height, sizeimage);
+  device->subscribe_event(V4L2_EVENT_SOURCE_CHANGE);
+  const uint32_t inputs =
+      device->request_buffers(M2mQueue::Output, INPUT_BUFFERS);
+  device->set_streaming(M2mQueue::Output, true);
+
+  free_inputs_.clear();
+  for (uint32_t i = 0; i < inputs; ++i)
+    free_inputs_.push_back(i);
+  capture_ready_ = false;
+  device_ = std::move(device);
+  std::cout << "H264Decoder: Using " << path << std::endl;
+}
+
+void H264Decoder::handle_events() {
+  uint32_t type;
+  while ((type = device_->dequeue_event()) != 0) {
+    if (type == V4L2_EVENT_SOURCE_CHANGE)
+      setup_capture();
+  }
+}
+
+void H264Decoder::setup_capture() {
+  // 分辨率变化时先停止并释放旧的输出队列
+  device_->set_streaming(M2mQueue::Capture, false);
+  device_->request_buffers(M2mQueue::Capture, 0);
+  capture_ready_ = false;
+
+  capture_format_ = device_->get_format(M2mQueue::Capture);
+  if (capture_format_.pixel_format != V4L2_PIX_FMT_NV12 &&
+      capture_format_.pixel_format != V4L2_PIX_FMT_NV12M)
+    capture_format_ =
+        device_->set_format(M2mQueue::Capture, V4L2_PIX_FMT_NV12,
+                            capture_format_.width, capture_format_.height);
+  if (capture_format_.pixel_format != V4L2_PIX_FMT_NV12 &&
+      capture_format_.pixel_format != V4L2_PIX_FMT_NV12M)
+    throw std::runtime_error(
+        "H264Decoder: " + device_->get_path() + " cannot output NV12");
+
+  visible_width_ = capture_format_.width;
+  visible_height_ = capture_format_.height;
+  device_->get_visible_size(&visible_width_, &visible_height_);
+
+  const int32_t min_buffers =
+      device_->get_control(V4L2_CID_MIN_BUFFERS_FOR_CAPTURE, 2);
+  const uint32_t count =
+      device_->request_buffers(M2mQueue::Capture, (uint32_t)min_buffers + 2);
+  for (uint32_t i = 0; i < count; ++i)
+    device_->queue_buffer(M2mQueue::Capture, i);
+  device_->set_streaming(M2mQueue::Capture, true);
+  capture_ready_ = true;
+  std::cout << "H264Decoder: Stream " << visible_width_ << "x"
+            << visible_height_ << ", " << count << " output buffers"
+            << std::endl;
+}
+
+int H264Decoder::acquire_input() {
+  M2mBuffer buffer;
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    while (device_->dequeue_buffer(M2mQueue::Output, &buffer))
+      free_inputs_.push_back(buffer.index);
+    if (!free_inputs_.empty()) {
+      int index = (int)free_inputs_.back();
+      free_inputs_.pop_back();
+      return index;
+    }
+    pollfd pfd = {device_->get_fd(), POLLOUT, 0};
+    poll(&pfd, 1, DECODE_TIMEOUT_MS);
+  }
+  return -1;
+}
+
+bool H264Decoder::drain_output(cv::Mat &out) {
+  M2mBuffer buffer;
+  int latest = -1;
+  while (device_->dequeue_buffer(M2mQueue::Capture, &buffer)) {
+    // 解码出错的帧与排空标记（bytesused 为 0）直接放回
+    if ((buffer.flags & V4L2_BUF_FLAG_ERROR) || buffer.bytesused[0] == 0) {
+      device_->queue_buffer(M2mQueue::Capture, buffer.index);
+      continue;
+    }
+    if (latest >= 0)
+      device_->queue_buffer(M2mQueue::Capture, latest);
+    latest = (int)buffer.index;
+  }
+  if (latest < 0)
+    return false;
+  convert(latest, out);
+  device_->queue_buffer(M2mQueue::Capture, latest);
+  return true;
+}
+
+void H264Decoder::convert(uint32_t index, cv::Mat &out) {
+  // 单平面 NV12 的 UV 紧跟在（按宏块对齐的）Y 平面之后，NV12M 为独立平面
+  uint8_t *y = device_->get_plane(M2mQueue::Capture, index, 0);
+  const size_t y_stride = capture_format_.bytesperline[0];
+  uint8_t *uv = nullptr;
+  size_t uv_stride = y_stride;
+  if (capture_format_.num_planes > 1) {
+    uv = device_->get_plane(M2mQueue::Capture, index, 1);
+    uv_stride = capture_format_.bytesperline[1];
+  } else {
+    uv = y + y_stride * capture_format_.height;
+  }
+
+  const cv::Size visible((int)visible_width_, (int)visible_height_);
+  const bool full_frame =
+      options_.roi.empty() && options_.scaled_size(visible) == visible;
+  cv::Mat &target = full_frame ? out : converted_;
+  cv::Mat y_plane(visible_height_, visible_width_, CV_8UC1, y, y_stride);
+  if (options_.color == DecodeColor::Gray) {
+    // 亮度平面即灰度图，跳过色度转换
+    y_plane.copyTo(target);
+  } else {
+    cv::Mat uv_plane(visible_height_ / 2, visible_width_ / 2, CV_8UC2, uv,
+                     uv_stride);
+    cv::cvtColorTwoPlane(y_plane, uv_plane, target, cv::COLOR_YUV2BGR_NV12);
+  }
+  if (full_frame)
+    return;
+
+  cv::Mat region = converted_;
+  if (!options_.roi.empty())
+    region = converted_(options_.roi &
+                        cv::Rect(0, 0, converted_.cols, converted_.rows));
+  const cv::Size out_size = options_.scaled_size(region.size());
+  if (region.empty())
+    out.release(); // ROI 完全在画面之外
+  else if (out_size == region.size())
+    region.copyTo(out);
+  else
+    cv::resize(region, out, out_size, 0, 0, cv::INTER_AREA);
+}
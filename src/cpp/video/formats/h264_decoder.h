@@ -0,0 +1,110 @@
+/**
+ * @file h264_decoder.h
+ * @brief H264 硬件解码器
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 该文件实现了基于 V4L2 M2M stateful 解码器的 H264 解码：码流送入硬件
+ * 解码器，取回 NV12 后由 OpenCV 转换为 BGR（或直接取亮度平面）。
+ */
+
+#ifndef H264_DECODER_H
+#define H264_DECODER_H
+
+#include "decoder_interface.h"
+#include "v4l2_m2m.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief H264 解码器类
+ *
+ * 实现 IDecoder 接口。H264 帧之间存在参考关系，与 MJPEG/YUYV 不同：
+ * - 解码器是有状态的，同一个实例必须按顺序收到同一路流的每一帧；
+ *   DecodePipeline 对 H264 只使用一个工作线程；
+ * - 首次使用或出错后丢弃帧直到下一个关键帧（ImageHeader::frame_type 含
+ *   H264FrameType::KEYFRAME），期间 out 为空矩阵而不是抛出异常；
+ * - 硬件解码器可能延迟输出，一次 decode_into() 最多等待 200 毫秒，
+ *   同时有多帧就绪时只转换最新一帧，避免延迟累积。
+ *
+ * 最新帧模式的消费者会跳帧，跳过的参考帧会让后续画面出现花屏直到下一个
+ * 关键帧；需要完整画面的消费者应使用队列模式，或在生产者端缩短 gop。
+ * 硬件解码器的 CAPTURE 格式须为 NV12/NV12M。
+ */
+class H264Decoder : public IDecoder {
+public:
+  /**
+   * @brief 构造函数，不立即打开设备
+   * @param options 输出选项；ROI 与输出尺寸在 BGR 转换后应用
+   * @param device_path M2M 解码器设备，为空时在首个关键帧到达时自动查找
+   */
+  explicit H264Decoder(const DecoderOptions &options = DecoderOptions(),
+                       const std::string &device_path = std::string());
+
+  /**
+   * @brief 析构函数，停止并关闭解码器
+   */
+  ~H264Decoder() override;
+
+  /**
+   * @brief 解码一帧 H264 码流
+   * @param data Annex B 码流
+   * @param header 图像头部信息，frame_type 为 H264FrameType 标志
+   * @param out 输出矩阵；等待关键帧或解码器尚未输出时为空
+   * @throws std::runtime_error 当找不到解码器、设备出错或码流超出缓冲区时抛出异常
+   */
+  void decode_into(const uint8_t *data, const ImageHeader &header,
+                   cv::Mat &out) override;
+
+  H264Decoder(const H264Decoder &) = delete;
+  H264Decoder &operator=(const H264Decoder &) = delete;
+
+private:
+  /**
+   * @brief 打开解码器并启动码流（OUTPUT）队列
+   */
+  void open_device(const ImageHeader &header);
+
+  /**
+   * @brief 处理解码器事件，分辨率确定或变化时重新建立 CAPTURE 队列
+   */
+  void handle_events();
+
+  /**
+   * @brief 按解码器报告的格式分配并启动 CAPTURE 队列
+   */
+  void setup_capture();
+
+  /**
+   * @brief 等待一个空闲的码流缓冲区
+   * @return int 缓冲区索引，超时返回 -1
+   */
+  int acquire_input();
+
+  /**
+   * @brief 取出全部已解码的帧，把最新一帧转换到 out
+   * @return bool 是否转换了至少一帧
+   */
+  bool drain_output(cv::Mat &out);
+
+  /**
+   * @brief 把 NV12 帧按输出选项转换到 out
+   */
+  void convert(uint32_t index, cv::Mat &out);
+
+  DecoderOptions options_;   ///< 输出选项
+  std::string device_path_;  ///< 配置的解码器设备
+  std::unique_ptr<V4l2M2mDevice> device_; ///< M2M 解码器，首个关键帧到达时打开
+  M2mFormat capture_format_; ///< CAPTURE 队列格式（NV12/NV12M）
+  uint32_t visible_width_;   ///< 可见宽度（去掉宏块对齐）
+  uint32_t visible_height_;  ///< 可见高度
+  std::vector<uint32_t> free_inputs_; ///< 空闲的码流缓冲区索引
+  bool capture_ready_;       ///< CAPTURE 队列是否已建立
+  bool waiting_keyframe_;    ///< 是否在丢帧等待关键帧
+  cv::Mat converted_;        ///< 应用 ROI/缩放前的完整 BGR 帧
+};
+
+#endif // H264_DECODER_H
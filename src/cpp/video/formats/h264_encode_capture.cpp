@@ -0,0 +1,322 @@
+/**
+ * @file h264_encode_capture.cpp
+ * @brief 生产者内 H264 硬件编码捕获器实现
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ */
+
+#include "h264_encode_capture.h"
+#include "h264_bitstream.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <linux/videodev2.h>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint32_t SOURCE_EVENT = 0;  ///< epoll 事件标签：源捕获器
+constexpr uint32_t ENCODER_EVENT = 1; ///< epoll 事件标签：编码器
+constexpr size_t MAX_PENDING = 64;    ///< 时间戳对照表上限，防止编码器丢帧时无限增长
+
+} // namespace
+
+H264EncodeCapture::H264EncodeCapture(std::unique_ptr<ICapture> source,
+                                     const V4l2Config &config)
+    : source_(std::move(source)), config_(config), epoll_fd_(-1),
+      streaming_(false), held_index_(-1), frames_dropped_(0) {
+  if (!source_ || source_->get_poll_fd() == -1)
+    throw std::runtime_error(
+        "H264EncodeCapture: source capture must provide a poll fd");
+  if (config_.pixel_format_v4l2 != V4L2_PIX_FMT_YUYV)
+    throw std::runtime_error(
+        "H264EncodeCapture: encoding requires a YUYV source");
+  if (config_.width <= 0 || config_.height <= 0)
+    throw std::runtime_error(
+        "H264EncodeCapture: encoding requires width and height");
+
+  std::string path = config_.encode.device_path;
+  if (path.empty())
+    path = V4l2M2mDevice::find_device(V4L2_PIX_FMT_H264, true);
+  if (path.empty())
+    throw std::runtime_error(
+        "H264EncodeCapture: no V4L2 M2M H264 encoder found");
+  encoder_ = std::make_unique<V4l2M2mDevice>(path);
+  init_encoder();
+
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd_ == -1)
+    throw std::runtime_error("H264EncodeCapture: epoll_create1 failed: " +
+                             std::string(strerror(errno)));
+  epoll_event source_event{};
+  source_event.events = EPOLLIN;
+  source_event.data.u32 = SOURCE_EVENT;
+  epoll_event encoder_event{};
+  encoder_event.events = EPOLLIN;
+  encoder_event.data.u32 = ENCODER_EVENT;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, source_->get_poll_fd(),
+                &source_event) == -1 ||
+      epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, encoder_->get_fd(),
+                &encoder_event) == -1) {
+    close(epoll_fd_);
+    throw std::runtime_error("H264EncodeCapture: epoll_ctl failed: " +
+                             std::string(strerror(errno)));
+  }
+}
+
+H264EncodeCapture::~H264EncodeCapture() {
+  try {
+    stop();
+  } catch (...) {
+  } // Destructors should not throw
+  if (epoll_fd_ != -1)
+    close(epoll_fd_);
+}
+
+void H264EncodeCapture::init_encoder() {
+  const uint32_t width = config_.width;
+  const uint32_t height = config_.height;
+
+  // stateful 编码器先设置编码格式（CAPTURE），再设置原始格式（OUTPUT）；
+  // 码流缓冲区按一帧 NV12 的大小申请，足以容纳最坏情况下的关键帧
+  encoder_->set_format(M2mQueue::Capture, V4L2_PIX_FMT_H264, width, height,
+                       width * height * 3 / 2);
+  input_format_ = encoder_->set_format(M2mQueue::Output,
+                                       config_.pixel_format_v4l2, width,
+                                       height);
+  if (input_format_.pixel_format != config_.pixel_format_v4l2 ||
+      input_format_.num_planes != 1)
+    throw std::runtime_error("H264EncodeCapture: " + encoder_->get_path() +
+                             " does not accept YUYV input");
+  if (input_format_.width != width || input_format_.height != height)
+    throw std::runtime_error(
+        "H264EncodeCapture: " + encoder_->get_path() + " does not support " +
+        std::to_string(width) + "x" + std::to_string(height));
+  if (input_format_.bytesperline[0] == 0)
+    input_format_.bytesperline[0] = width * 2;
+
+  encoder_->set_frame_rate(config_.encode.fps);
+
+  // 各驱动支持的控制项不同，不支持的只打印警告：
+  // 不插入 B 帧以免重排序延迟，关键帧前重复 SPS/PPS 供中途加入的消费者解码
+  const struct {
+    uint32_t id;
+    int32_t value;
+    const char *name;
+  } controls[] = {
+      {V4L2_CID_MPEG_VIDEO_BITRATE, (int32_t)config_.encode.bitrate,
+       "bitrate"},
+      {V4L2_CID_MPEG_VIDEO_GOP_SIZE, (int32_t)config_.encode.gop, "gop size"},
+      {V4L2_CID_MPEG_VIDEO_H264_I_PERIOD, (int32_t)config_.encode.gop,
+       "I period"},
+      {V4L2_CID_MPEG_VIDEO_B_FRAMES, 0, "B frames"},
+      {V4L2_CID_MPEG_VIDEO_REPEAT_SEQ_HEADER, 1, "repeat sequence header"},
+  };
+  for (const auto &control : controls) {
+    if (!encoder_->set_control(control.id, control.value))
+      std::cerr << "H264EncodeCapture: " << encoder_->get_path()
+                << " ignores " << control.name << " control" << std::endl;
+  }
+
+  const uint32_t inputs =
+      encoder_->request_buffers(M2mQueue::Output, config_.encode.buffer_count);
+  const uint32_t outputs = encoder_->request_buffers(
+      M2mQueue::Capture, config_.encode.buffer_count);
+  if (outputs < 2)
+    throw std::runtime_error(
+        "H264EncodeCapture: insufficient encoder buffers");
+  if (encoder_->get_plane_length(M2mQueue::Output, 0, 0) <
+      (size_t)input_format_.bytesperline[0] * height)
+    throw std::runtime_error(
+        "H264EncodeCapture: encoder input buffer too small");
+  free_inputs_.reserve(inputs);
+
+  std::cout << "H264EncodeCapture: Encoding " << width << "x" << height
+            << " at " << config_.encode.bitrate << " bit/s, GOP "
+            << config_.encode.gop << " via " << encoder_->get_path()
+            << std::endl;
+}
+
+void H264EncodeCapture::start() {
+  if (streaming_)
+    return;
+  free_inputs_.clear();
+  for (uint32_t i = 0; i < encoder_->get_buffer_count(M2mQueue::Output); ++i)
+    free_inputs_.push_back(i);
+  for (uint32_t i = 0; i < encoder_->get_buffer_count(M2mQueue::Capture); ++i)
+    encoder_->queue_buffer(M2mQueue::Capture, i);
+  encoder_->set_streaming(M2mQueue::Output, true);
+  encoder_->set_streaming(M2mQueue::Capture, true);
+  streaming_ = true;
+  source_->start();
+}
+
+void H264EncodeCapture::stop() {
+  if (!streaming_)
+    return;
+  source_->stop();
+  // STREAMOFF 后编码器归还两个队列的全部缓冲区
+  encoder_->set_streaming(M2mQueue::Capture, false);
+  encoder_->set_streaming(M2mQueue::Output, false);
+  streaming_ = false;
+  held_index_ = -1;
+  pending_.clear();
+  if (frames_dropped_)
+    std::cout << "H264EncodeCapture: Dropped " << frames_dropped_
+              << " source frames (encoder busy)" << std::endl;
+}
+
+bool H264EncodeCapture::capture(CapturedFrame &out_frame,
+                                std::atomic<bool> &running) {
+  // 上一帧的码流已被调用者使用完毕，此时才归还给编码器
+  if (held_index_ >= 0) {
+    encoder_->queue_buffer(M2mQueue::Capture, held_index_);
+    held_index_ = -1;
+  }
+
+  if (!dequeue(out_frame, running))
+    return false;
+  held_index_ = out_frame.buffer_index;
+  out_frame.buffer_index = -1;
+  return true;
+}
+
+bool H264EncodeCapture::dequeue(CapturedFrame &out_frame,
+                                std::atomic<bool> &running) {
+  out_frame.data = nullptr;
+  out_frame.buffer_index = -1;
+
+  epoll_event event;
+  int ret = epoll_wait(epoll_fd_, &event, 1, 200);
+  if (ret < 0)
+    return errno == EINTR;
+  if (ret == 0)
+    return true;
+
+  if (!running.load())
+    return false;
+
+  return dequeue_ready(out_frame);
+}
+
+bool H264EncodeCapture::dequeue_ready(CapturedFrame &out_frame) {
+  out_frame.data = nullptr;
+  out_frame.buffer_index = -1;
+
+  // 只在源描述符就绪时取源帧：回放源的 dequeue_ready() 不检查是否到期
+  epoll_event events[2];
+  int ready = epoll_wait(epoll_fd_, events, 2, 0);
+  bool source_ready = false;
+  for (int i = 0; i < ready; ++i)
+    if (events[i].data.u32 == SOURCE_EVENT)
+      source_ready = true;
+
+  try {
+    reclaim_input();
+    if (source_ready) {
+      CapturedFrame raw{};
+      if (!source_->dequeue_ready(raw))
+        return false;
+      if (raw.data) {
+        bool fed = feed(raw);
+        source_->release(raw);
+        if (!fed)
+          frames_dropped_++;
+      }
+    }
+    take_encoded(out_frame);
+  } catch (const std::exception &e) {
+    std::cerr << "H264EncodeCapture: " << e.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void H264EncodeCapture::release(const CapturedFrame &frame) {
+  if (frame.buffer_index >= 0 && streaming_)
+    encoder_->queue_buffer(M2mQueue::Capture, frame.buffer_index);
+}
+
+uint32_t H264EncodeCapture::get_max_outstanding() const {
+  // 至少留一个 CAPTURE 缓冲区给编码器，否则编码器停止输出
+  return encoder_->get_buffer_count(M2mQueue::Capture) - 1;
+}
+
+void H264EncodeCapture::reclaim_input() {
+  M2mBuffer buffer;
+  while (encoder_->dequeue_buffer(M2mQueue::Output, &buffer))
+    free_inputs_.push_back(buffer.index);
+}
+
+bool H264EncodeCapture::feed(const CapturedFrame &raw) {
+  if (raw.format != ImageFormat::YUYV || raw.width != input_format_.width ||
+      raw.height != input_format_.height)
+    throw std::runtime_error("source frame does not match encoder input " +
+                             std::to_string(input_format_.width) + "x" +
+                             std::to_string(input_format_.height) + " YUYV");
+  const size_t src_stride = (size_t)raw.width * 2;
+  const size_t dst_stride = input_format_.bytesperline[0];
+  if (raw.size < src_stride * raw.height)
+    return false; // 驱动交出的残帧
+  if (free_inputs_.empty())
+    return false;
+
+  const uint32_t index = free_inputs_.back();
+  free_inputs_.pop_back();
+  uint8_t *dst = encoder_->get_plane(M2mQueue::Output, index, 0);
+  if (dst_stride == src_stride) {
+    memcpy(dst, raw.data, src_stride * raw.height);
+  } else {
+    // 编码器要求的行跨度有对齐填充时逐行拷贝
+    for (uint32_t row = 0; row < raw.height; ++row)
+      memcpy(dst + row * dst_stride, raw.data + row * src_stride, src_stride);
+  }
+
+  // 采集时间戳随缓冲区经编码器复制到码流缓冲区，出队时间戳按对照表取回
+  const uint32_t bytesused[2] = {(uint32_t)(dst_stride * raw.height), 0};
+  encoder_->queue_buffer(M2mQueue::Output, index, bytesused, raw.timestamp_us);
+  pending_.emplace_back(raw.timestamp_us, raw.dequeue_timestamp_us);
+  if (pending_.size() > MAX_PENDING)
+    pending_.pop_front();
+  return true;
+}
+
+bool H264EncodeCapture::take_encoded(CapturedFrame &out_frame) {
+  M2mBuffer buffer;
+  while (encoder_->dequeue_buffer(M2mQueue::Capture, &buffer)) {
+    if ((buffer.flags & V4L2_BUF_FLAG_ERROR) || buffer.bytesused[0] == 0) {
+      encoder_->queue_buffer(M2mQueue::Capture, buffer.index);
+      continue;
+    }
+
+    const uint8_t *data =
+        encoder_->get_plane(M2mQueue::Capture, buffer.index, 0);
+    out_frame.data = data;
+    out_frame.size = buffer.bytesused[0];
+    out_frame.width = input_format_.width;
+    out_frame.height = input_format_.height;
+    out_frame.format = ImageFormat::H264;
+    out_frame.cv_type = h264_frame_type(data, out_frame.size);
+    if (buffer.flags & V4L2_BUF_FLAG_KEYFRAME)
+      out_frame.cv_type |= H264FrameType::KEYFRAME;
+    out_frame.published = false;
+    out_frame.buffer_index = (int)buffer.index;
+    out_frame.timestamp_us = buffer.timestamp_us;
+
+    // 编码器不重排序（B 帧已关闭），对照表按采集时间戳顺序匹配
+    while (!pending_.empty() && pending_.front().first < buffer.timestamp_us)
+      pending_.pop_front();
+    if (!pending_.empty() && pending_.front().first == buffer.timestamp_us) {
+      out_frame.dequeue_timestamp_us = pending_.front().second;
+      pending_.pop_front();
+    } else {
+      out_frame.dequeue_timestamp_us = monotonic_now_us();
+    }
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,142 @@
+/**
+ * @file h264_encode_capture.h
+ * @brief 生产者内 H264 硬件编码捕获器
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 该文件实现了包装其他捕获器的编码捕获器：原始帧（YUYV）在生产者内送入
+ * V4L2 M2M 硬件编码器，发布到共享内存的是 H264 码流。1280x720 YUYV 每帧
+ * 1.8 MB，编码后通常只有几十 KB，网络桥接与录制的带宽随之大幅下降。
+ */
+
+#ifndef H264_ENCODE_CAPTURE_H
+#define H264_ENCODE_CAPTURE_H
+
+#include "capture_interface.h"
+#include "config/config_manager.h"
+#include "v4l2_m2m.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief H264 编码捕获器
+ *
+ * 实现 ICapture 接口，内部持有原始帧捕获器（V4l2Capture 或 ReplayCapture）
+ * 和一个 V4L2 M2M 编码器：
+ * - 原始帧出队后拷贝进编码器 OUTPUT 缓冲区并立即归还源捕获器；
+ * - 编码器 CAPTURE 缓冲区中的码流作为帧交给调用者，buffer_index 为编码器
+ *   缓冲区索引，release() 后才放回编码器，发布线程可以直接从中拷贝；
+ * - 帧的 cv_type 为 H264FrameType 标志（关键帧、参数集等），经
+ *   ImageHeader::frame_type 传给消费者。
+ *
+ * 源捕获器与编码器的描述符注册在内部 epoll 实例中，get_poll_fd() 返回该
+ * 实例，因此编码通道同样可以加入 CapturePipeline 的多设备 epoll 循环。
+ * 编码器按配置每 gop 帧插入一个关键帧并在关键帧前重复 SPS/PPS，消费者中途
+ * 加入时最多等待一个关键帧间隔即可开始解码。
+ *
+ * @note 原始帧必须由编码器自己的缓冲区承载，不支持零拷贝（userptr）源
+ */
+class H264EncodeCapture : public ICapture {
+public:
+  /**
+   * @brief 构造函数，打开并配置编码器
+   * @param source 原始帧捕获器，须提供 get_poll_fd()
+   * @param config 捕获配置，使用其中的 width/height/pixel_format_v4l2 与 encode 字段
+   * @throws std::runtime_error 当找不到编码器、编码器不接受源格式或
+   *         缓冲区分配失败时抛出异常
+   */
+  H264EncodeCapture(std::unique_ptr<ICapture> source,
+                    const V4l2Config &config);
+
+  /**
+   * @brief 析构函数，停止编码器与源捕获器
+   */
+  ~H264EncodeCapture() override;
+
+  /**
+   * @brief 启动编码器两个队列，然后启动源捕获器
+   * @throws std::runtime_error 当 STREAMON 失败时抛出异常
+   */
+  void start() override;
+
+  /**
+   * @brief 停止源捕获器与编码器
+   */
+  void stop() override;
+
+  /**
+   * @brief 取出一帧编码后的码流，缓冲区在下次调用时归还编码器
+   */
+  bool capture(CapturedFrame &out_frame, std::atomic<bool> &running) override;
+
+  /**
+   * @brief 等待源帧或编码结果，最多 200 毫秒；语义同 V4l2Capture::dequeue()
+   */
+  bool dequeue(CapturedFrame &out_frame, std::atomic<bool> &running) override;
+
+  /**
+   * @brief 获取内部 epoll 描述符，源帧到达或编码完成时可读
+   */
+  int get_poll_fd() const override { return epoll_fd_; }
+
+  /**
+   * @brief 把已到达的源帧送入编码器，并取出一个已完成的编码帧
+   * @param out_frame 输出参数；暂无编码结果时 data 为 nullptr
+   * @return bool false表示源捕获器或编码器出错
+   */
+  bool dequeue_ready(CapturedFrame &out_frame) override;
+
+  /**
+   * @brief 将编码帧缓冲区放回编码器 CAPTURE 队列
+   */
+  void release(const CapturedFrame &frame) override;
+
+  /**
+   * @brief 最多可同时持有的编码帧数量（CAPTURE 缓冲区数量减一）
+   */
+  uint32_t get_max_outstanding() const override;
+
+  H264EncodeCapture(const H264EncodeCapture &) = delete;
+  H264EncodeCapture &operator=(const H264EncodeCapture &) = delete;
+
+private:
+  /**
+   * @brief 配置编码器格式、码率控制参数并分配缓冲区
+   */
+  void init_encoder();
+
+  /**
+   * @brief 回收编码器已读完的 OUTPUT 缓冲区
+   */
+  void reclaim_input();
+
+  /**
+   * @brief 把一帧原始数据拷贝进空闲的 OUTPUT 缓冲区并入队
+   * @return bool 没有空闲缓冲区（编码器跟不上）时返回false，该帧被丢弃
+   */
+  bool feed(const CapturedFrame &raw);
+
+  /**
+   * @brief 取出一个编码完成的 CAPTURE 缓冲区
+   * @return bool 取到有效码流时返回true
+   */
+  bool take_encoded(CapturedFrame &out_frame);
+
+  std::unique_ptr<ICapture> source_; ///< 原始帧捕获器
+  V4l2Config config_;                ///< 捕获与编码配置
+  std::unique_ptr<V4l2M2mDevice> encoder_; ///< M2M 编码器
+  M2mFormat input_format_;           ///< 编码器 OUTPUT 队列格式
+  std::vector<uint32_t> free_inputs_; ///< 空闲的 OUTPUT 缓冲区索引
+  std::deque<std::pair<uint64_t, uint64_t>> pending_; ///< 编码中帧的（采集时间戳, 出队时间戳）
+  int epoll_fd_;     ///< 内部 epoll 实例（源捕获器 + 编码器）
+  bool streaming_;   ///< 是否已启动
+  int held_index_;   ///< capture() 交出、尚未归还的编码器缓冲区
+  uint64_t frames_dropped_; ///< 编码器跟不上而丢弃的源帧数量
+};
+
+#endif // H264_ENCODE_CAPTURE_H
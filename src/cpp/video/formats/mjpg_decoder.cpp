@@ -11,7 +11,95 @@
 
 #include "mjpg_decoder.h"
 
-cv::Mat MjpgDecoder::decode(const uint8_t *data, const ImageHeader &header) {
+namespace {
+
+/**
+ * @brief 缩小倍数与颜色格式对应的 imdecode 标志
+ */
+int imread_flags(int reduction, bool gray) {
+  switch (reduction) {
+  case 2:
+    return gray ? cv::IMREAD_REDUCED_GRAYSCALE_2 : cv::IMREAD_REDUCED_COLOR_2;
+  case 4:
+    return gray ? cv::IMREAD_REDUCED_GRAYSCALE_4 : cv::IMREAD_REDUCED_COLOR_4;
+  case 8:
+    return gray ? cv::IMREAD_REDUCED_GRAYSCALE_8 : cv::IMREAD_REDUCED_COLOR_8;
+  default:
+    return gray ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR;
+  }
+}
+
+} // namespace
+
+MjpgDecoder::MjpgDecoder(const DecoderOptions &options) : options_(options) {}
+
+int MjpgDecoder::select_reduction(const cv::Size &region,
+                                  const cv::Size &target) {
+  if (region.area() <= 0 || target.area() <= 0)
+    return 1;
+  for (int reduction = 8; reduction > 1; reduction /= 2) {
+    if ((region.width + reduction - 1) / reduction >= target.width &&
+        (region.height + reduction - 1) / reduction >= target.height)
+      return reduction;
+  }
+  return 1;
+}
+
+void MjpgDecoder::decode_into(const uint8_t *data, const ImageHeader &header,
+                              cv::Mat &out) {
   cv::Mat compressed_mat(1, header.data_size, CV_8UC1, (void *)data);
-  return cv::imdecode(compressed_mat, cv::IMREAD_COLOR);
-}
\ No newline at end of file
+  const bool gray = options_.color == DecodeColor::Gray;
+
+  // 头部缺少分辨率时无法预先选择缩小倍数，全分辨率解码后再裁剪/缩放
+  const cv::Rect full(0, 0, (int)header.width, (int)header.height);
+  cv::Rect roi = full;
+  if (!options_.roi.empty() && !full.empty()) {
+    roi = options_.roi & full;
+    if (roi.empty()) {
+      out.release(); // ROI 完全在画面之外
+      return;
+    }
+  }
+  const cv::Size target = options_.scaled_size(roi.size());
+  const int reduction = select_reduction(roi.size(), target);
+  const int flags = imread_flags(reduction, gray);
+
+  // 整幅图像缩小解码恰好得到输出尺寸：带 dst 的 imdecode 重载直接解码到
+  // out，分辨率不变时不重新分配
+  const cv::Size reduced((full.width + reduction - 1) / reduction,
+                         (full.height + reduction - 1) / reduction);
+  if (options_.is_default() ||
+      (!full.empty() && roi == full && target == reduced)) {
+    cv::imdecode(compressed_mat, flags, &out);
+    return;
+  }
+
+  cv::imdecode(compressed_mat, flags, &reduced_);
+  if (reduced_.empty()) {
+    out.release();
+    return;
+  }
+
+  // ROI 换算到缩小后的图像坐标（向外取整）
+  cv::Rect bounds(0, 0, reduced_.cols, reduced_.rows);
+  cv::Rect region = bounds;
+  if (!options_.roi.empty()) {
+    const cv::Rect &r = options_.roi;
+    const int x0 = r.x / reduction, y0 = r.y / reduction;
+    const int x1 = (r.x + r.width + reduction - 1) / reduction;
+    const int y1 = (r.y + r.height + reduction - 1) / reduction;
+    region = cv::Rect(x0, y0, x1 - x0, y1 - y0) & bounds;
+  }
+  if (region.empty()) {
+    out.release(); // ROI 完全在画面之外
+    return;
+  }
+
+  const cv::Size out_size =
+      full.empty() ? options_.scaled_size(region.size()) : target;
+  cv::Mat view = reduced_(region);
+  if (view.size() == out_size)
+    view.copyTo(out);
+  else
+    cv::resize(view, out, out_size, 0, 0, cv::INTER_AREA);
+}
@@ -27,27 +27,57 @@
  * - 广泛用于网络摄像头和视频会议
  *
  * 解码过程利用OpenCV内置的JPEG解码器，确保高效和稳定的性能。
+ *
+ * 指定输出选项时在 DCT 域缩小解码（IMREAD_REDUCED_*，libjpeg 只做
+ * 1/2、1/4、1/8 的反变换）：按 ROI 与输出尺寸选择不小于输出尺寸的最大
+ * 缩小倍数，再在缩小后的图像上裁剪并缩放到输出尺寸。灰度输出只解码
+ * 亮度分量，跳过色度上采样与颜色转换。熵解码的开销与缩小倍数无关，
+ * 节省的是反变换、上采样与颜色转换。
  */
 class MjpgDecoder : public IDecoder {
 public:
+  /**
+   * @brief 构造函数
+   * @param options 输出选项（颜色格式、ROI、输出尺寸、缩小倍数），
+   *                ROI 以原始分辨率的像素坐标给出
+   */
+  explicit MjpgDecoder(const DecoderOptions &options = DecoderOptions());
+
   /**
    * @brief 解码MJPEG格式图像数据
    * @param data MJPEG格式的压缩图像数据指针
    * @param header 图像头部信息，包含数据大小等元数据
-   * @return cv::Mat 解码后的BGR格式OpenCV矩阵
+   * @param out 输出的BGR（灰度输出时为CV_8UC1）矩阵，尺寸与类型匹配时直接
+   *            复用其缓冲区；ROI 与图像无交集时为空
    * @throws std::runtime_error 当数据无效或解码失败时抛出异常
    *
    * 将MJPEG压缩数据解码为BGR格式：
    * 1. 验证输入数据的完整性和有效性
-   * 2. 使用OpenCV的imdecode函数解码JPEG数据
+   * 2. 使用OpenCV的imdecode函数解码JPEG数据（按输出选项缩小解码）
    * 3. 检查解码结果的有效性
    * 4. 确保输出格式为BGR（OpenCV默认格式）
-   * 5. 返回解码后的Mat对象
+   * 5. 写入 out（尺寸不变时不重新分配）
+   *
+   * 整幅图像缩小解码恰好得到输出尺寸时（包括默认选项）直接解码到 out，
+   * 否则经内部缓冲区裁剪/缩放。ROI 与输出尺寸按 header 中的原始分辨率计算。
    *
    * @note 输入数据必须是有效的JPEG格式
    * @warning data指针必须指向完整的JPEG数据块
    */
-  cv::Mat decode(const uint8_t *data, const ImageHeader &header) override;
+  void decode_into(const uint8_t *data, const ImageHeader &header,
+                   cv::Mat &out) override;
+
+  /**
+   * @brief 选择 DCT 域缩小倍数
+   * @param region 原始分辨率下需要的区域尺寸
+   * @param target 输出尺寸
+   * @return int 1、2、4 或 8：缩小后区域仍不小于输出尺寸的最大倍数
+   */
+  static int select_reduction(const cv::Size &region, const cv::Size &target);
+
+private:
+  DecoderOptions options_; ///< 输出选项
+  cv::Mat reduced_;        ///< 缩小解码后、裁剪/缩放前的整幅图像
 };
 
-#endif // MJPG_DECODER_H
\ No newline at end of file
+#endif // MJPG_DECODER_H
@@ -0,0 +1,94 @@
+/**
+ * @file nv12_decoder.cpp
+ * @brief NV12/NV16 半平面格式解码器实现
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ */
+
+#include "nv12_decoder.h"
+#include <stdexcept>
+#include <string>
+
+Nv12Decoder::Nv12Decoder(const DecoderOptions &options) : options_(options) {}
+
+void Nv12Decoder::decode_into(const uint8_t *data, const ImageHeader &header,
+                              cv::Mat &out) {
+  const bool nv12 = header.format == ImageFormat::NV12;
+  if (!nv12 && header.format != ImageFormat::NV16)
+    throw std::runtime_error("Nv12Decoder: unexpected image format " +
+                             std::to_string((int)header.format));
+
+  // 两个平面的最后一行都必须落在图像数据内
+  const ImagePlaneLayout planes = image_plane_layout(header);
+  const int width = (int)(header.width & ~1u);
+  const int height = (int)(nv12 ? header.height & ~1u : header.height);
+  const int chroma_rows = nv12 ? height / 2 : height;
+  if (!data || width == 0 || height == 0 ||
+      planes.strides[0] < (uint32_t)width ||
+      planes.strides[1] < (uint32_t)width ||
+      planes.offsets[0] + (uint64_t)planes.strides[0] * (height - 1) + width >
+          header.data_size ||
+      planes.offsets[1] + (uint64_t)planes.strides[1] * (chroma_rows - 1) +
+              width >
+          header.data_size)
+    throw std::runtime_error("Nv12Decoder: planes exceed frame data (" +
+                             std::to_string(header.data_size) + " bytes)");
+
+  // ROI 对齐到色度采样网格，保证每个输出像素都有对应的 UV
+  cv::Rect roi(0, 0, width, height);
+  if (!options_.roi.empty())
+    roi = options_.roi & roi;
+  roi.x &= ~1;
+  roi.width &= ~1;
+  if (nv12) {
+    roi.y &= ~1;
+    roi.height &= ~1;
+  }
+  if (roi.width <= 0 || roi.height <= 0) {
+    out.release(); // ROI 完全在画面之外
+    return;
+  }
+
+  uint8_t *base = const_cast<uint8_t *>(data);
+  cv::Mat y_plane =
+      cv::Mat(height, width, CV_8UC1, base + planes.offsets[0],
+              planes.strides[0])(roi);
+  const cv::Size out_size = options_.scaled_size(roi.size());
+  const bool scale = out_size != roi.size();
+  if (options_.color == DecodeColor::Gray) {
+    // 亮度平面即灰度图
+    if (scale)
+      cv::resize(y_plane, out, out_size, 0, 0, cv::INTER_AREA);
+    else
+      y_plane.copyTo(out);
+    return;
+  }
+
+  cv::Mat &target = scale ? converted_ : out;
+  if (nv12) {
+    cv::Mat uv_plane =
+        cv::Mat(chroma_rows, width / 2, CV_8UC2, base + planes.offsets[1],
+                planes.strides[1])(cv::Rect(roi.x / 2, roi.y / 2,
+                                            roi.width / 2, roi.height / 2));
+    cv::cvtColorTwoPlane(y_plane, uv_plane, target, cv::COLOR_YUV2BGR_NV12);
+  } else {
+    // UV 平面每行与 Y 平面同高，两个像素共享一对 UV：按 Y0 U Y1 V 交织
+    packed_.create(roi.height, roi.width, CV_8UC2);
+    for (int row = 0; row < roi.height; ++row) {
+      const uint8_t *y = y_plane.ptr<uint8_t>(row);
+      const uint8_t *uv = data + planes.offsets[1] +
+                          (size_t)planes.strides[1] * (roi.y + row) + roi.x;
+      uint8_t *dst = packed_.ptr<uint8_t>(row);
+      for (int x = 0; x < roi.width; x += 2) {
+        dst[2 * x + 0] = y[x];
+        dst[2 * x + 1] = uv[x];
+        dst[2 * x + 2] = y[x + 1];
+        dst[2 * x + 3] = uv[x + 1];
+      }
+    }
+    cv::cvtColor(packed_, target, cv::COLOR_YUV2BGR_YUY2);
+  }
+  if (scale)
+    cv::resize(converted_, out, out_size, 0, 0, cv::INTER_AREA);
+}
@@ -0,0 +1,59 @@
+/**
+ * @file nv12_decoder.h
+ * @brief NV12/NV16 半平面格式解码器
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 该文件实现了 ISP 摄像头常见的半平面 YUV 格式（NV12 为 4:2:0，NV16 为
+ * 4:2:2）到 BGR 或灰度的解码器。平面位置与行跨度取自 ImageHeader::planes，
+ * 驱动的行对齐填充与独立的 UV 平面（NV12M/NV16M）都按原样读取。
+ */
+
+#ifndef NV12_DECODER_H
+#define NV12_DECODER_H
+
+#include "decoder_interface.h"
+
+/**
+ * @brief NV12/NV16 解码器类
+ *
+ * 实现 IDecoder 接口，同一个实例可解码 NV12 与 NV16：
+ * - 先在源平面上裁剪 ROI，只转换需要的区域；ROI 向下对齐到色度采样
+ *   网格（NV12 行列均为偶数，NV16 列为偶数）
+ * - 灰度输出直接取 Y 平面，完全跳过色度
+ * - NV12 使用 OpenCV 的两平面转换；OpenCV 没有 NV16 转换，逐行交织为
+ *   YUYV 后再转换
+ * - 指定输出尺寸时在颜色转换后缩放（INTER_AREA）
+ *
+ * 只需要 NV12 原始数据的消费者（如推理前处理）应直接读取共享内存，
+ * 不必经过该解码器。
+ *
+ * @note 非线程安全，每个线程应使用独立实例
+ */
+class Nv12Decoder : public IDecoder {
+public:
+  /**
+   * @brief 构造函数
+   * @param options 输出选项（颜色格式、ROI、输出尺寸）
+   */
+  explicit Nv12Decoder(const DecoderOptions &options = DecoderOptions());
+
+  /**
+   * @brief 将 NV12/NV16 数据按输出选项解码到 out
+   * @param data 图像数据，平面布局见 header.planes
+   * @param header 图像头部信息，format 须为 NV12 或 NV16
+   * @param out 输出矩阵（CV_8UC3 或 CV_8UC1），尺寸不变时复用其缓冲区；
+   *            ROI 与图像无交集时为空
+   * @throws std::runtime_error 当格式不符或平面超出图像数据范围时抛出异常
+   */
+  void decode_into(const uint8_t *data, const ImageHeader &header,
+                   cv::Mat &out) override;
+
+private:
+  DecoderOptions options_; ///< 输出选项
+  cv::Mat packed_;         ///< NV16 交织成的 YUYV 区域
+  cv::Mat converted_;      ///< 缩放前的 BGR 区域
+};
+
+#endif // NV12_DECODER_H
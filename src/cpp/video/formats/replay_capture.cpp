@@ -0,0 +1,195 @@
+/**
+ * @file replay_capture.cpp
+ * @brief 录制回放捕获器实现
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ */
+
+#include "replay_capture.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/timerfd.h>
+#include <thread>
+#include <unistd.h>
+
+ReplayCapture::ReplayCapture(const V4l2Config &config)
+    : config_(config.replay), timer_fd_(-1), started_(false), finished_(false),
+      next_index_(0), origin_ts_us_(0), origin_due_us_(0), current_due_us_(0),
+      frame_interval_us_(0), loops_(0) {
+  timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (timer_fd_ == -1)
+    throw std::runtime_error("ReplayCapture Error: timerfd_create failed: " +
+                             std::string(strerror(errno)));
+}
+
+ReplayCapture::~ReplayCapture() {
+  stop();
+  close(timer_fd_);
+}
+
+void ReplayCapture::start() {
+  if (started_)
+    return;
+  reader_.open(config_.path);
+  RecordedFrame first, last;
+  if (!reader_.get_frame(0, &first) ||
+      !reader_.get_frame(reader_.frame_count() - 1, &last)) {
+    reader_.close();
+    throw std::runtime_error("ReplayCapture Error: No frames in recording '" +
+                             config_.path + "'");
+  }
+  uint64_t count = reader_.frame_count();
+  frame_interval_us_ =
+      count > 1 && last.timestamp_us > first.timestamp_us
+          ? (last.timestamp_us - first.timestamp_us) / (count - 1)
+          : 0;
+
+  next_index_ = 0;
+  loops_ = 0;
+  finished_ = false;
+  origin_ts_us_ = first.timestamp_us;
+  origin_due_us_ = monotonic_now_us();
+  current_due_us_ = origin_due_us_;
+  arm_timer(current_due_us_);
+  started_ = true;
+  std::cout << "ReplayCapture: Replaying " << count << " frames from "
+            << reader_.segment_count() << " segment(s) of '" << config_.path
+            << "' at ";
+  if (config_.speed > 0)
+    std::cout << config_.speed << "x";
+  else
+    std::cout << "max speed";
+  std::cout << (config_.loop ? ", looping" : "") << std::endl;
+}
+
+void ReplayCapture::stop() {
+  if (!started_)
+    return;
+  started_ = false;
+  arm_timer(0);
+  reader_.close();
+  std::cout << "ReplayCapture: Stopped after " << loops_ << " loop(s)"
+            << std::endl;
+}
+
+uint64_t ReplayCapture::due_us(uint64_t timestamp_us) {
+  if (config_.speed <= 0)
+    return monotonic_now_us();
+  if (timestamp_us < origin_ts_us_) {
+    origin_ts_us_ = timestamp_us;
+    origin_due_us_ = monotonic_now_us();
+  }
+  return origin_due_us_ + static_cast<uint64_t>(
+                              (timestamp_us - origin_ts_us_) / config_.speed);
+}
+
+void ReplayCapture::arm_timer(uint64_t due_us) {
+  struct itimerspec spec;
+  std::memset(&spec, 0, sizeof(spec));
+  spec.it_value.tv_sec = static_cast<time_t>(due_us / 1000000);
+  spec.it_value.tv_nsec = static_cast<long>(due_us % 1000000) * 1000;
+  // it_value 全零表示停用；已过期的绝对时间立即触发
+  timerfd_settime(timer_fd_, due_us ? TFD_TIMER_ABSTIME : 0, &spec, nullptr);
+}
+
+bool ReplayCapture::wait_due(std::atomic<bool> &running) {
+  struct pollfd pfd = {timer_fd_, POLLIN, 0};
+  while (running.load()) {
+    // 超时返回以便及时响应停止
+    int ret = poll(&pfd, 1, 100);
+    if (ret > 0)
+      return true;
+    if (ret < 0 && errno != EINTR)
+      return false;
+  }
+  return false;
+}
+
+bool ReplayCapture::next_frame(CapturedFrame &out_frame) {
+  out_frame.data = nullptr;
+  out_frame.buffer_index = -1;
+  if (!started_ || finished_)
+    return false;
+  uint64_t expirations;
+  ssize_t drained = read(timer_fd_, &expirations, sizeof(expirations));
+  (void)drained; // 未到期时 EAGAIN
+
+  RecordedFrame frame;
+  if (reader_.get_frame(next_index_, &frame)) {
+    const ImageHeader &image = frame.image;
+    out_frame.data = frame.data;
+    out_frame.size = frame.size;
+    out_frame.width = image.width;
+    out_frame.height = image.height;
+    out_frame.format = image.format;
+    out_frame.cv_type = image.frame_type;
+    out_frame.planes = image.planes;
+    out_frame.published = false;
+    out_frame.timestamp_us = current_due_us_;
+    out_frame.dequeue_timestamp_us = monotonic_now_us();
+  }
+
+  // 推进到下一帧并按其录制时间戳设定定时器
+  if (++next_index_ >= reader_.frame_count()) {
+    if (!config_.loop) {
+      finished_ = true;
+      arm_timer(0);
+      std::cout << "ReplayCapture: Reached end of recording" << std::endl;
+      return out_frame.data != nullptr;
+    }
+    next_index_ = 0;
+    ++loops_;
+    RecordedFrame first;
+    reader_.get_frame(0, &first);
+    origin_ts_us_ = first.timestamp_us;
+    origin_due_us_ =
+        current_due_us_ +
+        static_cast<uint64_t>(config_.speed > 0
+                                  ? frame_interval_us_ / config_.speed
+                                  : 0);
+    current_due_us_ = origin_due_us_;
+  } else {
+    RecordedFrame next;
+    current_due_us_ = reader_.get_frame(next_index_, &next)
+                          ? due_us(next.timestamp_us)
+                          : monotonic_now_us();
+  }
+  arm_timer(current_due_us_);
+  return out_frame.data != nullptr;
+}
+
+bool ReplayCapture::capture(CapturedFrame &out_frame,
+                            std::atomic<bool> &running) {
+  out_frame.data = nullptr;
+  if (!started_ || finished_ || !wait_due(running))
+    return false;
+  // 损坏的记录被跳过，继续等待下一帧
+  while (!next_frame(out_frame)) {
+    if (finished_ || !wait_due(running))
+      return false;
+  }
+  return true;
+}
+
+bool ReplayCapture::dequeue(CapturedFrame &out_frame,
+                            std::atomic<bool> &running) {
+  out_frame.data = nullptr;
+  out_frame.buffer_index = -1;
+  if (finished_) {
+    // 播放完毕后保持空闲，生产者继续运行直到被停止
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    return true;
+  }
+  if (wait_due(running))
+    next_frame(out_frame);
+  return true;
+}
+
+bool ReplayCapture::dequeue_ready(CapturedFrame &out_frame) {
+  next_frame(out_frame);
+  return true;
+}
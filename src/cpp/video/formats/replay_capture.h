@@ -0,0 +1,120 @@
+/**
+ * @file replay_capture.h
+ * @brief 录制回放捕获器
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 该文件实现了把 recorder_process 录制的段文件当作视频源的捕获器。
+ * 录制的原始负载（MJPG/YUYV 等）经与摄像头相同的 CapturePipeline /
+ * ImageShmManager 路径发布，用于无摄像头的回归测试、算法调参与
+ * 离线吞吐压力测试。
+ */
+
+#ifndef REPLAY_CAPTURE_H
+#define REPLAY_CAPTURE_H
+
+#include "capture_interface.h"
+#include "config/config_manager.h"
+#include "video/recording_reader.h"
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief 录制回放捕获器
+ *
+ * 以只读 mmap 打开录制，帧数据指针直接指向映射的文件页，发布时只有
+ * 写入共享内存的一次拷贝。发布节奏按录制的采集时间戳计算：
+ * - speed = 1：原始节奏；speed > 1：倍速；speed = 0：不限速
+ *
+ * 节奏由 timerfd 驱动，get_poll_fd() 返回该 timerfd，因此回放源可以与
+ * 摄像头一起加入 CapturePipeline 的 epoll 循环。发布的采集时间戳按回放
+ * 节奏重新计算（相对间隔除以 speed），消费者的延迟统计依然有效；
+ * 原始时间戳保留在录制文件中。
+ */
+class ReplayCapture : public ICapture {
+public:
+  /**
+   * @brief 构造函数
+   * @param config 捕获配置，使用其中的 replay 字段
+   * @throws std::runtime_error 当 timerfd 创建失败时抛出异常
+   */
+  explicit ReplayCapture(const V4l2Config &config);
+
+  /**
+   * @brief 析构函数，停止回放并关闭 timerfd
+   */
+  ~ReplayCapture() override;
+
+  /**
+   * @brief 打开录制并从第一帧开始回放
+   * @throws std::runtime_error 当录制无法打开或不含任何帧时抛出异常
+   */
+  void start() override;
+
+  /**
+   * @brief 停止回放并解除录制映射
+   */
+  void stop() override;
+
+  /**
+   * @brief 阻塞到下一帧的发布时间并取出该帧
+   * @return bool 回放结束（且未循环）或 running 变为 false 时返回false
+   */
+  bool capture(CapturedFrame &out_frame, std::atomic<bool> &running) override;
+
+  /**
+   * @brief 取出一帧；回放结束后不阻塞，返回 data 为 nullptr 的帧
+   */
+  bool dequeue(CapturedFrame &out_frame, std::atomic<bool> &running) override;
+
+  /**
+   * @brief 获取节奏 timerfd，下一帧到发布时间时可读
+   */
+  int get_poll_fd() const override { return timer_fd_; }
+
+  /**
+   * @brief timerfd 可读后取出到期的帧
+   * @return bool 始终返回true；回放结束时 data 为 nullptr
+   */
+  bool dequeue_ready(CapturedFrame &out_frame) override;
+
+private:
+  /**
+   * @brief 取出当前帧并为下一帧设定定时器
+   * @return bool 是否取到帧（回放结束时为false）
+   */
+  bool next_frame(CapturedFrame &out_frame);
+
+  /**
+   * @brief 按录制采集时间戳计算发布时间（CLOCK_MONOTONIC 微秒）
+   *
+   * 时间戳回退（如跨开机的多段录制）时从该帧重新计时。
+   */
+  uint64_t due_us(uint64_t timestamp_us);
+
+  /**
+   * @brief 把 timerfd 设定到绝对时间 due_us，0 表示停用
+   */
+  void arm_timer(uint64_t due_us);
+
+  /**
+   * @brief 等待 timerfd 可读
+   * @return bool running 变为 false 时返回false
+   */
+  bool wait_due(std::atomic<bool> &running);
+
+  ReplayConfig config_;      ///< 回放配置
+  RecordingReader reader_;   ///< 录制读取器
+  int timer_fd_;             ///< 节奏 timerfd
+  bool started_;             ///< 是否已启动
+  bool finished_;            ///< 是否已播放完毕（未循环）
+  uint64_t next_index_;      ///< 下一帧帧号
+  uint64_t origin_ts_us_;    ///< 本轮回放首帧的录制采集时间戳
+  uint64_t origin_due_us_;   ///< 本轮回放首帧的发布时间
+  uint64_t current_due_us_;  ///< 下一帧的发布时间
+  uint64_t frame_interval_us_; ///< 录制的平均帧间隔，用于循环衔接
+  uint64_t loops_;           ///< 已完成的循环次数
+};
+
+#endif // REPLAY_CAPTURE_H
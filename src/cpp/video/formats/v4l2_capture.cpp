@@ -12,11 +12,14 @@
 
 #include "v4l2_capture.h"
 #include "config/config_manager.h"
+#include "h264_bitstream.h"
 
+#include <cerrno>
 #include <cstring> // for strerror
 #include <fcntl.h>
 #include <iostream>
 #include <linux/videodev2.h>
+#include <memory>
 #include <opencv2/opencv.hpp>
 #include <poll.h>
 #include <stdexcept>
@@ -24,19 +27,55 @@
 #include <sys/mman.h>
 #include <unistd.h>
 
+namespace {
+
+/// 两个平面位于独立缓冲区时，第1平面在发布负载中的对齐（USERPTR 按页交给驱动）
+constexpr size_t PLANE_ALIGN = 4096;
+
+/**
+ * @brief 多平面格式对应的单缓冲区格式，反之亦然（NV12 <-> NV12M）
+ * @return uint32_t 对应格式，非 NV12/NV16 时返回0
+ */
+uint32_t alternate_plane_format(uint32_t pixel_format) {
+  switch (pixel_format) {
+  case V4L2_PIX_FMT_NV12:
+    return V4L2_PIX_FMT_NV12M;
+  case V4L2_PIX_FMT_NV12M:
+    return V4L2_PIX_FMT_NV12;
+  case V4L2_PIX_FMT_NV16:
+    return V4L2_PIX_FMT_NV16M;
+  case V4L2_PIX_FMT_NV16M:
+    return V4L2_PIX_FMT_NV16;
+  default:
+    return 0;
+  }
+}
+
+} // namespace
+
 struct V4l2Capture::Buffer {
-  void *start;
-  size_t length;
+  /// MMAP: 各平面的驱动缓冲区映射地址；USERPTR: 共享内存槽位内对应平面的地址
+  void *start[IMAGE_MAX_PLANES];
+  size_t length[IMAGE_MAX_PLANES]; ///< 各平面缓冲区长度
+  std::unique_ptr<WriteImageGuard> slot; ///< USERPTR模式下持有的共享内存槽位
 };
 
 V4l2Capture::V4l2Capture(const V4l2Config &config)
     : config_(config), fd_(-1), buffers_(nullptr), buffer_count_(0),
-      is_streaming_(false) {
+      is_streaming_(false), buf_type_(V4L2_BUF_TYPE_VIDEO_CAPTURE),
+      pixel_format_(config.pixel_format_v4l2), num_planes_(1),
+      plane_sizes_{0, 0}, layout_{}, frame_size_(0), held_index_(-1),
+      output_shm_(nullptr), next_frame_version_(1) {
   try {
     open_device();
     init_format();
-    init_mmap();
+    if (config_.memory_v4l2 == V4L2_MEMORY_USERPTR)
+      init_userptr();
+    else
+      init_mmap();
   } catch (...) {
+    delete[] buffers_;
+    buffers_ = nullptr;
     if (fd_ != -1)
       close(fd_);
     throw;
@@ -51,9 +90,13 @@ V4l2Capture::~V4l2Capture() {
     } // Destructors should not throw
   }
   if (buffers_) {
-    for (size_t i = 0; i < buffer_count_; ++i) {
-      if (buffers_[i].start)
-        munmap(buffers_[i].start, buffers_[i].length);
+    if (config_.memory_v4l2 == V4L2_MEMORY_MMAP) {
+      for (size_t i = 0; i < buffer_count_; ++i) {
+        for (uint32_t p = 0; p < num_planes_; ++p) {
+          if (buffers_[i].start[p])
+            munmap(buffers_[i].start[p], buffers_[i].length[p]);
+        }
+      }
     }
     delete[] buffers_;
   }
@@ -62,18 +105,38 @@ V4l2Capture::~V4l2Capture() {
   std::cout << "V4l2Capture cleaned up." << std::endl;
 }
 
+bool V4l2Capture::bind_output(ImageShmManager *shm) {
+  if (config_.memory_v4l2 != V4L2_MEMORY_USERPTR)
+    return false;
+  if (!shm || !shm->is_initialized())
+    throw std::runtime_error("Zero-copy capture requires a mapped shm.");
+  // 每个驱动缓冲区都独占一个槽位，至少还需要一个槽位留给读者
+  if (shm->get_buffer_count() <= buffer_count_)
+    throw std::runtime_error(
+        "Zero-copy capture needs more shm buffers (" +
+        std::to_string(shm->get_buffer_count()) + ") than V4L2 buffers (" +
+        std::to_string(buffer_count_) + ").");
+  if (shm->get_max_payload_size() < frame_size_)
+    throw std::runtime_error("Shm buffer too small for frame size " +
+                             std::to_string(frame_size_));
+  output_shm_ = shm;
+  return true;
+}
+
 // 实现 ICapture 接口
 void V4l2Capture::start() {
   if (is_streaming_)
     return;
+  if (config_.memory_v4l2 == V4L2_MEMORY_USERPTR && !output_shm_)
+    throw std::runtime_error("USERPTR capture started without bind_output().");
+
   for (size_t i = 0; i < buffer_count_; ++i) {
-    v4l2_buffer buf{};
-    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    buf.memory = V4L2_MEMORY_MMAP;
-    buf.index = i;
-    xioctl(VIDIOC_QBUF, &buf);
+    if (config_.memory_v4l2 == V4L2_MEMORY_USERPTR && !attach_slot(i))
+      throw std::runtime_error("No free shm slot for V4L2 buffer " +
+                               std::to_string(i));
+    queue_buffer(i);
   }
-  v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  v4l2_buf_type type = static_cast<v4l2_buf_type>(buf_type_);
   xioctl(VIDIOC_STREAMON, &type);
   is_streaming_ = true;
 }
@@ -81,13 +144,35 @@ void V4l2Capture::start() {
 void V4l2Capture::stop() {
   if (!is_streaming_)
     return;
-  v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  v4l2_buf_type type = static_cast<v4l2_buf_type>(buf_type_);
   xioctl(VIDIOC_STREAMOFF, &type);
   is_streaming_ = false;
+  held_index_ = -1;
+  // STREAMOFF 后驱动已归还所有缓冲区，释放未提交的共享内存槽位
+  for (size_t i = 0; i < buffer_count_; ++i)
+    buffers_[i].slot.reset();
 }
 
 bool V4l2Capture::capture(CapturedFrame &out_frame,
                           std::atomic<bool> &running) {
+  // 上一帧的数据已被调用者使用完毕，此时才归还给驱动
+  if (held_index_ >= 0) {
+    queue_buffer(held_index_);
+    held_index_ = -1;
+  }
+
+  if (!dequeue(out_frame, running))
+    return false;
+  held_index_ = out_frame.buffer_index;
+  out_frame.buffer_index = -1;
+  return true;
+}
+
+bool V4l2Capture::dequeue(CapturedFrame &out_frame,
+                          std::atomic<bool> &running) {
+  out_frame.data = nullptr;
+  out_frame.buffer_index = -1;
+
   pollfd pfd = {fd_, POLLIN, 0};
   int ret = poll(&pfd, 1, 200);
   if (ret < 0)
@@ -98,80 +183,313 @@ bool V4l2Capture::capture(CapturedFrame &out_frame,
   if (!running.load())
     return false;
 
+  return dequeue_ready(out_frame);
+}
+
+int V4l2Capture::get_poll_fd() const { return fd_; }
+
+bool V4l2Capture::dequeue_ready(CapturedFrame &out_frame) {
+  out_frame.data = nullptr;
+  out_frame.buffer_index = -1;
+
+  v4l2_plane planes[VIDEO_MAX_PLANES]{};
   v4l2_buffer buf{};
-  buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-  buf.memory = V4L2_MEMORY_MMAP;
+  buf.type = buf_type_;
+  buf.memory = config_.memory_v4l2;
+  if (buf_type_ == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE) {
+    buf.m.planes = planes;
+    buf.length = num_planes_;
+  }
   if (ioctl(fd_, VIDIOC_DQBUF, &buf) == -1)
-    return false;
+    return errno == EAGAIN; // 非阻塞描述符上暂无就绪帧
+
+  // 驱动时间戳为 CLOCK_MONOTONIC 时直接沿用（帧首字节到达主机的时间），
+  // 否则退化为出队时间
+  current_frame_.dequeue_timestamp_us = monotonic_now_us();
+  if ((buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) ==
+          V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC &&
+      (buf.timestamp.tv_sec != 0 || buf.timestamp.tv_usec != 0))
+    current_frame_.timestamp_us = (uint64_t)buf.timestamp.tv_sec * 1000000ULL +
+                                  (uint64_t)buf.timestamp.tv_usec;
+  else
+    current_frame_.timestamp_us = current_frame_.dequeue_timestamp_us;
 
-  // 填充 CapturedFrame 结构
-  current_frame_.data = static_cast<const uint8_t *>(buffers_[buf.index].start);
-  current_frame_.size = buf.bytesused;
+  // 填充 CapturedFrame 结构；多平面缓冲区的第1平面单独交给发布者拼接
+  const Buffer &buffer = buffers_[buf.index];
+  const bool multiplanar = buf_type_ == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+  current_frame_.data = static_cast<const uint8_t *>(buffer.start[0]);
+  current_frame_.size = multiplanar ? planes[0].bytesused : buf.bytesused;
   current_frame_.width = config_.width;
   current_frame_.height = config_.height;
+  current_frame_.published = false;
+  current_frame_.buffer_index = -1;
+  current_frame_.planes = layout_;
+  current_frame_.chroma_data =
+      num_planes_ > 1 ? static_cast<const uint8_t *>(buffer.start[1]) : nullptr;
+  current_frame_.chroma_size = num_planes_ > 1 ? planes[1].bytesused : 0;
 
-  // 根据配置设置格式和 OpenCV 类型
-  if (config_.pixel_format_v4l2 == V4L2_PIX_FMT_YUYV) {
+  // 根据协商后的像素格式设置格式和 OpenCV 类型
+  if (pixel_format_ == V4L2_PIX_FMT_YUYV) {
     current_frame_.format = ImageFormat::YUYV;
     current_frame_.cv_type = CV_8UC2;
-  } else if (config_.pixel_format_v4l2 == V4L2_PIX_FMT_MJPEG) {
+  } else if (pixel_format_ == V4L2_PIX_FMT_MJPEG) {
     current_frame_.format = ImageFormat::MJPG;
     current_frame_.cv_type = CV_8UC1;
+  } else if (pixel_format_ == V4L2_PIX_FMT_NV12 ||
+             pixel_format_ == V4L2_PIX_FMT_NV12M) {
+    // 半平面格式按单通道字节平面描述，各平面位置见 planes
+    current_frame_.format = ImageFormat::NV12;
+    current_frame_.cv_type = CV_8UC1;
+  } else if (pixel_format_ == V4L2_PIX_FMT_NV16 ||
+             pixel_format_ == V4L2_PIX_FMT_NV16M) {
+    current_frame_.format = ImageFormat::NV16;
+    current_frame_.cv_type = CV_8UC1;
+  } else if (pixel_format_ == V4L2_PIX_FMT_H264) {
+    // H264 的 frame_type 携带关键帧等标志，供消费者从关键帧开始解码
+    current_frame_.format = ImageFormat::H264;
+    current_frame_.cv_type =
+        current_frame_.data
+            ? h264_frame_type(current_frame_.data, current_frame_.size)
+            : 0;
+    if (buf.flags & V4L2_BUF_FLAG_KEYFRAME)
+      current_frame_.cv_type |= H264FrameType::KEYFRAME;
   } else {
     // 默认处理
     current_frame_.format = ImageFormat::YUYV;
     current_frame_.cv_type = CV_8UC2;
   }
 
+  if (config_.memory_v4l2 == V4L2_MEMORY_USERPTR) {
+    publish_userptr_frame(buf.index);
+    queue_buffer(buf.index);
+  } else {
+    current_frame_.buffer_index = (int)buf.index;
+  }
+
   out_frame = current_frame_;
-  xioctl(VIDIOC_QBUF, &buf);
   return true;
 }
 
+void V4l2Capture::release(const CapturedFrame &frame) {
+  if (frame.buffer_index >= 0 && is_streaming_)
+    queue_buffer(frame.buffer_index);
+}
+
+uint32_t V4l2Capture::get_max_outstanding() const {
+  if (config_.memory_v4l2 == V4L2_MEMORY_USERPTR)
+    return 0;
+  return buffer_count_ - 1;
+}
+
+void V4l2Capture::publish_userptr_frame(uint32_t index) {
+  Buffer &buffer = buffers_[index];
+  // 先为该驱动缓冲区换入新槽位，失败时丢弃本帧并复用原槽位，
+  // 保证驱动队列永远不会因为读者占用槽位而断流
+  std::unique_ptr<WriteImageGuard> filled = std::move(buffer.slot);
+  if (!attach_slot(index)) {
+    buffer.slot = std::move(filled);
+    current_frame_.data = nullptr;
+    return;
+  }
+
+  // 两个平面由驱动直接写在同一槽位内，负载覆盖到第1平面末尾
+  size_t size = current_frame_.size;
+  if (current_frame_.chroma_data)
+    size = layout_.offsets[1] + current_frame_.chroma_size;
+  uint32_t channels = (current_frame_.format == ImageFormat::YUYV) ? 2 : 3;
+  ShmStatus status =
+      filled->commit(size, current_frame_.width, current_frame_.height,
+                     channels, next_frame_version_++, current_frame_.format,
+                     current_frame_.cv_type, current_frame_.timestamp_us,
+                     current_frame_.dequeue_timestamp_us, layout_);
+  current_frame_.published = (status == ShmStatus::Success);
+}
+
+bool V4l2Capture::attach_slot(uint32_t index) {
+  auto slot = std::make_unique<WriteImageGuard>(
+      output_shm_->acquire_image_for_write(frame_size_));
+  if (!slot->is_valid())
+    return false;
+  Buffer &buffer = buffers_[index];
+  buffer.start[0] = slot->data();
+  buffer.length[0] = num_planes_ > 1 ? plane_sizes_[0] : frame_size_;
+  if (num_planes_ > 1) {
+    buffer.start[1] = slot->data() + layout_.offsets[1];
+    buffer.length[1] = plane_sizes_[1];
+  }
+  buffer.slot = std::move(slot);
+  return true;
+}
+
+void V4l2Capture::queue_buffer(uint32_t index) {
+  const Buffer &buffer = buffers_[index];
+  const bool userptr = config_.memory_v4l2 == V4L2_MEMORY_USERPTR;
+  v4l2_plane planes[VIDEO_MAX_PLANES]{};
+  v4l2_buffer buf{};
+  buf.type = buf_type_;
+  buf.memory = config_.memory_v4l2;
+  buf.index = index;
+  if (buf_type_ == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE) {
+    buf.m.planes = planes;
+    buf.length = num_planes_;
+    for (uint32_t p = 0; userptr && p < num_planes_; ++p) {
+      planes[p].m.userptr = reinterpret_cast<unsigned long>(buffer.start[p]);
+      planes[p].length = buffer.length[p];
+    }
+  } else if (userptr) {
+    buf.m.userptr = reinterpret_cast<unsigned long>(buffer.start[0]);
+    buf.length = buffer.length[0];
+  }
+  xioctl(VIDIOC_QBUF, &buf);
+}
+
 void V4l2Capture::open_device() {
-  fd_ = open(config_.device_path.c_str(), O_RDWR);
+  // 非阻塞打开：出队前总是先等待可读，多设备共用 epoll 循环时
+  // 任何一个设备的伪唤醒都不会阻塞其他设备
+  fd_ = open(config_.device_path.c_str(), O_RDWR | O_NONBLOCK);
   if (fd_ == -1)
     throw std::runtime_error("Failed to open device: " + config_.device_path);
+
+  // ISP 类设备通常只提供多平面（_MPLANE）接口，两者都有时使用单平面接口
+  v4l2_capability cap{};
+  xioctl(VIDIOC_QUERYCAP, &cap);
+  uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps
+                                                            : cap.capabilities;
+  if (caps & V4L2_CAP_VIDEO_CAPTURE)
+    buf_type_ = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  else if (caps & V4L2_CAP_VIDEO_CAPTURE_MPLANE)
+    buf_type_ = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+  else
+    throw std::runtime_error("Device " + config_.device_path +
+                             " is not a video capture device");
 }
 
 void V4l2Capture::init_format() {
   v4l2_format fmt{};
-  fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-  fmt.fmt.pix.width = config_.width;
-  fmt.fmt.pix.height = config_.height;
-  fmt.fmt.pix.pixelformat = config_.pixel_format_v4l2;
-  fmt.fmt.pix.field = V4L2_FIELD_NONE;
-  xioctl(VIDIOC_S_FMT, &fmt);
+  fmt.type = buf_type_;
+  uint32_t bytesperline[IMAGE_MAX_PLANES] = {0, 0};
+  if (buf_type_ == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE) {
+    fmt.fmt.pix_mp.width = config_.width;
+    fmt.fmt.pix_mp.height = config_.height;
+    fmt.fmt.pix_mp.pixelformat = config_.pixel_format_v4l2;
+    fmt.fmt.pix_mp.field = V4L2_FIELD_NONE;
+    xioctl(VIDIOC_S_FMT, &fmt);
+    // 驱动只提供 NV12M 而配置为 NV12（或反之）时改用另一种内存布局
+    const uint32_t alternate =
+        alternate_plane_format(config_.pixel_format_v4l2);
+    if (alternate && fmt.fmt.pix_mp.pixelformat != config_.pixel_format_v4l2) {
+      fmt.fmt.pix_mp.width = config_.width;
+      fmt.fmt.pix_mp.height = config_.height;
+      fmt.fmt.pix_mp.pixelformat = alternate;
+      fmt.fmt.pix_mp.field = V4L2_FIELD_NONE;
+      xioctl(VIDIOC_S_FMT, &fmt);
+    }
+    pixel_format_ = fmt.fmt.pix_mp.pixelformat;
+    num_planes_ = fmt.fmt.pix_mp.num_planes;
+    if (num_planes_ == 0 || num_planes_ > IMAGE_MAX_PLANES)
+      throw std::runtime_error("Device " + config_.device_path + " uses " +
+                               std::to_string(num_planes_) +
+                               " memory planes, at most 2 are supported");
+    for (uint32_t p = 0; p < num_planes_; ++p) {
+      plane_sizes_[p] = fmt.fmt.pix_mp.plane_fmt[p].sizeimage;
+      bytesperline[p] = fmt.fmt.pix_mp.plane_fmt[p].bytesperline;
+    }
+  } else {
+    fmt.fmt.pix.width = config_.width;
+    fmt.fmt.pix.height = config_.height;
+    fmt.fmt.pix.pixelformat = config_.pixel_format_v4l2;
+    fmt.fmt.pix.field = V4L2_FIELD_NONE;
+    xioctl(VIDIOC_S_FMT, &fmt);
+    pixel_format_ = fmt.fmt.pix.pixelformat;
+    num_planes_ = 1;
+    plane_sizes_[0] = fmt.fmt.pix.sizeimage;
+    bytesperline[0] = fmt.fmt.pix.bytesperline;
+  }
+
+  // 摄像头不提供 H264/NV12/NV16 时驱动会改用其他格式，数据无法按配置解读
+  const uint32_t alternate = alternate_plane_format(config_.pixel_format_v4l2);
+  if ((config_.pixel_format_v4l2 == V4L2_PIX_FMT_H264 || alternate) &&
+      pixel_format_ != config_.pixel_format_v4l2 && pixel_format_ != alternate)
+    throw std::runtime_error("Device " + config_.device_path +
+                             " does not offer the configured pixel format");
+
+  // 发布负载中的平面布局：单缓冲区 NV12/NV16 的 UV 紧跟 Y 平面，
+  // NV12M/NV16M 的 UV 平面放在 Y 平面之后按页对齐的位置
+  layout_ = ImagePlaneLayout();
+  const bool semi_planar = alternate != 0;
+  if (pixel_format_ != V4L2_PIX_FMT_MJPEG &&
+      pixel_format_ != V4L2_PIX_FMT_H264)
+    layout_.strides[0] = bytesperline[0];
+  if (num_planes_ > 1) {
+    layout_.offsets[1] = static_cast<uint32_t>(
+        ShmBufferControl::align_up(plane_sizes_[0], PLANE_ALIGN));
+    layout_.strides[1] = bytesperline[1];
+    frame_size_ = layout_.offsets[1] + plane_sizes_[1];
+  } else {
+    if (semi_planar) {
+      layout_.offsets[1] =
+          bytesperline[0] * static_cast<uint32_t>(config_.height);
+      layout_.strides[1] = bytesperline[0];
+    }
+    frame_size_ = plane_sizes_[0];
+  }
 }
 
 void V4l2Capture::init_mmap() {
   v4l2_requestbuffers req{};
   req.count = config_.buffer_count;
-  req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  req.type = buf_type_;
   req.memory = V4L2_MEMORY_MMAP;
   xioctl(VIDIOC_REQBUFS, &req);
 
   if (req.count < 2)
     throw std::runtime_error("Insufficient buffer memory.");
   buffer_count_ = req.count;
-  buffers_ = new Buffer[buffer_count_];
+  buffers_ = new Buffer[buffer_count_]();
 
   for (size_t i = 0; i < buffer_count_; ++i) {
+    v4l2_plane planes[VIDEO_MAX_PLANES]{};
     v4l2_buffer buf{};
-    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.type = buf_type_;
     buf.memory = V4L2_MEMORY_MMAP;
     buf.index = i;
+    if (buf_type_ == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE) {
+      buf.m.planes = planes;
+      buf.length = num_planes_;
+    }
     xioctl(VIDIOC_QUERYBUF, &buf);
-    buffers_[i].length = buf.length;
-    buffers_[i].start = mmap(nullptr, buf.length, PROT_READ | PROT_WRITE,
-                             MAP_SHARED, fd_, buf.m.offset);
-    if (buffers_[i].start == MAP_FAILED)
-      throw std::runtime_error("mmap failed");
+    for (uint32_t p = 0; p < num_planes_; ++p) {
+      const bool multiplanar = buf_type_ == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+      size_t length = multiplanar ? planes[p].length : buf.length;
+      off_t offset = multiplanar ? planes[p].m.mem_offset : buf.m.offset;
+      void *start = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED,
+                         fd_, offset);
+      if (start == MAP_FAILED)
+        throw std::runtime_error("mmap failed");
+      buffers_[i].start[p] = start;
+      buffers_[i].length[p] = length;
+    }
   }
 }
 
+void V4l2Capture::init_userptr() {
+  v4l2_requestbuffers req{};
+  req.count = config_.buffer_count;
+  req.type = buf_type_;
+  req.memory = V4L2_MEMORY_USERPTR;
+  if (ioctl(fd_, VIDIOC_REQBUFS, &req) == -1)
+    throw std::runtime_error("Device does not support USERPTR streaming: " +
+                             std::string(strerror(errno)));
+
+  if (req.count < 2)
+    throw std::runtime_error("Insufficient buffer memory.");
+  buffer_count_ = req.count;
+  // 槽位在 start() 时由共享内存分配，这里只建立索引表
+  buffers_ = new Buffer[buffer_count_]();
+}
+
 void V4l2Capture::xioctl(unsigned long request, void *arg) {
   if (ioctl(fd_, request, arg) == -1) {
     throw std::runtime_error("ioctl failed: " + std::string(strerror(errno)));
   }
-}
\ No newline at end of file
+}
@@ -22,10 +22,13 @@
  * @brief V4L2视频捕获器类
  *
  * 实现 ICapture 接口的 V4L2 捕获器，专门用于Linux系统下的视频设备访问。
- * 使用内存映射（mmap）方式进行高效的数据传输，支持多种像素格式。
+ * 支持内存映射（mmap）与用户指针（userptr）两种IO方式，后者让驱动
+ * 直接写入共享内存槽位，实现零拷贝发布。
  *
  * 主要特性：
- * - 支持YUYV、MJPEG等常见格式
+ * - 支持YUYV、MJPEG以及摄像头直出的H264（帧类型标志写入 cv_type）
+ * - 支持单平面与多平面（_MPLANE）接口，ISP 输出的 NV12/NV16 原样发布，
+ *   行跨度与平面偏移写入 CapturedFrame::planes
  * - 使用内存映射避免数据拷贝
  * - 多缓冲区机制确保流畅采集
  * - 线程安全的启动/停止控制
@@ -84,11 +87,64 @@ public:
    * 从V4L2设备队列中取出一帧数据。该方法会阻塞等待新帧到达，
    * 但会定期检查running标志以支持优雅退出。
    *
-   * @note 返回的帧数据指针指向内部缓冲区，在下次调用前有效
+   * @note 返回的帧数据指针指向内部缓冲区，在下次调用前有效；
+   *       mmap 模式下缓冲区在下次调用时才归还给驱动
+   * @note userptr 模式下帧在出队时已提交到共享内存（published为true），
+   *       若没有空闲槽位则丢弃该帧（data为nullptr）
    * @warning 必须在调用start()之后使用
    */
   bool capture(CapturedFrame &out_frame, std::atomic<bool> &running) override;
 
+  /**
+   * @brief 取出一帧，缓冲区在 release() 之前不归还驱动
+   * @param out_frame 输出参数，接收捕获的帧数据；超时时 data 为 nullptr
+   * @param running 原子布尔标志，用于外部控制捕获循环
+   * @return bool true表示成功（含超时），false表示应停止捕获
+   *
+   * mmap 模式下 buffer_index 为驱动缓冲区索引，调用者发布完成后须调用
+   * release() 执行 VIDIOC_QBUF；userptr 模式下帧在出队时已提交，缓冲区
+   * 立即换入新槽位并重新入队，buffer_index 为 -1。
+   */
+  bool dequeue(CapturedFrame &out_frame, std::atomic<bool> &running) override;
+
+  /**
+   * @brief 获取设备文件描述符，供多设备 epoll 循环使用
+   */
+  int get_poll_fd() const override;
+
+  /**
+   * @brief 设备文件描述符可读后出队一帧（VIDIOC_DQBUF），语义同 dequeue()
+   * @param out_frame 输出参数；驱动暂无就绪缓冲区时 data 为 nullptr
+   * @return bool false表示出队失败
+   */
+  bool dequeue_ready(CapturedFrame &out_frame) override;
+
+  /**
+   * @brief 将 dequeue() 交出的缓冲区放回驱动队列（VIDIOC_QBUF）
+   * @param frame dequeue() 返回的帧
+   * @throws std::runtime_error 当 VIDIOC_QBUF 失败时抛出异常
+   */
+  void release(const CapturedFrame &frame) override;
+
+  /**
+   * @brief 调用者最多可同时持有的缓冲区数量
+   * @return uint32_t mmap 模式为缓冲区数量减一（至少留一个给驱动），
+   *         userptr 模式为 0
+   */
+  uint32_t get_max_outstanding() const override;
+
+  /**
+   * @brief 绑定输出共享内存，启用零拷贝捕获
+   * @param shm 已映射的图像共享内存管理器
+   * @return bool 配置为 userptr 模式时返回true，mmap 模式返回false
+   * @throws std::runtime_error 当共享内存槽位数量不足或槽位过小时抛出异常
+   *
+   * userptr 模式下，共享内存槽位本身被交给驱动（V4L2_MEMORY_USERPTR），
+   * 驱动直接把帧写入槽位，出队时即提交，捕获到消费者全程零拷贝。
+   * 共享内存缓冲区数量必须大于V4L2缓冲区数量，多出的槽位供读者使用。
+   */
+  bool bind_output(ImageShmManager *shm) override;
+
   // 禁用拷贝构造和赋值，确保资源管理安全
   V4l2Capture(const V4l2Capture &) = delete;
   V4l2Capture &operator=(const V4l2Capture &) = delete;
@@ -97,7 +153,7 @@ private:
   /**
    * @brief 内部缓冲区结构体声明
    *
-   * 存储V4L2内存映射缓冲区的信息，包括地址和大小。
+   * 存储V4L2内存映射缓冲区的信息，包括各平面的地址和大小。
    */
   struct Buffer;
 
@@ -112,8 +168,8 @@ private:
   void xioctl(unsigned long request, void *arg);
 
   /**
-   * @brief 打开V4L2设备文件
-   * @throws std::runtime_error 当设备无法打开时抛出异常
+   * @brief 打开V4L2设备文件并确定使用单平面还是多平面接口
+   * @throws std::runtime_error 当设备无法打开或不是视频捕获设备时抛出异常
    */
   void open_device();
 
@@ -121,7 +177,8 @@ private:
    * @brief 初始化视频格式设置
    * @throws std::runtime_error 当格式设置失败时抛出异常
    *
-   * 根据配置设置设备的像素格式、分辨率等参数。
+   * 根据配置设置设备的像素格式、分辨率等参数。多平面设备上 NV12 与
+   * NV12M（NV16 与 NV16M）可互相替代，按驱动接受的一种建立平面布局。
    */
   void init_format();
 
@@ -133,12 +190,48 @@ private:
    */
   void init_mmap();
 
+  /**
+   * @brief 初始化用户指针（USERPTR）缓冲区
+   * @throws std::runtime_error 当设备不支持USERPTR时抛出异常
+   *
+   * 仅向驱动申请缓冲区索引，实际内存在 start() 时从共享内存槽位获取。
+   */
+  void init_userptr();
+
+  /**
+   * @brief 将指定缓冲区放回驱动队列
+   * @param index 缓冲区索引
+   */
+  void queue_buffer(uint32_t index);
+
+  /**
+   * @brief 为指定驱动缓冲区获取一个新的共享内存槽位
+   * @param index 缓冲区索引
+   * @return bool 成功返回true，没有空闲槽位时返回false
+   */
+  bool attach_slot(uint32_t index);
+
+  /**
+   * @brief 提交驱动已填充的槽位，并为该缓冲区换入新槽位
+   * @param index 出队的缓冲区索引
+   */
+  void publish_userptr_frame(uint32_t index);
+
 private:
   V4l2Config config_;     ///< V4L2配置参数
   int fd_;                ///< 设备文件描述符
   Buffer *buffers_;       ///< 内存映射缓冲区数组
   uint32_t buffer_count_; ///< 缓冲区数量
   bool is_streaming_;     ///< 是否正在流式传输标志
+  uint32_t buf_type_;     ///< V4L2_BUF_TYPE_VIDEO_CAPTURE 或 V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE
+  uint32_t pixel_format_; ///< 与驱动协商后的像素格式
+  uint32_t num_planes_;   ///< 每个缓冲区的内存平面数（NV12M/NV16M 为2，其余为1）
+  uint32_t plane_sizes_[IMAGE_MAX_PLANES]; ///< 各内存平面的 sizeimage
+  ImagePlaneLayout layout_; ///< 发布负载中的平面布局
+  uint32_t frame_size_;   ///< 发布负载的最大字节数（各平面按 layout_ 排列后的总长）
+  int held_index_;        ///< mmap模式下调用者正在使用、尚未归还的缓冲区
+  ImageShmManager *output_shm_; ///< 零拷贝模式下的输出共享内存
+  uint64_t next_frame_version_; ///< 零拷贝模式下提交使用的帧版本号
 
   CapturedFrame current_frame_; ///< 当前帧数据缓存，用于实现capture()方法
 };
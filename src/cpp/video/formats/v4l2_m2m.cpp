@@ -0,0 +1,361 @@
+/**
+ * @file v4l2_m2m.cpp
+ * @brief V4L2 内存到内存（M2M）编解码设备封装实现
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ */
+
+#include "v4l2_m2m.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/videodev2.h>
+#include <stdexcept>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint32_t MAX_PLANES = 2; ///< 支持的最大平面数（NV12M 为 2）
+constexpr int MAX_VIDEO_NODES = 64; ///< find_device() 扫描的 /dev/videoN 数量
+
+/**
+ * @brief 读取设备能力，优先使用 device_caps
+ */
+uint32_t query_caps(int fd) {
+  v4l2_capability cap{};
+  if (ioctl(fd, VIDIOC_QUERYCAP, &cap) == -1)
+    return 0;
+  return (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps
+                                                   : cap.capabilities;
+}
+
+/**
+ * @brief 把 v4l2_format 转换为 M2mFormat
+ */
+M2mFormat to_m2m_format(const v4l2_format &fmt, bool mplane) {
+  M2mFormat out;
+  if (mplane) {
+    out.pixel_format = fmt.fmt.pix_mp.pixelformat;
+    out.width = fmt.fmt.pix_mp.width;
+    out.height = fmt.fmt.pix_mp.height;
+    out.num_planes = fmt.fmt.pix_mp.num_planes;
+    for (uint32_t p = 0; p < out.num_planes && p < MAX_PLANES; ++p) {
+      out.bytesperline[p] = fmt.fmt.pix_mp.plane_fmt[p].bytesperline;
+      out.sizeimage[p] = fmt.fmt.pix_mp.plane_fmt[p].sizeimage;
+    }
+  } else {
+    out.pixel_format = fmt.fmt.pix.pixelformat;
+    out.width = fmt.fmt.pix.width;
+    out.height = fmt.fmt.pix.height;
+    out.num_planes = 1;
+    out.bytesperline[0] = fmt.fmt.pix.bytesperline;
+    out.sizeimage[0] = fmt.fmt.pix.sizeimage;
+  }
+  return out;
+}
+
+} // namespace
+
+std::string V4l2M2mDevice::find_device(uint32_t coded_format, bool encoder) {
+  for (int n = 0; n < MAX_VIDEO_NODES; ++n) {
+    const std::string path = "/dev/video" + std::to_string(n);
+    int fd = open(path.c_str(), O_RDWR | O_NONBLOCK);
+    if (fd == -1)
+      continue;
+
+    const uint32_t caps = query_caps(fd);
+    bool found = false;
+    if (caps & (V4L2_CAP_VIDEO_M2M | V4L2_CAP_VIDEO_M2M_MPLANE)) {
+      const bool mplane = caps & V4L2_CAP_VIDEO_M2M_MPLANE;
+      // 编码器在 CAPTURE 队列输出码流，解码器在 OUTPUT 队列接受码流
+      v4l2_fmtdesc desc{};
+      if (encoder)
+        desc.type = mplane ? V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE
+                           : V4L2_BUF_TYPE_VIDEO_CAPTURE;
+      else
+        desc.type = mplane ? V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE
+                           : V4L2_BUF_TYPE_VIDEO_OUTPUT;
+      for (desc.index = 0; ioctl(fd, VIDIOC_ENUM_FMT, &desc) == 0;
+           ++desc.index) {
+        if (desc.pixelformat == coded_format) {
+          found = true;
+          break;
+        }
+      }
+    }
+    close(fd);
+    if (found)
+      return path;
+  }
+  return std::string();
+}
+
+V4l2M2mDevice::V4l2M2mDevice(const std::string &device_path)
+    : path_(device_path), fd_(-1), mplane_(false) {
+  fd_ = open(path_.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  if (fd_ == -1)
+    throw std::runtime_error("Failed to open M2M device " + path_ + ": " +
+                             strerror(errno));
+  const uint32_t caps = query_caps(fd_);
+  if (!(caps & (V4L2_CAP_VIDEO_M2M | V4L2_CAP_VIDEO_M2M_MPLANE)) ||
+      !(caps & V4L2_CAP_STREAMING)) {
+    close(fd_);
+    throw std::runtime_error(path_ + " is not a streaming V4L2 M2M device");
+  }
+  mplane_ = caps & V4L2_CAP_VIDEO_M2M_MPLANE;
+}
+
+V4l2M2mDevice::~V4l2M2mDevice() {
+  for (M2mQueue queue : {M2mQueue::Output, M2mQueue::Capture}) {
+    Queue &state = get_queue(queue);
+    if (state.streaming) {
+      int type = buffer_type(queue);
+      ioctl(fd_, VIDIOC_STREAMOFF, &type);
+    }
+    unmap_buffers(state);
+  }
+  close(fd_);
+}
+
+uint32_t V4l2M2mDevice::buffer_type(M2mQueue queue) const {
+  if (queue == M2mQueue::Output)
+    return mplane_ ? V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE
+                   : V4L2_BUF_TYPE_VIDEO_OUTPUT;
+  return mplane_ ? V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE
+                 : V4L2_BUF_TYPE_VIDEO_CAPTURE;
+}
+
+M2mFormat V4l2M2mDevice::set_format(M2mQueue queue, uint32_t pixel_format,
+                                    uint32_t width, uint32_t height,
+                                    uint32_t sizeimage) {
+  v4l2_format fmt{};
+  fmt.type = buffer_type(queue);
+  if (mplane_) {
+    fmt.fmt.pix_mp.width = width;
+    fmt.fmt.pix_mp.height = height;
+    fmt.fmt.pix_mp.pixelformat = pixel_format;
+    fmt.fmt.pix_mp.field = V4L2_FIELD_NONE;
+    fmt.fmt.pix_mp.num_planes = 1;
+    fmt.fmt.pix_mp.plane_fmt[0].sizeimage = sizeimage;
+  } else {
+    fmt.fmt.pix.width = width;
+    fmt.fmt.pix.height = height;
+    fmt.fmt.pix.pixelformat = pixel_format;
+    fmt.fmt.pix.field = V4L2_FIELD_NONE;
+    fmt.fmt.pix.sizeimage = sizeimage;
+  }
+  xioctl(VIDIOC_S_FMT, &fmt, "VIDIOC_S_FMT");
+  M2mFormat out = to_m2m_format(fmt, mplane_);
+  get_queue(queue).num_planes = out.num_planes;
+  return out;
+}
+
+M2mFormat V4l2M2mDevice::get_format(M2mQueue queue) {
+  v4l2_format fmt{};
+  fmt.type = buffer_type(queue);
+  xioctl(VIDIOC_G_FMT, &fmt, "VIDIOC_G_FMT");
+  M2mFormat out = to_m2m_format(fmt, mplane_);
+  get_queue(queue).num_planes = out.num_planes;
+  return out;
+}
+
+bool V4l2M2mDevice::set_frame_rate(uint32_t fps) {
+  v4l2_streamparm parm{};
+  parm.type = buffer_type(M2mQueue::Output);
+  parm.parm.output.timeperframe.numerator = 1;
+  parm.parm.output.timeperframe.denominator = fps;
+  return ioctl(fd_, VIDIOC_S_PARM, &parm) == 0;
+}
+
+bool V4l2M2mDevice::set_control(uint32_t id, int32_t value) {
+  v4l2_control ctrl{};
+  ctrl.id = id;
+  ctrl.value = value;
+  return ioctl(fd_, VIDIOC_S_CTRL, &ctrl) == 0;
+}
+
+int32_t V4l2M2mDevice::get_control(uint32_t id, int32_t fallback) {
+  v4l2_control ctrl{};
+  ctrl.id = id;
+  if (ioctl(fd_, VIDIOC_G_CTRL, &ctrl) == -1)
+    return fallback;
+  return ctrl.value;
+}
+
+uint32_t V4l2M2mDevice::request_buffers(M2mQueue queue, uint32_t count) {
+  Queue &state = get_queue(queue);
+  unmap_buffers(state);
+
+  v4l2_requestbuffers req{};
+  req.count = count;
+  req.type = buffer_type(queue);
+  req.memory = V4L2_MEMORY_MMAP;
+  xioctl(VIDIOC_REQBUFS, &req, "VIDIOC_REQBUFS");
+  if (count == 0)
+    return 0;
+  if (req.count == 0)
+    throw std::runtime_error(path_ + ": no buffers allocated");
+
+  state.buffers.resize(req.count);
+  for (uint32_t i = 0; i < req.count; ++i) {
+    v4l2_buffer buf{};
+    v4l2_plane planes[VIDEO_MAX_PLANES]{};
+    buf.type = req.type;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index = i;
+    if (mplane_) {
+      buf.m.planes = planes;
+      buf.length = VIDEO_MAX_PLANES;
+    }
+    xioctl(VIDIOC_QUERYBUF, &buf, "VIDIOC_QUERYBUF");
+
+    const uint32_t num_planes = mplane_ ? buf.length : 1;
+    if (num_planes > MAX_PLANES)
+      throw std::runtime_error(path_ + ": unsupported plane count " +
+                               std::to_string(num_planes));
+    state.num_planes = num_planes;
+    for (uint32_t p = 0; p < num_planes; ++p) {
+      const size_t length = mplane_ ? planes[p].length : buf.length;
+      const off_t offset = mplane_ ? planes[p].m.mem_offset : buf.m.offset;
+      void *start = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED,
+                         fd_, offset);
+      if (start == MAP_FAILED)
+        throw std::runtime_error(path_ + ": mmap failed: " + strerror(errno));
+      state.buffers[i].start[p] = static_cast<uint8_t *>(start);
+      state.buffers[i].length[p] = length;
+    }
+  }
+  return req.count;
+}
+
+uint32_t V4l2M2mDevice::get_buffer_count(M2mQueue queue) const {
+  return static_cast<uint32_t>(get_queue(queue).buffers.size());
+}
+
+uint8_t *V4l2M2mDevice::get_plane(M2mQueue queue, uint32_t index,
+                                  uint32_t plane) const {
+  return get_queue(queue).buffers[index].start[plane];
+}
+
+size_t V4l2M2mDevice::get_plane_length(M2mQueue queue, uint32_t index,
+                                       uint32_t plane) const {
+  return get_queue(queue).buffers[index].length[plane];
+}
+
+void V4l2M2mDevice::queue_buffer(M2mQueue queue, uint32_t index,
+                                 const uint32_t *bytesused,
+                                 uint64_t timestamp_us) {
+  const Queue &state = get_queue(queue);
+  v4l2_buffer buf{};
+  v4l2_plane planes[VIDEO_MAX_PLANES]{};
+  buf.type = buffer_type(queue);
+  buf.memory = V4L2_MEMORY_MMAP;
+  buf.index = index;
+  buf.timestamp.tv_sec = timestamp_us / 1000000ULL;
+  buf.timestamp.tv_usec = timestamp_us % 1000000ULL;
+  if (mplane_) {
+    buf.m.planes = planes;
+    buf.length = state.num_planes;
+    for (uint32_t p = 0; p < state.num_planes; ++p) {
+      planes[p].length = state.buffers[index].length[p];
+      planes[p].bytesused = bytesused ? bytesused[p] : 0;
+    }
+  } else {
+    buf.length = state.buffers[index].length[0];
+    buf.bytesused = bytesused ? bytesused[0] : 0;
+  }
+  xioctl(VIDIOC_QBUF, &buf, "VIDIOC_QBUF");
+}
+
+bool V4l2M2mDevice::dequeue_buffer(M2mQueue queue, M2mBuffer *out) {
+  v4l2_buffer buf{};
+  v4l2_plane planes[VIDEO_MAX_PLANES]{};
+  buf.type = buffer_type(queue);
+  buf.memory = V4L2_MEMORY_MMAP;
+  if (mplane_) {
+    buf.m.planes = planes;
+    buf.length = VIDEO_MAX_PLANES;
+  }
+  if (ioctl(fd_, VIDIOC_DQBUF, &buf) == -1) {
+    if (errno == EAGAIN)
+      return false;
+    throw std::runtime_error(path_ + ": VIDIOC_DQBUF failed: " +
+                             strerror(errno));
+  }
+
+  out->index = buf.index;
+  out->flags = buf.flags;
+  out->timestamp_us = (uint64_t)buf.timestamp.tv_sec * 1000000ULL +
+                      (uint64_t)buf.timestamp.tv_usec;
+  if (mplane_) {
+    for (uint32_t p = 0; p < buf.length && p < MAX_PLANES; ++p)
+      out->bytesused[p] = planes[p].bytesused;
+  } else {
+    out->bytesused[0] = buf.bytesused;
+  }
+  return true;
+}
+
+void V4l2M2mDevice::set_streaming(M2mQueue queue, bool on) {
+  Queue &state = get_queue(queue);
+  if (state.streaming == on)
+    return;
+  int type = buffer_type(queue);
+  if (on)
+    xioctl(VIDIOC_STREAMON, &type, "VIDIOC_STREAMON");
+  else
+    xioctl(VIDIOC_STREAMOFF, &type, "VIDIOC_STREAMOFF");
+  state.streaming = on;
+}
+
+bool V4l2M2mDevice::is_streaming(M2mQueue queue) const {
+  return get_queue(queue).streaming;
+}
+
+void V4l2M2mDevice::subscribe_event(uint32_t type) {
+  v4l2_event_subscription sub{};
+  sub.type = type;
+  xioctl(VIDIOC_SUBSCRIBE_EVENT, &sub, "VIDIOC_SUBSCRIBE_EVENT");
+}
+
+uint32_t V4l2M2mDevice::dequeue_event() {
+  v4l2_event event{};
+  if (ioctl(fd_, VIDIOC_DQEVENT, &event) == -1)
+    return 0;
+  return event.type;
+}
+
+void V4l2M2mDevice::get_visible_size(uint32_t *width, uint32_t *height) {
+  // 选择 API 约定使用单平面类型，内核会转换为多平面队列
+  v4l2_selection sel{};
+  sel.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  sel.target = V4L2_SEL_TGT_COMPOSE;
+  if (ioctl(fd_, VIDIOC_G_SELECTION, &sel) == 0 && sel.r.width > 0 &&
+      sel.r.height > 0) {
+    *width = sel.r.width;
+    *height = sel.r.height;
+  }
+}
+
+void V4l2M2mDevice::unmap_buffers(Queue &queue) {
+  for (Buffer &buffer : queue.buffers)
+    for (uint32_t p = 0; p < MAX_PLANES; ++p)
+      if (buffer.start[p])
+        munmap(buffer.start[p], buffer.length[p]);
+  queue.buffers.clear();
+}
+
+void V4l2M2mDevice::xioctl(unsigned long request, void *arg,
+                           const char *name) {
+  int ret;
+  do {
+    ret = ioctl(fd_, request, arg);
+  } while (ret == -1 && errno == EINTR);
+  if (ret == -1)
+    throw std::runtime_error(path_ + ": " + name + " failed: " +
+                             strerror(errno));
+}
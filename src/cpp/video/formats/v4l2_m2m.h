@@ -0,0 +1,255 @@
+/**
+ * @file v4l2_m2m.h
+ * @brief V4L2 内存到内存（M2M）编解码设备封装
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 硬件编解码器（Raspberry Pi bcm2835-codec、Rockchip/NXP Hantro、Qualcomm
+ * Venus、Amlogic 等）在 Linux 下以 V4L2 M2M 设备出现：OUTPUT 队列送入
+ * 待处理数据，CAPTURE 队列取回结果。该文件封装两个队列的格式协商、mmap
+ * 缓冲区与出入队操作，同时支持单平面与多平面（_MPLANE）API，供
+ * H264EncodeCapture 与 H264Decoder 共用。
+ */
+
+#ifndef V4L2_M2M_H
+#define V4L2_M2M_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief M2M 设备的两个队列
+ */
+enum class M2mQueue {
+  Output, ///< 应用写入、设备读取（编码器的原始帧，解码器的码流）
+  Capture ///< 设备写入、应用读取（编码器的码流，解码器的原始帧）
+};
+
+/**
+ * @brief 队列格式
+ */
+struct M2mFormat {
+  uint32_t pixel_format = 0;     ///< V4L2_PIX_FMT_* 常量
+  uint32_t width = 0;            ///< 图像宽度（像素）
+  uint32_t height = 0;           ///< 图像高度（像素，解码器可能按宏块对齐）
+  uint32_t num_planes = 1;       ///< 内存平面数量（单平面 API 恒为 1）
+  uint32_t bytesperline[2] = {}; ///< 各平面行跨度（字节）
+  uint32_t sizeimage[2] = {};    ///< 各平面缓冲区大小（字节）
+};
+
+/**
+ * @brief 已出队的缓冲区
+ */
+struct M2mBuffer {
+  uint32_t index = 0;          ///< 缓冲区索引
+  uint32_t bytesused[2] = {};  ///< 各平面有效字节数
+  uint32_t flags = 0;          ///< V4L2_BUF_FLAG_* 标志
+  uint64_t timestamp_us = 0;   ///< 缓冲区时间戳（M2M 设备从 OUTPUT 复制到 CAPTURE）
+};
+
+/**
+ * @brief V4L2 M2M 编解码设备
+ *
+ * 两个队列都使用 V4L2_MEMORY_MMAP。设备以非阻塞方式打开，dequeue() 在没有
+ * 就绪缓冲区时立即返回false，调用者通过 get_fd() 上的 poll 等待：POLLIN 表示
+ * CAPTURE 有结果，POLLOUT 表示 OUTPUT 有已处理完的缓冲区，POLLPRI 表示有事件。
+ *
+ * @note 错误以 std::runtime_error 抛出；析构时停止两个队列并释放全部映射
+ */
+class V4l2M2mDevice {
+public:
+  /**
+   * @brief 查找支持指定编码格式的 M2M 设备
+   * @param coded_format 编码格式（如 V4L2_PIX_FMT_H264）
+   * @param encoder true 查找编码器（CAPTURE 队列输出该格式），
+   *        false 查找解码器（OUTPUT 队列接受该格式）
+   * @return std::string 第一个匹配的 /dev/videoN，找不到时为空
+   */
+  static std::string find_device(uint32_t coded_format, bool encoder);
+
+  /**
+   * @brief 打开 M2M 设备
+   * @param device_path 设备路径，如 "/dev/video11"
+   * @throws std::runtime_error 当设备无法打开或不是 M2M 设备时抛出异常
+   */
+  explicit V4l2M2mDevice(const std::string &device_path);
+
+  /**
+   * @brief 停止两个队列，解除映射并关闭设备
+   */
+  ~V4l2M2mDevice();
+
+  V4l2M2mDevice(const V4l2M2mDevice &) = delete;
+  V4l2M2mDevice &operator=(const V4l2M2mDevice &) = delete;
+
+  /**
+   * @brief 设备文件描述符，用于 poll/epoll
+   */
+  int get_fd() const { return fd_; }
+
+  /**
+   * @brief 设备路径
+   */
+  const std::string &get_path() const { return path_; }
+
+  /**
+   * @brief 设置队列格式（VIDIOC_S_FMT）
+   * @param queue 目标队列
+   * @param pixel_format V4L2_PIX_FMT_* 常量
+   * @param width 图像宽度
+   * @param height 图像高度
+   * @param sizeimage 编码格式的缓冲区大小提示，原始格式传 0 由驱动计算
+   * @return M2mFormat 驱动实际采用的格式
+   * @throws std::runtime_error 当 ioctl 失败时抛出异常
+   */
+  M2mFormat set_format(M2mQueue queue, uint32_t pixel_format, uint32_t width,
+                       uint32_t height, uint32_t sizeimage = 0);
+
+  /**
+   * @brief 读取队列当前格式（VIDIOC_G_FMT）
+   * @throws std::runtime_error 当 ioctl 失败时抛出异常
+   */
+  M2mFormat get_format(M2mQueue queue);
+
+  /**
+   * @brief 设置帧率（OUTPUT 队列 VIDIOC_S_PARM），设备不支持时返回false
+   */
+  bool set_frame_rate(uint32_t fps);
+
+  /**
+   * @brief 设置控制项（VIDIOC_S_CTRL），设备不支持时返回false
+   */
+  bool set_control(uint32_t id, int32_t value);
+
+  /**
+   * @brief 读取控制项（VIDIOC_G_CTRL），设备不支持时返回 fallback
+   */
+  int32_t get_control(uint32_t id, int32_t fallback);
+
+  /**
+   * @brief 申请并映射队列缓冲区（VIDIOC_REQBUFS + VIDIOC_QUERYBUF + mmap）
+   * @param queue 目标队列
+   * @param count 期望的缓冲区数量，驱动可能调整
+   * @return uint32_t 实际分配的数量；count 为 0 时释放该队列全部缓冲区
+   * @throws std::runtime_error 当分配或映射失败时抛出异常
+   */
+  uint32_t request_buffers(M2mQueue queue, uint32_t count);
+
+  /**
+   * @brief 队列缓冲区数量
+   */
+  uint32_t get_buffer_count(M2mQueue queue) const;
+
+  /**
+   * @brief 缓冲区某个平面的映射地址
+   */
+  uint8_t *get_plane(M2mQueue queue, uint32_t index, uint32_t plane) const;
+
+  /**
+   * @brief 缓冲区某个平面的映射长度
+   */
+  size_t get_plane_length(M2mQueue queue, uint32_t index,
+                          uint32_t plane) const;
+
+  /**
+   * @brief 将缓冲区放入队列（VIDIOC_QBUF）
+   * @param queue 目标队列
+   * @param index 缓冲区索引
+   * @param bytesused 各平面有效字节数（CAPTURE 队列传 nullptr）
+   * @param timestamp_us 缓冲区时间戳（CLOCK_MONOTONIC 微秒）
+   * @throws std::runtime_error 当 ioctl 失败时抛出异常
+   */
+  void queue_buffer(M2mQueue queue, uint32_t index,
+                    const uint32_t *bytesused = nullptr,
+                    uint64_t timestamp_us = 0);
+
+  /**
+   * @brief 非阻塞地取出一个已处理的缓冲区（VIDIOC_DQBUF）
+   * @param queue 目标队列
+   * @param out 输出参数，接收缓冲区信息
+   * @return bool true表示取到缓冲区，false表示暂无就绪缓冲区
+   * @throws std::runtime_error 当 ioctl 因 EAGAIN 以外的原因失败时抛出异常
+   */
+  bool dequeue_buffer(M2mQueue queue, M2mBuffer *out);
+
+  /**
+   * @brief 启动或停止队列（VIDIOC_STREAMON / VIDIOC_STREAMOFF）
+   * @throws std::runtime_error 当 ioctl 失败时抛出异常
+   */
+  void set_streaming(M2mQueue queue, bool on);
+
+  /**
+   * @brief 队列是否已启动
+   */
+  bool is_streaming(M2mQueue queue) const;
+
+  /**
+   * @brief 订阅事件（VIDIOC_SUBSCRIBE_EVENT），如 V4L2_EVENT_SOURCE_CHANGE
+   * @throws std::runtime_error 当 ioctl 失败时抛出异常
+   */
+  void subscribe_event(uint32_t type);
+
+  /**
+   * @brief 取出一个待处理事件（VIDIOC_DQEVENT）
+   * @return uint32_t 事件类型，没有事件时返回 0
+   */
+  uint32_t dequeue_event();
+
+  /**
+   * @brief 读取 CAPTURE 队列的可见区域（VIDIOC_G_SELECTION compose）
+   * @param width 输出参数，可见宽度；设备不支持时保持不变
+   * @param height 输出参数，可见高度；设备不支持时保持不变
+   */
+  void get_visible_size(uint32_t *width, uint32_t *height);
+
+private:
+  /**
+   * @brief 一个已映射的缓冲区
+   */
+  struct Buffer {
+    uint8_t *start[2] = {};  ///< 各平面映射地址
+    size_t length[2] = {};   ///< 各平面映射长度
+  };
+
+  /**
+   * @brief 队列状态
+   */
+  struct Queue {
+    std::vector<Buffer> buffers; ///< 已映射的缓冲区
+    uint32_t num_planes = 1;     ///< 当前格式的平面数量
+    bool streaming = false;      ///< 是否已 STREAMON
+  };
+
+  /**
+   * @brief 队列对应的 v4l2_buf_type
+   */
+  uint32_t buffer_type(M2mQueue queue) const;
+
+  /**
+   * @brief 解除队列全部映射
+   */
+  void unmap_buffers(Queue &queue);
+
+  /**
+   * @brief ioctl 包装器，处理 EINTR，失败时抛出带请求名称的异常
+   */
+  void xioctl(unsigned long request, void *arg, const char *name);
+
+  Queue &get_queue(M2mQueue queue) {
+    return queue == M2mQueue::Output ? output_ : capture_;
+  }
+  const Queue &get_queue(M2mQueue queue) const {
+    return queue == M2mQueue::Output ? output_ : capture_;
+  }
+
+  std::string path_; ///< 设备路径
+  int fd_;           ///< 设备文件描述符
+  bool mplane_;      ///< 是否使用多平面 API
+  Queue output_;     ///< OUTPUT 队列
+  Queue capture_;    ///< CAPTURE 队列
+};
+
+#endif // V4L2_M2M_H
@@ -11,10 +11,10 @@
 
 #include "yuyv_decoder.h"
 
-cv::Mat YuyvDecoder::decode(const uint8_t *data, const ImageHeader &header) {
+void YuyvDecoder::decode_into(const uint8_t *data, const ImageHeader &header,
+                              cv::Mat &out) {
   cv::Mat yuyv_mat(header.height, header.width, header.frame_type,
                    (void *)data);
-  cv::Mat bgr_mat;
-  cv::cvtColor(yuyv_mat, bgr_mat, cv::COLOR_YUV2BGR_YUY2);
-  return bgr_mat;
+  // cvtColor 内部调用 out.create，尺寸与类型不变时直接复用 out 的缓冲区
+  cv::cvtColor(yuyv_mat, out, cv::COLOR_YUV2BGR_YUY2);
 }
\ No newline at end of file
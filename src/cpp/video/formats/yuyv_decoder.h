@@ -34,7 +34,7 @@ public:
    * @brief 解码YUYV格式图像数据
    * @param data YUYV格式的原始图像数据指针
    * @param header 图像头部信息，包含宽度、高度等元数据
-   * @return cv::Mat 解码后的BGR格式OpenCV矩阵
+   * @param out 输出的BGR矩阵，尺寸与类型匹配时直接复用其缓冲区
    * @throws std::runtime_error 当数据无效或解码失败时抛出异常
    *
    * 将YUYV格式的原始数据转换为BGR格式：
@@ -42,12 +42,13 @@ public:
    * 2. 逐像素提取Y、U、V分量
    * 3. 应用YUV到RGB的转换公式
    * 4. 转换颜色通道顺序（RGB到BGR）
-   * 5. 返回OpenCV Mat对象
+   * 5. 写入 out（尺寸不变时不重新分配）
    *
    * @note 输入数据大小必须等于 width * height * 2 字节
    * @warning data指针必须指向有效的YUYV数据
    */
-  cv::Mat decode(const uint8_t *data, const ImageHeader &header) override;
+  void decode_into(const uint8_t *data, const ImageHeader &header,
+                   cv::Mat &out) override;
 };
 
 #endif // YUYV_DECODER_H
\ No newline at end of file
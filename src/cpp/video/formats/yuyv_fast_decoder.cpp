@@ -0,0 +1,337 @@
+/**
+ * @file yuyv_fast_decoder.cpp
+ * @brief YUYV 单遍裁剪/缩放/颜色转换解码器实现
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 定点系数（放大 64 倍）：
+ *   C = 74 * (Y - 16) + 32
+ *   B = (C + 129 * U') >> 6
+ *   G = (C -  25 * U' - 52 * V') >> 6
+ *   R = (C + 102 * V') >> 6        其中 U' = U - 128, V' = V - 128
+ * 中间值除 B/R 最后一次加法外都在 int16 范围内，SIMD 路径使用饱和加法，
+ * 溢出时结果本就应截断为 255，因此与标量路径逐位一致。
+ */
+
+#include "yuyv_fast_decoder.h"
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define YUYV_HAVE_X86 1
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define YUYV_HAVE_NEON 1
+#endif
+
+static inline uint8_t clamp_u8(int value) {
+  return (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+/**
+ * @brief 标量颜色转换：平面 Y/U/V -> 交错 BGR
+ */
+static void convert_row_bgr_scalar(const uint8_t *y_row, const uint8_t *u_row,
+                                   const uint8_t *v_row, uint8_t *bgr, int n) {
+  for (int i = 0; i < n; ++i) {
+    int c = 74 * (y_row[i] - 16) + 32;
+    int u = u_row[i] - 128;
+    int v = v_row[i] - 128;
+    bgr[3 * i + 0] = clamp_u8((c + 129 * u) >> 6);
+    bgr[3 * i + 1] = clamp_u8((c - 25 * u - 52 * v) >> 6);
+    bgr[3 * i + 2] = clamp_u8((c + 102 * v) >> 6);
+  }
+}
+
+#ifdef YUYV_HAVE_X86
+/**
+ * @brief 生成把 B/G/R 三个 16 字节平面交错为 48 字节 BGR 的 pshufb 掩码
+ *
+ * masks[k][c] 用于从通道 c 的平面中取出第 k 个 16 字节输出块所需的字节，
+ * 不属于该通道的位置填 0x80（pshufb 输出 0）。
+ */
+struct BgrShuffleMasks {
+  alignas(16) uint8_t masks[3][3][16];
+  BgrShuffleMasks() {
+    for (int k = 0; k < 3; ++k)
+      for (int c = 0; c < 3; ++c)
+        for (int j = 0; j < 16; ++j) {
+          int pos = 16 * k + j;
+          masks[k][c][j] = (pos % 3 == c) ? (uint8_t)(pos / 3) : 0x80;
+        }
+  }
+};
+
+/**
+ * @brief AVX2 颜色转换：每次处理 16 个像素
+ */
+__attribute__((target("avx2"))) static void
+convert_row_bgr_avx2(const uint8_t *y_row, const uint8_t *u_row,
+                     const uint8_t *v_row, uint8_t *bgr, int n) {
+  static const BgrShuffleMasks shuffle;
+  const __m256i k16 = _mm256_set1_epi16(16);
+  const __m256i k128 = _mm256_set1_epi16(128);
+  const __m256i k_y = _mm256_set1_epi16(74);
+  const __m256i k_round = _mm256_set1_epi16(32);
+  const __m256i k_ub = _mm256_set1_epi16(129);
+  const __m256i k_ug = _mm256_set1_epi16(25);
+  const __m256i k_vg = _mm256_set1_epi16(52);
+  const __m256i k_vr = _mm256_set1_epi16(102);
+
+  __m128i m[3][3];
+  for (int k = 0; k < 3; ++k)
+    for (int c = 0; c < 3; ++c)
+      m[k][c] = _mm_load_si128((const __m128i *)shuffle.masks[k][c]);
+
+  int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i y = _mm256_cvtepu8_epi16(
+        _mm_loadu_si128((const __m128i *)(y_row + i)));
+    __m256i u = _mm256_cvtepu8_epi16(
+        _mm_loadu_si128((const __m128i *)(u_row + i)));
+    __m256i v = _mm256_cvtepu8_epi16(
+        _mm_loadu_si128((const __m128i *)(v_row + i)));
+
+    __m256i c = _mm256_add_epi16(
+        _mm256_mullo_epi16(_mm256_sub_epi16(y, k16), k_y), k_round);
+    u = _mm256_sub_epi16(u, k128);
+    v = _mm256_sub_epi16(v, k128);
+
+    __m256i b = _mm256_srai_epi16(
+        _mm256_adds_epi16(c, _mm256_mullo_epi16(u, k_ub)), 6);
+    __m256i g = _mm256_srai_epi16(
+        _mm256_subs_epi16(_mm256_subs_epi16(c, _mm256_mullo_epi16(u, k_ug)),
+                          _mm256_mullo_epi16(v, k_vg)),
+        6);
+    __m256i r = _mm256_srai_epi16(
+        _mm256_adds_epi16(c, _mm256_mullo_epi16(v, k_vr)), 6);
+
+    // 256 位 int16 -> 128 位 uint8（饱和），保持像素顺序
+    __m128i b8 = _mm_packus_epi16(_mm256_castsi256_si128(b),
+                                  _mm256_extracti128_si256(b, 1));
+    __m128i g8 = _mm_packus_epi16(_mm256_castsi256_si128(g),
+                                  _mm256_extracti128_si256(g, 1));
+    __m128i r8 = _mm_packus_epi16(_mm256_castsi256_si128(r),
+                                  _mm256_extracti128_si256(r, 1));
+
+    for (int k = 0; k < 3; ++k) {
+      __m128i chunk = _mm_or_si128(
+          _mm_or_si128(_mm_shuffle_epi8(b8, m[k][0]),
+                       _mm_shuffle_epi8(g8, m[k][1])),
+          _mm_shuffle_epi8(r8, m[k][2]));
+      _mm_storeu_si128((__m128i *)(bgr + 3 * i + 16 * k), chunk);
+    }
+  }
+  convert_row_bgr_scalar(y_row + i, u_row + i, v_row + i, bgr + 3 * i, n - i);
+}
+#endif
+
+#ifdef YUYV_HAVE_NEON
+/**
+ * @brief NEON 颜色转换：每次处理 8 个像素，vst3 直接交错写出
+ */
+static void convert_row_bgr_neon(const uint8_t *y_row, const uint8_t *u_row,
+                                 const uint8_t *v_row, uint8_t *bgr, int n) {
+  const int16x8_t k16 = vdupq_n_s16(16);
+  const int16x8_t k128 = vdupq_n_s16(128);
+  const int16x8_t k_round = vdupq_n_s16(32);
+
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    int16x8_t y = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(y_row + i)));
+    int16x8_t u = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(u_row + i))),
+                            k128);
+    int16x8_t v = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(v_row + i))),
+                            k128);
+    int16x8_t c = vaddq_s16(vmulq_n_s16(vsubq_s16(y, k16), 74), k_round);
+
+    int16x8_t b = vqaddq_s16(c, vmulq_n_s16(u, 129));
+    int16x8_t g =
+        vqsubq_s16(vqsubq_s16(c, vmulq_n_s16(u, 25)), vmulq_n_s16(v, 52));
+    int16x8_t r = vqaddq_s16(c, vmulq_n_s16(v, 102));
+
+    uint8x8x3_t out;
+    out.val[0] = vqshrun_n_s16(b, 6);
+    out.val[1] = vqshrun_n_s16(g, 6);
+    out.val[2] = vqshrun_n_s16(r, 6);
+    vst3_u8(bgr + 3 * i, out);
+  }
+  convert_row_bgr_scalar(y_row + i, u_row + i, v_row + i, bgr + 3 * i, n - i);
+}
+#endif
+
+/// 颜色转换内核函数指针类型
+using ConvertRowFn = void (*)(const uint8_t *, const uint8_t *,
+                              const uint8_t *, uint8_t *, int);
+
+/**
+ * @brief 选择当前 CPU 可用的最快颜色转换内核
+ */
+static ConvertRowFn select_convert_row() {
+#if defined(YUYV_HAVE_NEON)
+  return convert_row_bgr_neon;
+#elif defined(YUYV_HAVE_X86)
+  // 在静态初始化阶段调用，需先显式初始化 CPU 特性检测
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return convert_row_bgr_avx2;
+  return convert_row_bgr_scalar;
+#else
+  return convert_row_bgr_scalar;
+#endif
+}
+
+static const ConvertRowFn convert_row_bgr = select_convert_row();
+
+/**
+ * @brief 2x2 均值行采样：两行源像素 -> 一行平面 Y/U/V
+ * @param row0 第一行 ROI 起点（偶数列）
+ * @param row1 第二行 ROI 起点
+ * @param y_out 输出 Y
+ * @param u_out 输出 U，为 nullptr 时跳过色度（灰度输出）
+ * @param v_out 输出 V
+ * @param n 输出像素数，每个输出像素对应一个 YUYV 宏像素
+ */
+static void sample_row_box2x(const uint8_t *row0, const uint8_t *row1,
+                             uint8_t *y_out, uint8_t *u_out, uint8_t *v_out,
+                             int n) {
+  int i = 0;
+#ifdef YUYV_HAVE_NEON
+  // vld4 一次解交错 8 个宏像素：Y0[8] U[8] Y1[8] V[8]
+  for (; i + 8 <= n; i += 8) {
+    uint8x8x4_t a = vld4_u8(row0 + 4 * i);
+    uint8x8x4_t b = vld4_u8(row1 + 4 * i);
+    uint16x8_t sum = vaddq_u16(vaddl_u8(a.val[0], a.val[2]),
+                               vaddl_u8(b.val[0], b.val[2]));
+    vst1_u8(y_out + i, vrshrn_n_u16(sum, 2));
+    if (u_out) {
+      vst1_u8(u_out + i, vrhadd_u8(a.val[1], b.val[1]));
+      vst1_u8(v_out + i, vrhadd_u8(a.val[3], b.val[3]));
+    }
+  }
+#endif
+  for (; i < n; ++i) {
+    const uint8_t *a = row0 + 4 * i;
+    const uint8_t *b = row1 + 4 * i;
+    y_out[i] = (uint8_t)((a[0] + a[2] + b[0] + b[2] + 2) >> 2);
+    if (u_out) {
+      u_out[i] = (uint8_t)((a[1] + b[1] + 1) >> 1);
+      v_out[i] = (uint8_t)((a[3] + b[3] + 1) >> 1);
+    }
+  }
+}
+
+/**
+ * @brief 最近邻行采样：一行源像素 -> 一行平面 Y/U/V
+ * @param row 源图像行起点
+ * @param x_map 每个输出列对应的源像素列
+ * @param y_out 输出 Y
+ * @param u_out 输出 U，为 nullptr 时跳过色度（灰度输出）
+ * @param v_out 输出 V
+ * @param n 输出像素数
+ */
+static void sample_row_nearest(const uint8_t *row, const int *x_map,
+                               uint8_t *y_out, uint8_t *u_out, uint8_t *v_out,
+                               int n) {
+  if (!u_out) {
+    for (int i = 0; i < n; ++i)
+      y_out[i] = row[2 * x_map[i]];
+    return;
+  }
+  for (int i = 0; i < n; ++i) {
+    int sx = x_map[i];
+    const uint8_t *macro = row + 4 * (sx >> 1);
+    y_out[i] = row[2 * sx];
+    u_out[i] = macro[1];
+    v_out[i] = macro[3];
+  }
+}
+
+YuyvFastDecoder::YuyvFastDecoder(const DecoderOptions &options)
+    : options_(options) {}
+
+bool YuyvFastDecoder::simd_available() {
+  return convert_row_bgr != convert_row_bgr_scalar;
+}
+
+bool YuyvFastDecoder::update_geometry(uint32_t width, uint32_t height) {
+  if (width == src_width_ && height == src_height_ && out_width_ > 0)
+    return true;
+
+  cv::Rect full(0, 0, (int)width, (int)height);
+  cv::Rect roi = options_.roi.empty() ? full : (options_.roi & full);
+  // 对齐到宏像素边界，保证色度采样不跨越 ROI
+  if (roi.x & 1) {
+    roi.x -= 1;
+    roi.width += 1;
+  }
+  if (roi.x + roi.width > full.width)
+    roi.width = full.width - roi.x;
+  if (roi.empty())
+    return false;
+
+  const cv::Size out_size = options_.scaled_size(roi.size());
+  int out_width = out_size.width;
+  int out_height = out_size.height;
+  if (out_width <= 0 || out_height <= 0)
+    return false;
+
+  roi_ = roi;
+  out_width_ = out_width;
+  out_height_ = out_height;
+  box2x_ = roi.width == 2 * out_width && roi.height == 2 * out_height;
+
+  // 最近邻采样取输出像素中心对应的源像素
+  x_map_.resize(out_width);
+  for (int i = 0; i < out_width; ++i)
+    x_map_[i] = roi.x + (int)(((2LL * i + 1) * roi.width) / (2LL * out_width));
+  y_map_.resize(out_height);
+  for (int i = 0; i < out_height; ++i)
+    y_map_[i] =
+        roi.y + (int)(((2LL * i + 1) * roi.height) / (2LL * out_height));
+
+  y_row_.resize(out_width);
+  u_row_.resize(out_width);
+  v_row_.resize(out_width);
+
+  src_width_ = width;
+  src_height_ = height;
+  return true;
+}
+
+void YuyvFastDecoder::decode_into(const uint8_t *data,
+                                  const ImageHeader &header, cv::Mat &out) {
+  const size_t stride = (size_t)header.width * 2;
+  if (header.data_size < stride * header.height ||
+      !update_geometry(header.width, header.height)) {
+    out.release();
+    return;
+  }
+
+  const bool gray = options_.color == DecodeColor::Gray;
+  out.create(out_height_, out_width_, gray ? CV_8UC1 : CV_8UC3);
+
+  for (int oy = 0; oy < out_height_; ++oy) {
+    uint8_t *dst = out.ptr(oy);
+    // 灰度输出时亮度直接写入目标行
+    uint8_t *y_out = gray ? dst : y_row_.data();
+    uint8_t *u_out = gray ? nullptr : u_row_.data();
+    uint8_t *v_out = gray ? nullptr : v_row_.data();
+
+    if (box2x_) {
+      const uint8_t *row0 =
+          data + (size_t)(roi_.y + 2 * oy) * stride + (size_t)roi_.x * 2;
+      sample_row_box2x(row0, row0 + stride, y_out, u_out, v_out, out_width_);
+    } else {
+      const uint8_t *row = data + (size_t)y_map_[oy] * stride;
+      sample_row_nearest(row, x_map_.data(), y_out, u_out, v_out, out_width_);
+    }
+
+    if (!gray)
+      convert_row_bgr(y_row_.data(), u_row_.data(), v_row_.data(), dst,
+                      out_width_);
+  }
+}
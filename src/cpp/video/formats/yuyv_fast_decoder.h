@@ -0,0 +1,81 @@
+/**
+ * @file yuyv_fast_decoder.h
+ * @brief YUYV 单遍裁剪/缩放/颜色转换解码器
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 该文件实现了按消费者所需输出尺寸直接解码 YUYV 的解码器。
+ * 只对输出像素对应的源像素做转换，缩放与 ROI 裁剪和颜色转换在同一遍内完成，
+ * 颜色转换内核在 x86 上使用 AVX2（运行时检测），在 ARM 上使用 NEON。
+ */
+
+#ifndef YUYV_FAST_DECODER_H
+#define YUYV_FAST_DECODER_H
+
+#include "decoder_interface.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief YUYV 快速解码器类
+ *
+ * 处理流程（逐输出行）：
+ * 1. 行采样：从 ROI 中取出该输出行对应的源像素，展开为平面 Y/U/V 行。
+ *    输出尺寸恰为 ROI 的 1/2 时使用 2x2 均值（抗混叠），否则使用最近邻采样；
+ * 2. 颜色转换：平面 Y/U/V 行经 SIMD 内核转换为 BGR 并写入输出矩阵；
+ *    灰度输出时亮度直接写入输出矩阵，完全跳过色度。
+ *
+ * 颜色转换采用 ITU-R BT.601 有限范围系数（6 位定点），各 SIMD 路径与
+ * 标量路径逐位一致。几何参数与采样表在分辨率或选项变化时才重新计算，
+ * 配合 FramePool 稳定状态下每帧无堆分配。
+ *
+ * @note 非线程安全，每个线程应使用独立实例
+ */
+class YuyvFastDecoder : public IDecoder {
+public:
+  /**
+   * @brief 构造函数
+   * @param options 输出选项（颜色格式、ROI、输出尺寸）
+   */
+  explicit YuyvFastDecoder(const DecoderOptions &options);
+
+  /**
+   * @brief 将YUYV数据按输出选项解码到 out
+   * @param data YUYV格式的原始图像数据指针
+   * @param header 图像头部信息，包含宽度、高度等元数据
+   * @param out 输出矩阵（CV_8UC3 或 CV_8UC1），尺寸不变时复用其缓冲区
+   *
+   * ROI 会被裁剪到图像范围内，并向下对齐到偶数列（YUYV 两像素共享色度）。
+   * 数据不完整或 ROI 与图像无交集时 out 被置空。
+   */
+  void decode_into(const uint8_t *data, const ImageHeader &header,
+                   cv::Mat &out) override;
+
+  /**
+   * @brief 是否启用了 SIMD 颜色转换内核
+   */
+  static bool simd_available();
+
+private:
+  /**
+   * @brief 根据图像尺寸计算 ROI、输出尺寸与采样表
+   * @return false 当 ROI 与图像无交集或输出尺寸无效时
+   */
+  bool update_geometry(uint32_t width, uint32_t height);
+
+  DecoderOptions options_;   ///< 输出选项
+  uint32_t src_width_ = 0;   ///< 上次计算几何参数时的源宽度
+  uint32_t src_height_ = 0;  ///< 上次计算几何参数时的源高度
+  cv::Rect roi_;             ///< 实际使用的 ROI（已裁剪、对齐）
+  int out_width_ = 0;        ///< 输出宽度
+  int out_height_ = 0;       ///< 输出高度
+  bool box2x_ = false;       ///< 是否使用 2x2 均值下采样
+  std::vector<int> x_map_;   ///< 每个输出列对应的源像素列
+  std::vector<int> y_map_;   ///< 每个输出行对应的源像素行
+  std::vector<uint8_t> y_row_; ///< 平面 Y 行缓冲
+  std::vector<uint8_t> u_row_; ///< 平面 U 行缓冲（每输出像素一个）
+  std::vector<uint8_t> v_row_; ///< 平面 V 行缓冲（每输出像素一个）
+};
+
+#endif // YUYV_FAST_DECODER_H
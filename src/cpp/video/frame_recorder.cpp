@@ -0,0 +1,243 @@
+/**
+ * @file frame_recorder.cpp
+ * @brief 原始帧磁盘录制器实现
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 帧负载从共享内存槽位直接拷入映射的段文件页，这是录制路径上唯一的一次拷贝；
+ * 文件系统块在创建段时一次性预分配，写入过程中不再扩展文件。
+ */
+
+#include "frame_recorder.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+/// 段文件最小大小，保证至少能容纳文件头与若干帧
+static constexpr uint64_t kMinSegmentSize = 1ULL << 20;
+static constexpr uint64_t kPageSize = 4096;
+
+static uint64_t realtime_now_us() {
+  timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+FrameRecorder::FrameRecorder(const FrameRecorderOptions &options)
+    : options_(options), next_segment_index_(0), fd_(-1), base_(nullptr),
+      data_end_(0), frame_count_(0), writeback_begin_(0),
+      last_frame_version_(0) {
+  options_.segment_size_bytes = ShmBufferControl::align_up(
+      std::max(options_.segment_size_bytes, kMinSegmentSize), kPageSize);
+  // 回写块须按页对齐，madvise 只能回收整页
+  options_.writeback_chunk_bytes =
+      ShmBufferControl::align_up(options_.writeback_chunk_bytes, kPageSize);
+}
+
+FrameRecorder::~FrameRecorder() { close(); }
+
+void FrameRecorder::open(const std::string &source_name) {
+  close();
+  source_name_ = source_name;
+  last_frame_version_ = 0;
+  open_segment();
+}
+
+void FrameRecorder::open_segment() {
+  std::string path;
+  int fd = -1;
+  // 跳过已存在的序号，不覆盖之前的录制
+  while (true) {
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), "_%06llu",
+                  static_cast<unsigned long long>(next_segment_index_));
+    path = options_.directory + "/" + options_.prefix + suffix +
+           RECORDING_FILE_SUFFIX;
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd != -1)
+      break;
+    if (errno != EEXIST)
+      throw std::runtime_error("Failed to create recording segment '" + path +
+                               "': " + std::strerror(errno));
+    ++next_segment_index_;
+  }
+
+  uint64_t size = options_.segment_size_bytes;
+  int err = posix_fallocate(fd, 0, static_cast<off_t>(size));
+  void *addr = err == 0 ? mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                               MAP_SHARED, fd, 0)
+                        : MAP_FAILED;
+  if (addr == MAP_FAILED) {
+    std::string reason = std::strerror(err != 0 ? err : errno);
+    ::close(fd);
+    unlink(path.c_str());
+    throw std::runtime_error("Failed to preallocate recording segment '" +
+                             path + "' (" + std::to_string(size) +
+                             " bytes): " + reason);
+  }
+  madvise(addr, size, MADV_SEQUENTIAL);
+
+  fd_ = fd;
+  base_ = static_cast<uint8_t *>(addr);
+  segment_path_ = path;
+  data_end_ = RECORDING_HEADER_SIZE;
+  frame_count_ = 0;
+  writeback_begin_ = RECORDING_HEADER_SIZE;
+
+  RecordingSegmentHeader *hdr = header();
+  std::memset(static_cast<void *>(hdr), 0, RECORDING_HEADER_SIZE);
+  hdr->magic = RecordingSegmentHeader::MAGIC;
+  hdr->version = RecordingSegmentHeader::VERSION;
+  hdr->header_size = RECORDING_HEADER_SIZE;
+  hdr->file_size = size;
+  hdr->segment_index = next_segment_index_;
+  hdr->created_realtime_us = realtime_now_us();
+  hdr->created_monotonic_us = monotonic_now_us();
+  std::strncpy(hdr->source_name, source_name_.c_str(),
+               sizeof(hdr->source_name) - 1);
+  new (&hdr->data_end) std::atomic<uint64_t>(data_end_);
+  new (&hdr->frame_count) std::atomic<uint32_t>(0);
+  new (&hdr->finalized) std::atomic<uint32_t>(0);
+
+  ++next_segment_index_;
+  ++stats_.segments_opened;
+  segments_.push_back(path);
+  while (options_.max_segments > 0 &&
+         segments_.size() > options_.max_segments) {
+    unlink(segments_.front().c_str());
+    segments_.pop_front();
+    ++stats_.segments_removed;
+  }
+}
+
+RecordingIndexEntry *FrameRecorder::tail_index(uint32_t i) const {
+  return reinterpret_cast<RecordingIndexEntry *>(
+             base_ + options_.segment_size_bytes) -
+         (i + 1);
+}
+
+bool FrameRecorder::record(const ReadImageGuard &image) {
+  if (!image.is_valid())
+    return false;
+  if (!base_)
+    throw std::runtime_error("FrameRecorder::record() called before open().");
+
+  const ImageHeader &info = image.header();
+  uint64_t record_size = ShmBufferControl::align_up(
+      sizeof(RecordedFrameHeader) + info.data_size, RECORDING_RECORD_ALIGN);
+  uint64_t capacity = options_.segment_size_bytes - RECORDING_HEADER_SIZE;
+  if (record_size + sizeof(RecordingIndexEntry) > capacity ||
+      record_size > UINT32_MAX) {
+    ++stats_.frames_rejected;
+    return false;
+  }
+  // 数据区与尾部索引相遇时轮换
+  if (data_end_ + record_size +
+          (uint64_t)(frame_count_ + 1) * sizeof(RecordingIndexEntry) >
+      options_.segment_size_bytes) {
+    seal_segment();
+    open_segment();
+  }
+
+  RecordedFrameHeader record;
+  std::memset(&record, 0, sizeof(record));
+  record.magic = RecordedFrameHeader::MAGIC;
+  record.record_size = static_cast<uint32_t>(record_size);
+  record.frame_version = image.frame_version();
+  record.image = info;
+  uint8_t *dst = base_ + data_end_;
+  std::memcpy(dst, &record, sizeof(record));
+  std::memcpy(dst + sizeof(record), image.data(), info.data_size);
+  *tail_index(frame_count_) = {info.capture_timestamp_us, data_end_};
+
+  // 记录与索引写完后再发布计数，崩溃时读者只会看到完整的帧
+  RecordingSegmentHeader *hdr = header();
+  if (frame_count_ == 0)
+    hdr->first_timestamp_us = info.capture_timestamp_us;
+  hdr->last_timestamp_us = info.capture_timestamp_us;
+  data_end_ += record_size;
+  ++frame_count_;
+  hdr->data_end.store(data_end_, std::memory_order_release);
+  hdr->frame_count.store(frame_count_, std::memory_order_release);
+
+  uint64_t version = image.frame_version();
+  if (last_frame_version_ != 0 && version > last_frame_version_ + 1)
+    stats_.frames_missed += version - last_frame_version_ - 1;
+  last_frame_version_ = version;
+  ++stats_.frames_recorded;
+  stats_.bytes_recorded += info.data_size;
+
+  writeback();
+  return true;
+}
+
+void FrameRecorder::writeback() {
+  uint64_t chunk = options_.writeback_chunk_bytes;
+  if (chunk == 0)
+    return;
+  while (data_end_ >= writeback_begin_ + chunk) {
+    uint64_t begin = writeback_begin_;
+    sync_file_range(fd_, static_cast<off_t>(begin), static_cast<off_t>(chunk),
+                    SYNC_FILE_RANGE_WRITE);
+    if (begin >= RECORDING_HEADER_SIZE + chunk) {
+      // 等待前一块落盘后回收其页缓存；磁盘跟不上时录制在此限速
+      uint64_t prev = begin - chunk;
+      sync_file_range(fd_, static_cast<off_t>(prev), static_cast<off_t>(chunk),
+                      SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                          SYNC_FILE_RANGE_WAIT_AFTER);
+      madvise(base_ + prev, chunk, MADV_DONTNEED);
+      posix_fadvise(fd_, static_cast<off_t>(prev), static_cast<off_t>(chunk),
+                    POSIX_FADV_DONTNEED);
+    }
+    writeback_begin_ += chunk;
+  }
+}
+
+void FrameRecorder::seal_segment() {
+  if (!base_)
+    return;
+  RecordingSegmentHeader *hdr = header();
+  uint64_t file_end = data_end_;
+  if (frame_count_ > 0) {
+    // 尾部索引为倒序，封存时按时间升序紧接数据区写出（记录已按64字节对齐）
+    std::vector<RecordingIndexEntry> index(frame_count_);
+    for (uint32_t i = 0; i < frame_count_; ++i)
+      index[i] = *tail_index(i);
+    std::memcpy(base_ + data_end_, index.data(),
+                index.size() * sizeof(RecordingIndexEntry));
+    hdr->index_offset = data_end_;
+    file_end += index.size() * sizeof(RecordingIndexEntry);
+  }
+  hdr->finalized.store(1, std::memory_order_release);
+  munmap(base_, options_.segment_size_bytes);
+  base_ = nullptr;
+
+  if (frame_count_ == 0) {
+    // 空段没有保留价值
+    ::close(fd_);
+    unlink(segment_path_.c_str());
+    segments_.pop_back();
+  } else {
+    if (ftruncate(fd_, static_cast<off_t>(file_end)) == -1)
+      std::cerr << "FrameRecorder: failed to truncate '" << segment_path_
+                << "': " << std::strerror(errno) << std::endl;
+    fdatasync(fd_);
+    posix_fadvise(fd_, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd_);
+    std::cout << "FrameRecorder: sealed '" << segment_path_ << "' ("
+              << frame_count_ << " frames, " << file_end << " bytes)"
+              << std::endl;
+  }
+  fd_ = -1;
+  segment_path_.clear();
+}
+
+void FrameRecorder::close() { seal_segment(); }
@@ -0,0 +1,143 @@
+/**
+ * @file frame_recorder.h
+ * @brief 原始帧磁盘录制器
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 该文件定义了把共享内存中的原始帧（MJPG/YUYV 等负载与 ImageHeader）
+ * 连续录制到预分配、内存映射段文件的录制器。每帧只从共享内存槽位拷贝
+ * 一次到映射的文件页，不做颜色转换或重新编码；段文件格式见 recording_format.h。
+ */
+
+#ifndef FRAME_RECORDER_H
+#define FRAME_RECORDER_H
+
+#include "video/image_shm_manager.h"
+#include "video/recording_format.h"
+#include <cstdint>
+#include <deque>
+#include <string>
+
+/**
+ * @brief 录制器配置
+ */
+struct FrameRecorderOptions {
+  std::string directory = ".";   ///< 段文件输出目录（须已存在）
+  std::string prefix = "record"; ///< 段文件名前缀，文件名为 <prefix>_<序号>.screc
+  uint64_t segment_size_bytes = 1ULL << 30; ///< 单个段文件预分配大小
+  uint32_t max_segments = 0;     ///< 本次录制最多保留的段数，超出时删除最旧的段，0 表示不限
+  uint64_t writeback_chunk_bytes = 16ULL << 20; ///< 回写与页缓存回收的块大小，0 表示交给内核
+};
+
+/**
+ * @brief 录制统计信息
+ */
+struct FrameRecorderStats {
+  uint64_t frames_recorded = 0;  ///< 已录制帧数
+  uint64_t bytes_recorded = 0;   ///< 已录制负载字节数
+  uint64_t frames_missed = 0;    ///< 按帧版本号推算的未录制帧数
+  uint64_t frames_rejected = 0;  ///< 超过单段容量而无法录制的帧数
+  uint64_t segments_opened = 0;  ///< 已创建的段文件数
+  uint64_t segments_removed = 0; ///< 因 max_segments 删除的段文件数
+};
+
+/**
+ * @brief 原始帧磁盘录制器
+ *
+ * 段文件以 posix_fallocate 预分配后整体映射，写入一帧只是一次 memcpy 加
+ * 两次头部原子更新，没有 write() 系统调用。数据区每写满一块就用
+ * sync_file_range 启动回写，并回收前一块的页缓存，持续录制时脏页与
+ * 页缓存占用保持在两块以内，磁盘跟不上时录制线程在这里被限速。
+ *
+ * @note 非线程安全，应由单个录制线程调用
+ */
+class FrameRecorder {
+public:
+  /**
+   * @brief 构造函数
+   * @param options 录制器配置
+   */
+  explicit FrameRecorder(const FrameRecorderOptions &options);
+
+  /**
+   * @brief 析构函数，封存当前段
+   */
+  ~FrameRecorder();
+
+  FrameRecorder(const FrameRecorder &) = delete;
+  FrameRecorder &operator=(const FrameRecorder &) = delete;
+
+  /**
+   * @brief 创建第一个段文件
+   * @param source_name 来源共享内存名称，写入段文件头
+   * @throws std::runtime_error 当段文件无法创建、预分配或映射时抛出异常
+   */
+  void open(const std::string &source_name);
+
+  /**
+   * @brief 录制一帧
+   * @param image 零拷贝读守卫，负载直接从共享内存槽位拷入段文件
+   * @return bool true表示已录制，false表示该帧超过单段容量被丢弃
+   * @throws std::runtime_error 当轮换时新段文件无法创建时抛出异常
+   *
+   * 当前段剩余空间不足时先封存并轮换到新段。
+   */
+  bool record(const ReadImageGuard &image);
+
+  /**
+   * @brief 封存当前段并停止录制
+   */
+  void close();
+
+  /**
+   * @brief 获取统计信息
+   */
+  const FrameRecorderStats &get_stats() const { return stats_; }
+
+  /**
+   * @brief 获取当前段文件路径，未打开时为空
+   */
+  const std::string &current_segment_path() const { return segment_path_; }
+
+private:
+  /**
+   * @brief 创建、预分配并映射下一个段文件
+   * @throws std::runtime_error 失败时抛出异常
+   */
+  void open_segment();
+
+  /**
+   * @brief 把尾部索引按升序移到数据区之后，截断文件并解除映射
+   */
+  void seal_segment();
+
+  /**
+   * @brief 对已写满的数据块启动回写并回收更早一块的页缓存
+   */
+  void writeback();
+
+  /**
+   * @brief 尾部第 i 个索引项
+   */
+  RecordingIndexEntry *tail_index(uint32_t i) const;
+
+  RecordingSegmentHeader *header() const {
+    return reinterpret_cast<RecordingSegmentHeader *>(base_);
+  }
+
+  FrameRecorderOptions options_;  ///< 录制器配置
+  std::string source_name_;       ///< 来源共享内存名称
+  std::string segment_path_;      ///< 当前段文件路径
+  std::deque<std::string> segments_; ///< 本次录制创建的段文件（用于 max_segments）
+  uint64_t next_segment_index_;   ///< 下一个段序号
+  int fd_;                        ///< 当前段文件描述符
+  uint8_t *base_;                 ///< 当前段映射基地址
+  uint64_t data_end_;             ///< 当前段数据末尾偏移
+  uint32_t frame_count_;          ///< 当前段帧数
+  uint64_t writeback_begin_;      ///< 下一个待回写数据块的起始偏移
+  uint64_t last_frame_version_;   ///< 上一帧版本号，用于推算漏录帧数
+  FrameRecorderStats stats_;      ///< 统计信息
+};
+
+#endif // FRAME_RECORDER_H
@@ -10,15 +10,142 @@
  */
 
 #include "image_shm_manager.h"
-#include <chrono>
 #include <cstring>
 #include <iostream>
 
+ImagePlaneLayout image_plane_layout(const ImageHeader &header) {
+  ImagePlaneLayout layout = header.planes;
+  uint32_t bytes_per_pixel = 0;
+  bool semi_planar = false;
+  switch (header.format) {
+  case ImageFormat::YUYV:
+    bytes_per_pixel = 2;
+    break;
+  case ImageFormat::BGR:
+    bytes_per_pixel = 3;
+    break;
+  case ImageFormat::GRAY:
+    bytes_per_pixel = 1;
+    break;
+  case ImageFormat::NV12:
+  case ImageFormat::NV16:
+    bytes_per_pixel = 1;
+    semi_planar = true;
+    break;
+  default:
+    return layout; // 压缩格式没有平面布局
+  }
+
+  if (layout.strides[0] == 0)
+    layout.strides[0] = header.width * bytes_per_pixel;
+  if (semi_planar) {
+    // UV 平面每行交织 width/2 个 UV 对，与 Y 平面行宽相同
+    if (layout.strides[1] == 0)
+      layout.strides[1] = layout.strides[0];
+    if (layout.offsets[1] == 0)
+      layout.offsets[1] = layout.offsets[0] + layout.strides[0] * header.height;
+  }
+  return layout;
+}
+
+// ========== ReadImageGuard Implementation ==========
+ReadImageGuard::ReadImageGuard(ReadBufferGuard &&guard)
+    : guard_(std::move(guard)), header_{}, data_(nullptr),
+      status_(ShmStatus::NoDataAvailable), acquire_timestamp_us_(0) {
+  if (!guard_.is_valid()) {
+    // 保留底层失败原因（如 NotInitialized），便于调用者重连
+    if (guard_.status() != ShmStatus::Success)
+      status_ = guard_.status();
+    return;
+  }
+
+  status_ = ShmStatus::InvalidArguments;
+  if (guard_.size() < ImageShmManager::HEADER_SIZE)
+    return;
+
+  const uint8_t *buffer_ptr = static_cast<const uint8_t *>(guard_.get());
+  std::memcpy(&header_, buffer_ptr, sizeof(ImageHeader));
+  if (guard_.size() != ImageShmManager::HEADER_SIZE + header_.data_size)
+    return;
+
+  data_ = buffer_ptr + ImageShmManager::HEADER_SIZE;
+  status_ = ShmStatus::Success;
+  acquire_timestamp_us_ = monotonic_now_us();
+}
+
+// ========== WriteImageGuard Implementation ==========
+WriteImageGuard::WriteImageGuard(ImageShmManager *manager,
+                                 size_t max_payload_size)
+    : manager_(manager),
+      guard_(manager->acquire_write_buffer(ImageShmManager::HEADER_SIZE +
+                                           max_payload_size)) {}
+
+uint8_t *WriteImageGuard::data() {
+  if (!guard_.is_valid())
+    return nullptr;
+  return static_cast<uint8_t *>(guard_.get()) + ImageShmManager::HEADER_SIZE;
+}
+
+size_t WriteImageGuard::capacity() const {
+  if (!guard_.is_valid() || guard_.capacity() < ImageShmManager::HEADER_SIZE)
+    return 0;
+  return guard_.capacity() - ImageShmManager::HEADER_SIZE;
+}
+
+ShmStatus WriteImageGuard::commit(size_t image_data_size, uint32_t width,
+                                  uint32_t height, uint32_t channels,
+                                  uint64_t frame_version, ImageFormat format,
+                                  uint8_t frame_type,
+                                  uint64_t capture_timestamp_us,
+                                  uint64_t dequeue_timestamp_us,
+                                  const ImagePlaneLayout &planes) {
+  return manager_->commit_image(guard_, image_data_size, width, height,
+                                channels, frame_version, format, frame_type,
+                                capture_timestamp_us, dequeue_timestamp_us,
+                                planes);
+}
+
+// ========== ImageShmManager Implementation ==========
+ReadImageGuard ImageShmManager::acquire_image() {
+  return ReadImageGuard(acquire_read_buffer());
+}
+
+ReadImageGuard ImageShmManager::acquire_next_image(uint32_t consumer_id) {
+  return ReadImageGuard(acquire_next_buffer(consumer_id));
+}
+
+ShmStatus
+ImageShmManager::acquire_image_batch(uint32_t k,
+                                     std::vector<ReadImageGuard> *images) {
+  if (!images)
+    return ShmStatus::InvalidArguments;
+  images->clear();
+  std::vector<ReadBufferGuard> buffers;
+  ShmStatus status = acquire_read_batch(k, &buffers);
+  if (status != ShmStatus::Success)
+    return status;
+  images->reserve(buffers.size());
+  for (auto &buffer : buffers) {
+    ReadImageGuard image(std::move(buffer));
+    if (image.is_valid())
+      images->push_back(std::move(image));
+  }
+  return images->empty() ? ShmStatus::NoDataAvailable : ShmStatus::Success;
+}
+
+WriteImageGuard
+ImageShmManager::acquire_image_for_write(size_t max_payload_size) {
+  return WriteImageGuard(this, max_payload_size);
+}
+
 ShmStatus ImageShmManager::write_image(const uint8_t *image_data,
                                        size_t image_data_size, uint32_t width,
                                        uint32_t height, uint32_t channels,
                                        uint64_t frame_version,
-                                       ImageFormat format, uint8_t frame_type) {
+                                       ImageFormat format, uint8_t frame_type,
+                                       uint64_t capture_timestamp_us,
+                                       uint64_t dequeue_timestamp_us,
+                                       const ImagePlaneLayout &planes) {
 
   if (!image_data || image_data_size == 0) {
     return ShmStatus::InvalidArguments;
@@ -29,56 +156,97 @@ ShmStatus ImageShmManager::write_image(const uint8_t *image_data,
     return ShmStatus::BufferTooSmall;
   }
 
-  WriteBufferGuard guard = acquire_write_buffer(total_size);
-  if (!guard.is_valid()) {
+  WriteImageGuard image = acquire_image_for_write(image_data_size);
+  if (!image.is_valid()) {
     return ShmStatus::BufferInUse;
   }
 
-  ImageHeader header = {format,
-                        width,
-                        height,
-                        channels,
-                        static_cast<uint32_t>(image_data_size),
-                        frame_type};
+  std::memcpy(image.data(), image_data, image_data_size);
+
+  return image.commit(image_data_size, width, height, channels, frame_version,
+                      format, frame_type, capture_timestamp_us,
+                      dequeue_timestamp_us, planes);
+}
 
+ShmStatus ImageShmManager::commit_image(WriteBufferGuard &guard,
+                                        size_t image_data_size, uint32_t width,
+                                        uint32_t height, uint32_t channels,
+                                        uint64_t frame_version,
+                                        ImageFormat format,
+                                        uint8_t frame_type,
+                                        uint64_t capture_timestamp_us,
+                                        uint64_t dequeue_timestamp_us,
+                                        const ImagePlaneLayout &planes) {
   uint8_t *buffer_ptr = static_cast<uint8_t *>(guard.get());
   if (!buffer_ptr) {
     // 这是一个不太可能发生的严重错误，但最好检查一下
     return ShmStatus::InvalidArguments;
   }
 
-  std::memcpy(buffer_ptr, &header, HEADER_SIZE);
-  std::memcpy(buffer_ptr + HEADER_SIZE, image_data, image_data_size);
+  size_t total_size = HEADER_SIZE + image_data_size;
+  if (total_size > guard.capacity()) {
+    return ShmStatus::BufferTooSmall;
+  }
 
-  uint64_t current_timestamp =
-      std::chrono::duration_cast<std::chrono::microseconds>(
-          std::chrono::system_clock::now().time_since_epoch())
-          .count();
+  // 没有驱动时间戳时以提交时间作为采集时间，槽位时间戳始终为采集时间
+  uint64_t commit_timestamp_us = monotonic_now_us();
+  if (capture_timestamp_us == 0)
+    capture_timestamp_us = commit_timestamp_us;
 
-  return guard.commit(total_size, frame_version, current_timestamp);
+  ImageHeader header = {format,
+                        width,
+                        height,
+                        channels,
+                        static_cast<uint32_t>(image_data_size),
+                        frame_type,
+                        capture_timestamp_us,
+                        dequeue_timestamp_us,
+                        commit_timestamp_us,
+                        planes};
+  std::memcpy(buffer_ptr, &header, sizeof(ImageHeader));
+
+  return guard.commit(total_size, frame_version, capture_timestamp_us);
 }
+
 ShmStatus ImageShmManager::read_image(
     uint8_t *out_buffer, size_t max_buffer_size, uint32_t *out_width,
     uint32_t *out_height, uint32_t *out_channels, size_t *out_data_size,
     uint64_t *out_frame_version, uint64_t *out_timestamp_us,
     ImageFormat *out_format, uint8_t *out_frame_type) {
-  ReadBufferGuard guard = acquire_read_buffer();
-  if (!guard.is_valid())
-    return ShmStatus::NoDataAvailable;
+  ReadImageGuard image = acquire_image();
+  return copy_image(image, out_buffer, max_buffer_size, out_width, out_height,
+                    out_channels, out_data_size, out_frame_version,
+                    out_timestamp_us, out_format, out_frame_type);
+}
 
-  if (guard.size() < HEADER_SIZE)
-    return ShmStatus::InvalidArguments;
+ShmStatus ImageShmManager::read_next_image(
+    uint32_t consumer_id, uint8_t *out_buffer, size_t max_buffer_size,
+    uint32_t *out_width, uint32_t *out_height, uint32_t *out_channels,
+    size_t *out_data_size, uint64_t *out_frame_version,
+    uint64_t *out_timestamp_us, ImageFormat *out_format,
+    uint8_t *out_frame_type) {
+  ReadImageGuard image = acquire_next_image(consumer_id);
+  return copy_image(image, out_buffer, max_buffer_size, out_width, out_height,
+                    out_channels, out_data_size, out_frame_version,
+                    out_timestamp_us, out_format, out_frame_type);
+}
 
-  const uint8_t *buffer_ptr = static_cast<const uint8_t *>(guard.get());
-  ImageHeader header;
-  std::memcpy(&header, buffer_ptr, HEADER_SIZE);
+ShmStatus ImageShmManager::copy_image(
+    const ReadImageGuard &image, uint8_t *out_buffer, size_t max_buffer_size,
+    uint32_t *out_width, uint32_t *out_height, uint32_t *out_channels,
+    size_t *out_data_size, uint64_t *out_frame_version,
+    uint64_t *out_timestamp_us, ImageFormat *out_format,
+    uint8_t *out_frame_type) {
+  if (!image.is_valid())
+    return image.status() == ShmStatus::InvalidArguments
+               ? ShmStatus::InvalidArguments
+               : ShmStatus::NoDataAvailable;
 
-  if (guard.size() != HEADER_SIZE + header.data_size)
-    return ShmStatus::InvalidArguments;
+  const ImageHeader &header = image.header();
   if (header.data_size > max_buffer_size)
     return ShmStatus::BufferTooSmall;
 
-  std::memcpy(out_buffer, buffer_ptr + HEADER_SIZE, header.data_size);
+  std::memcpy(out_buffer, image.data(), header.data_size);
 
   if (out_width)
     *out_width = header.width;
@@ -93,9 +261,9 @@ ShmStatus ImageShmManager::read_image(
   if (out_frame_type)
     *out_frame_type = header.frame_type;
   if (out_frame_version)
-    *out_frame_version = guard.frame_version();
+    *out_frame_version = image.frame_version();
   if (out_timestamp_us)
-    *out_timestamp_us = guard.timestamp_us();
+    *out_timestamp_us = image.timestamp_us();
 
   return ShmStatus::Success;
-}
\ No newline at end of file
+}
@@ -15,6 +15,7 @@
 #include "common/ipc/shm_manager.h"
 #include <cstdint>
 #include <string>
+#include <vector>
 
 /**
  * @brief 支持的图像格式枚举
@@ -25,7 +26,41 @@ enum class ImageFormat {
   YUYV, ///< YUYV 422格式，常用于USB摄像头
   H264, ///< H.264视频编码格式
   BGR,  ///< OpenCV标准的BGR格式
-  MJPG  ///< Motion JPEG压缩格式
+  MJPG, ///< Motion JPEG压缩格式
+  GRAY, ///< 单通道灰度（亮度）格式
+  NV12, ///< YUV 4:2:0 半平面格式：Y 平面后接交织的 UV 平面（高度减半）
+  NV16  ///< YUV 4:2:2 半平面格式：Y 平面后接交织的 UV 平面（高度不变）
+};
+
+/**
+ * @brief H264 帧类型标志
+ *
+ * format 为 H264 时 ImageHeader::frame_type 按位组合以下标志；其他格式的
+ * frame_type 仍为对应的 OpenCV 数据类型常量。KEYFRAME、PFRAME、BFRAME
+ * 均未置位表示非 IDR 的 I 帧或无法识别的帧。
+ */
+struct H264FrameType {
+  static constexpr uint8_t KEYFRAME = 0x01;     ///< IDR 关键帧，解码器可从此帧开始解码
+  static constexpr uint8_t PFRAME = 0x02;       ///< P 帧
+  static constexpr uint8_t BFRAME = 0x04;       ///< B 帧
+  static constexpr uint8_t CODEC_CONFIG = 0x08; ///< 帧内携带 SPS/PPS 参数集
+};
+
+/// ImagePlaneLayout 可描述的最大平面数量（Y + 交织 UV）
+constexpr uint32_t IMAGE_MAX_PLANES = 2;
+
+/**
+ * @brief 图像平面布局
+ *
+ * 各平面相对图像数据起始处的偏移与行跨度（字节）。字段为0表示紧凑排列：
+ * 行跨度按格式与宽度推算，第1平面紧接第0平面，旧生产者写入的头部即为
+ * 这种情况。NV12/NV16 第0平面为 Y、第1平面为交织的 UV；YUYV、BGR、GRAY
+ * 只使用第0平面的行跨度；压缩格式（MJPG、H264）不使用该结构。
+ * 读取时应通过 image_plane_layout() 获取补全后的布局。
+ */
+struct ImagePlaneLayout {
+  uint32_t offsets[IMAGE_MAX_PLANES]; ///< 平面起始偏移（字节），第0平面通常为0
+  uint32_t strides[IMAGE_MAX_PLANES]; ///< 平面行跨度（字节），含驱动的行对齐填充
 };
 
 /**
@@ -33,6 +68,7 @@ enum class ImageFormat {
  *
  * 存储图像的元数据信息，包括格式、尺寸、通道数等。
  * 该结构体会与图像数据一起存储在共享内存中。
+ * 各阶段时间戳均为 CLOCK_MONOTONIC，消费者可据此分解端到端延迟。
  */
 struct ImageHeader {
   ImageFormat format; ///< 图像格式
@@ -40,7 +76,164 @@ struct ImageHeader {
   uint32_t height;    ///< 图像高度（像素）
   uint32_t channels;  ///< 颜色通道数（如RGB为3，RGBA为4）
   uint32_t data_size; ///< 图像数据大小（字节）
-  uint8_t frame_type; ///< 帧类型标志（如关键帧、差分帧等）
+  uint8_t frame_type; ///< 帧类型：H264 为 H264FrameType 标志，其他格式为 OpenCV 数据类型
+  uint64_t capture_timestamp_us; ///< 采集时间（驱动时间戳，CLOCK_MONOTONIC 微秒），无驱动时间戳时等于提交时间
+  uint64_t dequeue_timestamp_us; ///< 生产者出队时间（CLOCK_MONOTONIC 微秒），未知时为0
+  uint64_t commit_timestamp_us;  ///< 提交到共享内存的时间（CLOCK_MONOTONIC 微秒）
+  ImagePlaneLayout planes;       ///< 平面偏移与行跨度，全0表示紧凑排列
+};
+
+// 头部恰好占满一个缓存行，图像数据偏移（payload_offset）保持为64字节
+static_assert(sizeof(ImageHeader) == 64, "ImageHeader must fill one cache line");
+
+/**
+ * @brief 获取补全默认值后的平面布局
+ * @param header 图像头部
+ * @return ImagePlaneLayout 行跨度为0的平面按格式与宽度推算，第1平面偏移为0时
+ *         紧接在第0平面之后；未使用的平面保持为0
+ */
+ImagePlaneLayout image_plane_layout(const ImageHeader &header);
+
+class ImageShmManager;
+
+/**
+ * @brief 零拷贝图像读守卫
+ *
+ * 持有读缓冲区守卫并解析图像头部，data() 直接指向共享内存中的图像数据，
+ * 守卫存活期间该槽位不会被写者覆盖。应尽快处理并析构以释放槽位。
+ */
+class ReadImageGuard {
+public:
+  /**
+   * @brief 构造函数，接管读缓冲区并校验图像头部
+   * @param guard 已获取的读缓冲区守卫
+   */
+  explicit ReadImageGuard(ReadBufferGuard &&guard);
+
+  ReadImageGuard(ReadImageGuard &&other) noexcept = default;
+  ReadImageGuard &operator=(ReadImageGuard &&other) noexcept = default;
+  ReadImageGuard(const ReadImageGuard &) = delete;
+  ReadImageGuard &operator=(const ReadImageGuard &) = delete;
+
+  /**
+   * @brief 检查图像是否有效
+   * @return bool true表示已获取到格式正确的图像
+   */
+  bool is_valid() const { return data_ != nullptr; }
+
+  /**
+   * @brief 获取失败原因
+   * @return ShmStatus 无数据时为 NoDataAvailable，头部损坏时为 InvalidArguments
+   */
+  ShmStatus status() const { return status_; }
+
+  /**
+   * @brief 获取图像头部
+   * @return const ImageHeader& 图像头部信息
+   */
+  const ImageHeader &header() const { return header_; }
+
+  /**
+   * @brief 获取图像数据指针（直接指向共享内存）
+   * @return const uint8_t* 图像数据，无效时为nullptr
+   */
+  const uint8_t *data() const { return data_; }
+
+  /**
+   * @brief 获取图像数据大小
+   * @return size_t 图像数据大小（字节）
+   */
+  size_t data_size() const { return header_.data_size; }
+
+  /**
+   * @brief 获取帧版本号
+   * @return uint64_t 帧版本号
+   */
+  uint64_t frame_version() const { return guard_.frame_version(); }
+
+  /**
+   * @brief 获取时间戳
+   * @return uint64_t 采集时间戳（CLOCK_MONOTONIC 微秒）
+   */
+  uint64_t timestamp_us() const { return guard_.timestamp_us(); }
+
+  /**
+   * @brief 获取消费者获取该帧的时间
+   * @return uint64_t 读守卫创建时间（CLOCK_MONOTONIC 微秒），无效时为0
+   */
+  uint64_t acquire_timestamp_us() const { return acquire_timestamp_us_; }
+
+private:
+  ReadBufferGuard guard_; ///< 底层读缓冲区守卫
+  ImageHeader header_;    ///< 解析后的图像头部
+  const uint8_t *data_;   ///< 图像数据指针
+  ShmStatus status_;      ///< 获取结果
+  uint64_t acquire_timestamp_us_; ///< 获取时间
+};
+
+/**
+ * @brief 就地写入图像守卫
+ *
+ * 生产者直接向 data() 写入图像数据，commit() 时补写头部并提交，
+ * 省去 write_image() 中从调用者缓冲区到共享内存的拷贝。
+ * 未提交即析构时自动放弃该槽位。
+ */
+class WriteImageGuard {
+public:
+  /**
+   * @brief 构造函数，获取可容纳 max_payload_size 字节图像数据的槽位
+   * @param manager 图像共享内存管理器
+   * @param max_payload_size 预计写入的最大图像数据大小（字节）
+   */
+  WriteImageGuard(ImageShmManager *manager, size_t max_payload_size);
+
+  WriteImageGuard(WriteImageGuard &&other) noexcept = default;
+  WriteImageGuard &operator=(WriteImageGuard &&other) noexcept = default;
+  WriteImageGuard(const WriteImageGuard &) = delete;
+  WriteImageGuard &operator=(const WriteImageGuard &) = delete;
+
+  /**
+   * @brief 检查是否成功获取槽位
+   * @return bool true表示可以写入
+   */
+  bool is_valid() const { return guard_.is_valid(); }
+
+  /**
+   * @brief 获取图像数据写入位置（直接指向共享内存）
+   * @return uint8_t* 图像数据指针，无效时为nullptr
+   */
+  uint8_t *data();
+
+  /**
+   * @brief 获取可写入的图像数据容量
+   * @return size_t 容量（字节）
+   */
+  size_t capacity() const;
+
+  /**
+   * @brief 写入头部并提交图像
+   * @param image_data_size 实际写入的图像数据大小（字节）
+   * @param width 图像宽度（像素）
+   * @param height 图像高度（像素）
+   * @param channels 颜色通道数
+   * @param frame_version 帧版本号
+   * @param format 图像格式
+   * @param frame_type 帧类型标志，默认为0
+   * @param capture_timestamp_us 采集时间（CLOCK_MONOTONIC 微秒），0 表示使用提交时间
+   * @param dequeue_timestamp_us 生产者出队时间（CLOCK_MONOTONIC 微秒），0 表示未知
+   * @param planes 平面布局，默认紧凑排列
+   * @return ShmStatus 操作结果状态码
+   */
+  ShmStatus commit(size_t image_data_size, uint32_t width, uint32_t height,
+                   uint32_t channels, uint64_t frame_version,
+                   ImageFormat format, uint8_t frame_type = 0,
+                   uint64_t capture_timestamp_us = 0,
+                   uint64_t dequeue_timestamp_us = 0,
+                   const ImagePlaneLayout &planes = ImagePlaneLayout());
+
+private:
+  ImageShmManager *manager_; ///< 所属管理器
+  WriteBufferGuard guard_;   ///< 底层写缓冲区守卫
 };
 
 /**
@@ -61,10 +254,13 @@ public:
   /**
    * @brief 构造函数
    * @param shm_name 共享内存名称
+   * @param map_options 映射选项（大页、预取、锁定等）
    *
    * 初始化图像共享内存管理器，继承父类的所有功能。
    */
-  ImageShmManager(const std::string &shm_name) : ShmManager(shm_name) {}
+  ImageShmManager(const std::string &shm_name,
+                  const ShmMapOptions &map_options = ShmMapOptions())
+      : ShmManager(shm_name, map_options) {}
 
   /**
    * @brief 写入图像数据到共享内存
@@ -76,17 +272,23 @@ public:
    * @param frame_version 帧版本号，用于标识数据更新
    * @param format 图像格式
    * @param frame_type 帧类型标志，默认为0
+   * @param capture_timestamp_us 采集时间（CLOCK_MONOTONIC 微秒），0 表示使用提交时间
+   * @param dequeue_timestamp_us 生产者出队时间（CLOCK_MONOTONIC 微秒），0 表示未知
+   * @param planes 平面布局，默认紧凑排列
    * @return ShmStatus 操作结果状态码
    *
    * 将图像数据和相关元数据写入共享内存。方法会自动创建
-   * ImageHeader结构体并与图像数据一起存储。
+   * ImageHeader结构体并与图像数据一起存储。槽位时间戳为采集时间。
    *
-   * @note 实际存储格式为：[ImageHeader][图像数据]
+   * @note 实际存储格式为：[ImageHeader][填充至64字节][图像数据]
    */
   ShmStatus write_image(const uint8_t *image_data, size_t image_data_size,
                         uint32_t width, uint32_t height, uint32_t channels,
                         uint64_t frame_version, ImageFormat format,
-                        uint8_t frame_type = 0);
+                        uint8_t frame_type = 0,
+                        uint64_t capture_timestamp_us = 0,
+                        uint64_t dequeue_timestamp_us = 0,
+                        const ImagePlaneLayout &planes = ImagePlaneLayout());
 
   /**
    * @brief 从共享内存读取图像数据
@@ -113,9 +315,106 @@ public:
                        uint64_t *out_frame_version, uint64_t *out_timestamp_us,
                        ImageFormat *out_format, uint8_t *out_frame_type);
 
+  /**
+   * @brief 以零拷贝方式获取最新图像
+   * @return ReadImageGuard 图像读守卫，无数据时无效
+   */
+  ReadImageGuard acquire_image();
+
+  /**
+   * @brief 以零拷贝方式获取指定消费者的下一帧图像（队列模式）
+   * @param consumer_id register_consumer() 返回的消费者ID
+   * @return ReadImageGuard 图像读守卫，无新帧时无效
+   */
+  ReadImageGuard acquire_next_image(uint32_t consumer_id);
+
+  /**
+   * @brief 以零拷贝方式一次性获取最近的至多 k 帧图像
+   * @param k 期望帧数（上限为 buffer_count - 1）
+   * @param images 输出参数，按帧版本升序排列的图像读守卫，原有内容被清空
+   * @return ShmStatus 操作结果状态码，没有可用图像时返回 NoDataAvailable
+   *
+   * 见 ShmManager::acquire_read_batch()。头部损坏的帧被跳过。
+   */
+  ShmStatus acquire_image_batch(uint32_t k, std::vector<ReadImageGuard> *images);
+
+  /**
+   * @brief 获取就地写入图像的守卫
+   * @param max_payload_size 预计写入的最大图像数据大小（字节）
+   * @return WriteImageGuard 图像写守卫，无空闲槽位时无效
+   */
+  WriteImageGuard acquire_image_for_write(size_t max_payload_size);
+
+  /**
+   * @brief 按版本顺序读取指定消费者的下一帧图像（队列模式）
+   * @param consumer_id register_consumer() 返回的消费者ID
+   * @return ShmStatus 操作结果状态码，无新帧时返回 NoDataAvailable
+   *
+   * 其余参数与 read_image() 相同。
+   */
+  ShmStatus read_next_image(uint32_t consumer_id, uint8_t *out_buffer,
+                            size_t max_buffer_size, uint32_t *out_width,
+                            uint32_t *out_height, uint32_t *out_channels,
+                            size_t *out_data_size, uint64_t *out_frame_version,
+                            uint64_t *out_timestamp_us, ImageFormat *out_format,
+                            uint8_t *out_frame_type);
+
+  /**
+   * @brief 为已填充图像数据的写缓冲区写入头部并提交
+   * @param guard 已获取的写缓冲区守卫，图像数据已位于 payload_offset() 处
+   * @param image_data_size 图像数据大小（字节）
+   * @param width 图像宽度（像素）
+   * @param height 图像高度（像素）
+   * @param channels 颜色通道数
+   * @param frame_version 帧版本号
+   * @param format 图像格式
+   * @param frame_type 帧类型标志，默认为0
+   * @param capture_timestamp_us 采集时间（CLOCK_MONOTONIC 微秒），0 表示使用提交时间
+   * @param dequeue_timestamp_us 生产者出队时间（CLOCK_MONOTONIC 微秒），0 表示未知
+   * @param planes 平面布局，默认紧凑排列
+   * @return ShmStatus 操作结果状态码
+   *
+   * 供就地填充数据的生产者（如零拷贝捕获）使用，避免额外的memcpy。
+   */
+  ShmStatus commit_image(WriteBufferGuard &guard, size_t image_data_size,
+                         uint32_t width, uint32_t height, uint32_t channels,
+                         uint64_t frame_version, ImageFormat format,
+                         uint8_t frame_type = 0,
+                         uint64_t capture_timestamp_us = 0,
+                         uint64_t dequeue_timestamp_us = 0,
+                         const ImagePlaneLayout &planes = ImagePlaneLayout());
+
+  /**
+   * @brief 获取图像数据在槽位内的偏移量
+   * @return size_t 偏移量（字节），按缓存行对齐
+   */
+  static constexpr size_t payload_offset() { return HEADER_SIZE; }
+
+  /**
+   * @brief 获取单个槽位可容纳的最大图像数据大小
+   * @return size_t 最大图像数据大小（字节）
+   */
+  size_t get_max_payload_size() const {
+    size_t buffer_size = get_buffer_size();
+    return buffer_size > HEADER_SIZE ? buffer_size - HEADER_SIZE : 0;
+  }
+
 private:
-  static constexpr size_t HEADER_SIZE =
-      sizeof(ImageHeader); ///< 图像头部大小常量
+  friend class ReadImageGuard;
+  friend class WriteImageGuard;
+
+  static ShmStatus copy_image(const ReadImageGuard &image, uint8_t *out_buffer,
+                              size_t max_buffer_size, uint32_t *out_width,
+                              uint32_t *out_height, uint32_t *out_channels,
+                              size_t *out_data_size,
+                              uint64_t *out_frame_version,
+                              uint64_t *out_timestamp_us,
+                              ImageFormat *out_format,
+                              uint8_t *out_frame_type);
+
+  /// 图像头部占用的空间，补齐到缓存行使图像数据在槽位内同样对齐
+  static constexpr size_t HEADER_SIZE = ShmBufferControl::align_up(
+      sizeof(ImageHeader), ShmBufferControl::CACHE_LINE_SIZE);
 };
 
 #endif // IMAGE_SHM_MANAGER_H
\ No newline at end of file
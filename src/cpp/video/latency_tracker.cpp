@@ -0,0 +1,107 @@
+/**
+ * @file latency_tracker.cpp
+ * @brief 端到端延迟分解统计实现
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ */
+
+#include "latency_tracker.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+FrameTimeline FrameTimeline::from(const ImageHeader &header,
+                                  uint64_t acquire_us, uint64_t decoded_us) {
+  FrameTimeline timeline;
+  timeline.capture_us = header.capture_timestamp_us;
+  timeline.dequeue_us = header.dequeue_timestamp_us;
+  timeline.commit_us = header.commit_timestamp_us;
+  timeline.acquire_us = acquire_us;
+  timeline.decoded_us = decoded_us;
+  return timeline;
+}
+
+LatencyTracker::LatencyTracker() = default;
+
+void LatencyTracker::add(Stage &stage, uint64_t begin_us, uint64_t end_us) {
+  if (begin_us == 0 || end_us == 0 || end_us < begin_us)
+    return;
+  uint64_t elapsed = end_us - begin_us;
+  stage.count++;
+  stage.sum_us += elapsed;
+  stage.max_us = std::max(stage.max_us, elapsed);
+  stage.buckets[std::min<uint64_t>(elapsed / BUCKET_US, BUCKET_COUNT)]++;
+}
+
+void LatencyTracker::record(const FrameTimeline &timeline) {
+  add(capture_to_dequeue_, timeline.capture_us, timeline.dequeue_us);
+  add(dequeue_to_commit_, timeline.dequeue_us, timeline.commit_us);
+  add(commit_to_acquire_, timeline.commit_us, timeline.acquire_us);
+  add(acquire_to_decoded_, timeline.acquire_us, timeline.decoded_us);
+  add(total_, timeline.capture_us, timeline.decoded_us);
+}
+
+LatencyStageStats LatencyTracker::summarize(const Stage &stage) {
+  LatencyStageStats stats;
+  stats.count = stage.count;
+  if (stage.count == 0)
+    return stats;
+  stats.mean_ms = stage.sum_us / 1000.0 / stage.count;
+  stats.max_ms = stage.max_us / 1000.0;
+
+  // 分位数取所在桶的上沿，溢出桶取最大值
+  auto percentile = [&](double q) {
+    uint64_t target = (uint64_t)(q * (stage.count - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < stage.buckets.size(); ++i) {
+      seen += stage.buckets[i];
+      if (seen >= target)
+        return i == BUCKET_COUNT
+                   ? stats.max_ms
+                   : std::min(stats.max_ms, (i + 1) * BUCKET_US / 1000.0);
+    }
+    return stats.max_ms;
+  };
+  stats.p50_ms = percentile(0.50);
+  stats.p99_ms = percentile(0.99);
+  return stats;
+}
+
+LatencyReport LatencyTracker::get_report() const {
+  LatencyReport report;
+  report.capture_to_dequeue = summarize(capture_to_dequeue_);
+  report.dequeue_to_commit = summarize(dequeue_to_commit_);
+  report.commit_to_acquire = summarize(commit_to_acquire_);
+  report.acquire_to_decoded = summarize(acquire_to_decoded_);
+  report.total = summarize(total_);
+  return report;
+}
+
+void LatencyTracker::reset() {
+  capture_to_dequeue_ = Stage();
+  dequeue_to_commit_ = Stage();
+  commit_to_acquire_ = Stage();
+  acquire_to_decoded_ = Stage();
+  total_ = Stage();
+}
+
+std::string LatencyTracker::format(const LatencyReport &report) {
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(2);
+  auto stage = [&](const char *name, const LatencyStageStats &stats) {
+    out << name << " " << stats.mean_ms << "/" << stats.p99_ms << "/"
+        << stats.max_ms;
+  };
+  stage("capture->dequeue", report.capture_to_dequeue);
+  out << ", ";
+  stage("dequeue->commit", report.dequeue_to_commit);
+  out << ", ";
+  stage("commit->acquire", report.commit_to_acquire);
+  out << ", ";
+  stage("acquire->decoded", report.acquire_to_decoded);
+  out << ", ";
+  stage("total", report.total);
+  out << " ms (mean/p99/max, " << report.total.count << " frames)";
+  return out.str();
+}
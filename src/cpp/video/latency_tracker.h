@@ -0,0 +1,127 @@
+/**
+ * @file latency_tracker.h
+ * @brief 端到端延迟分解统计
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 该文件定义了按处理阶段统计帧延迟的工具。帧从驱动采集到消费者解码完成
+ * 经过的每个阶段都记录了 CLOCK_MONOTONIC 时间戳（见 ImageHeader），
+ * 消费者把它们交给 LatencyTracker 即可得到各阶段的延迟分布。
+ */
+
+#ifndef LATENCY_TRACKER_H
+#define LATENCY_TRACKER_H
+
+#include "video/image_shm_manager.h"
+#include <array>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief 单帧各阶段时间戳（CLOCK_MONOTONIC 微秒，0 表示未知）
+ */
+struct FrameTimeline {
+  uint64_t capture_us = 0; ///< 驱动采集时间
+  uint64_t dequeue_us = 0; ///< 生产者出队时间
+  uint64_t commit_us = 0;  ///< 提交到共享内存的时间
+  uint64_t acquire_us = 0; ///< 消费者获取时间
+  uint64_t decoded_us = 0; ///< 解码完成时间
+
+  /**
+   * @brief 由图像头部与消费者侧时间戳组装时间线
+   * @param header 图像头部（包含生产者侧时间戳）
+   * @param acquire_us 消费者获取时间
+   * @param decoded_us 解码完成时间
+   */
+  static FrameTimeline from(const ImageHeader &header, uint64_t acquire_us,
+                            uint64_t decoded_us);
+};
+
+/**
+ * @brief 单个阶段的延迟统计（毫秒）
+ */
+struct LatencyStageStats {
+  uint64_t count = 0;  ///< 样本数
+  double mean_ms = 0;  ///< 平均值
+  double p50_ms = 0;   ///< 中位数（0.1ms 精度）
+  double p99_ms = 0;   ///< 99 分位（0.1ms 精度）
+  double max_ms = 0;   ///< 最大值
+};
+
+/**
+ * @brief 延迟分解报告
+ */
+struct LatencyReport {
+  LatencyStageStats capture_to_dequeue; ///< 驱动采集 -> 生产者出队（传输、驱动排队）
+  LatencyStageStats dequeue_to_commit;  ///< 生产者出队 -> 共享内存提交（交接、拷贝）
+  LatencyStageStats commit_to_acquire;  ///< 共享内存提交 -> 消费者获取（唤醒、调度）
+  LatencyStageStats acquire_to_decoded; ///< 消费者获取 -> 解码完成
+  LatencyStageStats total;              ///< 驱动采集 -> 解码完成
+};
+
+/**
+ * @brief 延迟分解统计器
+ *
+ * 每个阶段使用 0.1ms 粒度、上限 100ms 的直方图统计分位数，记录一帧为
+ * O(1) 且不分配内存。时间戳缺失或倒序的阶段不计入样本。
+ *
+ * @note 非线程安全，每个消费者线程应使用独立实例
+ */
+class LatencyTracker {
+public:
+  LatencyTracker();
+
+  /**
+   * @brief 记录一帧
+   * @param timeline 该帧各阶段时间戳
+   */
+  void record(const FrameTimeline &timeline);
+
+  /**
+   * @brief 获取自上次 reset() 以来的统计报告
+   */
+  LatencyReport get_report() const;
+
+  /**
+   * @brief 清空统计
+   */
+  void reset();
+
+  /**
+   * @brief 将报告格式化为单行文本，便于日志输出
+   */
+  static std::string format(const LatencyReport &report);
+
+private:
+  static constexpr size_t BUCKET_COUNT = 1000; ///< 直方图桶数
+  static constexpr uint64_t BUCKET_US = 100;   ///< 桶宽（微秒）
+
+  /**
+   * @brief 单个阶段的累计数据
+   */
+  struct Stage {
+    uint64_t count = 0;                          ///< 样本数
+    uint64_t sum_us = 0;                         ///< 总和
+    uint64_t max_us = 0;                         ///< 最大值
+    std::array<uint32_t, BUCKET_COUNT + 1> buckets{}; ///< 直方图，最后一桶为溢出
+  };
+
+  /**
+   * @brief 记录一个阶段的耗时，任一端时间戳未知或倒序时忽略
+   */
+  static void add(Stage &stage, uint64_t begin_us, uint64_t end_us);
+
+  /**
+   * @brief 由累计数据计算统计结果
+   */
+  static LatencyStageStats summarize(const Stage &stage);
+
+  Stage capture_to_dequeue_; ///< 采集 -> 出队
+  Stage dequeue_to_commit_;  ///< 出队 -> 提交
+  Stage commit_to_acquire_;  ///< 提交 -> 获取
+  Stage acquire_to_decoded_; ///< 获取 -> 解码完成
+  Stage total_;              ///< 采集 -> 解码完成
+};
+
+#endif // LATENCY_TRACKER_H
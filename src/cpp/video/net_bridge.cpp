@@ -0,0 +1,852 @@
+/**
+ * @file net_bridge.cpp
+ * @brief 共享内存图像流网络桥接实现
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ */
+
+#include "net_bridge.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <linux/errqueue.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdexcept>
+#include <unistd.h>
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
+
+static constexpr size_t MAX_IOVECS = 1024;    ///< 单条消息的 iovec 上限 (UIO_MAXIOV)
+static constexpr size_t MAX_MESSAGES = 1024;  ///< 单次 sendmmsg 的消息上限
+static constexpr int SEND_TIMEOUT_S = 5;      ///< TCP 发送超时，超时视为对端卡死
+static constexpr int RECEIVE_STALL_LIMIT = 5; ///< 记录中途连续 1 秒无数据的次数上限
+static constexpr size_t RECEIVE_BATCH = 32;   ///< 单次 recvmmsg 的数据报数
+static constexpr size_t RECORDS_PER_RECEIVE = 64; ///< 单次 receive() 处理的 TCP 记录上限
+
+// ==================== 发送端 ====================
+
+NetBridgeSender::NetBridgeSender(int socket_fd, BridgeTransport transport,
+                                 const NetBridgeOptions &options)
+    : fd_(socket_fd), transport_(transport), options_(options),
+      zerocopy_(false), next_sequence_(0), session_(0), next_datagram_(0),
+      next_zerocopy_id_(0), completed_zerocopy_id_(0) {
+  options_.max_batch_frames = std::max(options_.max_batch_frames, 1u);
+  options_.max_datagram_bytes =
+      std::min(std::max<size_t>(options_.max_datagram_bytes, 256),
+               BRIDGE_MAX_DATAGRAM);
+  int one = 1;
+  if (transport_ == BridgeTransport::Tcp) {
+    setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    struct timeval timeout = {SEND_TIMEOUT_S, 0};
+    setsockopt(fd_, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    if (options_.zerocopy) {
+      zerocopy_ =
+          setsockopt(fd_, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0;
+      if (!zerocopy_)
+        std::cerr << "NetBridgeSender: MSG_ZEROCOPY unavailable ("
+                  << strerror(errno) << "), using copying sends"
+                  << std::endl;
+    }
+  } else {
+    session_ = static_cast<uint32_t>(monotonic_now_us() ^
+                                     (static_cast<uint64_t>(getpid()) << 20));
+    if (options_.zerocopy)
+      std::cerr << "NetBridgeSender: MSG_ZEROCOPY is only used for TCP"
+                << std::endl;
+  }
+}
+
+NetBridgeSender::~NetBridgeSender() {
+  drain(1000);
+  close(fd_);
+}
+
+void NetBridgeSender::drain(int timeout_ms) {
+  // 内核可能仍在引用保留槽位的页，尽量等到完成通知再释放守卫
+  for (int waited = 0; waited < timeout_ms && !pending_.empty(); waited += 100)
+    reap_completions(100);
+  pending_.clear();
+}
+
+void NetBridgeSender::fill_header(const ReadImageGuard &image,
+                                  uint64_t now_us, BridgeFrameHeader *out) {
+  const ImageHeader &header = image.header();
+  std::memset(out, 0, sizeof(*out));
+  out->magic = BridgeFrameHeader::MAGIC;
+  out->version = BridgeFrameHeader::VERSION;
+  out->header_size = sizeof(BridgeFrameHeader);
+  out->payload_size = static_cast<uint32_t>(image.data_size());
+  out->width = header.width;
+  out->height = header.height;
+  out->channels = header.channels;
+  out->format = static_cast<uint8_t>(header.format);
+  out->frame_type = header.frame_type;
+  out->plane_stride = header.planes.strides[0] <= UINT16_MAX
+                          ? static_cast<uint16_t>(header.planes.strides[0])
+                          : 0;
+  out->plane1_offset = header.planes.offsets[1];
+  out->frame_version = image.frame_version();
+  out->sequence = next_sequence_++;
+  out->capture_age_us = now_us > header.capture_timestamp_us
+                            ? now_us - header.capture_timestamp_us
+                            : 0;
+  out->dequeue_age_us =
+      header.dequeue_timestamp_us && now_us > header.dequeue_timestamp_us
+          ? now_us - header.dequeue_timestamp_us
+          : 0;
+}
+
+bool NetBridgeSender::send(std::vector<ReadImageGuard> &frames) {
+  if (frames.empty())
+    return true;
+  reap_completions(0);
+  uint64_t now_us = monotonic_now_us();
+  bool ok = transport_ == BridgeTransport::Tcp
+                ? send_stream(frames, now_us)
+                : send_datagrams(frames, now_us);
+  frames.clear();
+  return ok;
+}
+
+bool NetBridgeSender::send_stream(std::vector<ReadImageGuard> &frames,
+                                  uint64_t now_us) {
+  size_t payload = 0;
+  for (const ReadImageGuard &image : frames)
+    payload += image.data_size();
+  bool zerocopy = zerocopy_ && payload >= options_.zerocopy_min_bytes;
+  if (zerocopy) {
+    // 保留的槽位过多时先等待完成通知，避免生产者无槽位可写
+    size_t limit =
+        std::max<size_t>(options_.max_inflight_frames, frames.size());
+    for (int waited = 0; !pending_.empty() &&
+                         pending_frames() + frames.size() > limit;
+         ++waited) {
+      if (waited == 10) {
+        std::cerr << "NetBridgeSender: Zero-copy completions overdue, "
+                     "releasing held slots"
+                  << std::endl;
+        pending_.clear();
+        break;
+      }
+      reap_completions(100);
+    }
+  }
+
+  frame_headers_.resize(frames.size());
+  iovecs_.clear();
+  for (size_t i = 0; i < frames.size(); ++i) {
+    fill_header(frames[i], now_us, &frame_headers_[i]);
+    iovecs_.push_back({&frame_headers_[i], sizeof(BridgeFrameHeader)});
+    if (frames[i].data_size())
+      iovecs_.push_back({const_cast<uint8_t *>(frames[i].data()),
+                         frames[i].data_size()});
+  }
+
+  bool ok = true;
+  uint32_t zerocopy_calls = 0;
+  size_t first = 0;
+  while (first < iovecs_.size()) {
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iovecs_[first];
+    msg.msg_iovlen = std::min(iovecs_.size() - first, MAX_IOVECS);
+    ssize_t sent =
+        sendmsg(fd_, &msg, MSG_NOSIGNAL | (zerocopy ? MSG_ZEROCOPY : 0));
+    if (sent < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno == ENOBUFS && zerocopy) {
+        // 锁页配额 (optmem) 用尽：本批剩余部分改为拷贝发送
+        zerocopy = false;
+        continue;
+      }
+      std::cerr << "NetBridgeSender: sendmsg failed: "
+                << (errno == EAGAIN ? "peer stalled" : strerror(errno))
+                << std::endl;
+      ok = false;
+      break;
+    }
+    ++stats_.send_calls;
+    if (zerocopy) {
+      ++zerocopy_calls;
+      ++stats_.zerocopy_sends;
+    }
+    // 部分写：跳过已发送的 iovec，调整第一个未发完的 iovec
+    size_t remaining = static_cast<size_t>(sent);
+    while (first < iovecs_.size() && remaining >= iovecs_[first].iov_len)
+      remaining -= iovecs_[first++].iov_len;
+    if (remaining) {
+      iovecs_[first].iov_base =
+          static_cast<uint8_t *>(iovecs_[first].iov_base) + remaining;
+      iovecs_[first].iov_len -= remaining;
+    }
+  }
+
+  if (zerocopy_calls) {
+    // 每次成功的 MSG_ZEROCOPY 发送占用一个通知序号，本批守卫保留到最后一个完成
+    next_zerocopy_id_ += zerocopy_calls;
+    pending_.push_back({next_zerocopy_id_ - 1, std::move(frames)});
+  }
+  if (ok) {
+    stats_.frames_sent += frame_headers_.size();
+    stats_.bytes_sent += payload;
+  }
+  return ok;
+}
+
+bool NetBridgeSender::send_datagrams(std::vector<ReadImageGuard> &frames,
+                                     uint64_t now_us) {
+  const size_t space =
+      options_.max_datagram_bytes - sizeof(BridgeDatagramHeader);
+  // 每个记录占两个 iovec，打包的记录数受单条消息 iovec 上限约束
+  const uint16_t max_records = (MAX_IOVECS - 1) / 2;
+
+  // 预先确定数据报数上限并预留空间，构造过程中的指针保持有效
+  size_t max_datagrams = 0;
+  for (const ReadImageGuard &image : frames) {
+    size_t record = sizeof(BridgeFrameHeader) + image.data_size();
+    max_datagrams += (record + space - 1) / space;
+  }
+  frame_headers_.resize(frames.size());
+  datagram_headers_.clear();
+  datagram_headers_.reserve(max_datagrams);
+  iovecs_.clear();
+  iovecs_.reserve(max_datagrams * 3 + frames.size() * 2);
+  messages_.clear();
+  messages_.reserve(max_datagrams);
+
+  auto begin_datagram = [&](uint32_t record_sequence) {
+    datagram_headers_.emplace_back();
+    BridgeDatagramHeader &header = datagram_headers_.back();
+    std::memset(&header, 0, sizeof(header));
+    header.magic = BridgeDatagramHeader::MAGIC;
+    header.version = BridgeFrameHeader::VERSION;
+    header.header_size = sizeof(BridgeDatagramHeader);
+    header.session = session_;
+    header.sequence = next_datagram_++;
+    header.record_sequence = record_sequence;
+    struct mmsghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_hdr.msg_iov = iovecs_.data() + iovecs_.size();
+    messages_.push_back(message);
+    iovecs_.push_back({&header, sizeof(header)});
+    return &header;
+  };
+  auto end_datagram = [&]() {
+    struct msghdr &msg = messages_.back().msg_hdr;
+    msg.msg_iovlen = static_cast<size_t>(iovecs_.data() + iovecs_.size() -
+                                         msg.msg_iov);
+  };
+
+  BridgeDatagramHeader *packing = nullptr; // 正在打包小帧的数据报
+  size_t packed_bytes = 0;
+  size_t payload = 0, sent_frames = 0;
+  for (size_t i = 0; i < frames.size(); ++i) {
+    BridgeFrameHeader &header = frame_headers_[i];
+    fill_header(frames[i], now_us, &header);
+    uint8_t *data = const_cast<uint8_t *>(frames[i].data());
+    size_t size = frames[i].data_size();
+    size_t record = sizeof(BridgeFrameHeader) + size;
+
+    if (record <= space) {
+      // 小帧：完整记录追加到当前数据报，放不下时另起一个
+      if (packing &&
+          (packed_bytes + record > space || packing->record_count >= max_records)) {
+        end_datagram();
+        packing = nullptr;
+      }
+      if (!packing) {
+        packing = begin_datagram(static_cast<uint32_t>(header.sequence));
+        packed_bytes = 0;
+      }
+      ++packing->record_count;
+      iovecs_.push_back({&header, sizeof(header)});
+      if (size)
+        iovecs_.push_back({data, size});
+      packed_bytes += record;
+    } else {
+      // 大帧：切成分片，分片可能跨越记录头与负载的边界
+      if (packing) {
+        end_datagram();
+        packing = nullptr;
+      }
+      size_t count = (record + space - 1) / space;
+      if (count > UINT16_MAX || record > UINT32_MAX) {
+        ++stats_.frames_rejected;
+        continue;
+      }
+      for (size_t k = 0; k < count; ++k) {
+        size_t offset = k * space;
+        size_t length = std::min(space, record - offset);
+        BridgeDatagramHeader *fragment =
+            begin_datagram(static_cast<uint32_t>(header.sequence));
+        fragment->fragment_count = static_cast<uint16_t>(count);
+        fragment->fragment_index = static_cast<uint16_t>(k);
+        fragment->fragment_offset = static_cast<uint32_t>(offset);
+        fragment->record_size = static_cast<uint32_t>(record);
+        if (offset < sizeof(header)) {
+          size_t head = std::min(length, sizeof(header) - offset);
+          iovecs_.push_back({reinterpret_cast<uint8_t *>(&header) + offset,
+                             head});
+          if (length > head)
+            iovecs_.push_back({data, length - head});
+        } else {
+          iovecs_.push_back({data + offset - sizeof(header), length});
+        }
+        end_datagram();
+      }
+    }
+    payload += size;
+    ++sent_frames;
+  }
+  if (packing)
+    end_datagram();
+
+  size_t done = 0;
+  while (done < messages_.size()) {
+    unsigned int count =
+        static_cast<unsigned int>(std::min(messages_.size() - done, MAX_MESSAGES));
+    int sent = sendmmsg(fd_, &messages_[done], count, 0);
+    if (sent < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno == EBADF || errno == ENOTSOCK || errno == EDESTADDRREQ) {
+        std::cerr << "NetBridgeSender: sendmmsg failed: " << strerror(errno)
+                  << std::endl;
+        return false;
+      }
+      // 瞬时错误（ENOBUFS、ECONNREFUSED 等）只丢弃当前数据报
+      ++stats_.send_errors;
+      ++done;
+      continue;
+    }
+    ++stats_.send_calls;
+    stats_.datagrams_sent += static_cast<uint64_t>(sent);
+    done += static_cast<size_t>(sent);
+  }
+  stats_.frames_sent += sent_frames;
+  stats_.bytes_sent += payload;
+  return true;
+}
+
+void NetBridgeSender::reap_completions(int timeout_ms) {
+  if (pending_.empty())
+    return;
+  if (timeout_ms > 0) {
+    // 错误队列非空时 poll 报告 POLLERR
+    struct pollfd pfd = {fd_, 0, 0};
+    poll(&pfd, 1, timeout_ms);
+  }
+  for (;;) {
+    char control[128];
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (recvmsg(fd_, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1)
+      break;
+    for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm;
+         cm = CMSG_NXTHDR(&msg, cm)) {
+      if (!(cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) &&
+          !(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))
+        continue;
+      struct sock_extended_err err;
+      std::memcpy(&err, CMSG_DATA(cm), sizeof(err));
+      if (err.ee_errno != 0 || err.ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+        continue;
+      // [ee_info, ee_data] 为一段已完成的通知序号
+      if (err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+        stats_.zerocopy_copied += err.ee_data - err.ee_info + 1;
+      early_completions_.emplace_back(err.ee_info, err.ee_data);
+    }
+  }
+
+  // 合并从 completed_zerocopy_id_ 开始连续的完成区间
+  for (bool merged = true; merged;) {
+    merged = false;
+    for (auto it = early_completions_.begin(); it != early_completions_.end();
+         ++it) {
+      if (static_cast<int32_t>(it->first - completed_zerocopy_id_) > 0)
+        continue;
+      if (static_cast<int32_t>(it->second + 1 - completed_zerocopy_id_) > 0)
+        completed_zerocopy_id_ = it->second + 1;
+      early_completions_.erase(it);
+      merged = true;
+      break;
+    }
+  }
+  while (!pending_.empty() &&
+         static_cast<int32_t>(pending_.front().last_id -
+                              completed_zerocopy_id_) < 0)
+    pending_.pop_front();
+}
+
+size_t NetBridgeSender::pending_frames() const {
+  size_t count = 0;
+  for (const PendingSend &send : pending_)
+    count += send.frames.size();
+  return count;
+}
+
+// ==================== 接收端 ====================
+
+NetBridgeReceiver::NetBridgeReceiver(int socket_fd, BridgeTransport transport,
+                                     ImageShmManager *output)
+    : fd_(socket_fd), transport_(transport), output_(output),
+      next_frame_version_(1), expected_sequence_(0), have_sequence_(false),
+      session_(0), expected_datagram_(0), have_session_(false) {
+  if (transport_ == BridgeTransport::Tcp) {
+    // 记录中途的等待以 1 秒为单位，连续 RECEIVE_STALL_LIMIT 次无数据视为断开
+    struct timeval timeout = {1, 0};
+    setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return;
+  }
+  datagrams_.assign(RECEIVE_BATCH, std::vector<uint8_t>(BRIDGE_MAX_DATAGRAM));
+  iovecs_.resize(RECEIVE_BATCH);
+  messages_.resize(RECEIVE_BATCH);
+  for (size_t i = 0; i < RECEIVE_BATCH; ++i) {
+    iovecs_[i] = {datagrams_[i].data(), datagrams_[i].size()};
+    std::memset(&messages_[i], 0, sizeof(messages_[i]));
+    messages_[i].msg_hdr.msg_iov = &iovecs_[i];
+    messages_[i].msg_hdr.msg_iovlen = 1;
+  }
+}
+
+NetBridgeReceiver::~NetBridgeReceiver() {
+  partial_.slot.reset();
+  close(fd_);
+}
+
+bool NetBridgeReceiver::receive(int timeout_ms) {
+  struct pollfd pfd = {fd_, POLLIN, 0};
+  int ready = poll(&pfd, 1, timeout_ms);
+  if (ready < 0)
+    return errno == EINTR;
+  if (ready == 0)
+    return true;
+
+  if (transport_ == BridgeTransport::Tcp) {
+    // 一次唤醒处理已到达的多条记录，同时保证调用者能定期检查退出标志
+    for (size_t i = 0; i < RECORDS_PER_RECEIVE; ++i) {
+      if (!receive_record())
+        return false;
+      if (poll(&pfd, 1, 0) <= 0)
+        break;
+    }
+    return true;
+  }
+
+  for (;;) {
+    int count = recvmmsg(fd_, messages_.data(),
+                         static_cast<unsigned int>(messages_.size()),
+                         MSG_DONTWAIT, nullptr);
+    if (count < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+        return true;
+      std::cerr << "NetBridgeReceiver: recvmmsg failed: " << strerror(errno)
+                << std::endl;
+      return false;
+    }
+    for (int i = 0; i < count; ++i)
+      handle_datagram(datagrams_[i].data(), messages_[i].msg_len);
+    if (static_cast<size_t>(count) < messages_.size())
+      return true;
+  }
+}
+
+bool NetBridgeReceiver::read_exact(void *buffer, size_t size) {
+  uint8_t *out = static_cast<uint8_t *>(buffer);
+  int stalls = 0;
+  while (size) {
+    ssize_t received = recv(fd_, out, size, MSG_WAITALL);
+    if (received > 0) {
+      out += received;
+      size -= static_cast<size_t>(received);
+      stalls = 0;
+      continue;
+    }
+    if (received == 0)
+      return false; // 对端关闭连接
+    if (errno == EINTR)
+      continue;
+    if ((errno == EAGAIN || errno == EWOULDBLOCK) &&
+        ++stalls < RECEIVE_STALL_LIMIT)
+      continue;
+    return false;
+  }
+  return true;
+}
+
+bool NetBridgeReceiver::receive_record() {
+  BridgeFrameHeader header;
+  if (!read_exact(&header, sizeof(header)))
+    return false;
+  if (!valid_header(header)) {
+    std::cerr << "NetBridgeReceiver: Invalid frame header, closing connection"
+              << std::endl;
+    return false;
+  }
+  // 更新版本的发送端可能扩展记录头，跳过未知部分
+  if (header.header_size > sizeof(header)) {
+    scratch_.resize(header.header_size - sizeof(header));
+    if (!read_exact(scratch_.data(), scratch_.size()))
+      return false;
+  }
+  track_sequence(static_cast<uint32_t>(header.sequence));
+
+  // 负载直接读入共享内存槽位
+  WriteImageGuard slot = output_->acquire_image_for_write(header.payload_size);
+  if (slot.is_valid() && slot.capacity() >= header.payload_size) {
+    if (!read_exact(slot.data(), header.payload_size))
+      return false;
+    commit(slot, header);
+    return true;
+  }
+
+  // 无可写槽位或超过槽位容量：读出并丢弃负载，保持流同步
+  ++stats_.frames_dropped;
+  scratch_.resize(std::min<size_t>(header.payload_size, 1 << 20));
+  for (size_t remaining = header.payload_size; remaining;) {
+    size_t chunk = std::min(remaining, scratch_.size());
+    if (!read_exact(scratch_.data(), chunk))
+      return false;
+    remaining -= chunk;
+  }
+  return true;
+}
+
+void NetBridgeReceiver::handle_datagram(const uint8_t *data, size_t size) {
+  BridgeDatagramHeader header;
+  if (size < sizeof(header)) {
+    ++stats_.datagrams_invalid;
+    return;
+  }
+  std::memcpy(&header, data, sizeof(header));
+  if (header.magic != BridgeDatagramHeader::MAGIC ||
+      header.version != BridgeFrameHeader::VERSION ||
+      header.header_size < sizeof(header) || header.header_size > size) {
+    ++stats_.datagrams_invalid;
+    return;
+  }
+  ++stats_.datagrams_received;
+
+  if (!have_session_ || header.session != session_) {
+    // 发送端重启：放弃重组中的帧，序号重新计数
+    if (have_session_)
+      std::cout << "NetBridgeReceiver: Sender restarted" << std::endl;
+    if (partial_.active && partial_.slot)
+      ++stats_.frames_dropped;
+    partial_.active = false;
+    partial_.slot.reset();
+    session_ = header.session;
+    have_session_ = true;
+    have_sequence_ = false;
+    expected_datagram_ = header.sequence;
+  }
+  int32_t gap = static_cast<int32_t>(header.sequence - expected_datagram_);
+  if (gap > 0)
+    stats_.datagrams_lost += static_cast<uint64_t>(gap);
+  if (gap >= 0)
+    expected_datagram_ = header.sequence + 1;
+
+  data += header.header_size;
+  size -= header.header_size;
+  if (header.fragment_count > 1) {
+    handle_fragment(header, data, size);
+    return;
+  }
+
+  for (uint16_t i = 0; i < header.record_count; ++i) {
+    BridgeFrameHeader record;
+    if (size < sizeof(record)) {
+      ++stats_.datagrams_invalid;
+      return;
+    }
+    std::memcpy(&record, data, sizeof(record));
+    if (!valid_header(record) ||
+        record.header_size + static_cast<size_t>(record.payload_size) > size) {
+      ++stats_.datagrams_invalid;
+      return;
+    }
+    track_sequence(static_cast<uint32_t>(record.sequence));
+    WriteImageGuard slot =
+        output_->acquire_image_for_write(record.payload_size);
+    if (slot.is_valid() && slot.capacity() >= record.payload_size) {
+      std::memcpy(slot.data(), data + record.header_size, record.payload_size);
+      commit(slot, record);
+    } else {
+      ++stats_.frames_dropped;
+    }
+    data += record.header_size + record.payload_size;
+    size -= record.header_size + record.payload_size;
+  }
+}
+
+void NetBridgeReceiver::handle_fragment(const BridgeDatagramHeader &header,
+                                        const uint8_t *data, size_t size) {
+  const size_t header_size = sizeof(BridgeFrameHeader);
+  if (header.record_size < header_size ||
+      header.fragment_index >= header.fragment_count ||
+      header.fragment_offset + static_cast<uint64_t>(size) >
+          header.record_size) {
+    ++stats_.datagrams_invalid;
+    return;
+  }
+
+  PartialFrame &partial = partial_;
+  if (!partial.active || partial.record_sequence != header.record_sequence) {
+    if (partial.active) {
+      // 上一帧的迟到分片直接忽略；新帧开始时上一帧仍未收齐则整帧丢弃
+      if (static_cast<int32_t>(header.record_sequence -
+                               partial.record_sequence) < 0)
+        return;
+      if (partial.slot)
+        ++stats_.frames_dropped;
+      partial.slot.reset();
+    } else if (have_sequence_ &&
+               static_cast<int32_t>(header.record_sequence -
+                                    expected_sequence_) < 0) {
+      return; // 已完成或已丢弃帧的迟到分片
+    }
+    track_sequence(header.record_sequence);
+    partial.active = true;
+    partial.session = header.session;
+    partial.record_sequence = header.record_sequence;
+    partial.record_size = header.record_size;
+    partial.fragments_received = 0;
+    partial.received.assign(header.fragment_count, 0);
+    size_t payload = header.record_size - header_size;
+    partial.slot.reset(
+        new WriteImageGuard(output_->acquire_image_for_write(payload)));
+    if (!partial.slot->is_valid() || partial.slot->capacity() < payload) {
+      // 无可写槽位：继续接收该帧的分片但不写入
+      ++stats_.frames_dropped;
+      partial.slot.reset();
+    }
+  }
+  if (header.record_size != partial.record_size ||
+      header.fragment_count != partial.received.size() ||
+      partial.received[header.fragment_index])
+    return; // 不一致或重复的分片
+  partial.received[header.fragment_index] = 1;
+  ++partial.fragments_received;
+
+  // 记录头部分写入本地，其余直接写入槽位
+  size_t offset = header.fragment_offset;
+  if (offset < header_size) {
+    size_t head = std::min(size, header_size - offset);
+    std::memcpy(reinterpret_cast<uint8_t *>(&partial.header) + offset, data,
+                head);
+    offset += head;
+    data += head;
+    size -= head;
+  }
+  if (partial.slot && size)
+    std::memcpy(partial.slot->data() + (offset - header_size), data, size);
+
+  if (partial.fragments_received < partial.received.size())
+    return;
+  partial.active = false;
+  if (partial.slot) {
+    if (valid_header(partial.header) &&
+        partial.header.header_size == header_size &&
+        partial.header.payload_size == partial.record_size - header_size) {
+      commit(*partial.slot, partial.header);
+    } else {
+      ++stats_.datagrams_invalid;
+      ++stats_.frames_dropped;
+    }
+    partial.slot.reset();
+  }
+}
+
+bool NetBridgeReceiver::valid_header(const BridgeFrameHeader &header) {
+  return header.magic == BridgeFrameHeader::MAGIC &&
+         header.version == BridgeFrameHeader::VERSION &&
+         header.header_size >= sizeof(BridgeFrameHeader) &&
+         header.format <= static_cast<uint8_t>(ImageFormat::NV16);
+}
+
+void NetBridgeReceiver::track_sequence(uint32_t sequence) {
+  if (have_sequence_) {
+    int32_t gap = static_cast<int32_t>(sequence - expected_sequence_);
+    if (gap > 0)
+      stats_.frames_missed += static_cast<uint64_t>(gap);
+  }
+  // 序号回退表示发送端重新开始计数，从新序号继续统计
+  expected_sequence_ = sequence + 1;
+  have_sequence_ = true;
+}
+
+void NetBridgeReceiver::commit(WriteImageGuard &slot,
+                               const BridgeFrameHeader &header) {
+  // 发送端给出的是距发送时刻的时长，换算到本地 CLOCK_MONOTONIC
+  uint64_t now_us = monotonic_now_us();
+  uint64_t capture_us =
+      header.capture_age_us < now_us ? now_us - header.capture_age_us : now_us;
+  uint64_t dequeue_us =
+      header.dequeue_age_us && header.dequeue_age_us < now_us
+          ? now_us - header.dequeue_age_us
+          : 0;
+  ImagePlaneLayout planes{};
+  planes.strides[0] = header.plane_stride;
+  planes.offsets[1] = header.plane1_offset;
+  const ImageFormat format = static_cast<ImageFormat>(header.format);
+  if (format == ImageFormat::NV12 || format == ImageFormat::NV16)
+    planes.strides[1] = header.plane_stride;
+  ShmStatus status = slot.commit(
+      header.payload_size, header.width, header.height, header.channels,
+      next_frame_version_++, format, header.frame_type, capture_us,
+      dequeue_us, planes);
+  if (status == ShmStatus::Success) {
+    ++stats_.frames_received;
+    stats_.bytes_received += header.payload_size;
+  } else {
+    ++stats_.frames_dropped;
+  }
+}
+
+// ==================== 套接字工具 ====================
+
+/**
+ * @brief 解析 IPv4 地址
+ * @throws std::runtime_error 无法解析时抛出异常
+ */
+static struct sockaddr_in resolve_ipv4(const std::string &host,
+                                       uint16_t port) {
+  struct addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  struct addrinfo *result = nullptr;
+  int ret = getaddrinfo(host.c_str(), nullptr, &hints, &result);
+  if (ret != 0 || !result)
+    throw std::runtime_error("NetBridge: Cannot resolve '" + host +
+                             "': " + gai_strerror(ret));
+  struct sockaddr_in addr;
+  std::memcpy(&addr, result->ai_addr, sizeof(addr));
+  freeaddrinfo(result);
+  addr.sin_port = htons(port);
+  return addr;
+}
+
+/**
+ * @brief 关闭套接字并抛出带 errno 描述的异常
+ */
+[[noreturn]] static void fail_socket(int fd, const std::string &what) {
+  std::string reason = strerror(errno);
+  if (fd != -1)
+    close(fd);
+  throw std::runtime_error("NetBridge: " + what + ": " + reason);
+}
+
+int bridge_listen_tcp(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd == -1)
+    fail_socket(fd, "socket failed");
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  struct sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == -1)
+    fail_socket(fd, "Cannot bind TCP port " + std::to_string(port));
+  if (listen(fd, 8) == -1)
+    fail_socket(fd, "listen failed");
+  return fd;
+}
+
+int bridge_connect_tcp(const std::string &host, uint16_t port) {
+  struct sockaddr_in addr = resolve_ipv4(host, port);
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd == -1)
+    fail_socket(fd, "socket failed");
+  if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) ==
+      -1) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int bridge_open_udp_sender(const std::string &group, uint16_t port, int ttl,
+                           const std::string &interface) {
+  struct sockaddr_in addr = resolve_ipv4(group, port);
+  struct in_addr local;
+  local.s_addr = interface.empty() ? htonl(INADDR_ANY)
+                                   : resolve_ipv4(interface, 0).sin_addr.s_addr;
+  int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  if (fd == -1)
+    fail_socket(fd, "socket failed");
+  // 较大的发送缓冲减少整批 sendmmsg 时的阻塞（受 wmem_max 限制）
+  int buffer = 4 << 20;
+  setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &buffer, sizeof(buffer));
+  if (IN_MULTICAST(ntohl(addr.sin_addr.s_addr))) {
+    int loop = 1;
+    if (setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) ==
+            -1 ||
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) ==
+            -1)
+      fail_socket(fd, "Cannot configure multicast");
+    if (!interface.empty()) {
+      if (setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &local,
+                     sizeof(local)) == -1)
+        fail_socket(fd, "Cannot select multicast interface " + interface);
+    }
+  }
+  if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) ==
+      -1)
+    fail_socket(fd, "Cannot connect UDP socket to " + group);
+  return fd;
+}
+
+int bridge_open_udp_receiver(const std::string &group, uint16_t port,
+                             const std::string &interface) {
+  struct sockaddr_in group_addr = resolve_ipv4(group, port);
+  struct in_addr local;
+  local.s_addr = interface.empty() ? htonl(INADDR_ANY)
+                                   : resolve_ipv4(interface, 0).sin_addr.s_addr;
+  int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  if (fd == -1)
+    fail_socket(fd, "socket failed");
+  // 同一主机上的多个接收端可以加入同一组播组
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  // 较大的接收缓冲吸收整批到达的分片（受 rmem_max 限制）
+  int buffer = 8 << 20;
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+  struct sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == -1)
+    fail_socket(fd, "Cannot bind UDP port " + std::to_string(port));
+  if (IN_MULTICAST(ntohl(group_addr.sin_addr.s_addr))) {
+    struct ip_mreq membership;
+    membership.imr_multiaddr = group_addr.sin_addr;
+    membership.imr_interface = local;
+    if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership,
+                   sizeof(membership)) == -1)
+      fail_socket(fd, "Cannot join multicast group " + group);
+  }
+  return fd;
+}
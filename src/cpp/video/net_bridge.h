@@ -0,0 +1,326 @@
+/**
+ * @file net_bridge.h
+ * @brief 共享内存图像流的网络桥接
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 该文件定义了把共享内存中的原始帧发送到其他节点的 NetBridgeSender，
+ * 以及在远端把收到的帧重新发布到本地 ImageShmManager 的 NetBridgeReceiver。
+ * 远端消费者连接本地共享内存，使用与本机完全相同的 API。
+ * 传输格式见 net_bridge_protocol.h。
+ */
+
+#ifndef NET_BRIDGE_H
+#define NET_BRIDGE_H
+
+#include "video/image_shm_manager.h"
+#include "video/net_bridge_protocol.h"
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 传输方式
+ */
+enum class BridgeTransport {
+  Tcp, ///< TCP 字节流，可靠，每个接收端一条连接
+  Udp  ///< UDP（通常为组播），一次发送多端接收，丢包时整帧丢弃
+};
+
+/**
+ * @brief 发送端配置
+ */
+struct NetBridgeOptions {
+  uint32_t max_batch_frames = 32; ///< 单次 sendmsg / sendmmsg 合并的最大帧数
+  bool zerocopy = false;          ///< TCP 下对大批次使用 MSG_ZEROCOPY
+  size_t zerocopy_min_bytes = 32 * 1024; ///< 批次负载不小于该值时才使用 MSG_ZEROCOPY
+  uint32_t max_inflight_frames = 2; ///< 等待 MSG_ZEROCOPY 完成通知而保留的最大帧（槽位）数
+  size_t max_datagram_bytes = 1472; ///< UDP 数据报大小上限（默认按 1500 MTU 计算）
+};
+
+/**
+ * @brief 发送统计信息
+ */
+struct NetBridgeSenderStats {
+  uint64_t frames_sent = 0;      ///< 已发送帧数
+  uint64_t bytes_sent = 0;       ///< 已发送负载字节数
+  uint64_t send_calls = 0;       ///< sendmsg / sendmmsg 调用次数
+  uint64_t datagrams_sent = 0;   ///< 已发送 UDP 数据报数
+  uint64_t frames_rejected = 0;  ///< 分片数超过上限而未发送的帧数
+  uint64_t send_errors = 0;      ///< UDP 发送失败的数据报数
+  uint64_t zerocopy_sends = 0;   ///< 使用 MSG_ZEROCOPY 的 sendmsg 次数
+  uint64_t zerocopy_copied = 0;  ///< 内核回退为拷贝的 MSG_ZEROCOPY 发送次数
+};
+
+/**
+ * @brief 网络桥接发送端
+ *
+ * 帧负载以 iovec 直接指向共享内存槽位，与记录头一起 scatter-gather 发送，
+ * 用户态没有任何拷贝：
+ * - TCP：一批帧合并为一次 sendmsg；开启 zerocopy 时使用 MSG_ZEROCOPY，
+ *   内核直接从槽位页 DMA，读守卫保留到错误队列上的完成通知到达后才释放
+ *   （最多 max_inflight_frames 帧，超过时等待完成通知）
+ * - UDP：小帧的完整记录打包进同一数据报，大帧切成分片，整批数据报
+ *   一次 sendmmsg 发出
+ *
+ * @note 非线程安全，每个套接字由单个发送线程使用
+ */
+class NetBridgeSender {
+public:
+  /**
+   * @brief 构造函数
+   * @param socket_fd 已连接的套接字（UDP 须已 connect 到目标地址），所有权转移给发送端
+   * @param transport 传输方式
+   * @param options 发送端配置
+   */
+  NetBridgeSender(int socket_fd, BridgeTransport transport,
+                  const NetBridgeOptions &options);
+
+  /**
+   * @brief 析构函数，等待未完成的零拷贝发送后关闭套接字
+   */
+  ~NetBridgeSender();
+
+  NetBridgeSender(const NetBridgeSender &) = delete;
+  NetBridgeSender &operator=(const NetBridgeSender &) = delete;
+
+  /**
+   * @brief 发送一批帧
+   * @param frames 按帧版本升序排列的读守卫，返回时被清空（零拷贝发送的守卫
+   *               转入内部保留，完成通知到达后释放）
+   * @return bool false 表示连接已断开或发生不可恢复的发送错误
+   */
+  bool send(std::vector<ReadImageGuard> &frames);
+
+  /**
+   * @brief 等待全部零拷贝发送完成并释放保留的守卫
+   * @param timeout_ms 最长等待时间（毫秒），超时后直接释放
+   *
+   * 共享内存重新附加（reconnect）前必须调用，保留的守卫属于旧映射。
+   */
+  void drain(int timeout_ms);
+
+  /**
+   * @brief 获取统计信息
+   */
+  const NetBridgeSenderStats &get_stats() const { return stats_; }
+
+  /**
+   * @brief 是否实际启用了 MSG_ZEROCOPY（内核不支持时自动关闭）
+   */
+  bool zerocopy_enabled() const { return zerocopy_; }
+
+private:
+  /**
+   * @brief 等待零拷贝完成通知的一组帧
+   */
+  struct PendingSend {
+    uint32_t last_id;                   ///< 该批次最后一次 sendmsg 的通知序号
+    std::vector<ReadImageGuard> frames; ///< 保留的读守卫
+  };
+
+  /**
+   * @brief 填写帧记录头
+   */
+  void fill_header(const ReadImageGuard &image, uint64_t now_us,
+                   BridgeFrameHeader *out);
+
+  /**
+   * @brief TCP：整批 writev 式发送，处理部分写
+   */
+  bool send_stream(std::vector<ReadImageGuard> &frames, uint64_t now_us);
+
+  /**
+   * @brief UDP：打包/分片后 sendmmsg 发送
+   */
+  bool send_datagrams(std::vector<ReadImageGuard> &frames, uint64_t now_us);
+
+  /**
+   * @brief 读取错误队列上的零拷贝完成通知，释放已完成的守卫
+   * @param timeout_ms 无通知时的等待时间，0 表示不等待
+   */
+  void reap_completions(int timeout_ms);
+
+  /**
+   * @brief 当前保留的帧数
+   */
+  size_t pending_frames() const;
+
+  int fd_;                       ///< 套接字
+  BridgeTransport transport_;    ///< 传输方式
+  NetBridgeOptions options_;     ///< 发送端配置
+  bool zerocopy_;                ///< 是否启用 MSG_ZEROCOPY
+  uint64_t next_sequence_;       ///< 下一帧序号
+  uint32_t session_;             ///< UDP 会话号
+  uint32_t next_datagram_;       ///< 下一个数据报序号
+  uint32_t next_zerocopy_id_;    ///< 下一次零拷贝发送的通知序号
+  uint32_t completed_zerocopy_id_; ///< 最小的未完成通知序号
+  std::vector<std::pair<uint32_t, uint32_t>> early_completions_; ///< 乱序到达的完成区间
+  std::deque<PendingSend> pending_; ///< 等待完成通知的批次
+  std::vector<BridgeFrameHeader> frame_headers_;       ///< 复用的记录头缓冲
+  std::vector<BridgeDatagramHeader> datagram_headers_; ///< 复用的数据报头缓冲
+  std::vector<struct iovec> iovecs_;                   ///< 复用的 iovec 缓冲
+  std::vector<struct mmsghdr> messages_;               ///< 复用的 sendmmsg 消息缓冲
+  NetBridgeSenderStats stats_;   ///< 统计信息
+};
+
+/**
+ * @brief 接收统计信息
+ */
+struct NetBridgeReceiverStats {
+  uint64_t frames_received = 0;   ///< 已重新发布的帧数
+  uint64_t bytes_received = 0;    ///< 已重新发布的负载字节数
+  uint64_t frames_dropped = 0;    ///< 丢弃的帧数（分片丢失、无可写槽位或超过槽位容量）
+  uint64_t frames_missed = 0;     ///< 按帧序号推算的发送端未送达帧数
+  uint64_t datagrams_received = 0; ///< 已接收 UDP 数据报数
+  uint64_t datagrams_lost = 0;    ///< 按数据报序号推算的丢包数
+  uint64_t datagrams_invalid = 0; ///< 格式不合法而丢弃的数据报数
+};
+
+/**
+ * @brief 网络桥接接收端
+ *
+ * 收到的帧以本地递增的帧版本号重新发布到输出共享内存，时间戳按发送端
+ * 给出的时长换算到本地时钟：
+ * - TCP：读出记录头后直接 recv 到共享内存槽位，不经中间缓冲
+ * - UDP：完整记录从数据报拷入槽位；分片直接在槽位中重组，全部到齐后提交
+ *
+ * @note 非线程安全，应由单个接收线程调用
+ */
+class NetBridgeReceiver {
+public:
+  /**
+   * @brief 构造函数
+   * @param socket_fd 已连接的 TCP 套接字或已绑定的 UDP 套接字，所有权转移给接收端
+   * @param transport 传输方式
+   * @param output 输出共享内存（须已 create_and_init）
+   */
+  NetBridgeReceiver(int socket_fd, BridgeTransport transport,
+                    ImageShmManager *output);
+
+  /**
+   * @brief 析构函数，关闭套接字
+   */
+  ~NetBridgeReceiver();
+
+  NetBridgeReceiver(const NetBridgeReceiver &) = delete;
+  NetBridgeReceiver &operator=(const NetBridgeReceiver &) = delete;
+
+  /**
+   * @brief 等待并处理已到达的数据
+   * @param timeout_ms 无数据时的最长等待时间（毫秒）
+   * @return bool false 表示 TCP 连接已断开、对端停止发送或数据流不合法
+   */
+  bool receive(int timeout_ms);
+
+  /**
+   * @brief 获取统计信息
+   */
+  const NetBridgeReceiverStats &get_stats() const { return stats_; }
+
+private:
+  /**
+   * @brief 正在重组的分片帧
+   */
+  struct PartialFrame {
+    bool active = false;         ///< 是否正在重组
+    uint32_t session = 0;        ///< 所属发送端会话
+    uint32_t record_sequence = 0; ///< 帧序号低32位
+    uint32_t record_size = 0;    ///< 记录总字节数
+    uint32_t fragments_received = 0; ///< 已收到的分片数
+    std::vector<uint8_t> received; ///< 各分片是否已收到
+    BridgeFrameHeader header;    ///< 重组出的记录头
+    std::unique_ptr<WriteImageGuard> slot; ///< 负载直接写入的槽位
+  };
+
+  /**
+   * @brief TCP：读取一条完整记录
+   */
+  bool receive_record();
+
+  /**
+   * @brief 从 TCP 流精确读取 size 字节，长时间无数据视为断开
+   */
+  bool read_exact(void *buffer, size_t size);
+
+  /**
+   * @brief UDP：处理一个数据报
+   */
+  void handle_datagram(const uint8_t *data, size_t size);
+
+  /**
+   * @brief UDP：处理一个分片
+   */
+  void handle_fragment(const BridgeDatagramHeader &header,
+                       const uint8_t *data, size_t size);
+
+  /**
+   * @brief 校验记录头
+   */
+  static bool valid_header(const BridgeFrameHeader &header);
+
+  /**
+   * @brief 按帧序号（低32位）统计未送达的帧
+   */
+  void track_sequence(uint32_t sequence);
+
+  /**
+   * @brief 填好负载后提交到输出共享内存
+   */
+  void commit(WriteImageGuard &slot, const BridgeFrameHeader &header);
+
+  int fd_;                       ///< 套接字
+  BridgeTransport transport_;    ///< 传输方式
+  ImageShmManager *output_;      ///< 输出共享内存
+  uint64_t next_frame_version_;  ///< 下一个本地帧版本号
+  uint32_t expected_sequence_;   ///< 期望的下一帧序号（低32位）
+  bool have_sequence_;           ///< 是否已收到过帧
+  uint32_t session_;             ///< 当前 UDP 发送端会话
+  uint32_t expected_datagram_;   ///< 期望的下一个数据报序号
+  bool have_session_;            ///< 是否已收到过数据报
+  PartialFrame partial_;         ///< 正在重组的分片帧
+  std::vector<uint8_t> scratch_; ///< 丢弃超大帧时的读缓冲
+  std::vector<std::vector<uint8_t>> datagrams_; ///< recvmmsg 接收缓冲
+  std::vector<struct iovec> iovecs_;            ///< recvmmsg iovec
+  std::vector<struct mmsghdr> messages_;        ///< recvmmsg 消息
+  NetBridgeReceiverStats stats_; ///< 统计信息
+};
+
+/**
+ * @brief 在 port 上监听 TCP 连接
+ * @throws std::runtime_error 当套接字无法创建、绑定或监听时抛出异常
+ */
+int bridge_listen_tcp(uint16_t port);
+
+/**
+ * @brief 连接到 host:port
+ * @return int 已连接的套接字，连接失败时返回 -1
+ * @throws std::runtime_error 当地址无法解析时抛出异常
+ */
+int bridge_connect_tcp(const std::string &host, uint16_t port);
+
+/**
+ * @brief 创建连接到组播组（或单播地址）group:port 的 UDP 发送套接字
+ * @param ttl 组播 TTL，1 表示只在本网段
+ * @param interface 发送使用的本地接口地址，为空表示由路由决定
+ * @throws std::runtime_error 当地址无法解析或套接字无法创建时抛出异常
+ */
+int bridge_open_udp_sender(const std::string &group, uint16_t port, int ttl,
+                           const std::string &interface);
+
+/**
+ * @brief 创建绑定到 port 并加入组播组 group 的 UDP 接收套接字
+ * @param group 组播地址；单播地址时不加入组
+ * @param interface 加入组播使用的本地接口地址，为空表示任意接口
+ * @throws std::runtime_error 当套接字无法创建、绑定或加入组播组时抛出异常
+ */
+int bridge_open_udp_receiver(const std::string &group, uint16_t port,
+                             const std::string &interface);
+
+#endif // NET_BRIDGE_H
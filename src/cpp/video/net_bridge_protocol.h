@@ -0,0 +1,91 @@
+/**
+ * @file net_bridge_protocol.h
+ * @brief 网络桥接传输格式定义
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 该文件定义了 NetBridgeSender / NetBridgeReceiver 之间的二进制传输格式。
+ * 每帧是一条记录：BridgeFrameHeader 之后紧跟 payload_size 字节的原始负载
+ * （MJPG/YUYV 等，与共享内存槽位中的内容相同）。
+ *
+ * - TCP：字节流上连续的帧记录，多帧合并为一次 sendmsg
+ * - UDP（组播）：每个数据报以 BridgeDatagramHeader 开头。小帧的完整记录
+ *   合并进同一个数据报；超过单个数据报的记录切成分片，接收端直接在共享内存
+ *   槽位中重组，任一分片丢失则整帧丢弃
+ *
+ * 字段按主机字节序传输，桥接两端须为相同字节序（x86 / ARM 小端）。
+ */
+
+#ifndef NET_BRIDGE_PROTOCOL_H
+#define NET_BRIDGE_PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief 帧记录头，紧随其后是 payload_size 字节的原始负载
+ *
+ * 采集/出队时间以“距发送时刻的时长”传输：两端 CLOCK_MONOTONIC 不可比，
+ * 接收端以接收时刻减去该时长重建本地时间戳，消费者的延迟统计仍然有效
+ * （不含网络传输时间）。
+ *
+ * 平面布局（ImageHeader::planes）只传输一个行跨度与第1平面偏移，两个平面
+ * 行跨度不同的帧按第0平面的行跨度重建。旧版本发送端在这两个字段写0，
+ * 等同于紧凑排列。
+ */
+struct BridgeFrameHeader {
+  static constexpr uint32_t MAGIC = 0x424e4353; ///< "SCNB"
+  static constexpr uint16_t VERSION = 1;        ///< 格式版本号
+
+  uint32_t magic;          ///< 魔数，MAGIC
+  uint16_t version;        ///< 格式版本号，VERSION
+  uint16_t header_size;    ///< 记录头大小（字节），负载起始偏移
+  uint32_t payload_size;   ///< 负载字节数
+  uint32_t width;          ///< 图像宽度（像素）
+  uint32_t height;         ///< 图像高度（像素）
+  uint32_t channels;       ///< 颜色通道数
+  uint8_t format;          ///< 图像格式（ImageFormat 的数值）
+  uint8_t frame_type;      ///< 帧类型标志
+  uint16_t plane_stride;   ///< 各平面的行跨度（字节），0 表示紧凑排列
+  uint32_t plane1_offset;  ///< 第1平面（NV12/NV16 的 UV）偏移，0 表示紧跟第0平面
+  uint64_t frame_version;  ///< 发送端共享内存中的帧版本号
+  uint64_t sequence;       ///< 本连接/会话内的帧序号，从0递增
+  uint64_t capture_age_us; ///< 发送时距采集的时长（微秒）
+  uint64_t dequeue_age_us; ///< 发送时距出队的时长（微秒），0 表示未知
+};
+
+/**
+ * @brief UDP 数据报头
+ *
+ * fragment_count <= 1 时数据报内依次是 record_count 条完整的帧记录；
+ * fragment_count > 1 时数据报承载帧记录 record_sequence 的第
+ * fragment_index 个分片，位于记录内 fragment_offset 处，记录总长 record_size。
+ */
+struct BridgeDatagramHeader {
+  static constexpr uint32_t MAGIC = 0x444e4353; ///< "SCND"
+
+  uint32_t magic;           ///< 魔数，MAGIC
+  uint16_t version;         ///< 格式版本号，BridgeFrameHeader::VERSION
+  uint16_t header_size;     ///< 数据报头大小（字节）
+  uint32_t session;         ///< 发送端会话号（随机），变化表示发送端已重启
+  uint32_t sequence;        ///< 数据报序号，用于统计丢包
+  uint32_t record_sequence; ///< 首条（或被分片的）记录的帧序号低32位
+  uint16_t record_count;    ///< 完整记录数（分片时为0）
+  uint16_t fragment_count;  ///< 分片总数，<= 1 表示未分片
+  uint16_t fragment_index;  ///< 分片序号
+  uint16_t reserved0;       ///< 保留，置0
+  uint32_t fragment_offset; ///< 分片在记录内的偏移
+  uint32_t record_size;     ///< 被分片记录的总字节数（含记录头）
+  uint32_t reserved1;       ///< 保留，置0
+};
+
+constexpr uint16_t BRIDGE_DEFAULT_PORT = 7600; ///< 默认端口
+constexpr size_t BRIDGE_MAX_DATAGRAM = 65507;  ///< UDP 数据报负载上限
+
+static_assert(sizeof(BridgeFrameHeader) == 64,
+              "BridgeFrameHeader must stay 64 bytes");
+static_assert(sizeof(BridgeDatagramHeader) == 40,
+              "BridgeDatagramHeader must stay 40 bytes");
+
+#endif // NET_BRIDGE_PROTOCOL_H
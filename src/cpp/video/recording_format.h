@@ -0,0 +1,102 @@
+/**
+ * @file recording_format.h
+ * @brief 录制段文件格式定义
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 该文件定义了 FrameRecorder 写出、回放读取的段文件二进制格式。
+ * 每个段文件由 4 KB 文件头、连续的帧记录（记录头 + 原始负载）和
+ * 固定长度的时间戳索引组成，负载按共享内存中的原样保存（MJPG/YUYV 等），
+ * 不做任何重新编码。
+ *
+ * 录制中的段预分配到 segment_size 字节：帧记录从文件头之后向后追加，
+ * 索引项从文件末尾向前追加（第 i 项位于 file_size - (i + 1) * 16），
+ * 两者相遇时轮换到下一个段。封存时索引按时间升序移到数据区之后并截断文件。
+ * 进程崩溃留下的未封存段仍可通过文件头中的 frame_count 与尾部索引读取。
+ */
+
+#ifndef RECORDING_FORMAT_H
+#define RECORDING_FORMAT_H
+
+#include "video/image_shm_manager.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief 段文件头（位于文件偏移 0，占 RECORDING_HEADER_SIZE 字节）
+ *
+ * data_end / frame_count / finalized 在录制过程中通过 mmap 原地更新，
+ * 读者以 acquire 语义读取后即可访问对应范围内的记录与索引。
+ */
+struct RecordingSegmentHeader {
+  static constexpr uint64_t MAGIC = 0x31434552434d4353ULL; ///< "SCMCREC1"
+  static constexpr uint32_t VERSION = 2;                    ///< 格式版本号
+  static constexpr uint32_t MIN_VERSION = 1;                ///< 读者仍接受的最低版本
+
+  uint64_t magic;               ///< 魔数，MAGIC
+  uint32_t version;             ///< 格式版本号，VERSION
+  uint32_t header_size;         ///< 文件头大小（字节），帧记录起始偏移
+  uint64_t file_size;           ///< 录制时预分配的文件大小，尾部索引以此为基准
+  uint64_t segment_index;       ///< 段序号（同一前缀下递增）
+  uint64_t created_realtime_us; ///< 创建时的墙上时间（CLOCK_REALTIME 微秒）
+  uint64_t created_monotonic_us; ///< 创建时的 CLOCK_MONOTONIC 时间，与帧时间戳同一时钟
+  char source_name[64];         ///< 来源共享内存名称（以 '\0' 结尾）
+  std::atomic<uint64_t> data_end;    ///< 已写帧记录的末尾偏移
+  std::atomic<uint32_t> frame_count; ///< 已写帧数（等于索引项数）
+  std::atomic<uint32_t> finalized;   ///< 1 表示已封存：索引位于 index_offset，文件已截断
+  uint64_t index_offset;        ///< 封存后升序索引的起始偏移，未封存时为0
+  uint64_t first_timestamp_us;  ///< 首帧采集时间戳
+  uint64_t last_timestamp_us;   ///< 末帧采集时间戳
+};
+
+/**
+ * @brief 帧记录头，紧随其后是 image.data_size 字节的原始负载
+ *
+ * 记录按 RECORDING_RECORD_ALIGN 对齐，record_size 包含记录头、负载与填充，
+ * 顺序扫描时直接跳到下一条记录。
+ *
+ * 版本 2 的 ImageHeader 增加了平面布局，记录头随之扩展到 128 字节；
+ * 版本 1 的记录头为 RECORDING_V1_RECORD_HEADER_SIZE 字节，其中的图像头部
+ * 只有 RECORDING_V1_IMAGE_HEADER_SIZE 字节（不含 planes，即紧凑排列）。
+ */
+struct RecordedFrameHeader {
+  static constexpr uint32_t MAGIC = 0x4d415246; ///< "FRAM"
+
+  uint32_t magic;         ///< 魔数，MAGIC
+  uint32_t record_size;   ///< 整条记录的字节数（含对齐填充）
+  uint64_t frame_version; ///< 原始帧版本号
+  ImageHeader image;      ///< 原始图像头部，各阶段时间戳保持不变
+  uint8_t reserved[48];   ///< 保留，置0，使负载按 RECORDING_RECORD_ALIGN 对齐
+};
+
+/**
+ * @brief 索引项：一帧的采集时间戳与记录偏移
+ */
+struct RecordingIndexEntry {
+  uint64_t timestamp_us; ///< 采集时间戳（CLOCK_MONOTONIC 微秒）
+  uint64_t offset;       ///< 帧记录在段文件中的偏移
+};
+
+constexpr size_t RECORDING_HEADER_SIZE = 4096; ///< 段文件头大小
+constexpr size_t RECORDING_RECORD_ALIGN = 64;  ///< 帧记录对齐
+constexpr const char *RECORDING_FILE_SUFFIX = ".screc"; ///< 段文件扩展名
+constexpr size_t RECORDING_V1_RECORD_HEADER_SIZE = 64; ///< 版本 1 的帧记录头大小
+constexpr size_t RECORDING_V1_IMAGE_HEADER_SIZE = 48;  ///< 版本 1 记录头内的图像头部大小
+
+static_assert(sizeof(RecordingSegmentHeader) <= RECORDING_HEADER_SIZE,
+              "segment header must fit in the reserved header area");
+static_assert(sizeof(RecordedFrameHeader) % RECORDING_RECORD_ALIGN == 0,
+              "record header must keep payloads aligned");
+static_assert(offsetof(RecordedFrameHeader, image) +
+                      RECORDING_V1_IMAGE_HEADER_SIZE ==
+                  RECORDING_V1_RECORD_HEADER_SIZE,
+              "version 1 records end where ImageHeader::planes begins");
+static_assert(offsetof(ImageHeader, planes) == RECORDING_V1_IMAGE_HEADER_SIZE,
+              "ImageHeader fields before planes must keep the version 1 layout");
+static_assert(sizeof(RecordingIndexEntry) == 16, "index entries are 16 bytes");
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "segment header atomics are shared through mmap");
+
+#endif // RECORDING_FORMAT_H
@@ -0,0 +1,219 @@
+/**
+ * @file recording_reader.cpp
+ * @brief 录制段文件只读访问实现
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ */
+
+#include "recording_reader.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+RecordingReader::~RecordingReader() { close(); }
+
+static bool ends_with(const std::string &value, const std::string &suffix) {
+  return value.size() >= suffix.size() &&
+         value.compare(value.size() - suffix.size(), suffix.size(), suffix) ==
+             0;
+}
+
+void RecordingReader::open(const std::string &path) {
+  close();
+
+  std::vector<std::string> files;
+  struct stat info;
+  bool exists = stat(path.c_str(), &info) == 0;
+  if (exists && S_ISREG(info.st_mode)) {
+    files.push_back(path);
+  } else {
+    // 目录：其中全部段文件；否则按 "<目录>/<前缀>" 匹配 <前缀>_*.screc
+    std::string dir = path, prefix;
+    if (!exists || !S_ISDIR(info.st_mode)) {
+      size_t slash = path.rfind('/');
+      dir = slash == std::string::npos ? "." : path.substr(0, slash);
+      prefix = (slash == std::string::npos ? path : path.substr(slash + 1)) +
+               "_";
+    }
+    DIR *dp = opendir(dir.c_str());
+    if (!dp)
+      throw std::runtime_error("RecordingReader: Cannot open directory '" +
+                               dir + "': " + std::strerror(errno));
+    while (struct dirent *entry = readdir(dp)) {
+      std::string name = entry->d_name;
+      if (ends_with(name, RECORDING_FILE_SUFFIX) &&
+          name.compare(0, prefix.size(), prefix) == 0)
+        files.push_back(dir + "/" + name);
+    }
+    closedir(dp);
+    std::sort(files.begin(), files.end());
+  }
+  if (files.empty())
+    throw std::runtime_error("RecordingReader: No recording segments at '" +
+                             path + "'");
+
+  std::set<std::string> sources;
+  for (const auto &file : files) {
+    Segment segment;
+    try {
+      segment = map_segment(file);
+    } catch (const std::exception &e) {
+      // 目录中个别损坏的段（如录制进程刚创建尚未写头部）跳过，单个文件直接报错
+      if (files.size() == 1) {
+        close();
+        throw;
+      }
+      std::cerr << e.what() << ", skipped" << std::endl;
+      continue;
+    }
+    segment.first_frame = frame_count_;
+    frame_count_ += segment.frame_count;
+    sources.insert(
+        reinterpret_cast<const RecordingSegmentHeader *>(segment.base)
+            ->source_name);
+    segments_.push_back(segment);
+  }
+  if (sources.size() > 1) {
+    close();
+    throw std::runtime_error("RecordingReader: '" + path +
+                             "' contains several recordings, open it as "
+                             "'<dir>/<prefix>' instead");
+  }
+  if (segments_.empty())
+    throw std::runtime_error("RecordingReader: No readable segments at '" +
+                             path + "'");
+}
+
+RecordingReader::Segment
+RecordingReader::map_segment(const std::string &path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat info;
+  if (fd == -1 || fstat(fd, &info) == -1) {
+    std::string reason = std::strerror(errno);
+    if (fd != -1)
+      ::close(fd);
+    throw std::runtime_error("RecordingReader: Cannot open '" + path +
+                             "': " + reason);
+  }
+  size_t size = static_cast<size_t>(info.st_size);
+  void *addr = size >= RECORDING_HEADER_SIZE
+                   ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0)
+                   : MAP_FAILED;
+  ::close(fd);
+  if (addr == MAP_FAILED)
+    throw std::runtime_error("RecordingReader: Cannot map '" + path + "'");
+
+  const auto *hdr = static_cast<const RecordingSegmentHeader *>(addr);
+  Segment segment{path, static_cast<const uint8_t *>(addr), size, nullptr,
+                  false, sizeof(RecordedFrameHeader), 0, 0};
+  bool valid = hdr->magic == RecordingSegmentHeader::MAGIC &&
+               hdr->version >= RecordingSegmentHeader::MIN_VERSION &&
+               hdr->version <= RecordingSegmentHeader::VERSION &&
+               hdr->header_size == RECORDING_HEADER_SIZE;
+  if (valid && hdr->version == 1)
+    segment.record_header_size = RECORDING_V1_RECORD_HEADER_SIZE;
+  if (valid) {
+    uint64_t data_end = hdr->data_end.load(std::memory_order_acquire);
+    uint32_t count = hdr->frame_count.load(std::memory_order_acquire);
+    uint64_t index_bytes = (uint64_t)count * sizeof(RecordingIndexEntry);
+    segment.frame_count = count;
+    if (hdr->finalized.load(std::memory_order_acquire)) {
+      valid = hdr->index_offset + index_bytes <= size;
+      segment.index = reinterpret_cast<const RecordingIndexEntry *>(
+          segment.base + hdr->index_offset);
+    } else {
+      // 未封存：文件仍为预分配大小，索引从末尾倒序排列
+      valid = hdr->file_size <= size && data_end + index_bytes <= hdr->file_size;
+      segment.tail_index = true;
+      segment.index = reinterpret_cast<const RecordingIndexEntry *>(
+                          segment.base + hdr->file_size) -
+                      1;
+    }
+  }
+  if (!valid) {
+    munmap(addr, size);
+    throw std::runtime_error("RecordingReader: '" + path +
+                             "' is not a valid recording segment");
+  }
+  // 回放按顺序读取，加大预读
+  madvise(addr, size, MADV_SEQUENTIAL);
+  return segment;
+}
+
+void RecordingReader::close() {
+  for (const auto &segment : segments_)
+    munmap(const_cast<uint8_t *>(segment.base), segment.size);
+  segments_.clear();
+  frame_count_ = 0;
+}
+
+const RecordingIndexEntry &RecordingReader::entry(const Segment &segment,
+                                                  uint32_t i) {
+  return segment.tail_index ? *(segment.index - i) : segment.index[i];
+}
+
+const RecordingReader::Segment *
+RecordingReader::find_segment(uint64_t index) const {
+  if (index >= frame_count_)
+    return nullptr;
+  auto it = std::upper_bound(
+      segments_.begin(), segments_.end(), index,
+      [](uint64_t value, const Segment &s) { return value < s.first_frame; });
+  // 空段与后继段首帧号相同，upper_bound 的前一个即为包含该帧的段
+  return &*(it - 1);
+}
+
+bool RecordingReader::get_frame(uint64_t index, RecordedFrame *out) const {
+  const Segment *segment = find_segment(index);
+  if (!segment || !out)
+    return false;
+  const RecordingIndexEntry &e =
+      entry(*segment, static_cast<uint32_t>(index - segment->first_frame));
+  const size_t header_size = segment->record_header_size;
+  if (e.offset < RECORDING_HEADER_SIZE ||
+      e.offset + header_size > segment->size)
+    return false;
+  const auto *record =
+      reinterpret_cast<const RecordedFrameHeader *>(segment->base + e.offset);
+  if (record->magic != RecordedFrameHeader::MAGIC)
+    return false;
+  // 版本 1 的图像头部止于 planes 之前，缺少的字段补0（紧凑排列）
+  ImageHeader image{};
+  std::memcpy(&image, &record->image,
+              header_size == sizeof(RecordedFrameHeader)
+                  ? sizeof(ImageHeader)
+                  : RECORDING_V1_IMAGE_HEADER_SIZE);
+  if (e.offset + header_size + image.data_size > segment->size)
+    return false;
+  out->image = image;
+  out->frame_version = record->frame_version;
+  out->data = segment->base + e.offset + header_size;
+  out->size = image.data_size;
+  out->timestamp_us = e.timestamp_us;
+  return true;
+}
+
+uint64_t RecordingReader::seek(uint64_t timestamp_us) const {
+  uint64_t lo = 0, hi = frame_count_;
+  while (lo < hi) {
+    uint64_t mid = lo + (hi - lo) / 2;
+    const Segment *segment = find_segment(mid);
+    uint64_t ts =
+        entry(*segment, static_cast<uint32_t>(mid - segment->first_frame))
+            .timestamp_us;
+    if (ts < timestamp_us)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
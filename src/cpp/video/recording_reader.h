@@ -0,0 +1,126 @@
+/**
+ * @file recording_reader.h
+ * @brief 录制段文件只读访问
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 该文件定义了以只读 mmap 方式打开 FrameRecorder 段文件的读取器。
+ * 多个段按序号拼接为一条连续的帧序列，按帧号定位为 O(1)（段内直接查索引），
+ * 按时间戳定位为二分查找；负载指针直接指向映射的文件页，不做拷贝。
+ */
+
+#ifndef RECORDING_READER_H
+#define RECORDING_READER_H
+
+#include "video/recording_format.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 一帧录制数据的只读视图（指向映射的段文件，读取器关闭前有效）
+ */
+struct RecordedFrame {
+  ImageHeader image{};            ///< 原始图像头部（版本 1 录制的 planes 为0）
+  uint64_t frame_version = 0;     ///< 原始帧版本号
+  const uint8_t *data = nullptr;  ///< 原始负载
+  size_t size = 0;                ///< 负载字节数
+  uint64_t timestamp_us = 0;      ///< 采集时间戳（CLOCK_MONOTONIC 微秒）
+};
+
+/**
+ * @brief 录制段文件读取器
+ *
+ * 支持已封存的段（升序索引位于数据之后）和录制进程崩溃留下的未封存段
+ * （倒序尾部索引，帧数以文件头中的 frame_count 为准），以及版本 1 的
+ * 旧录制（记录头较短，图像头部不含平面布局）。
+ */
+class RecordingReader {
+public:
+  RecordingReader() = default;
+
+  /**
+   * @brief 析构函数，解除全部段的映射
+   */
+  ~RecordingReader();
+
+  RecordingReader(const RecordingReader &) = delete;
+  RecordingReader &operator=(const RecordingReader &) = delete;
+
+  /**
+   * @brief 打开录制
+   * @param path 单个段文件、只含一路录制的目录，或 "<目录>/<前缀>"
+   *             （匹配 <前缀>_*.screc）
+   * @throws std::runtime_error 当没有可用的段文件、目录中混有多路录制或
+   *         段文件头损坏时抛出异常
+   */
+  void open(const std::string &path);
+
+  /**
+   * @brief 解除全部段的映射
+   */
+  void close();
+
+  /**
+   * @brief 获取总帧数
+   */
+  uint64_t frame_count() const { return frame_count_; }
+
+  /**
+   * @brief 获取段文件数
+   */
+  size_t segment_count() const { return segments_.size(); }
+
+  /**
+   * @brief 按帧号读取一帧
+   * @param index 帧号（0 起，跨段连续）
+   * @param out 输出参数，接收帧视图
+   * @return bool 帧号越界或记录头损坏时返回false
+   */
+  bool get_frame(uint64_t index, RecordedFrame *out) const;
+
+  /**
+   * @brief 查找采集时间戳不早于 timestamp_us 的第一帧
+   * @param timestamp_us 采集时间戳（CLOCK_MONOTONIC 微秒）
+   * @return uint64_t 帧号，所有帧都更早时返回 frame_count()
+   */
+  uint64_t seek(uint64_t timestamp_us) const;
+
+private:
+  /**
+   * @brief 单个映射的段文件
+   */
+  struct Segment {
+    std::string path;        ///< 文件路径
+    const uint8_t *base;     ///< 映射基地址
+    size_t size;             ///< 映射长度
+    const RecordingIndexEntry *index; ///< 索引起点（封存段为升序首项，未封存段为尾部第0项）
+    bool tail_index;         ///< 是否为未封存段的倒序尾部索引
+    uint32_t record_header_size; ///< 帧记录头大小（随格式版本不同）
+    uint32_t frame_count;    ///< 段内帧数
+    uint64_t first_frame;    ///< 段内首帧的全局帧号
+  };
+
+  /**
+   * @brief 映射并校验一个段文件
+   * @throws std::runtime_error 文件无法映射或文件头损坏时抛出异常
+   */
+  static Segment map_segment(const std::string &path);
+
+  /**
+   * @brief 段内第 i 个索引项
+   */
+  static const RecordingIndexEntry &entry(const Segment &segment, uint32_t i);
+
+  /**
+   * @brief 查找包含全局帧号的段
+   */
+  const Segment *find_segment(uint64_t index) const;
+
+  std::vector<Segment> segments_; ///< 按序号排列的段
+  uint64_t frame_count_ = 0;      ///< 总帧数
+};
+
+#endif // RECORDING_READER_H
@@ -0,0 +1,167 @@
+/**
+ * @file bridge_receiver_process.cpp
+ * @brief 共享内存图像流网络桥接接收端
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 从 bridge_sender_process 接收原始帧，重新发布到本地图像共享内存，
+ * 本机的消费者（consumer_process、Python 扩展等）按原名称连接即可，
+ * 与直接连接摄像头生产者没有区别。共享内存几何参数取自 shmConfig.json，
+ * 槽位大小须能容纳远端的帧。TCP 断开后每秒重连一次，Ctrl-C 退出。
+ *
+ * 用法：
+ *   bridge_receiver_process tcp <host>:<port> [shm_name]
+ *   bridge_receiver_process udp <group>:<port> [shm_name] [if=<本地接口地址>]
+ */
+
+#include "config/config_manager.h"
+#include "video/image_shm_manager.h"
+#include "video/net_bridge.h"
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+static volatile std::sig_atomic_t g_running = 1;
+
+static void handle_signal(int) { g_running = 0; }
+
+/**
+ * @brief 每秒打印一次接收速率
+ */
+static void print_progress(const NetBridgeReceiverStats &stats,
+                           const NetBridgeReceiverStats &prev,
+                           double seconds) {
+  double fps = (stats.frames_received - prev.frames_received) / seconds;
+  double mbps =
+      (stats.bytes_received - prev.bytes_received) / seconds / (1 << 20);
+  std::cout << "BridgeReceiver: " << std::fixed << std::setprecision(1) << fps
+            << " fps, " << mbps << " MB/s, total " << stats.frames_received
+            << " frames, missed " << stats.frames_missed << ", dropped "
+            << stats.frames_dropped;
+  if (stats.datagrams_received)
+    std::cout << ", datagrams lost " << stats.datagrams_lost;
+  std::cout << std::endl;
+}
+
+/**
+ * @brief 接收直到连接断开或 Ctrl-C
+ * @return bool false 表示连接已断开
+ */
+static bool run(NetBridgeReceiver &receiver) {
+  NetBridgeReceiverStats prev = receiver.get_stats();
+  auto last_report = std::chrono::steady_clock::now();
+  while (g_running) {
+    if (!receiver.receive(100))
+      return false;
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - last_report).count();
+    if (elapsed >= 1.0) {
+      print_progress(receiver.get_stats(), prev, elapsed);
+      prev = receiver.get_stats();
+      last_report = now;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief 拆分 "<host>:<port>"
+ */
+static bool split_endpoint(const std::string &endpoint, std::string *host,
+                           uint16_t *port) {
+  size_t colon = endpoint.rfind(':');
+  if (colon == std::string::npos || colon == 0)
+    return false;
+  *host = endpoint.substr(0, colon);
+  *port = static_cast<uint16_t>(std::atoi(endpoint.c_str() + colon + 1));
+  return *port != 0;
+}
+
+static void usage(const char *program) {
+  std::cerr << "Usage: " << program << " tcp <host>:<port> [shm_name]\n"
+            << "       " << program
+            << " udp <group>:<port> [shm_name] [if=<addr>]" << std::endl;
+}
+
+int main(int argc, char **argv) {
+  std::string host, interface;
+  uint16_t port = 0;
+  if (argc < 3 || !split_endpoint(argv[2], &host, &port)) {
+    usage(argv[0]);
+    return 1;
+  }
+  const std::string transport = argv[1];
+  if (transport != "tcp" && transport != "udp") {
+    usage(argv[0]);
+    return 1;
+  }
+
+  std::signal(SIGINT, handle_signal);
+  std::signal(SIGTERM, handle_signal);
+
+  try {
+    ConfigManager::get_instance().load_shm_config(
+        "../../../config/shmConfig.json");
+    const auto &shm_config = ConfigManager::get_instance().get_shm_config();
+    std::string shm_name = shm_config.name;
+    for (int i = 3; i < argc; ++i) {
+      std::string arg = argv[i];
+      if (arg.compare(0, 3, "if=") == 0)
+        interface = arg.substr(3);
+      else
+        shm_name = arg;
+    }
+
+    // 本地共享内存按 shmConfig.json 创建，远端消费者看到的与本机生产者相同
+    ShmCreateOptions shm_options;
+    shm_options.ring_mode = shm_config.ring_mode;
+    shm_options.overflow_policy = shm_config.overflow_policy;
+    shm_options.allocator = shm_config.allocator;
+    ImageShmManager shm(shm_name, shm_config.map_options);
+    shm.unlink_shm(); // 清理之前可能残留的共享内存
+    if (shm.create_and_init(shm_config.total_size_bytes,
+                            shm_config.buffer_size_bytes,
+                            shm_config.buffer_count,
+                            shm_options) != ShmStatus::Success)
+      throw std::runtime_error("Failed to initialize shared memory '" +
+                               shm_name + "'.");
+    std::cout << "BridgeReceiver: Publishing to '" << shm_name << "' ("
+              << shm_config.buffer_count << " x "
+              << shm_config.buffer_size_bytes << " bytes)" << std::endl;
+
+    if (transport == "udp") {
+      int fd = bridge_open_udp_receiver(host, port, interface);
+      std::cout << "BridgeReceiver: Listening on udp://" << host << ":"
+                << port << std::endl;
+      NetBridgeReceiver receiver(fd, BridgeTransport::Udp, &shm);
+      run(receiver);
+    } else {
+      while (g_running) {
+        int fd = bridge_connect_tcp(host, port);
+        if (fd == -1) {
+          std::this_thread::sleep_for(std::chrono::seconds(1));
+          continue;
+        }
+        std::cout << "BridgeReceiver: Connected to " << host << ":" << port
+                  << std::endl;
+        NetBridgeReceiver receiver(fd, BridgeTransport::Tcp, &shm);
+        if (!run(receiver))
+          std::cerr << "BridgeReceiver: Connection lost, reconnecting..."
+                    << std::endl;
+      }
+    }
+    shm.unmap_and_close();
+    shm.unlink_shm();
+  } catch (const std::exception &e) {
+    std::cerr << "BridgeReceiver: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,355 @@
+/**
+ * @file bridge_sender_process.cpp
+ * @brief 共享内存图像流网络桥接发送端
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 附加到图像共享内存，把原始帧通过 TCP（每个连接的接收端一个发送线程）
+ * 或 UDP 组播发送给其他节点上的 bridge_receiver_process。帧负载以
+ * scatter-gather 方式直接从共享内存槽位发送，积压的帧合并为一次系统调用。
+ * 生产者重启后自动重新附加，Ctrl-C 退出。
+ *
+ * 用法：
+ *   bridge_sender_process tcp <port> [shm_name] [选项...]
+ *   bridge_sender_process udp <group>:<port> [shm_name] [选项...]
+ * 选项：zerocopy（TCP MSG_ZEROCOPY）、linger=<ms>（等待更多帧合并发送）、
+ *       mtu=<bytes>（UDP 数据报上限）、ttl=<n>、if=<本地接口地址>
+ */
+
+#include "config/config_manager.h"
+#include "video/image_shm_manager.h"
+#include "video/net_bridge.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+static volatile std::sig_atomic_t g_running = 1;
+
+static void handle_signal(int) { g_running = 0; }
+
+/**
+ * @brief 发送端运行参数
+ */
+struct SenderConfig {
+  std::string shm_name;      ///< 来源共享内存名称
+  ShmMapOptions map_options; ///< 共享内存映射选项
+  NetBridgeOptions options;  ///< 发送端配置
+  int linger_ms = 0;         ///< 取到帧后再等待的时间，用于合并小帧
+};
+
+/**
+ * @brief 按名称附加到共享内存，等待期间响应 Ctrl-C
+ * @return bool 是否附加成功
+ */
+static bool attach(ImageShmManager &shm) {
+  while (g_running) {
+    if (shm.reconnect(1000) == ShmStatus::Success)
+      return true;
+  }
+  return false;
+}
+
+/**
+ * @brief 取出所有比 last_version 新的帧，追加到 batch
+ * @param limit batch 的帧数上限
+ */
+static void collect(ImageShmManager &shm, uint32_t consumer_id, size_t limit,
+                    uint64_t *last_version, uint64_t *missed,
+                    std::vector<ReadImageGuard> *batch,
+                    std::vector<ReadImageGuard> *scratch) {
+  auto append = [&](ReadImageGuard &&image) {
+    if (*last_version && image.frame_version() > *last_version + 1)
+      *missed += image.frame_version() - *last_version - 1;
+    *last_version = image.frame_version();
+    batch->push_back(std::move(image));
+  };
+  if (consumer_id != ShmBufferControl::NO_CONSUMER) {
+    // 队列模式：按版本顺序逐帧取出，写者不会覆盖未发送的帧
+    while (batch->size() < limit) {
+      ReadImageGuard image = shm.acquire_next_image(consumer_id);
+      if (!image.is_valid())
+        break;
+      append(std::move(image));
+    }
+    return;
+  }
+  // 最新帧模式：一次取回环内所有未发送的帧
+  uint64_t latest = shm.get_latest_frame_version();
+  if (latest <= *last_version || batch->size() >= limit)
+    return;
+  uint32_t k = static_cast<uint32_t>(
+      std::min<uint64_t>(latest - *last_version, limit - batch->size()));
+  if (shm.acquire_image_batch(k, scratch) == ShmStatus::Success) {
+    for (ReadImageGuard &image : *scratch) {
+      if (image.frame_version() > *last_version)
+        append(std::move(image));
+    }
+  }
+  scratch->clear();
+}
+
+/**
+ * @brief 把共享内存中的帧持续发送到一个套接字
+ * @param peer 日志中显示的对端描述
+ * @return bool false 表示因连接断开而停止
+ */
+static bool stream(const SenderConfig &config, NetBridgeSender &sender,
+                   const std::string &peer) {
+  ImageShmManager shm(config.shm_name, config.map_options);
+  if (!attach(shm))
+    return true;
+
+  uint32_t consumer_id = ShmBufferControl::NO_CONSUMER;
+  if (shm.get_ring_mode() == ShmRingMode::Queue)
+    shm.register_consumer(&consumer_id);
+  // 每批最多取环的槽位数减一帧；零拷贝时本批与等待完成通知的帧合计不超过
+  // max_inflight_frames，生产者始终有槽位可写
+  size_t limit = std::min<size_t>(
+      config.options.max_batch_frames,
+      std::max(shm.get_buffer_count(), 2u) - 1);
+  if (sender.zerocopy_enabled())
+    limit = std::max<size_t>(1, std::min<size_t>(
+                                    limit, config.options.max_inflight_frames));
+
+  uint64_t last_version = 0, missed = 0;
+  std::vector<ReadImageGuard> batch, scratch;
+  NetBridgeSenderStats prev = sender.get_stats();
+  auto last_report = std::chrono::steady_clock::now();
+  bool connected = true;
+  while (g_running && connected) {
+    collect(shm, consumer_id, limit, &last_version, &missed, &batch, &scratch);
+    if (!batch.empty() && config.linger_ms > 0 && batch.size() < limit &&
+        shm.wait_for_new_frame(last_version, config.linger_ms) ==
+            ShmStatus::Success)
+      collect(shm, consumer_id, limit, &last_version, &missed, &batch,
+              &scratch);
+    if (!batch.empty())
+      connected = sender.send(batch);
+
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - last_report).count();
+    if (elapsed >= 1.0) {
+      const NetBridgeSenderStats &stats = sender.get_stats();
+      double fps = (stats.frames_sent - prev.frames_sent) / elapsed;
+      double mbps = (stats.bytes_sent - prev.bytes_sent) / elapsed / (1 << 20);
+      double per_call =
+          stats.send_calls > prev.send_calls
+              ? double(stats.frames_sent - prev.frames_sent) /
+                    (stats.send_calls - prev.send_calls)
+              : 0.0;
+      std::cout << "BridgeSender[" << peer << "]: " << std::fixed
+                << std::setprecision(1) << fps << " fps, " << mbps
+                << " MB/s, " << per_call << " frames/call, missed " << missed;
+      if (sender.zerocopy_enabled())
+        std::cout << ", zerocopy " << stats.zerocopy_sends << " (copied "
+                  << stats.zerocopy_copied << ")";
+      std::cout << std::endl;
+      prev = stats;
+      last_report = now;
+    }
+    if (!connected)
+      break;
+
+    ShmStatus wait_status = shm.wait_for_new_frame(last_version, 100);
+    if (wait_status == ShmStatus::ProducerRestarted ||
+        wait_status == ShmStatus::NotInitialized ||
+        (wait_status == ShmStatus::Timeout && shm.producer_restarted())) {
+      std::cerr << "BridgeSender[" << peer
+                << "]: Producer restarted, re-attaching..." << std::endl;
+      // 保留的守卫属于旧映射，重新附加前全部释放
+      sender.drain(1000);
+      bool queue_consumer = consumer_id != ShmBufferControl::NO_CONSUMER;
+      if (queue_consumer)
+        shm.unregister_consumer(consumer_id);
+      consumer_id = ShmBufferControl::NO_CONSUMER;
+      if (!attach(shm))
+        break;
+      // 新生产者的帧版本从头开始计数
+      last_version = 0;
+      if (queue_consumer && shm.get_ring_mode() == ShmRingMode::Queue)
+        shm.register_consumer(&consumer_id);
+    }
+  }
+  sender.drain(1000);
+  if (consumer_id != ShmBufferControl::NO_CONSUMER)
+    shm.unregister_consumer(consumer_id);
+  return connected;
+}
+
+/**
+ * @brief 一个 TCP 接收端的发送线程
+ */
+struct Client {
+  std::thread thread;             ///< 发送线程
+  std::atomic<bool> done{false};  ///< 线程是否已退出
+};
+
+/**
+ * @brief TCP 模式：接受连接，每个接收端一个发送线程
+ */
+static int serve_tcp(const SenderConfig &config, uint16_t port) {
+  int listen_fd = bridge_listen_tcp(port);
+  std::cout << "BridgeSender: Serving '" << config.shm_name
+            << "' on TCP port " << port << std::endl;
+  std::list<Client> clients;
+  while (g_running) {
+    struct pollfd pfd = {listen_fd, POLLIN, 0};
+    if (poll(&pfd, 1, 500) > 0) {
+      struct sockaddr_in addr;
+      socklen_t length = sizeof(addr);
+      int fd = accept4(listen_fd, reinterpret_cast<struct sockaddr *>(&addr),
+                       &length, SOCK_CLOEXEC);
+      if (fd != -1) {
+        char host[INET_ADDRSTRLEN] = {0};
+        inet_ntop(AF_INET, &addr.sin_addr, host, sizeof(host));
+        std::string peer =
+            std::string(host) + ":" + std::to_string(ntohs(addr.sin_port));
+        std::cout << "BridgeSender: Receiver connected from " << peer
+                  << std::endl;
+        clients.emplace_back();
+        Client &client = clients.back();
+        client.thread = std::thread([&config, &client, fd, peer] {
+          NetBridgeSender sender(fd, BridgeTransport::Tcp, config.options);
+          stream(config, sender, peer);
+          const NetBridgeSenderStats &stats = sender.get_stats();
+          std::cout << "BridgeSender: Stopped streaming to " << peer
+                    << " after " << stats.frames_sent << " frames ("
+                    << stats.bytes_sent << " bytes)" << std::endl;
+          client.done = true;
+        });
+      }
+    }
+    // 回收已断开的接收端
+    for (auto it = clients.begin(); it != clients.end();) {
+      if (it->done) {
+        it->thread.join();
+        it = clients.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  for (Client &client : clients)
+    client.thread.join();
+  close(listen_fd);
+  return 0;
+}
+
+/**
+ * @brief UDP 模式：单线程发送到组播组
+ */
+static int serve_udp(const SenderConfig &config, const std::string &group,
+                     uint16_t port, int ttl, const std::string &interface) {
+  int fd = bridge_open_udp_sender(group, port, ttl, interface);
+  std::cout << "BridgeSender: Sending '" << config.shm_name << "' to udp://"
+            << group << ":" << port << " (" << config.options.max_datagram_bytes
+            << "-byte datagrams)" << std::endl;
+  NetBridgeSender sender(fd, BridgeTransport::Udp, config.options);
+  stream(config, sender, group);
+  const NetBridgeSenderStats &stats = sender.get_stats();
+  std::cout << "BridgeSender: Sent " << stats.frames_sent << " frames in "
+            << stats.datagrams_sent << " datagrams (" << stats.send_calls
+            << " sendmmsg calls), rejected " << stats.frames_rejected
+            << ", send errors " << stats.send_errors << std::endl;
+  return 0;
+}
+
+/**
+ * @brief 拆分 "<host>:<port>"
+ */
+static bool split_endpoint(const std::string &endpoint, std::string *host,
+                           uint16_t *port) {
+  size_t colon = endpoint.rfind(':');
+  if (colon == std::string::npos || colon == 0)
+    return false;
+  *host = endpoint.substr(0, colon);
+  *port = static_cast<uint16_t>(std::atoi(endpoint.c_str() + colon + 1));
+  return *port != 0;
+}
+
+static void usage(const char *program) {
+  std::cerr << "Usage: " << program << " tcp <port> [shm_name] [options...]\n"
+            << "       " << program
+            << " udp <group>:<port> [shm_name] [options...]\n"
+            << "Options: zerocopy linger=<ms> mtu=<bytes> ttl=<n> if=<addr>"
+            << std::endl;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    usage(argv[0]);
+    return 1;
+  }
+  const std::string transport = argv[1];
+  SenderConfig config;
+  try {
+    ConfigManager::get_instance().load_shm_config(
+        "../../../config/shmConfig.json");
+    const auto &shm_config = ConfigManager::get_instance().get_shm_config();
+    config.shm_name = shm_config.name;
+    config.map_options = shm_config.map_options;
+  } catch (const std::exception &e) {
+    if (argc < 4 || std::string(argv[3]).find('=') != std::string::npos) {
+      std::cerr << "bridge_sender_process: " << e.what() << std::endl;
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  int ttl = 1;
+  std::string interface;
+  for (int i = 3; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "zerocopy")
+      config.options.zerocopy = true;
+    else if (arg.compare(0, 7, "linger=") == 0)
+      config.linger_ms = std::atoi(arg.c_str() + 7);
+    else if (arg.compare(0, 4, "mtu=") == 0)
+      config.options.max_datagram_bytes = std::strtoull(arg.c_str() + 4, nullptr, 10);
+    else if (arg.compare(0, 4, "ttl=") == 0)
+      ttl = std::atoi(arg.c_str() + 4);
+    else if (arg.compare(0, 3, "if=") == 0)
+      interface = arg.substr(3);
+    else if (i == 3)
+      config.shm_name = arg;
+    else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  std::signal(SIGINT, handle_signal);
+  std::signal(SIGTERM, handle_signal);
+  std::signal(SIGPIPE, SIG_IGN);
+
+  try {
+    if (transport == "tcp")
+      return serve_tcp(config, static_cast<uint16_t>(std::atoi(argv[2])));
+    std::string group;
+    uint16_t port = 0;
+    if (transport != "udp" || !split_endpoint(argv[2], &group, &port)) {
+      usage(argv[0]);
+      return 1;
+    }
+    return serve_udp(config, group, port, ttl, interface);
+  } catch (const std::exception &e) {
+    std::cerr << "BridgeSender: " << e.what() << std::endl;
+    return 1;
+  }
+}
@@ -9,21 +9,26 @@
  * 解码并显示在OpenCV窗口中。支持动态格式切换和实时性能监控。
  *
  * 主要功能：
- * - 连接共享内存并读取图像数据
+ * - 连接共享内存并读取图像数据（可用命令行参数指定摄像头通道名称）
+ * - 配置了解码缓存时 MJPEG 帧优先从缓存取得 BGR 结果（第二个参数可指定缓存名称）
  * - 动态选择合适的解码器
- * - 实时视频显示和性能统计
+ * - 实时视频显示和性能统计（含采集到解码完成的分阶段延迟）
  * - 支持多种图像格式的无缝切换
  * - 优雅的错误处理和资源清理
  */
 
 #include "config/config_manager.h"
 #include "config/factory.h"
+#include "video/decode_cache.h"
+#include "video/formats/frame_pool.h"
 #include "video/image_shm_manager.h"
+#include "video/latency_tracker.h"
 #include <chrono>
 #include <iomanip>
 #include <iostream>
 #include <map>
 #include <opencv2/opencv.hpp>
+#include <stdexcept>
 #include <string>
 #include <thread>
 #include <vector>
@@ -39,12 +44,18 @@ const char *getFormatName(ImageFormat format) {
     return "BGR";
   case ImageFormat::H264:
     return "H264";
+  case ImageFormat::GRAY:
+    return "GRAY";
+  case ImageFormat::NV12:
+    return "NV12";
+  case ImageFormat::NV16:
+    return "NV16";
   default:
     return "UNKNOWN";
   }
 }
 
-int main() {
+int main(int argc, char **argv) {
   std::cout << "=== Video Consumer (Dynamic Factory Version) ===" << std::endl;
 
   try {
@@ -53,23 +64,81 @@ int main() {
         "../../../config/shmConfig.json");
     const auto &shm_config = ConfigManager::get_instance().get_shm_config();
 
-    // 2. 连接共享内存
-    ImageShmManager shm_transport(shm_config.name);
+    // 2. 连接共享内存（多摄像头时通过第一个参数指定通道名称）
+    const std::string shm_name = argc > 1 ? argv[1] : shm_config.name;
+    ImageShmManager shm_transport(shm_name, shm_config.map_options);
     std::cout << "ConsumerGUI: Waiting for producer to create shared memory..."
               << std::endl;
-    while (shm_transport.open_and_map(
-               shm_config.total_size_bytes, shm_config.buffer_size_bytes,
-               shm_config.buffer_count) != ShmStatus::Success) {
-      std::cout << "ConsumerGUI: Waiting..." << std::endl;
-      std::this_thread::sleep_for(std::chrono::seconds(1));
-    }
+    // 段几何参数从段头部读取，与生产者的配置无需一致
+    if (shm_transport.reconnect(-1) != ShmStatus::Success)
+      throw std::runtime_error("Failed to attach to shared memory '" +
+                               shm_name + "'");
     std::cout << "ConsumerGUI: Successfully connected to shared memory with "
-              << shm_config.buffer_count << " buffers!" << std::endl;
+              << shm_transport.get_buffer_count() << " buffers (generation "
+              << shm_transport.get_generation() << ")!" << std::endl;
+
+    // 3. 加载可选的解码配置
+    bool decode_config_loaded = false;
+    DecoderOptions decoder_options;
+    try {
+      ConfigManager::get_instance().load_decode_config(
+          "../../../config/decodeConfig.json");
+      decoder_options =
+          ConfigManager::get_instance().get_decode_config().options;
+      decode_config_loaded = true;
+    } catch (const std::exception &e) {
+      std::cout << "ConsumerGUI: Using default decode settings (" << e.what()
+                << ")" << std::endl;
+    }
 
-    // 3. 创建解码器 Map - 支持动态格式切换
+    // 创建解码器 Map - 支持动态格式切换；YUYV 按输出选项单遍裁剪/缩放，
+    // MJPEG 按输出选项在 DCT 域缩小解码
     std::map<ImageFormat, std::unique_ptr<IDecoder>> decoders;
-    decoders[ImageFormat::YUYV] = Factory::create_decoder(ImageFormat::YUYV);
-    decoders[ImageFormat::MJPG] = Factory::create_decoder(ImageFormat::MJPG);
+    decoders[ImageFormat::YUYV] =
+        Factory::create_decoder(ImageFormat::YUYV, decoder_options);
+    decoders[ImageFormat::MJPG] =
+        Factory::create_decoder(ImageFormat::MJPG, decoder_options);
+    // H264 硬件解码器在第一个关键帧到达时才打开设备，之前的帧显示为空
+    decoders[ImageFormat::H264] =
+        Factory::create_decoder(ImageFormat::H264, decoder_options);
+    decoders[ImageFormat::NV12] =
+        Factory::create_decoder(ImageFormat::NV12, decoder_options);
+    decoders[ImageFormat::NV16] =
+        Factory::create_decoder(ImageFormat::NV16, decoder_options);
+    // 解码输出缓冲池：分辨率稳定后每帧解码不再分配内存
+    FramePool frame_pool;
+
+    // MJPEG 单核解码跟不上高帧率时使用多线程流水线，结果按帧版本顺序交付
+    std::unique_ptr<DecodePipeline> mjpg_pipeline;
+    auto start_pipeline = [&]() {
+      if (!decode_config_loaded)
+        return;
+      try {
+        mjpg_pipeline = Factory::create_decoder(
+            ImageFormat::MJPG,
+            ConfigManager::get_instance().get_decode_config());
+        std::cout << "ConsumerGUI: MJPEG decode pipeline started with "
+                  << mjpg_pipeline->get_thread_count() << " threads"
+                  << std::endl;
+      } catch (const std::exception &e) {
+        std::cout << "ConsumerGUI: MJPEG decode pipeline disabled ("
+                  << e.what() << "), decoding on the display thread"
+                  << std::endl;
+      }
+    };
+    start_pipeline();
+
+    // 可选的解码缓存：多个消费者共享服务进程的 MJPEG 解码结果，取不到时本地解码
+    const std::string cache_name =
+        argc > 2 ? argv[2] : shm_config.decode_cache.name;
+    std::unique_ptr<DecodeCacheClient> decode_cache;
+    if (!cache_name.empty()) {
+      decode_cache = std::make_unique<DecodeCacheClient>(
+          cache_name, shm_transport, shm_config.map_options);
+      std::cout << "ConsumerGUI: Using decode cache '" << cache_name << "'"
+                << std::endl;
+    }
+    cv::Mat cached_frame; // 缓存结果的可写副本（叠加状态文字）
 
     // 4. 创建窗口
     const std::string window_name = "Dynamic Video Stream";
@@ -77,31 +146,74 @@ int main() {
 
     // 5. 主循环变量
     uint64_t last_processed_version = 0;
-    std::vector<uint8_t> buffer(10 * 1024 * 1024);
 
     // 性能统计
     auto last_log_time = std::chrono::steady_clock::now();
     int frames_processed = 0;
     double display_fps = 0.0;
     ImageFormat last_format = ImageFormat::YUYV; // 跟踪格式变化
+    LatencyTracker latency; // 采集 -> 解码完成各阶段延迟
+
+    // 叠加状态信息并显示一帧
+    auto show_frame = [&](cv::Mat &bgr_frame, const ImageHeader &header) {
+      if (bgr_frame.empty())
+        return;
+      // 更新状态信息显示，包含实际格式名称
+      std::string info_text =
+          "Format: " + std::string(getFormatName(header.format)) + " (" +
+          std::to_string((int)header.format) + ")" +
+          " | FPS: " + std::to_string((int)display_fps) + " | " +
+          std::to_string(header.width) + "x" + std::to_string(header.height) +
+          " | Size: " + std::to_string(header.data_size) + "B";
+      cv::putText(bgr_frame, info_text, cv::Point(10, 30),
+                  cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 255, 0), 2);
+
+      cv::imshow(window_name, bgr_frame);
+      frames_processed++;
+    };
 
     std::cout
         << "ConsumerGUI: Starting video display. Press 'q' or ESC to exit."
         << std::endl;
 
     while (true) {
-      uint32_t width, height, channels;
-      size_t data_size;
-      uint64_t frame_version, timestamp_us;
-      ImageFormat format;
-      uint8_t frame_type;
-
-      ShmStatus status = shm_transport.read_image(
-          buffer.data(), buffer.size(), &width, &height, &channels, &data_size,
-          &frame_version, &timestamp_us, &format, &frame_type);
-
-      if (status == ShmStatus::Success &&
-          frame_version > last_processed_version) {
+      // 阻塞等待新帧（futex唤醒），超时保证窗口事件仍能及时处理
+      ShmStatus wait_status =
+          shm_transport.wait_for_new_frame(last_processed_version, 10);
+      if (wait_status == ShmStatus::ProducerRestarted ||
+          wait_status == ShmStatus::NotInitialized) {
+        // 生产者重建了段：重新附加，新生产者的帧版本从头计数，
+        // 流水线中按旧版本排序的在途帧一并丢弃
+        std::cout << "ConsumerGUI: Producer restarted, re-attaching..."
+                  << std::endl;
+        mjpg_pipeline.reset();
+        while (shm_transport.reconnect(100) != ShmStatus::Success) {
+          char key = (char)cv::waitKey(1);
+          if (key == 'q' || key == 27)
+            break;
+        }
+        if (!shm_transport.is_initialized())
+          break;
+        std::cout << "ConsumerGUI: Re-attached (generation "
+                  << shm_transport.get_generation() << ")" << std::endl;
+        last_processed_version = 0;
+        start_pipeline();
+        continue;
+      }
+
+      // 零拷贝读取：解码器直接读取共享内存中的图像数据，
+      // image 析构前该槽位不会被写者覆盖
+      ReadImageGuard image = shm_transport.acquire_image();
+
+      if (image.is_valid() && image.frame_version() > last_processed_version) {
+        const ImageHeader &header = image.header();
+        uint32_t width = header.width, height = header.height;
+        uint32_t channels = header.channels;
+        size_t data_size = header.data_size;
+        uint64_t frame_version = image.frame_version();
+        uint64_t timestamp_us = image.timestamp_us();
+        ImageFormat format = header.format;
+        uint8_t frame_type = header.frame_type;
         last_processed_version = frame_version;
 
         // 检测格式变化并输出详细信息
@@ -137,43 +249,59 @@ int main() {
           std::cout << "================================" << std::endl;
         }
 
-        // 4. 根据收到的 format 查找正确的解码器
-        auto it = decoders.find(format);
-        if (it != decoders.end() && it->second) {
-          auto processing_start = std::chrono::steady_clock::now();
-
-          try {
-            // 5. 使用找到的解码器进行解码
-            ImageHeader header = {
-                format,    width, height, channels, (uint32_t)data_size,
-                frame_type};
-            cv::Mat bgr_frame = it->second->decode(buffer.data(), header);
-
-            if (!bgr_frame.empty()) {
-              // 更新状态信息显示，包含实际格式名称
-              std::string info_text =
-                  "Format: " + std::string(getFormatName(format)) + " (" +
-                  std::to_string((int)format) + ")" +
-                  " | FPS: " + std::to_string((int)display_fps) + " | " +
-                  std::to_string(width) + "x" + std::to_string(height) +
-                  " | Size: " + std::to_string(data_size) + "B";
-              cv::putText(bgr_frame, info_text, cv::Point(10, 30),
-                          cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 255, 0),
-                          2);
-
-              cv::imshow(window_name, bgr_frame);
-              frames_processed++;
-            }
-          } catch (const cv::Exception &e) {
-            std::cerr << "ConsumerGUI: Decoding error for format "
-                      << getFormatName(format) << " (" << (int)format
-                      << "): " << e.what() << std::endl;
+        // 4. MJPEG 先查解码缓存，其次交给并行流水线，结果在下方按序取回显示
+        bool served_from_cache = false;
+        if (format == ImageFormat::MJPG && decode_cache) {
+          ReadImageGuard cached = decode_cache->acquire(
+              frame_version, shm_config.decode_cache.request_timeout_ms);
+          if (cached.is_valid()) {
+            const ImageHeader &cached_header = cached.header();
+            cv::Mat(cached_header.height, cached_header.width, CV_8UC3,
+                    (void *)cached.data())
+                .copyTo(cached_frame);
+            latency.record(FrameTimeline::from(
+                header, image.acquire_timestamp_us(), monotonic_now_us()));
+            show_frame(cached_frame, header);
+            served_from_cache = true;
           }
+        }
+        if (served_from_cache) {
+          // 已显示缓存中的解码结果
+        } else if (format == ImageFormat::MJPG && mjpg_pipeline) {
+          mjpg_pipeline->submit(image);
         } else {
-          std::cerr << "ConsumerGUI: No decoder found for format "
-                    << getFormatName(format) << " (" << (int)format << ")"
-                    << std::endl;
+          // 根据收到的 format 查找正确的解码器
+          auto it = decoders.find(format);
+          if (it != decoders.end() && it->second) {
+            try {
+              // 5. 使用找到的解码器解码到缓冲池中复用的输出帧
+              cv::Mat bgr_frame = frame_pool.decode(*it->second, image);
+              latency.record(FrameTimeline::from(
+                  header, image.acquire_timestamp_us(), monotonic_now_us()));
+              show_frame(bgr_frame, header);
+            } catch (const std::exception &e) {
+              std::cerr << "ConsumerGUI: Decoding error for format "
+                        << getFormatName(format) << " (" << (int)format
+                        << "): " << e.what() << std::endl;
+            }
+          } else {
+            std::cerr << "ConsumerGUI: No decoder found for format "
+                      << getFormatName(format) << " (" << (int)format << ")"
+                      << std::endl;
+          }
+        }
+      }
+
+      // 取回流水线已按序解码完成的帧，只显示其中最新的一帧
+      if (mjpg_pipeline) {
+        DecodedFrame decoded, latest;
+        while (mjpg_pipeline->poll(decoded)) {
+          latency.record(FrameTimeline::from(decoded.header,
+                                             decoded.acquire_timestamp_us,
+                                             decoded.decoded_timestamp_us));
+          latest = std::move(decoded);
         }
+        show_frame(latest.frame, latest.header);
       }
 
       // 性能统计
@@ -186,7 +314,29 @@ int main() {
         std::cout << "ConsumerGUI: Display FPS: " << std::fixed
                   << std::setprecision(1) << display_fps
                   << ", Format: " << getFormatName(last_format) << " ("
-                  << (int)last_format << ")" << std::endl;
+                  << (int)last_format << ")"
+                  << ", Decode allocs: " << frame_pool.get_stats().allocations
+                  << std::endl;
+        std::cout << "ConsumerGUI: Latency "
+                  << LatencyTracker::format(latency.get_report()) << std::endl;
+        latency.reset();
+        if (decode_cache && decode_cache->is_attached()) {
+          DecodeCacheStats stats = decode_cache->get_stats();
+          std::cout << "ConsumerGUI: Decode cache hits: " << stats.hits
+                    << ", misses: " << stats.misses
+                    << ", fallbacks: " << stats.fallbacks
+                    << ", decodes: " << stats.decodes << std::endl;
+        }
+        if (mjpg_pipeline) {
+          DecodePipelineStats stats = mjpg_pipeline->get_stats();
+          std::cout << "ConsumerGUI: Decode pipeline queue: "
+                    << stats.queue_depth << ", reorder: "
+                    << stats.reorder_depth << ", in flight: "
+                    << stats.in_flight << "/" << stats.max_in_flight
+                    << ", decoded: " << stats.decoded
+                    << ", dropped: " << stats.dropped
+                    << ", errors: " << stats.decode_errors << std::endl;
+        }
         last_log_time = now;
         frames_processed = 0;
       }
@@ -195,11 +345,6 @@ int main() {
       char key = (char)cv::waitKey(1);
       if (key == 'q' || key == 27)
         break;
-
-      // 避免空转CPU
-      if (status != ShmStatus::Success) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(5));
-      }
     }
 
     // 清理
@@ -22,18 +22,28 @@ int main() {
 
   std::cout << "Consumer: Waiting for producer..." << std::endl;
 
-  // 初次连接
-  while (yuyv_shm.open_and_map(32 * 1024 * 1024, 10 * 1024 * 1024, 3) !=
-         ShmStatus::Success) {
-    std::cout << "Consumer: Waiting for shared memory..." << std::endl;
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+  // 初次连接：段几何参数从段头部读取，生产者一旦完成初始化即可附加
+  if (yuyv_shm.reconnect(-1) != ShmStatus::Success) {
+    std::cerr << "Consumer: Failed to attach to shared memory." << std::endl;
+    return 1;
+  }
+  std::cout << "Consumer: Successfully connected to 'yuyv_shm' ("
+            << yuyv_shm.get_buffer_count() << " x "
+            << yuyv_shm.get_buffer_size() << " bytes, generation "
+            << yuyv_shm.get_generation() << ")!" << std::endl;
+
+  // 队列模式下注册为消费者，逐帧保存而不是只取最新帧
+  uint32_t consumer_id = ShmBufferControl::NO_CONSUMER;
+  if (yuyv_shm.get_ring_mode() == ShmRingMode::Queue &&
+      yuyv_shm.register_consumer(&consumer_id) == ShmStatus::Success) {
+    std::cout << "Consumer: Registered as queue consumer " << consumer_id
+              << std::endl;
   }
-  std::cout << "Consumer: Successfully connected to 'yuyv_shm'!" << std::endl;
 
   uint64_t last_processed_version = 0;
   int frames_saved_count = 0;
   const int max_frames_to_save = 100;
-  std::vector<uint8_t> buffer(10 * 1024 * 1024);
+  std::vector<uint8_t> buffer(yuyv_shm.get_buffer_size());
 
   while (frames_saved_count < max_frames_to_save) {
     uint32_t width, height, channels;
@@ -42,9 +52,16 @@ int main() {
     ImageFormat format;
     uint8_t frame_type;
 
-    ShmStatus status = yuyv_shm.read_image(
-        buffer.data(), buffer.size(), &width, &height, &channels, &data_size,
-        &frame_version, &timestamp_us, &format, &frame_type);
+    ShmStatus status =
+        consumer_id != ShmBufferControl::NO_CONSUMER
+            ? yuyv_shm.read_next_image(consumer_id, buffer.data(),
+                                       buffer.size(), &width, &height,
+                                       &channels, &data_size, &frame_version,
+                                       &timestamp_us, &format, &frame_type)
+            : yuyv_shm.read_image(buffer.data(), buffer.size(), &width,
+                                  &height, &channels, &data_size,
+                                  &frame_version, &timestamp_us, &format,
+                                  &frame_type);
 
     if (status == ShmStatus::Success &&
         frame_version > last_processed_version) {
@@ -73,25 +90,46 @@ int main() {
       } catch (const cv::Exception &e) {
         std::cerr << "  FAILURE: OpenCV exception: " << e.what() << std::endl;
       }
-    } else if (status == ShmStatus::NotInitialized ||
-               status == ShmStatus::ShmOpenFailed) {
-      std::cerr << "Consumer: SHM disconnected, trying to reconnect..."
-                << std::endl;
-      while (yuyv_shm.open_and_map(32 * 1024 * 1024, 10 * 1024 * 1024, 3) !=
-             ShmStatus::Success) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-      }
-      std::cout << "Consumer: Reconnected to shared memory!" << std::endl;
-    } else if (status != ShmStatus::NoDataAvailable) {
+    } else if (status != ShmStatus::NoDataAvailable &&
+               status != ShmStatus::NotInitialized) {
       std::cerr << "Consumer: read_image returned status: "
                 << shm_status_to_string(status) << std::endl;
     }
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    // 阻塞等待下一帧提交；生产者重建段时会立即唤醒，超时后检查段名是否被替换
+    ShmStatus wait_status =
+        yuyv_shm.wait_for_new_frame(last_processed_version, 100);
+    if (wait_status == ShmStatus::ProducerRestarted ||
+        wait_status == ShmStatus::NotInitialized ||
+        (wait_status == ShmStatus::Timeout && yuyv_shm.producer_restarted())) {
+      std::cerr << "Consumer: Producer restarted, re-attaching..." << std::endl;
+      bool queue_consumer = consumer_id != ShmBufferControl::NO_CONSUMER;
+      if (queue_consumer) // 新生产者可能接管同一个段，先归还游标
+        yuyv_shm.unregister_consumer(consumer_id);
+      consumer_id = ShmBufferControl::NO_CONSUMER;
+      if (yuyv_shm.reconnect(-1) != ShmStatus::Success)
+        break;
+      std::cout << "Consumer: Reconnected to shared memory (generation "
+                << yuyv_shm.get_generation() << ")!" << std::endl;
+      // 新生产者的帧版本从头开始计数
+      last_processed_version = 0;
+      buffer.resize(yuyv_shm.get_buffer_size());
+      if (queue_consumer && yuyv_shm.get_ring_mode() == ShmRingMode::Queue &&
+          yuyv_shm.register_consumer(&consumer_id) != ShmStatus::Success)
+        consumer_id = ShmBufferControl::NO_CONSUMER;
+    }
   }
 
   std::cout << "Consumer: Finished saving " << frames_saved_count
             << " frames. Exiting." << std::endl;
+  if (consumer_id != ShmBufferControl::NO_CONSUMER) {
+    ShmConsumerStats stats;
+    if (yuyv_shm.get_consumer_stats(consumer_id, &stats) == ShmStatus::Success)
+      std::cout << "Consumer: consumed " << stats.frames_consumed
+                << ", dropped " << stats.frames_dropped << ", lag "
+                << stats.lag << std::endl;
+    yuyv_shm.unregister_consumer(consumer_id);
+  }
   yuyv_shm.unmap_and_close();
   return 0;
 }
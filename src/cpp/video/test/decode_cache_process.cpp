@@ -0,0 +1,119 @@
+/**
+ * @file decode_cache_process.cpp
+ * @brief 解码缓存服务进程
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 附加到主流共享内存（通常为 MJPEG），按消费者的请求把每帧解码一次，
+ * BGR 结果以主流帧版本号为键发布到缓存共享内存（见 DecodeCacheService）。
+ * 配置了同名 decode_cache 的消费者先查缓存，未命中时才本地解码。
+ * 每两秒打印一次命中统计，Ctrl-C 删除缓存后退出。
+ *
+ * 用法：decode_cache_process [shm_name] [cache_name] [buffer_count]
+ */
+
+#include "config/config_manager.h"
+#include "video/decode_cache.h"
+#include "video/image_shm_manager.h"
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+static volatile std::sig_atomic_t g_running = 1;
+
+static void handle_signal(int) { g_running = 0; }
+
+/**
+ * @brief 打印解码速率与命中率
+ */
+static void print_stats(const DecodeCacheStats &stats,
+                        const DecodeCacheStats &prev, double seconds) {
+  const uint64_t lookups = stats.hits + stats.misses + stats.fallbacks;
+  const double hit_rate = lookups ? 100.0 * stats.hits / lookups : 0.0;
+  std::cout << "DecodeCache: " << std::fixed << std::setprecision(1)
+            << (stats.decodes - prev.decodes) / seconds << " decodes/s, hits "
+            << stats.hits << ", misses " << stats.misses << ", fallbacks "
+            << stats.fallbacks << " (hit rate " << hit_rate << "%), expired "
+            << stats.expired << ", errors " << stats.errors << std::endl;
+}
+
+int main(int argc, char **argv) {
+  std::string shm_name;
+  ShmMapOptions map_options;
+  DecodeCacheConfig config{std::string(), 4, 40};
+  try {
+    ConfigManager::get_instance().load_shm_config(
+        "../../../config/shmConfig.json");
+    const auto &shm_config = ConfigManager::get_instance().get_shm_config();
+    shm_name = shm_config.name;
+    map_options = shm_config.map_options;
+    config = shm_config.decode_cache;
+  } catch (const std::exception &e) {
+    if (argc < 2) {
+      std::cerr << "decode_cache_process: " << e.what() << std::endl;
+      std::cerr << "Usage: " << argv[0]
+                << " [shm_name] [cache_name] [buffer_count]" << std::endl;
+      return 1;
+    }
+  }
+  if (argc > 1)
+    shm_name = argv[1];
+  if (argc > 2)
+    config.name = argv[2];
+  if (argc > 3)
+    config.buffer_count = static_cast<uint32_t>(std::atoi(argv[3]));
+  if (config.name.empty())
+    config.name = shm_name + "_bgr";
+  if (config.buffer_count < 2) {
+    std::cerr << "decode_cache_process: buffer_count must be at least 2"
+              << std::endl;
+    return 1;
+  }
+
+  std::signal(SIGINT, handle_signal);
+  std::signal(SIGTERM, handle_signal);
+
+  ImageShmManager source(shm_name, map_options);
+  std::cout << "DecodeCache: Waiting for producer '" << shm_name << "'..."
+            << std::endl;
+  while (g_running && source.reconnect(1000) != ShmStatus::Success) {
+  }
+  if (!g_running)
+    return 0;
+
+  DecodeCacheService service(source, config, map_options);
+  try {
+    service.start();
+  } catch (const std::exception &e) {
+    std::cerr << "DecodeCache: " << e.what() << std::endl;
+    return 1;
+  }
+
+  DecodeCacheStats prev = service.get_stats();
+  auto last_report = std::chrono::steady_clock::now();
+  while (g_running) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - last_report).count();
+    if (seconds >= 2.0) {
+      DecodeCacheStats stats = service.get_stats();
+      print_stats(stats, prev, seconds);
+      prev = stats;
+      last_report = now;
+    }
+  }
+
+  print_stats(service.get_stats(), prev,
+              std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                            last_report)
+                  .count());
+  service.stop();
+  std::cout << "DecodeCache: Stopped." << std::endl;
+  return 0;
+}
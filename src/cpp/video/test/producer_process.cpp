@@ -24,7 +24,8 @@
  * - **多格式支持**: YUYV、MJPEG等主流视频格式
  * - **工厂模式**: 灵活的设备创建和管理机制
  * - **异常安全**: RAII资源管理和完善的错误处理
- * - **实时监控**: 每30帧输出一次性能统计信息
+ * - **流水线发布**: 捕获与共享内存写入分属两个线程，经无锁队列交接
+ * - **实时监控**: 每秒输出一次性能统计信息
  *
  * ## 使用示例
  * @code{.bash}
@@ -52,12 +53,17 @@
 // ==========================================================
 #include "config/config_manager.h"
 #include "config/factory.h"
+#include "video/capture_pipeline.h"
+#include "video/derived_stream_publisher.h"
 #include "video/image_shm_manager.h"
 #include <atomic>
 #include <chrono>
 #include <csignal>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
 
 /**
  * @brief 全局运行状态标志
@@ -97,14 +103,15 @@ void signal_handler(int signal) {
  * 程序执行流程：
  * 1. **信号注册**: 注册SIGINT和SIGTERM信号处理函数
  * 2. **配置加载**: 从JSON文件加载视频和共享内存配置
- * 3. **设备创建**: 使用Factory模式创建V4L2捕获器
- * 4. **内存初始化**: 创建并初始化共享内存缓冲区
- * 5. **启动捕获**: 开始V4L2视频流捕获
- * 6. **主循环**: 连续捕获帧并写入共享内存
+ * 3. **内存初始化**: 为每个摄像头创建并初始化共享内存通道
+ * 4. **设备创建**: 使用Factory模式创建V4L2捕获器，并尝试绑定零拷贝输出
+ * 5. **启动捕获**: 开始全部V4L2视频流捕获
+ * 6. **流水线**: 捕获线程以 epoll 等待全部设备出队、发布线程写入共享内存，
+ *    主线程输出统计
  * 7. **资源清理**: 停止捕获、释放内存、清理资源
  *
  * ## 性能特点
- * - 📊 **实时统计**: 每处理30帧输出一次FPS统计
+ * - 📊 **实时统计**: 每秒输出一次FPS与丢帧统计
  * - ⚡ **高效传输**: 零拷贝共享内存数据传输
  * - 🔄 **动态适应**: 自动适应不同视频格式和分辨率
  * - 🛡️ **异常处理**: 完善的错误处理和资源清理机制
@@ -128,8 +135,8 @@ void signal_handler(int signal) {
  * Producer: Loaded config - Device: /dev/video0, PixelFormat: 1196444237,
  * Resolution: 1280x720 Producer: Shared memory initialized with 3 buffers.
  * Producer: Started capture stream.
- * Producer: Processed 30 frames, FPS: 29.8, Format: 3, Size: 184320 bytes
- * Producer: Processed 60 frames, FPS: 30.1, Format: 3, Size: 184320 bytes
+ * Producer: Processed 30 frames, FPS: 29.8, Dropped: 0, Write failures: 0, Queue: 0
+ * Producer: Processed 60 frames, FPS: 30.1, Dropped: 0, Write failures: 0, Queue: 1
  * Producer exited cleanly.
  * @endcode
  */
@@ -153,49 +160,93 @@ int main() {
     ConfigManager::get_instance().load_shm_config(
         "../../../config/shmConfig.json");
 
-    const auto &v4l2_config = ConfigManager::get_instance().get_v4l2_config();
+    const auto &v4l2_configs = ConfigManager::get_instance().get_v4l2_configs();
     const auto &shm_config = ConfigManager::get_instance().get_shm_config();
 
     // 输出加载的配置信息，便于调试
-    std::cout << "Producer: Loaded config - Device: " << v4l2_config.device_path
-              << ", PixelFormat: " << v4l2_config.pixel_format_v4l2
-              << ", Resolution: " << v4l2_config.width << "x"
-              << v4l2_config.height << std::endl;
+    for (const auto &v4l2_config : v4l2_configs)
+      std::cout << "Producer: Loaded config - Device: "
+                << v4l2_config.device_path
+                << ", PixelFormat: " << v4l2_config.pixel_format_v4l2
+                << ", Resolution: " << v4l2_config.width << "x"
+                << v4l2_config.height << std::endl;
 
     // ================================================================
-    // 2. 设备创建阶段
+    // 2. 共享内存初始化阶段
     // ================================================================
 
     /**
-     * 使用工厂模式创建V4L2捕获器实例
-     * Factory::create_capture() 会根据配置自动选择合适的捕获器实现
+     * 每个摄像头一个共享内存通道，几何参数均取自 shmConfig.json
+     * 先于捕获器创建，保证零拷贝模式下捕获器持有的槽位先于共享内存释放
      */
-    auto producer = Factory::create_capture(v4l2_config);
-    if (!producer) {
-      throw std::runtime_error("Failed to create producer from factory.");
+    ShmCreateOptions shm_options;
+    shm_options.ring_mode = shm_config.ring_mode;
+    shm_options.overflow_policy = shm_config.overflow_policy;
+    shm_options.allocator = shm_config.allocator;
+
+    std::vector<std::unique_ptr<ImageShmManager>> shm_channels;
+    std::vector<std::string> channel_names;
+    for (const auto &v4l2_config : v4l2_configs) {
+      const std::string name = v4l2_config.shm_name.empty()
+                                    ? shm_config.name
+                                    : v4l2_config.shm_name;
+      auto shm =
+          std::make_unique<ImageShmManager>(name, shm_config.map_options);
+      shm->unlink_shm(); // 清理之前可能残留的共享内存
+
+      // 初始化共享内存缓冲区系统
+      if (shm->create_and_init(shm_config.total_size_bytes,
+                               shm_config.buffer_size_bytes,
+                               shm_config.buffer_count,
+                               shm_options) != ShmStatus::Success) {
+        throw std::runtime_error("Failed to initialize shared memory '" +
+                                 name + "'.");
+      }
+      std::cout << "Producer: Shared memory '" << name
+                << "' initialized with " << shm_config.buffer_count
+                << " buffers." << std::endl;
+      shm_channels.push_back(std::move(shm));
+      channel_names.push_back(name);
     }
 
+    /**
+     * 可选的派生流：后台线程每帧解码一次主流，发布预览/亮度等低成本流，
+     * 轻量消费者连接派生流即可，避免各自重复解码和缩放。
+     * 派生流从第一个摄像头的通道派生
+     */
+    DerivedStreamPublisher derived_streams(*shm_channels.front(),
+                                           shm_config.derived_streams,
+                                           shm_config.map_options);
+    if (!shm_config.derived_streams.empty())
+      derived_streams.start();
+
     // ================================================================
-    // 3. 共享内存初始化阶段
+    // 3. 设备创建阶段
     // ================================================================
 
     /**
-     * 创建共享内存传输通道
-     * ImageShmManager 提供高效的图像数据共享内存管理
+     * 使用工厂模式创建V4L2捕获器实例
+     * Factory::create_capture() 会根据配置自动选择合适的捕获器实现
+     *
+     * 零拷贝模式（io_method: userptr）下，驱动直接写入共享内存槽位，
+     * 出队的帧已提交，无需再调用 write_image()
      */
-    ImageShmManager shm_transport(shm_config.name);
-    shm_transport.unlink_shm(); // 清理之前可能残留的共享内存
-
-    // 初始化共享内存缓冲区系统
-    if (shm_transport.create_and_init(
-            shm_config.total_size_bytes, shm_config.buffer_size_bytes,
-            shm_config.buffer_count) != ShmStatus::Success) {
-      throw std::runtime_error("Failed to initialize shared memory.");
+    std::vector<std::unique_ptr<ICapture>> producers;
+    std::vector<CaptureChannel> channels;
+    for (size_t i = 0; i < v4l2_configs.size(); ++i) {
+      auto producer = Factory::create_capture(v4l2_configs[i]);
+      if (!producer) {
+        throw std::runtime_error("Failed to create producer from factory.");
+      }
+      bool zero_copy = producer->bind_output(shm_channels[i].get());
+      std::cout << "Producer: " << v4l2_configs[i].device_path
+                << " IO mode: "
+                << (zero_copy ? "zero-copy (USERPTR)" : "copy (MMAP)")
+                << std::endl;
+      channels.push_back({producer.get(), shm_channels[i].get()});
+      producers.push_back(std::move(producer));
     }
 
-    std::cout << "Producer: Shared memory initialized with "
-              << shm_config.buffer_count << " buffers." << std::endl;
-
     // ================================================================
     // 4. 启动捕获阶段
     // ================================================================
@@ -204,77 +255,67 @@ int main() {
      * 启动V4L2视频流捕获
      * 这将初始化摄像头设备并开始数据流
      */
-    producer->start();
-    std::cout << "Producer: Started capture stream." << std::endl;
+    for (auto &producer : producers)
+      producer->start();
+    std::cout << "Producer: Started " << producers.size()
+              << " capture stream(s)." << std::endl;
 
     // ================================================================
-    // 5. 主循环 - 视频捕获与传输
+    // 5. 捕获/发布流水线 - 主线程只负责统计输出
     // ================================================================
 
-    uint64_t frame_version = 1; ///< 帧版本号，用于消费者检测新帧
-    uint64_t frames_processed = 0; ///< 已处理帧数统计
+    /**
+     * 捕获线程用一个 epoll 循环等待所有设备，只做 DQBUF 并通过无锁队列
+     * 把缓冲区交给发布线程，发布线程写入对应共享内存后才 QBUF；
+     * 摄像头数量增加时线程数不变，统计输出留在主线程，不会推迟下一次出队。
+     * 线程绑定/调度使用第一个设备的 threads 配置
+     */
+    CapturePipeline pipeline(channels, v4l2_configs.front().threads);
+    pipeline.start();
+
     auto start_time = std::chrono::steady_clock::now(); ///< 性能统计起始时间
+    auto last_report = start_time;
 
     /**
-     * @brief 主处理循环
+     * @brief 统计循环
      *
-     * 循环执行以下操作：
-     * 1. 从V4L2设备捕获一帧数据
-     * 2. 检查帧数据的有效性
-     * 3. 将帧数据写入共享内存
-     * 4. 更新统计信息并定期输出
-     * 5. 检查退出信号
+     * 每秒输出一次统计信息（多摄像头时逐通道输出），包括：
+     * - 总发布帧数与实时FPS
+     * - 发布线程积压时丢弃的帧数
+     * - 共享内存写入失败次数
      */
     while (g_running.load()) {
-      CapturedFrame frame_data;
-
-      // 从捕获器获取一帧数据
-      if (producer->capture(frame_data, g_running) && frame_data.data) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      auto now = std::chrono::steady_clock::now();
+      if (now - last_report < std::chrono::seconds(1))
+        continue;
+      last_report = now;
 
-        /**
-         * @brief 写入共享内存
-         *
-         * 根据视频格式计算通道数：
-         * - YUYV格式: 2通道 (Y + UV)
-         * - 其他格式: 3通道 (RGB或类似)
-         */
-        ShmStatus status = shm_transport.write_image(
-            frame_data.data, frame_data.size, frame_data.width,
-            frame_data.height,
-            (frame_data.format == ImageFormat::YUYV) ? 2 : 3, // 通道数近似值
-            frame_version++, frame_data.format, frame_data.cv_type);
-
-        if (status == ShmStatus::Success) {
-          frames_processed++;
-
-          /**
-           * @brief 性能统计输出
-           *
-           * 每处理30帧输出一次统计信息，包括：
-           * - 总处理帧数
-           * - 实时FPS
-           * - 当前帧格式
-           * - 帧数据大小
-           */
-          if (frames_processed % 30 == 0) {
-            auto elapsed = std::chrono::steady_clock::now() - start_time;
-            double fps =
-                frames_processed * 1000.0 /
-                std::chrono::duration_cast<std::chrono::milliseconds>(elapsed)
-                    .count();
-            std::cout << "Producer: Processed " << frames_processed
-                      << " frames, FPS: " << std::fixed << std::setprecision(1)
-                      << fps << ", Format: " << (int)frame_data.format
-                      << ", Size: " << frame_data.size << " bytes" << std::endl;
-          }
-        } else {
-          std::cerr << "Producer: Failed to write frame to SHM" << std::endl;
-        }
+      double elapsed_ms =
+          std::chrono::duration_cast<std::chrono::milliseconds>(now -
+                                                                start_time)
+              .count();
+      for (size_t i = 0; i < pipeline.get_channel_count(); ++i) {
+        CapturePipelineStats stats = pipeline.get_stats(i);
+        double fps =
+            elapsed_ms > 0 ? stats.published * 1000.0 / elapsed_ms : 0;
+        std::cout << "Producer: ";
+        if (pipeline.get_channel_count() > 1)
+          std::cout << "[" << channel_names[i] << "] ";
+        std::cout << "Processed " << stats.published
+                  << " frames, FPS: " << std::fixed << std::setprecision(1)
+                  << fps << ", Dropped: " << stats.dropped
+                  << ", Write failures: " << stats.publish_failures
+                  << ", Queue: " << stats.queue_depth << std::endl;
+      }
+      if (!shm_config.derived_streams.empty()) {
+        DerivedStreamStats derived = derived_streams.get_stats();
+        std::cout << "Producer: Derived streams - source frames: "
+                  << derived.source_frames
+                  << ", skipped: " << derived.source_skipped
+                  << ", published: " << derived.frames_published
+                  << ", errors: " << derived.errors << std::endl;
       }
-
-      // 检查退出信号，确保响应用户中断
-      if (!g_running.load())
-        break;
     }
 
     // ================================================================
@@ -285,13 +326,19 @@ int main() {
      * @brief 优雅关闭和资源清理
      *
      * 按照正确的顺序清理资源：
-     * 1. 停止视频捕获流
-     * 2. 解除共享内存映射
-     * 3. 清理共享内存对象
+     * 1. 停止捕获/发布线程并归还全部缓冲区
+     * 2. 停止视频捕获流
+     * 3. 解除共享内存映射
+     * 4. 清理共享内存对象
      */
-    producer->stop();                // 停止V4L2捕获流
-    shm_transport.unmap_and_close(); // 解除内存映射
-    shm_transport.unlink_shm();      // 清理共享内存对象
+    pipeline.stop(); // 停止捕获/发布线程
+    for (auto &producer : producers)
+      producer->stop();     // 停止V4L2捕获流
+    derived_streams.stop(); // 停止派生流并删除其共享内存
+    for (auto &shm : shm_channels) {
+      shm->unmap_and_close(); // 解除内存映射
+      shm->unlink_shm();      // 清理共享内存对象
+    }
 
   } catch (const std::exception &e) {
     /**
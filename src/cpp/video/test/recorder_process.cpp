@@ -0,0 +1,192 @@
+/**
+ * @file recorder_process.cpp
+ * @brief 共享内存原始帧录制工具
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 附加到图像共享内存，把每帧的原始负载与 ImageHeader 不经转换地追加到
+ * 预分配的内存映射段文件（见 FrameRecorder），按大小轮换并写出时间戳索引。
+ * 队列模式下注册为消费者逐帧录制；最新帧模式下每次唤醒取回环内全部
+ * 未录制的帧，尽量不漏帧。生产者重启后自动重新附加，Ctrl-C 封存当前段退出。
+ *
+ * 用法：recorder_process [shm_name] [output_dir] [segment_mb] [max_segments]
+ */
+
+#include "config/config_manager.h"
+#include "video/frame_recorder.h"
+#include "video/image_shm_manager.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static volatile std::sig_atomic_t g_running = 1;
+
+static void handle_signal(int) { g_running = 0; }
+
+/**
+ * @brief 每秒打印一次录制速率
+ */
+static void print_progress(const FrameRecorderStats &stats,
+                           const FrameRecorderStats &prev, double seconds,
+                           const std::string &segment) {
+  double fps = (stats.frames_recorded - prev.frames_recorded) / seconds;
+  double mbps =
+      (stats.bytes_recorded - prev.bytes_recorded) / seconds / (1 << 20);
+  std::cout << "Recorder: " << std::fixed << std::setprecision(1) << fps
+            << " fps, " << mbps << " MB/s, total " << stats.frames_recorded
+            << " frames, missed " << stats.frames_missed << " -> " << segment
+            << std::endl;
+}
+
+/**
+ * @brief 按名称附加到共享内存，等待期间响应 Ctrl-C
+ * @return bool 是否附加成功
+ */
+static bool attach(ImageShmManager &shm) {
+  while (g_running) {
+    if (shm.reconnect(1000) == ShmStatus::Success)
+      return true;
+  }
+  return false;
+}
+
+int main(int argc, char **argv) {
+  std::string shm_name;
+  ShmMapOptions map_options;
+  try {
+    ConfigManager::get_instance().load_shm_config(
+        "../../../config/shmConfig.json");
+    const auto &shm_config = ConfigManager::get_instance().get_shm_config();
+    shm_name = shm_config.name;
+    map_options = shm_config.map_options;
+  } catch (const std::exception &e) {
+    if (argc < 2) {
+      std::cerr << "recorder_process: " << e.what() << std::endl;
+      std::cerr << "Usage: " << argv[0]
+                << " [shm_name] [output_dir] [segment_mb] [max_segments]"
+                << std::endl;
+      return 1;
+    }
+  }
+  if (argc > 1)
+    shm_name = argv[1];
+  FrameRecorderOptions options;
+  options.directory = argc > 2 ? argv[2] : "recordings";
+  if (argc > 3)
+    options.segment_size_bytes = std::strtoull(argv[3], nullptr, 10) << 20;
+  if (argc > 4)
+    options.max_segments = static_cast<uint32_t>(std::atoi(argv[4]));
+  options.prefix = shm_name;
+  while (!options.prefix.empty() && options.prefix.front() == '/')
+    options.prefix.erase(0, 1);
+
+  std::signal(SIGINT, handle_signal);
+  std::signal(SIGTERM, handle_signal);
+  system(("mkdir -p " + options.directory).c_str());
+
+  ImageShmManager shm(shm_name, map_options);
+  std::cout << "Recorder: Waiting for producer '" << shm_name << "'..."
+            << std::endl;
+  if (!attach(shm)) {
+    std::cerr << "Recorder: Failed to attach to shared memory." << std::endl;
+    return 1;
+  }
+
+  FrameRecorder recorder(options);
+  try {
+    recorder.open(shm_name);
+  } catch (const std::exception &e) {
+    std::cerr << "Recorder: " << e.what() << std::endl;
+    return 1;
+  }
+  std::cout << "Recorder: Recording '" << shm_name << "' to '"
+            << options.directory << "' (" << (options.segment_size_bytes >> 20)
+            << " MB segments)" << std::endl;
+
+  uint32_t consumer_id = ShmBufferControl::NO_CONSUMER;
+  if (shm.get_ring_mode() == ShmRingMode::Queue)
+    shm.register_consumer(&consumer_id);
+
+  uint64_t last_version = 0;
+  std::vector<ReadImageGuard> batch;
+  FrameRecorderStats prev = recorder.get_stats();
+  auto last_report = std::chrono::steady_clock::now();
+  try {
+    while (g_running) {
+      if (consumer_id != ShmBufferControl::NO_CONSUMER) {
+        // 队列模式：按版本顺序逐帧录制，写者不会覆盖未读帧
+        while (g_running) {
+          ReadImageGuard image = shm.acquire_next_image(consumer_id);
+          if (!image.is_valid())
+            break;
+          recorder.record(image);
+          last_version = image.frame_version();
+        }
+      } else {
+        // 最新帧模式：一次取回环内所有比 last_version 新的帧，守卫随 clear() 释放
+        uint64_t latest = shm.get_latest_frame_version();
+        if (latest > last_version) {
+          uint32_t k = static_cast<uint32_t>(
+              std::min<uint64_t>(latest - last_version,
+                                 std::max(shm.get_buffer_count(), 2u) - 1));
+          if (shm.acquire_image_batch(k, &batch) == ShmStatus::Success) {
+            for (const ReadImageGuard &image : batch) {
+              if (image.frame_version() <= last_version)
+                continue;
+              recorder.record(image);
+              last_version = image.frame_version();
+            }
+          }
+          batch.clear();
+        }
+      }
+
+      auto now = std::chrono::steady_clock::now();
+      double elapsed = std::chrono::duration<double>(now - last_report).count();
+      if (elapsed >= 1.0) {
+        print_progress(recorder.get_stats(), prev, elapsed,
+                       recorder.current_segment_path());
+        prev = recorder.get_stats();
+        last_report = now;
+      }
+
+      ShmStatus wait_status = shm.wait_for_new_frame(last_version, 100);
+      if (wait_status == ShmStatus::ProducerRestarted ||
+          wait_status == ShmStatus::NotInitialized ||
+          (wait_status == ShmStatus::Timeout && shm.producer_restarted())) {
+        std::cerr << "Recorder: Producer restarted, re-attaching..."
+                  << std::endl;
+        bool queue_consumer = consumer_id != ShmBufferControl::NO_CONSUMER;
+        if (queue_consumer)
+          shm.unregister_consumer(consumer_id);
+        consumer_id = ShmBufferControl::NO_CONSUMER;
+        if (!attach(shm))
+          break;
+        // 新生产者的帧版本从头开始计数
+        last_version = 0;
+        if (queue_consumer && shm.get_ring_mode() == ShmRingMode::Queue)
+          shm.register_consumer(&consumer_id);
+      }
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "Recorder: " << e.what() << std::endl;
+  }
+
+  recorder.close();
+  const FrameRecorderStats &stats = recorder.get_stats();
+  std::cout << "Recorder: Recorded " << stats.frames_recorded << " frames ("
+            << stats.bytes_recorded << " bytes) in " << stats.segments_opened
+            << " segments, missed " << stats.frames_missed << ", rejected "
+            << stats.frames_rejected << std::endl;
+  if (consumer_id != ShmBufferControl::NO_CONSUMER)
+    shm.unregister_consumer(consumer_id);
+  shm.unmap_and_close();
+  return 0;
+}
@@ -0,0 +1,523 @@
+/**
+ * @file shm_bench.cpp
+ * @brief 共享内存 IPC 与解码热路径基准测试
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 使用合成生产者，不需要摄像头。覆盖：
+ * - 提交 -> 可见延迟分位数（futex 阻塞等待与轮询两种读者）
+ * - 不同帧大小与 buffer_count 下的最大可持续帧率
+ * - 1~16 个并发读者时的写者帧率与读者延迟
+ * - YuyvDecoder / YuyvFastDecoder / MjpgDecoder 解码吞吐
+ *
+ * 结果以 JSON 输出到标准输出（或 --output 指定的文件），便于跨版本对比
+ * 无锁与零拷贝改动带来的回归。进度信息输出到标准错误。
+ *
+ * 用法：shm_bench [--quick] [--duration-ms N] [--output file.json]
+ */
+
+#include "common/ipc/shm_manager.h"
+#include "common/json/nlohmann_json/include/nlohmann/json.hpp"
+#include "config/factory.h"
+#include "video/image_shm_manager.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using nlohmann::json;
+
+namespace {
+
+/**
+ * @brief 命令行选项
+ */
+struct BenchOptions {
+  int duration_ms = 2000; ///< 每个测试点的持续时间
+  bool quick = false;     ///< 快速模式：缩短时间并减少测试点
+  std::string output;     ///< JSON 输出文件，为空时输出到标准输出
+};
+
+/// 640x480 YUYV 一帧的大小，作为默认帧大小
+constexpr size_t kVgaYuyvBytes = 640 * 480 * 2;
+
+uint64_t now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * @brief 基准专用共享内存段：构造时创建，析构时删除
+ */
+class BenchSegment {
+public:
+  /**
+   * @param frame_bytes 单帧大小
+   * @param buffer_count 缓冲区数量
+   * @throws std::runtime_error 当共享内存创建失败时抛出异常
+   */
+  BenchSegment(size_t frame_bytes, uint32_t buffer_count)
+      : name_("/shm_bench_" + std::to_string(getpid())), writer_(name_) {
+    size_t buffer_size =
+        ShmBufferControl::align_up(frame_bytes, ShmBufferControl::PAGE_SIZE);
+    size_t total_size =
+        ShmBufferControl::get_required_size(buffer_count, buffer_size);
+    writer_.unlink_shm();
+    if (writer_.create_and_init(total_size, buffer_size, buffer_count) !=
+        ShmStatus::Success)
+      throw std::runtime_error("shm_bench: Failed to create shared memory");
+  }
+
+  ~BenchSegment() {
+    writer_.unmap_and_close();
+    writer_.unlink_shm();
+  }
+
+  const std::string &name() const { return name_; }
+  ShmManager &writer() { return writer_; }
+
+private:
+  std::string name_;  ///< 段名称（按进程号区分，可并行运行多个实例）
+  ShmManager writer_; ///< 写者（创建者）
+};
+
+/**
+ * @brief 延迟样本的分位数摘要（微秒）
+ */
+json summarize_latency(std::vector<uint64_t> &samples_ns) {
+  json out = {{"samples", samples_ns.size()}};
+  if (samples_ns.empty())
+    return out;
+  std::sort(samples_ns.begin(), samples_ns.end());
+  auto percentile = [&](double p) {
+    size_t idx = (size_t)(p * (samples_ns.size() - 1) + 0.5);
+    return samples_ns[idx] / 1000.0;
+  };
+  uint64_t sum = 0;
+  for (uint64_t v : samples_ns)
+    sum += v;
+  out["mean_us"] = sum / 1000.0 / samples_ns.size();
+  out["p50_us"] = percentile(0.50);
+  out["p90_us"] = percentile(0.90);
+  out["p99_us"] = percentile(0.99);
+  out["p999_us"] = percentile(0.999);
+  out["max_us"] = samples_ns.back() / 1000.0;
+  return out;
+}
+
+/**
+ * @brief 读者线程：等待新帧并记录负载中写者时间戳到读取时刻的延迟
+ * @param poll true 表示忙轮询，false 表示 futex 阻塞等待
+ */
+void reader_loop(const std::string &name, const std::atomic<bool> &running,
+                 bool poll, std::vector<uint64_t> *samples,
+                 uint64_t *frames_read) {
+  ShmManager reader(name);
+  if (reader.open_and_map() != ShmStatus::Success)
+    return;
+  uint64_t last_version = 0;
+  while (running.load(std::memory_order_relaxed)) {
+    if (reader.wait_for_new_frame(last_version, poll ? 0 : 50) !=
+        ShmStatus::Success)
+      continue;
+    ReadBufferGuard guard = reader.acquire_read_buffer();
+    if (!guard.is_valid() || guard.frame_version() <= last_version)
+      continue;
+    uint64_t seen_ns = now_ns();
+    uint64_t stamp_ns;
+    std::memcpy(&stamp_ns, guard.get(), sizeof(stamp_ns));
+    if (samples)
+      samples->push_back(seen_ns - stamp_ns);
+    last_version = guard.frame_version();
+    ++*frames_read;
+  }
+}
+
+/**
+ * @brief 写者：按给定帧率（0 表示不限速）提交帧，负载头部写入提交前时间戳
+ * @return uint64_t 成功提交的帧数
+ */
+uint64_t writer_loop(ShmManager &writer, size_t frame_bytes, double rate_fps,
+                     int duration_ms, const std::vector<uint8_t> &source,
+                     uint64_t *acquire_failures) {
+  uint64_t committed = 0;
+  uint64_t start = now_ns();
+  uint64_t end = start + (uint64_t)duration_ms * 1000000ull;
+  uint64_t period = rate_fps > 0 ? (uint64_t)(1e9 / rate_fps) : 0;
+  uint64_t next = start;
+  for (uint64_t version = 1;; ++version) {
+    uint64_t now = now_ns();
+    if (now >= end)
+      break;
+    if (period) {
+      if (now < next)
+        std::this_thread::sleep_for(std::chrono::nanoseconds(next - now));
+      next += period;
+    }
+    WriteBufferGuard guard = writer.acquire_write_buffer(frame_bytes);
+    if (!guard.is_valid()) {
+      ++*acquire_failures;
+      continue;
+    }
+    // 模拟拷贝型生产者：整帧写入后再打时间戳
+    std::memcpy(guard.get(), source.data(), frame_bytes);
+    uint64_t stamp = now_ns();
+    std::memcpy(guard.get(), &stamp, sizeof(stamp));
+    if (guard.commit(frame_bytes, version, stamp / 1000) == ShmStatus::Success)
+      ++committed;
+  }
+  return committed;
+}
+
+/**
+ * @brief 提交 -> 可见延迟
+ */
+json bench_latency(const BenchOptions &options) {
+  json results = json::array();
+  const double rate_fps = 1000;
+  for (bool poll : {false, true}) {
+    BenchSegment segment(kVgaYuyvBytes, 3);
+    std::vector<uint8_t> source(kVgaYuyvBytes, 0x80);
+    std::atomic<bool> running{true};
+    std::vector<uint64_t> samples;
+    samples.reserve((size_t)(rate_fps * options.duration_ms / 1000) + 16);
+    uint64_t frames_read = 0, failures = 0;
+    std::thread reader(reader_loop, segment.name(), std::cref(running), poll,
+                       &samples, &frames_read);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    uint64_t committed = writer_loop(segment.writer(), kVgaYuyvBytes, rate_fps,
+                                     options.duration_ms, source, &failures);
+    running.store(false);
+    reader.join();
+
+    json result = {{"reader", poll ? "poll" : "futex"},
+                   {"frame_bytes", kVgaYuyvBytes},
+                   {"buffer_count", 3},
+                   {"rate_fps", rate_fps},
+                   {"frames_committed", committed},
+                   {"frames_read", frames_read}};
+    result["latency"] = summarize_latency(samples);
+    std::cerr << "  latency " << (poll ? "poll " : "futex") << ": p50 "
+              << result["latency"].value("p50_us", 0.0) << " us, p99 "
+              << result["latency"].value("p99_us", 0.0) << " us" << std::endl;
+    results.push_back(result);
+  }
+  return results;
+}
+
+/**
+ * @brief 不同帧大小与缓冲区数量下的最大可持续帧率（一个最新帧读者）
+ */
+json bench_throughput(const BenchOptions &options) {
+  json results = json::array();
+  std::vector<size_t> sizes = {64 * 1024, kVgaYuyvBytes, 1280 * 720 * 2,
+                               1920 * 1080 * 2};
+  std::vector<uint32_t> counts = {2, 3, 4, 8};
+  if (options.quick) {
+    sizes = {64 * 1024, kVgaYuyvBytes};
+    counts = {2, 4};
+  }
+  for (size_t frame_bytes : sizes) {
+    std::vector<uint8_t> source(frame_bytes, 0x80);
+    for (uint32_t buffer_count : counts) {
+      BenchSegment segment(frame_bytes, buffer_count);
+      std::atomic<bool> running{true};
+      uint64_t frames_read = 0, failures = 0;
+      std::thread reader(reader_loop, segment.name(), std::cref(running), false,
+                         nullptr, &frames_read);
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      uint64_t start = now_ns();
+      uint64_t committed = writer_loop(segment.writer(), frame_bytes, 0,
+                                       options.duration_ms, source, &failures);
+      double seconds = (now_ns() - start) / 1e9;
+      running.store(false);
+      reader.join();
+
+      ShmSegmentStats stats;
+      uint64_t unread = 0;
+      if (segment.writer().get_segment_stats(&stats) == ShmStatus::Success)
+        unread = stats.frames_overwritten_unread;
+      double fps = committed / seconds;
+      json result = {{"frame_bytes", frame_bytes},
+                     {"buffer_count", buffer_count},
+                     {"commit_fps", fps},
+                     {"commit_mb_per_s", fps * frame_bytes / 1e6},
+                     {"read_fps", frames_read / seconds},
+                     {"write_acquire_failures", failures},
+                     {"frames_overwritten_unread", unread}};
+      std::cerr << "  throughput " << frame_bytes << " B x " << buffer_count
+                << ": " << (uint64_t)fps << " fps" << std::endl;
+      results.push_back(result);
+    }
+  }
+  return results;
+}
+
+/**
+ * @brief 并发读者扩展性：写者 1000 fps 提交 640x480 YUYV 帧
+ */
+json bench_reader_scaling(const BenchOptions &options) {
+  json results = json::array();
+  std::vector<int> reader_counts = {1, 2, 4, 8, 16};
+  if (options.quick)
+    reader_counts = {1, 4, 16};
+  const double rate_fps = 1000;
+  std::vector<uint8_t> source(kVgaYuyvBytes, 0x80);
+  for (int readers : reader_counts) {
+    BenchSegment segment(kVgaYuyvBytes, 4);
+    std::atomic<bool> running{true};
+    std::vector<std::vector<uint64_t>> samples(readers);
+    std::vector<uint64_t> frames_read(readers, 0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < readers; ++i)
+      threads.emplace_back(reader_loop, segment.name(), std::cref(running),
+                           false, &samples[i], &frames_read[i]);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    uint64_t failures = 0;
+    uint64_t start = now_ns();
+    uint64_t committed = writer_loop(segment.writer(), kVgaYuyvBytes, rate_fps,
+                                     options.duration_ms, source, &failures);
+    double seconds = (now_ns() - start) / 1e9;
+    running.store(false);
+    for (auto &thread : threads)
+      thread.join();
+
+    std::vector<uint64_t> merged;
+    uint64_t total_read = 0;
+    for (int i = 0; i < readers; ++i) {
+      merged.insert(merged.end(), samples[i].begin(), samples[i].end());
+      total_read += frames_read[i];
+    }
+    json result = {{"readers", readers},
+                   {"frame_bytes", kVgaYuyvBytes},
+                   {"rate_fps", rate_fps},
+                   {"commit_fps", committed / seconds},
+                   {"reads_per_s", total_read / seconds},
+                   {"write_acquire_failures", failures}};
+    result["latency"] = summarize_latency(merged);
+    std::cerr << "  readers " << readers << ": p99 "
+              << result["latency"].value("p99_us", 0.0) << " us, failures "
+              << failures << std::endl;
+    results.push_back(result);
+  }
+  return results;
+}
+
+/**
+ * @brief 生成渐变加噪声的合成画面，使 JPEG 压缩量接近真实场景
+ */
+cv::Mat make_scene(int width, int height) {
+  cv::Mat bgr(height, width, CV_8UC3);
+  for (int y = 0; y < height; ++y) {
+    uint8_t *row = bgr.ptr<uint8_t>(y);
+    for (int x = 0; x < width; ++x) {
+      uint8_t noise = (uint8_t)((x * 7919 + y * 104729) & 0x1F);
+      row[3 * x + 0] = (uint8_t)(x * 255 / width) ^ noise;
+      row[3 * x + 1] = (uint8_t)(y * 255 / height);
+      row[3 * x + 2] = (uint8_t)((x + y) & 0xFF);
+    }
+  }
+  return bgr;
+}
+
+/**
+ * @brief 生成合成 YUYV 帧
+ */
+std::vector<uint8_t> make_yuyv(int width, int height) {
+  std::vector<uint8_t> yuyv((size_t)width * height * 2);
+  for (int y = 0; y < height; ++y) {
+    uint8_t *row = yuyv.data() + (size_t)y * width * 2;
+    for (int x = 0; x < width; x += 2) {
+      row[2 * x + 0] = (uint8_t)((x + y) & 0xFF);
+      row[2 * x + 1] = (uint8_t)(x * 255 / width);
+      row[2 * x + 2] = (uint8_t)((x + y + 1) & 0xFF);
+      row[2 * x + 3] = (uint8_t)(y * 255 / height);
+    }
+  }
+  return yuyv;
+}
+
+/**
+ * @brief 单个解码测试点：在给定时间内反复解码同一帧
+ */
+json run_decode_case(const std::string &label, IDecoder &decoder,
+                     const std::vector<uint8_t> &data,
+                     const ImageHeader &header, int duration_ms) {
+  json result = {{"decoder", label},
+                 {"format", header.format == ImageFormat::MJPG ? "MJPG" : "YUYV"},
+                 {"width", header.width},
+                 {"height", header.height},
+                 {"input_bytes", header.data_size}};
+  cv::Mat out; // 复用输出，测量稳态（无分配）解码开销
+  uint64_t frames = 0;
+  uint64_t start = now_ns();
+  uint64_t end = start + (uint64_t)duration_ms * 1000000ull;
+  try {
+    do {
+      decoder.decode_into(data.data(), header, out);
+      ++frames;
+    } while (now_ns() < end);
+  } catch (const std::exception &e) {
+    result["error"] = e.what();
+    return result;
+  }
+  double seconds = (now_ns() - start) / 1e9;
+  result["fps"] = frames / seconds;
+  result["ms_per_frame"] = seconds * 1000 / frames;
+  result["input_mb_per_s"] = frames * (double)header.data_size / seconds / 1e6;
+  result["output"] = std::to_string(out.cols) + "x" + std::to_string(out.rows) +
+                     "x" + std::to_string(out.channels());
+  std::cerr << "  decode " << label << " " << header.width << "x"
+            << header.height << ": " << (uint64_t)(frames / seconds) << " fps"
+            << std::endl;
+  return result;
+}
+
+/**
+ * @brief 解码吞吐
+ */
+json bench_decode(const BenchOptions &options) {
+  json results = json::array();
+  std::vector<cv::Size> sizes = {cv::Size(640, 480), cv::Size(1280, 720),
+                                 cv::Size(1920, 1080)};
+  if (options.quick)
+    sizes = {cv::Size(640, 480)};
+
+  for (const cv::Size &size : sizes) {
+    ImageHeader header{};
+    header.width = size.width;
+    header.height = size.height;
+
+    // YUYV：默认解码器与单遍灰度 / 半分辨率输出
+    std::vector<uint8_t> yuyv = make_yuyv(size.width, size.height);
+    header.format = ImageFormat::YUYV;
+    header.channels = 2;
+    header.data_size = (uint32_t)yuyv.size();
+    auto yuyv_decoder = Factory::create_decoder(ImageFormat::YUYV);
+    results.push_back(run_decode_case("YuyvDecoder", *yuyv_decoder, yuyv,
+                                      header, options.duration_ms));
+    DecoderOptions gray;
+    gray.color = DecodeColor::Gray;
+    auto gray_decoder = Factory::create_decoder(ImageFormat::YUYV, gray);
+    results.push_back(run_decode_case("YuyvFastDecoder/gray", *gray_decoder,
+                                      yuyv, header, options.duration_ms));
+    DecoderOptions half;
+    half.output_size = cv::Size(size.width / 2, size.height / 2);
+    auto half_decoder = Factory::create_decoder(ImageFormat::YUYV, half);
+    results.push_back(run_decode_case("YuyvFastDecoder/half", *half_decoder,
+                                      yuyv, header, options.duration_ms));
+
+    // MJPEG：合成画面按 90 质量编码
+    std::vector<uint8_t> jpeg;
+    cv::imencode(".jpg", make_scene(size.width, size.height), jpeg,
+                 {cv::IMWRITE_JPEG_QUALITY, 90});
+    header.format = ImageFormat::MJPG;
+    header.channels = 3;
+    header.data_size = (uint32_t)jpeg.size();
+    auto mjpg_decoder = Factory::create_decoder(ImageFormat::MJPG);
+    results.push_back(run_decode_case("MjpgDecoder", *mjpg_decoder, jpeg,
+                                      header, options.duration_ms));
+    // DCT 域缩小解码：1/2、1/4 分辨率与只解码亮度
+    for (uint32_t scale : {2u, 4u}) {
+      DecoderOptions reduced;
+      reduced.scale = scale;
+      auto reduced_decoder =
+          Factory::create_decoder(ImageFormat::MJPG, reduced);
+      results.push_back(run_decode_case(
+          "MjpgDecoder/scale" + std::to_string(scale), *reduced_decoder, jpeg,
+          header, options.duration_ms));
+    }
+    auto mjpg_gray_decoder = Factory::create_decoder(ImageFormat::MJPG, gray);
+    results.push_back(run_decode_case("MjpgDecoder/gray", *mjpg_gray_decoder,
+                                      jpeg, header, options.duration_ms));
+  }
+  return results;
+}
+
+void print_usage(const char *program) {
+  std::cerr << "Usage: " << program
+            << " [--quick] [--duration-ms N] [--output file.json]" << std::endl;
+}
+
+std::string utc_timestamp() {
+  std::time_t now = std::time(nullptr);
+  char buffer[32];
+  std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ",
+                std::gmtime(&now));
+  return buffer;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  BenchOptions options;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--quick") {
+      options.quick = true;
+      options.duration_ms = 300;
+    } else if (arg == "--duration-ms" && i + 1 < argc) {
+      options.duration_ms = std::max(50, std::atoi(argv[++i]));
+    } else if (arg == "--output" && i + 1 < argc) {
+      options.output = argv[++i];
+    } else {
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+
+  // ShmManager 的创建/映射日志写入标准输出，基准期间丢弃以保证 JSON 干净
+  std::ostringstream discarded;
+  std::streambuf *stdout_buffer = std::cout.rdbuf(discarded.rdbuf());
+
+  char hostname[256] = {0};
+  gethostname(hostname, sizeof(hostname) - 1);
+  json report = {{"schema_version", 1},
+                 {"timestamp", utc_timestamp()},
+                 {"host", {{"hostname", hostname},
+                           {"cpus", std::thread::hardware_concurrency()}}},
+                 {"options", {{"duration_ms", options.duration_ms},
+                              {"quick", options.quick}}}};
+  int rc = 0;
+  try {
+    std::cerr << "shm_bench: commit -> visible latency" << std::endl;
+    report["latency"] = bench_latency(options);
+    std::cerr << "shm_bench: max sustainable fps" << std::endl;
+    report["throughput"] = bench_throughput(options);
+    std::cerr << "shm_bench: concurrent readers" << std::endl;
+    report["reader_scaling"] = bench_reader_scaling(options);
+    std::cerr << "shm_bench: decoder throughput" << std::endl;
+    report["decode"] = bench_decode(options);
+  } catch (const std::exception &e) {
+    std::cerr << "shm_bench: " << e.what() << std::endl;
+    report["error"] = e.what();
+    rc = 1;
+  }
+  std::cout.rdbuf(stdout_buffer);
+
+  if (options.output.empty()) {
+    std::cout << report.dump(2) << std::endl;
+  } else {
+    std::ofstream file(options.output);
+    if (!file) {
+      std::cerr << "shm_bench: Cannot write " << options.output << std::endl;
+      return 1;
+    }
+    file << report.dump(2) << std::endl;
+    std::cerr << "shm_bench: Results written to " << options.output
+              << std::endl;
+  }
+  return rc;
+}
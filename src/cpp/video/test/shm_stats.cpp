@@ -0,0 +1,347 @@
+/**
+ * @file shm_stats.cpp
+ * @brief 共享内存段内性能计数查看工具
+ * @author SensorComm Team
+ * @date 2025-08-11
+ * @version 1.0
+ *
+ * 以只读方式附加到正在运行的共享内存段，周期性采样段内计数区，
+ * 打印提交/读取速率、未读覆盖与写失败次数、读者持有时间与落后帧数直方图、
+ * 各槽位持有统计以及队列模式消费者游标。不修改段内任何数据，
+ * 生产者与消费者无需重启。
+ *
+ * 用法：shm_stats [shm_name] [interval_ms]
+ */
+
+#include "common/ipc/shm_types.h"
+#include "config/config_manager.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+static volatile std::sig_atomic_t g_running = 1;
+
+static void handle_signal(int) { g_running = 0; }
+
+/**
+ * @brief 只读映射的共享内存段
+ */
+struct ReadOnlySegment {
+  void *base = nullptr; ///< 映射基地址
+  size_t size = 0;      ///< 映射长度
+  ino_t inode = 0;      ///< 文件 inode，用于检测段被重建
+
+  const ShmBufferControl *control() const {
+    return static_cast<const ShmBufferControl *>(base);
+  }
+
+  void close() {
+    if (base)
+      munmap(base, size);
+    base = nullptr;
+    size = 0;
+    inode = 0;
+  }
+};
+
+/**
+ * @brief 以只读方式打开共享内存段文件
+ * @return int 文件描述符，失败返回 -1
+ */
+static int open_segment(const std::string &name, const ShmMapOptions &options) {
+  if (options.use_hugetlbfs) {
+    std::string file_name = name;
+    while (!file_name.empty() && file_name.front() == '/')
+      file_name.erase(0, 1);
+    int fd = open((options.hugetlbfs_dir + "/" + file_name).c_str(), O_RDONLY);
+    if (fd >= 0)
+      return fd;
+  }
+  return shm_open(name.c_str(), O_RDONLY, 0);
+}
+
+/**
+ * @brief 附加到共享内存段并校验头部
+ * @param error 失败原因
+ * @return bool 是否附加成功
+ */
+static bool attach(const std::string &name, const ShmMapOptions &options,
+                   ReadOnlySegment *segment, std::string *error) {
+  int fd = open_segment(name, options);
+  if (fd < 0) {
+    *error = "segment not found";
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ShmBufferControl)) {
+    ::close(fd);
+    *error = "segment not initialized";
+    return false;
+  }
+  void *base =
+      mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (base == MAP_FAILED) {
+    *error = "mmap failed";
+    return false;
+  }
+
+  const auto *control = static_cast<const ShmBufferControl *>(base);
+  std::string reason;
+  if (control->magic.load(std::memory_order_acquire) != ShmBufferControl::MAGIC)
+    reason = "bad magic (segment still initializing?)";
+  else if (!ShmBufferControl::is_supported_layout(control->layout_version))
+    reason = "unsupported layout v" + std::to_string(control->layout_version);
+  else if (ShmBufferControl::get_data_buffers_offset(
+               control->buffer_count.load(std::memory_order_acquire)) >
+           (size_t)st.st_size)
+    reason = "segment smaller than its header";
+  if (!reason.empty()) {
+    munmap(base, st.st_size);
+    *error = reason;
+    return false;
+  }
+
+  segment->base = base;
+  segment->size = st.st_size;
+  segment->inode = st.st_ino;
+  return true;
+}
+
+/**
+ * @brief 检查共享内存段是否已被删除或重建
+ */
+static bool segment_replaced(const std::string &name,
+                             const ShmMapOptions &options,
+                             const ReadOnlySegment &segment) {
+  // 生产者重启时旧段会先被标记为已取代
+  if (segment.control()->superseded.load(std::memory_order_acquire))
+    return true;
+  int fd = open_segment(name, options);
+  if (fd < 0)
+    return true;
+  struct stat st;
+  bool replaced = fstat(fd, &st) != 0 || st.st_ino != segment.inode;
+  ::close(fd);
+  return replaced;
+}
+
+/**
+ * @brief 打印直方图（区间增量）
+ * @param label_of 返回第 i 个桶的标签
+ */
+template <typename LabelFn>
+static void print_histogram(const char *title, const uint64_t *now,
+                            const uint64_t *prev, uint32_t buckets,
+                            LabelFn label_of) {
+  uint64_t total = 0, peak = 0;
+  uint32_t first = buckets, last = 0;
+  for (uint32_t i = 0; i < buckets; ++i) {
+    uint64_t delta = now[i] - prev[i];
+    total += delta;
+    peak = std::max(peak, delta);
+    if (delta) {
+      first = std::min(first, i);
+      last = i;
+    }
+  }
+  std::cout << "  " << title << " (" << total << " samples)" << std::endl;
+  if (total == 0)
+    return;
+  // 只打印首尾非空桶之间的范围
+  for (uint32_t i = first; i <= last; ++i) {
+    uint64_t delta = now[i] - prev[i];
+    int bar = peak ? (int)(delta * 40 / peak) : 0;
+    std::cout << "    " << std::setw(12) << label_of(i) << " "
+              << std::setw(8) << delta << " " << std::string(bar, '#')
+              << std::endl;
+  }
+}
+
+static std::string hold_label(uint32_t b) {
+  std::ostringstream out;
+  if (b == ShmStatsRegion::HOLD_BUCKETS - 1) {
+    out << ">=" << (1ULL << (b - 1)) / 1000 << "ms";
+    return out.str();
+  }
+  uint64_t upper = 1ULL << b; // 桶 b 上界（微秒）
+  if (upper >= 1000)
+    out << "<" << std::fixed << std::setprecision(upper >= 10000 ? 0 : 1)
+        << upper / 1000.0 << "ms";
+  else
+    out << "<" << upper << "us";
+  return out.str();
+}
+
+static std::string lag_label(uint32_t b) {
+  if (b == 0)
+    return "0";
+  if (b == ShmStatsRegion::LAG_BUCKETS - 1)
+    return ">=" + std::to_string(1ULL << (b - 1));
+  uint64_t low = 1ULL << (b - 1), high = (1ULL << b) - 1;
+  return low == high ? std::to_string(low)
+                     : std::to_string(low) + "-" + std::to_string(high);
+}
+
+/**
+ * @brief 打印一个采样区间的统计
+ */
+static void print_report(const std::string &name, const ShmBufferControl *control,
+                         void *base, const ShmSegmentStats &now,
+                         const ShmSegmentStats &prev) {
+  double seconds = (now.sample_us - prev.sample_us) / 1e6;
+  if (seconds <= 0)
+    return;
+  auto rate = [seconds](uint64_t a, uint64_t b) { return (a - b) / seconds; };
+  uint64_t reads = now.reads - prev.reads;
+  uint64_t holds = 0;
+  for (uint32_t i = 0; i < ShmStatsRegion::HOLD_BUCKETS; ++i)
+    holds += now.hold_hist[i] - prev.hold_hist[i];
+
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << "=== " << name << "  " << control->buffer_count.load() << " x "
+            << control->buffer_size << " B, "
+            << (control->is_queue_mode() ? "queue" : "latest") << " mode, gen "
+            << control->generation.load(std::memory_order_relaxed) << ", up "
+            << (now.sample_us - now.created_us) / 1000000 << " s ==="
+            << std::endl;
+  std::cout << "  commit   " << std::setw(8)
+            << rate(now.frames_committed, prev.frames_committed) << " fps  "
+            << std::setw(8)
+            << rate(now.bytes_committed, prev.bytes_committed) / (1 << 20)
+            << " MB/s   total " << now.frames_committed << std::endl;
+  std::cout << "  read     " << std::setw(8) << rate(now.reads, prev.reads)
+            << " /s   miss " << std::setw(8)
+            << rate(now.read_misses, prev.read_misses) << " /s" << std::endl;
+  std::cout << "  overwritten unread " << std::setw(6)
+            << now.frames_overwritten_unread - prev.frames_overwritten_unread
+            << " (total " << now.frames_overwritten_unread << ")"
+            << "   write acquire failures " << std::setw(6)
+            << now.write_acquire_failures - prev.write_acquire_failures
+            << " (total " << now.write_acquire_failures << ")" << std::endl;
+  std::cout << "  reader leases active " << now.reader_leases_active
+            << "   reclaimed " << std::setw(4)
+            << now.reader_leases_reclaimed - prev.reader_leases_reclaimed
+            << " (total " << now.reader_leases_reclaimed << ")" << std::endl;
+  std::cout << std::setprecision(3) << "  hold mean "
+            << (holds ? (now.hold_total_us - prev.hold_total_us) / 1000.0 / holds
+                      : 0.0)
+            << " ms, max " << now.hold_max_us / 1000.0 << " ms"
+            << "   lag mean "
+            << (reads ? (double)(now.lag_total - prev.lag_total) / reads : 0.0)
+            << ", max " << now.lag_max << std::endl;
+
+  print_histogram("reader hold time", now.hold_hist, prev.hold_hist,
+                  ShmStatsRegion::HOLD_BUCKETS, hold_label);
+  print_histogram("lag at acquire (frames)", now.lag_hist, prev.lag_hist,
+                  ShmStatsRegion::LAG_BUCKETS, lag_label);
+
+  std::cout << "  slot   reads/s  hold mean ms  hold max ms  readers"
+            << std::endl;
+  for (size_t i = 0; i < now.slots.size() && i < prev.slots.size(); ++i) {
+    const ShmSlotStats &s = now.slots[i];
+    const ShmSlotStats &p = prev.slots[i];
+    uint64_t n = s.reads - p.reads;
+    std::cout << "  " << std::setw(4) << i << std::setprecision(1)
+              << std::setw(10) << n / seconds << std::setprecision(3)
+              << std::setw(14)
+              << (n ? (s.hold_total_us - p.hold_total_us) / 1000.0 / n : 0.0)
+              << std::setw(13) << s.hold_max_us / 1000.0 << std::setw(9)
+              << s.readers << std::endl;
+  }
+
+  if (control->is_queue_mode()) {
+    uint64_t latest = 0;
+    for (uint32_t i = 0; i < control->buffer_count.load(); ++i) {
+      ShmSlotView slot = control->get_slot(i, base);
+      if (slot.ready->load(std::memory_order_acquire))
+        latest = std::max(latest,
+                          slot.frame_version->load(std::memory_order_acquire));
+    }
+    for (uint32_t i = 0; i < ShmBufferControl::MAX_CONSUMERS; ++i) {
+      const ShmConsumerCursor *cursor = control->get_consumer(i, base);
+      if (cursor->active.load(std::memory_order_acquire) != 1)
+        continue; // 仅显示已激活（非空闲/注册中）的游标
+      uint64_t next = cursor->next_version.load(std::memory_order_acquire);
+      std::cout << "  consumer " << i << " pid " << cursor->pid.load()
+                << "  consumed " << cursor->frames_consumed.load()
+                << "  dropped " << cursor->frames_dropped.load() << "  lag "
+                << (latest >= next ? latest - next + 1 : 0) << std::endl;
+    }
+  }
+  std::cout << std::endl;
+}
+
+int main(int argc, char **argv) {
+  std::string shm_name;
+  ShmMapOptions map_options;
+  try {
+    ConfigManager::get_instance().load_shm_config(
+        "../../../config/shmConfig.json");
+    const auto &shm_config = ConfigManager::get_instance().get_shm_config();
+    shm_name = shm_config.name;
+    map_options = shm_config.map_options;
+  } catch (const std::exception &e) {
+    if (argc < 2) {
+      std::cerr << "shm_stats: " << e.what() << std::endl;
+      std::cerr << "Usage: " << argv[0] << " [shm_name] [interval_ms]"
+                << std::endl;
+      return 1;
+    }
+  }
+  if (argc > 1)
+    shm_name = argv[1];
+  int interval_ms = argc > 2 ? std::atoi(argv[2]) : 1000;
+  if (interval_ms <= 0)
+    interval_ms = 1000;
+
+  std::signal(SIGINT, handle_signal);
+  std::signal(SIGTERM, handle_signal);
+
+  ReadOnlySegment segment;
+  ShmSegmentStats prev;
+  std::string last_error;
+  while (g_running) {
+    if (!segment.base) {
+      std::string error;
+      if (!attach(shm_name, map_options, &segment, &error)) {
+        if (error != last_error)
+          std::cerr << "shm_stats: '" << shm_name << "': " << error
+                    << ", retrying..." << std::endl;
+        last_error = error;
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+        continue;
+      }
+      last_error.clear();
+      segment.control()->read_stats(segment.base, &prev);
+      std::cout << "shm_stats: attached to '" << shm_name << "' ("
+                << segment.size << " bytes, read-only)" << std::endl;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+    if (segment_replaced(shm_name, map_options, segment)) {
+      // 生产者重启会删除并重建段，重新附加到新段
+      std::cout << "shm_stats: segment replaced, re-attaching" << std::endl;
+      segment.close();
+      continue;
+    }
+
+    ShmSegmentStats now;
+    segment.control()->read_stats(segment.base, &now);
+    print_report(shm_name, segment.control(), segment.base, now, prev);
+    prev = now;
+  }
+
+  segment.close();
+  return 0;
+}